@@ -8,6 +8,7 @@
 
 #include "alarmlistview.h"
 
+#include "resources/datamodel.h"
 #include "resources/resourcedatamodelbase.h"
 #include "resources/eventmodel.h"
 
@@ -15,6 +16,8 @@
 #include <KConfigGroup>
 
 #include <QHeaderView>
+#include <QScrollBar>
+#include <QTimer>
 #include <QMenu>
 #include <QAction>
 #include <QApplication>
@@ -43,6 +46,62 @@ AlarmListView::AlarmListView(const QString& configGroup, QWidget* parent)
     header()->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(header(), &QWidget::customContextMenuRequested, this, &AlarmListView::headerContextMenuRequested);
     Preferences::connect(&Preferences::useAlarmNameChanged, this, &AlarmListView::useAlarmNameChanged);
+
+    // Keep the data model informed of which alarms are displayed, so that
+    // only their time-to-alarm values need to be refreshed each minute.
+    mVisibleTimer = new QTimer(this);
+    mVisibleTimer->setSingleShot(true);
+    connect(mVisibleTimer, &QTimer::timeout, this, &AlarmListView::updateVisibleEvents);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, mVisibleTimer, qOverload<>(&QTimer::start));
+    connect(header(), &QHeaderView::sectionResized, mVisibleTimer, qOverload<>(&QTimer::start));
+}
+
+AlarmListView::~AlarmListView()
+{
+    DataModel::setTimeToVisibleEvents(this, {});
+}
+
+void AlarmListView::setModel(QAbstractItemModel* model)
+{
+    EventListView::setModel(model);
+    connect(model, &QAbstractItemModel::rowsInserted, mVisibleTimer, qOverload<>(&QTimer::start));
+    connect(model, &QAbstractItemModel::rowsRemoved, mVisibleTimer, qOverload<>(&QTimer::start));
+    connect(model, &QAbstractItemModel::rowsMoved, mVisibleTimer, qOverload<>(&QTimer::start));
+    connect(model, &QAbstractItemModel::layoutChanged, mVisibleTimer, qOverload<>(&QTimer::start));
+    connect(model, &QAbstractItemModel::modelReset, mVisibleTimer, qOverload<>(&QTimer::start));
+    mVisibleTimer->start();
+}
+
+/******************************************************************************
+* Called when the widget is resized.
+*/
+void AlarmListView::resizeEvent(QResizeEvent* re)
+{
+    EventListView::resizeEvent(re);
+    mVisibleTimer->start();
+}
+
+/******************************************************************************
+* Tell the data model which alarms are currently displayed in the Time To
+* column, so that only these are refreshed every minute.
+*/
+void AlarmListView::updateVisibleEvents()
+{
+    QSet<QString> eventIds;
+    EventListModel* elm = itemModel();
+    if (elm  &&  !header()->isSectionHidden(AlarmListModel::TimeToColumn))
+    {
+        const QModelIndex first = indexAt(QPoint(0, 0));
+        const QModelIndex last = indexAt(QPoint(0, viewport()->height() - 1));
+        const int lastRow = last.isValid() ? last.row() : elm->rowCount() - 1;
+        for (int row = first.isValid() ? first.row() : 0;  row <= lastRow;  ++row)
+        {
+            const QString id = elm->event(elm->index(row, 0)).id();
+            if (!id.isEmpty())
+                eventIds.insert(id);
+        }
+    }
+    DataModel::setTimeToVisibleEvents(this, eventIds);
 }
 
 /******************************************************************************
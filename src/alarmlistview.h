@@ -12,12 +12,16 @@
 
 #include <QByteArray>
 
+class QTimer;
+
 
 class AlarmListView : public EventListView
 {
     Q_OBJECT
 public:
     explicit AlarmListView(const QString& configGroup, QWidget* parent = nullptr);
+    ~AlarmListView() override;
+    void     setModel(QAbstractItemModel*) override;
 
     /** Return which of the optional columns are currently shown. */
     QList<bool> columnsVisible() const;
@@ -27,6 +31,9 @@ public:
 Q_SIGNALS:
     void     columnsVisibleChanged();
 
+protected:
+    void     resizeEvent(QResizeEvent*) override;
+
 protected Q_SLOTS:
     void     initSections() override;
 
@@ -34,6 +41,7 @@ private Q_SLOTS:
     void     saveColumnsState();
     void     headerContextMenuRequested(const QPoint&);
     void     useAlarmNameChanged(bool);
+    void     updateVisibleEvents();
 
 private:
     void     showHideColumn(QMenu&, QAction*);
@@ -41,6 +49,7 @@ private:
     void     enableTimeColumns(QMenu*);
 
     QString  mConfigGroup;
+    QTimer*  mVisibleTimer;     // to update the visible events once control returns to the event loop
 };
 
 // vim: et sw=4:
@@ -0,0 +1,358 @@
+/*
+ *  alarmscheduler.cpp  -  handles due alarms and reschedules them
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "alarmscheduler.h"
+
+#include "kalarmcalendar/datetime.h"
+#include "kalarm_debug.h"
+
+/******************************************************************************
+* Find the maximum number of seconds late which a late-cancel alarm is allowed
+* to be. This is calculated as the late cancel interval, plus a few seconds
+* leeway to cater for any timing irregularities.
+*/
+int AlarmScheduler::maxLateness(int lateCancel)
+{
+    static const int LATENESS_LEEWAY = 5;
+    int lc = (lateCancel >= 1) ? (lateCancel - 1)*60 : 0;
+    return LATENESS_LEEWAY + lc;
+}
+
+/******************************************************************************
+* Handle an event's alarms which are due. The first due alarm is executed, and
+* any others which are due are rescheduled or cancelled.
+* If 'trigger' is true and no alarm is due, the first alarm is executed
+* regardless.
+* Reply = 0 if can't trigger display event because notifications are inhibited.
+*       = 1 otherwise (including if the event has been deleted).
+*/
+int AlarmScheduler::handleAlarms(KAEvent& event, bool trigger)
+{
+    const KADateTime now = currentTime();
+    qCDebug(KALARM_LOG) << "AlarmScheduler::handleAlarms:" << event.id() << "," << (trigger ? "TRIGGER:" : "HANDLE:") << qPrintable(now.qDateTime().toString(QStringLiteral("yyyy-MM-dd hh:mm"))) << "UTC";
+    bool updateCalAndDisplay = false;
+    bool alarmToExecuteValid = false;
+    KAAlarm alarmToExecute;
+    bool restart = false;
+    // Check all the alarms in turn.
+    // Note that the main alarm is fetched before any other alarms.
+    for (KAAlarm alarm = event.firstAlarm();
+         alarm.isValid();
+         alarm = (restart ? event.firstAlarm() : event.nextAlarm(alarm)), restart = false)
+    {
+        // Check if the alarm is due yet.
+        const KADateTime nextDT = alarm.dateTime(true).effectiveKDateTime();
+        const int secs = nextDT.secsTo(now);
+        if (secs < 0)
+        {
+            // The alarm appears to be in the future.
+            // Check if it's an invalid local time during a daylight
+            // saving time shift, which has actually passed.
+            if (alarm.dateTime().timeSpec() != KADateTime::LocalZone
+            ||  nextDT > now.toTimeSpec(KADateTime::LocalZone))
+            {
+                // This alarm is definitely not due yet
+                qCDebug(KALARM_LOG) << "AlarmScheduler::handleAlarms: Alarm" << alarm.type() << "at" << nextDT << ": not due";
+                continue;
+            }
+        }
+        bool reschedule = false;
+        bool rescheduleWork = false;
+        if ((event.workTimeOnly() || event.holidaysExcluded())  &&  !alarm.deferred())
+        {
+            // The alarm is restricted to working hours and/or non-holidays
+            // (apart from deferrals). This needs to be re-evaluated every
+            // time it triggers, since working hours could change.
+            if (alarm.dateTime().isDateOnly())
+            {
+                KADateTime dt(nextDT);
+                dt.setDateOnly(true);
+                reschedule = event.excludedByWorkTimeOrHoliday(dt);
+            }
+            else
+                reschedule = event.excludedByWorkTimeOrHoliday(nextDT);
+            rescheduleWork = reschedule;
+            if (reschedule)
+                qCDebug(KALARM_LOG) << "AlarmScheduler::handleAlarms: Alarm" << alarm.type() << "at" << nextDT << ": not during working hours";
+        }
+        if (!reschedule  &&  alarm.repeatAtLogin())
+        {
+            // Alarm is to be displayed at every login.
+            qCDebug(KALARM_LOG) << "AlarmScheduler::handleAlarms: REPEAT_AT_LOGIN";
+            // Check if the main alarm is already being displayed.
+            // (We don't want to display both at the same time.)
+            if (alarmToExecute.isValid())
+                continue;
+
+            // Set the time to display if it's a display alarm
+            alarm.setTime(now);
+        }
+        if (!reschedule  &&  event.lateCancel())
+        {
+            // Alarm is due, and it is to be cancelled if too late.
+            qCDebug(KALARM_LOG) << "AlarmScheduler::handleAlarms: LATE_CANCEL";
+            bool cancel = false;
+            bool tooLate = false;
+            KAEvent::OccurType prevType = KAEvent::OccurType::None;
+            if (alarm.dateTime().isDateOnly())
+            {
+                // The alarm has no time, so cancel it if its date is too far past
+                const int maxlate = event.lateCancel() / 1440;    // maximum lateness in days
+                KADateTime limit(DateTime(nextDT.addDays(maxlate + 1)).effectiveKDateTime());
+                if (now >= limit)
+                {
+                    // It's too late to display the scheduled occurrence.
+                    // Find the last previous occurrence of the alarm.
+                    DateTime next;
+                    prevType = event.previousOccurrence(now, next, KAEvent::Repeats::Return);
+                    if (KAEvent::isRecur(prevType))
+                    {
+                        limit.setDate(next.date().addDays(maxlate + 1));
+                        if (now >= limit)
+                            tooLate = true;
+                    }
+                    else
+                        reschedule = true;
+                }
+            }
+            else
+            {
+                // The alarm is timed. Allow it to be the permitted amount late before cancelling it.
+                const int maxlate = maxLateness(event.lateCancel());
+                if (secs > maxlate)
+                {
+                    // It's over the maximum interval late.
+                    // Find the most recent occurrence of the alarm.
+                    DateTime next;
+                    prevType = event.previousOccurrence(now, next, KAEvent::Repeats::Return);
+                    if (KAEvent::isRecur(prevType))
+                    {
+                        if (next.effectiveKDateTime().secsTo(now) > maxlate)
+                            tooLate = true;
+                    }
+                    else
+                        reschedule = true;
+                }
+            }
+            if (tooLate)
+            {
+                // If it's past the last recurrence, and there are no
+                // sub-repetitions to come, cancel the alarm.
+                DateTime next;
+                if (KAEvent::isLastRecur(prevType)
+                &&  event.nextDateTime(now, next, KAEvent::NextRepeat) == KAEvent::TriggerType::None)
+                    cancel = true;
+                else
+                    reschedule = true;
+            }
+
+            if (cancel)
+            {
+                // All recurrences are finished, so cancel the event
+                event.setArchive();
+                if (cancelAlarm(event, alarm.type(), false))
+                    return 1;   // event has been deleted
+                updateCalAndDisplay = true;
+                continue;
+            }
+        }
+        if (reschedule)
+        {
+            // The latest repetition was too long ago, so schedule the next one
+            switch (rescheduleAlarm(event, alarm, false, (rescheduleWork ? nextDT : KADateTime())))
+            {
+                case 1:
+                    // A working-time-only alarm has been rescheduled and the
+                    // rescheduled time is already due. Start processing the
+                    // event again.
+                    alarmToExecuteValid = false;
+                    restart = true;
+                    break;
+                case -1:
+                    return 1;   // event has been deleted
+                default:
+                    break;
+            }
+            updateCalAndDisplay = true;
+            continue;
+        }
+        if (!alarmToExecuteValid)
+        {
+            qCDebug(KALARM_LOG) << "AlarmScheduler::handleAlarms: Alarm" << alarm.type() << ": execute";
+            alarmToExecute = alarm;             // note the alarm to be displayed
+            alarmToExecuteValid = true;         // only trigger one alarm for the event
+        }
+        else
+            qCDebug(KALARM_LOG) << "AlarmScheduler::handleAlarms: Alarm" << alarm.type() << ": skip";
+    }
+
+    // If there is an alarm to execute, do this last after rescheduling/cancelling
+    // any others. This ensures that the updated event is only saved once to the calendar.
+    if (alarmToExecute.isValid())
+    {
+        if (!executeAlarm(event, alarmToExecute, true))
+            return 0;    // display alarm, but notifications are inhibited
+    }
+    else
+    {
+        if (trigger)
+        {
+            // The alarm is to be executed regardless of whether it's due.
+            // Only trigger one alarm from the event - we don't want multiple
+            // identical messages, for example.
+            const KAAlarm alarm = event.firstAlarm();
+            if (alarm.isValid())
+            {
+                if (!executeAlarm(event, alarm, false))
+                    return 0;    // display alarm, but notifications are inhibited
+            }
+        }
+        if (updateCalAndDisplay)
+            updateEvent(event);     // update the window lists and calendar file
+        else if (!trigger) { qCDebug(KALARM_LOG) << "AlarmScheduler::handleAlarms: No action"; }
+    }
+    return 1;
+}
+
+/******************************************************************************
+* Reschedule the alarm for its next recurrence after now. If none remain,
+* delete it.  If the alarm is deleted and it is the last alarm for its event,
+* the event is removed from the calendar file and from every main window
+* instance.
+* If 'nextDt' is valid, the event is rescheduled for the next non-working
+* time occurrence after that.
+* Reply = 1 if 'nextDt' is valid and the rescheduled event is already due
+*       = -1 if the event has been deleted
+*       = 0 otherwise.
+*/
+int AlarmScheduler::rescheduleAlarm(KAEvent& event, const KAAlarm& alarm, bool updateCalAndDisplay, const KADateTime& nextDt)
+{
+    qCDebug(KALARM_LOG) << "AlarmScheduler::rescheduleAlarm: Alarm type:" << alarm.type();
+    if (!canEventRetrigger(event))
+        return 0;
+    int reply = 0;
+    bool update = false;
+    event.startChanges();
+    if (alarm.repeatAtLogin())
+    {
+        // Leave an alarm which repeats at every login until its main alarm triggers
+        if (!event.reminderActive()  &&  event.reminderMinutes() < 0)
+        {
+            // Executing an at-login alarm: first schedule the reminder
+            // which occurs AFTER the main alarm.
+            event.activateReminderAfter(currentTime());
+        }
+        // Repeat-at-login alarms are usually unchanged after triggering.
+        // Ensure that the archive flag (which was set in execAlarm()) is saved.
+        update = true;
+    }
+    else if (alarm.isReminder()  ||  alarm.deferred())
+    {
+        // It's a reminder alarm or an extra deferred alarm, so delete it
+        event.removeExpiredAlarm(alarm.type());
+        update = true;
+    }
+    else
+    {
+        // Reschedule the alarm for its next occurrence.
+        DateTime last = event.mainDateTime(false);   // note this trigger time
+        if (last != event.mainDateTime(true))
+            last = DateTime();                       // but ignore sub-repetition triggers
+        bool next = nextDt.isValid();
+        KADateTime next_dt = nextDt;
+        const KADateTime now = currentTime();
+        do
+        {
+            KAEvent::OccurType type;
+            if (!event.setNextOccurrence(next ? next_dt : now, type))
+            {
+                // The next occurrence hasn't changed.
+                if (type == KAEvent::OccurType::None)
+                {
+                    // All repetitions are finished, so cancel the event
+                    qCDebug(KALARM_LOG) << "AlarmScheduler::rescheduleAlarm: No occurrence";
+                    if (event.reminderMinutes() < 0  &&  last.isValid()
+                    &&  alarm.type() != KAAlarm::Type::AtLogin  &&  !event.mainExpired())
+                    {
+                        // Set the reminder which is now due after the last main alarm trigger.
+                        // Note that at-login reminders are scheduled when the alarm is executed.
+                        event.activateReminderAfter(last);
+                        updateCalAndDisplay = true;
+                    }
+                    if (cancelAlarm(event, alarm.type(), updateCalAndDisplay))
+                        return -1;
+                }
+            }
+            else if (KAEvent::isRecur(type) || KAEvent::isRepeat(type))
+            {
+                // The event is due by now and repetitions still remain, so rewrite the event
+                if (updateCalAndDisplay)
+                    update = true;
+            }
+            if (event.deferred())
+            {
+                // Just in case there's also a deferred alarm, ensure it's removed
+                event.removeExpiredAlarm(KAAlarm::Type::Deferred);
+                update = true;
+            }
+            if (next)
+            {
+                // The alarm is restricted to working hours and/or non-holidays.
+                // Check if the calculated next time is valid.
+                next_dt = event.mainDateTime(true).effectiveKDateTime();
+                if (event.mainDateTime(false).isDateOnly())
+                {
+                    KADateTime dt(next_dt);
+                    dt.setDateOnly(true);
+                    next = event.excludedByWorkTimeOrHoliday(dt);
+                }
+                else
+                    next = event.excludedByWorkTimeOrHoliday(next_dt);
+            }
+        } while (next && next_dt <= now);
+        reply = (next_dt.isValid() && (next_dt <= now)) ? 1 : 0;
+
+        if (event.reminderMinutes() < 0  &&  last.isValid()
+        &&  alarm.type() != KAAlarm::Type::AtLogin)
+        {
+            // Set the reminder which is now due after the last main alarm trigger.
+            // Note that at-login reminders are scheduled when the alarm is executed.
+            event.activateReminderAfter(last);
+        }
+    }
+    event.endChanges();
+    if (update)
+        updateEvent(event, false);   // update the window lists and calendar file
+    return reply;
+}
+
+/******************************************************************************
+* Delete the alarm. If it is the last alarm for its event, the event is removed
+* from the calendar file and from every main window instance.
+* Reply = true if event has been deleted.
+*/
+bool AlarmScheduler::cancelAlarm(KAEvent& event, KAAlarm::Type alarmType, bool updateCalAndDisplay)
+{
+    qCDebug(KALARM_LOG) << "AlarmScheduler::cancelAlarm";
+    if (alarmType == KAAlarm::Type::Main  &&  !event.displaying()  &&  event.toBeArchived())
+    {
+        // The event is being deleted. Save it in the archived resource first.
+        archiveEvent(event);
+    }
+    event.removeExpiredAlarm(alarmType);
+    if (!event.alarmCount())
+    {
+        deleteEvent(event);
+        return true;
+    }
+    if (updateCalAndDisplay)
+        updateEvent(event);    // update the window lists and calendar file
+    return false;
+}
+
+// vim: et sw=4:
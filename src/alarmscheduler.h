@@ -0,0 +1,84 @@
+/*
+ *  alarmscheduler.h  -  handles due alarms and reschedules them
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+/** @file alarmscheduler.h - handles due alarms and reschedules them */
+
+#include "kalarmcalendar/kaevent.h"
+
+using namespace KAlarmCal;
+
+/** AlarmScheduler decides what to do with an event's alarms when the event is
+ *  due: which alarm to execute, which late alarms to cancel, and how to
+ *  reschedule alarms once they have triggered. It does not execute alarms or
+ *  access calendars itself, but calls virtual methods to do so. This allows the
+ *  scheduling logic to be driven by KAlarmApp, or by tests using in-memory
+ *  storage.
+ *
+ *  @author David Jarvie <djarvie@kde.org>
+ */
+class AlarmScheduler
+{
+public:
+    virtual ~AlarmScheduler() = default;
+
+    /** Find the maximum number of seconds late which a late-cancel alarm is
+     *  allowed to be.
+     */
+    static int maxLateness(int lateCancel);
+
+    /** Handle an event's alarms which are due. The first due alarm is executed,
+     *  and any other due alarms are rescheduled or cancelled.
+     *  @param event    The event, which is updated to reflect rescheduling.
+     *  @param trigger  If no alarm is due, execute the event's first alarm regardless.
+     *  @return 0 if a display alarm can't be executed because notifications are inhibited;
+     *          1 otherwise (including if the event has been deleted).
+     */
+    int handleAlarms(KAEvent& event, bool trigger);
+
+    /** Reschedule an alarm for its next recurrence after now. If none remain,
+     *  delete it.
+     *  @param nextDt  If valid, reschedule for the next non-working time
+     *                 occurrence after this time.
+     *  @return 1 if @p nextDt is valid and the rescheduled event is already due;
+     *          -1 if the event has been deleted; 0 otherwise.
+     */
+    int rescheduleAlarm(KAEvent&, const KAAlarm&, bool updateCalAndDisplay,
+                        const KADateTime& nextDt = KADateTime());
+
+    /** Delete an alarm. If it is the event's last alarm, the event is deleted.
+     *  @return true if the event has been deleted.
+     */
+    bool cancelAlarm(KAEvent&, KAAlarm::Type, bool updateCalAndDisplay);
+
+protected:
+    /** Execute an alarm.
+     *  @param reschedule  true to reschedule the alarm once it has executed (by
+     *                     calling rescheduleAlarm()), false to simply execute it.
+     *  @return false if it is a display alarm and notifications are inhibited.
+     */
+    virtual bool executeAlarm(KAEvent&, const KAAlarm&, bool reschedule) = 0;
+
+    /** Return whether an event can be rescheduled, i.e. its resource is writable. */
+    virtual bool canEventRetrigger(const KAEvent&) const = 0;
+
+    /** Save an updated event to its resource, and update displays. */
+    virtual void updateEvent(KAEvent&, bool saveIfReadOnly = true) = 0;
+
+    /** Save a copy of an event, which is about to be deleted, as an archived event. */
+    virtual void archiveEvent(const KAEvent&) = 0;
+
+    /** Delete an event which has no alarms left. */
+    virtual void deleteEvent(KAEvent&) = 0;
+
+    /** Return the current time. */
+    virtual KADateTime currentTime() const   { return KADateTime::currentUtcDateTime(); }
+};
+
+// vim: et sw=4:
@@ -0,0 +1,204 @@
+/*
+ *  schedulerbenchmark.cpp  -  benchmark for alarm scheduling
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "schedulerbenchmark.h"
+
+#include "alarmscheduler.h"
+#include "simulationworkload.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTest>
+
+using namespace KAlarmCal;
+
+QTEST_GUILESS_MAIN(SchedulerBenchmark)
+
+namespace
+{
+const KADateTime START(QDate(2026, 3, 2), QTime(9, 0, 0), KADateTime::UTC);
+const KADateTime END = START.addSecs(3 * 3600);
+const int RESOURCE_COUNT = 4;   // number of resources to spread the events across
+
+// Alarm scheduler which holds its events in memory instead of in calendars,
+// and which counts alarms instead of executing them. Time is advanced to each
+// alarm's trigger time as it is handled.
+class MemoryScheduler : public AlarmScheduler
+{
+public:
+    explicit MemoryScheduler(const KADateTime& now) : mNow(now)  { mResources.resize(RESOURCE_COUNT); }
+
+    void addEvents(const QList<KAEvent>& events)
+    {
+        int i = 0;
+        for (KAEvent event : events)
+        {
+            event.setResourceId(i++ % RESOURCE_COUNT);
+            mResources[event.resourceId()].events[event.id()] = event;
+        }
+        for (MemoryResource& resource : mResources)
+            findEarliest(resource);
+    }
+
+    // Handle alarms in time order until none are due before 'end'.
+    // Reply = false if an alarm was not rescheduled after being handled.
+    bool run(const KADateTime& end, int maxSteps)
+    {
+        for (int steps = 0;  ;  ++steps)
+        {
+            KAEvent event;
+            KADateTime due;
+            for (const MemoryResource& resource : std::as_const(mResources))
+            {
+                if (!resource.earliestId.isEmpty())
+                {
+                    const KAEvent& e = resource.events[resource.earliestId];
+                    const KADateTime dt = e.nextTrigger(KAEvent::Trigger::All, true).effectiveKDateTime();
+                    if (!due.isValid()  ||  dt < due)
+                    {
+                        due = dt;
+                        event = e;
+                    }
+                }
+            }
+            if (!due.isValid()  ||  due > end)
+                return true;
+            if (steps >= maxSteps)
+                return false;
+            if (due > mNow)
+                mNow = due;
+            handleAlarms(event, false);
+        }
+    }
+
+    int eventCount() const
+    {
+        int count = 0;
+        for (const MemoryResource& resource : mResources)
+            count += resource.events.count();
+        return count;
+    }
+    int executed() const   { return mExecuted; }
+    int archived() const   { return mArchived; }
+
+protected:
+    bool executeAlarm(KAEvent& event, const KAAlarm& alarm, bool reschedule) override
+    {
+        event.setArchive();
+        ++mExecuted;
+        if (reschedule)
+            rescheduleAlarm(event, alarm, true);
+        return true;
+    }
+
+    bool canEventRetrigger(const KAEvent&) const override   { return true; }
+
+    void updateEvent(KAEvent& event, bool) override
+    {
+        MemoryResource& resource = mResources[event.resourceId()];
+        resource.events[event.id()] = event;
+        if (event.id() == resource.earliestId)
+            findEarliest(resource);
+        else
+        {
+            const DateTime dt = event.nextTrigger(KAEvent::Trigger::All, true);
+            if (dt.isValid()
+            &&  (resource.earliestId.isEmpty()  ||  dt < resource.events[resource.earliestId].nextTrigger(KAEvent::Trigger::All, true)))
+                resource.earliestId = event.id();
+        }
+    }
+
+    void archiveEvent(const KAEvent&) override   { ++mArchived; }
+
+    void deleteEvent(KAEvent& event) override
+    {
+        MemoryResource& resource = mResources[event.resourceId()];
+        resource.events.remove(event.id());
+        if (event.id() == resource.earliestId)
+            findEarliest(resource);
+    }
+
+    KADateTime currentTime() const override   { return mNow; }
+
+private:
+    struct MemoryResource
+    {
+        QHash<QString, KAEvent> events;
+        QString earliestId;     // ID of the event which is due soonest
+    };
+
+    void findEarliest(MemoryResource& resource)
+    {
+        resource.earliestId.clear();
+        DateTime earliest;
+        for (auto it = resource.events.constBegin();  it != resource.events.constEnd();  ++it)
+        {
+            const DateTime dt = it.value().nextTrigger(KAEvent::Trigger::All, true);
+            if (dt.isValid()  &&  (!earliest.isValid()  ||  dt < earliest))
+            {
+                earliest = dt;
+                resource.earliestId = it.key();
+            }
+        }
+    }
+
+    QList<MemoryResource> mResources;
+    KADateTime mNow;
+    int mExecuted {0};
+    int mArchived {0};
+};
+}
+
+void SchedulerBenchmark::workload_data()
+{
+    QTest::addColumn<QString>("spec");
+    QTest::addColumn<int>("events");
+    QTest::addColumn<int>("executions");
+
+    // Each minutely alarm has 12 recurrences, each with 3 sub-repetitions.
+    // Each deferred alarm triggers for its deferral and for its 2 recurrences.
+    // Each late-cancel alarm has 12 recurrences of which 3 are before the start
+    // time; the one at the start time is also missed when it is exactly due then.
+    QTest::newRow("burst")      << QStringLiteral("burst:2000")      << 2000 << 2000;
+    QTest::newRow("minutely")   << QStringLiteral("minutely:500")    << 500  << 500 * 48;
+    QTest::newRow("deferral")   << QStringLiteral("deferral:2000")   << 2000 << 2000 * 3;
+    QTest::newRow("latecancel") << QStringLiteral("latecancel:1000") << 1000 << 1000 * 9 - (1000 + 59) / 60;
+    QTest::newRow("mixed")      << QStringLiteral("burst:500,minutely:100,deferral:500,latecancel:240")
+                                << 1340 << 500 + 100 * 48 + 500 * 3 + 240 * 9 - 4;
+}
+
+// Handle a workload's alarms through the real scheduling code, and check that
+// every alarm triggers the expected number of times and that every event is
+// archived and deleted after its last alarm.
+void SchedulerBenchmark::workload()
+{
+    QFETCH(QString, spec);
+    QFETCH(int, events);
+    QFETCH(int, executions);
+
+    SimulationWorkload workload;
+    QVERIFY(workload.parse(spec));
+    const QList<KAEvent> workloadEvents = workload.createEvents(START);
+    QCOMPARE(workloadEvents.count(), events);
+
+    MemoryScheduler scheduler(START);
+    scheduler.addEvents(workloadEvents);
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(scheduler.run(END, 2 * (executions + events)));
+    const qint64 nsecs = timer.nsecsElapsed();
+
+    QCOMPARE(scheduler.executed(), executions);
+    QCOMPARE(scheduler.archived(), events);
+    QCOMPARE(scheduler.eventCount(), 0);
+    QTest::setBenchmarkResult(static_cast<qreal>(nsecs) / executions, QTest::WalltimeNanoseconds);
+}
+
+#include "moc_schedulerbenchmark.cpp"
+
+// vim: et sw=4:
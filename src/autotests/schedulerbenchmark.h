@@ -0,0 +1,21 @@
+/*
+ *  schedulerbenchmark.h  -  benchmark for alarm scheduling
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <QObject>
+
+class SchedulerBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void workload_data();
+    void workload();
+};
+
+// vim: et sw=4:
@@ -0,0 +1,247 @@
+/*
+ *  segmentedfileresourcetest.cpp  -  unit tests for segmented archived alarm calendars
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "segmentedfileresourcetest.h"
+
+#include "resources/resources.h"
+#include "resources/segmentedfileresource.h"
+#include "kalarmcalendar/kacalendar.h"
+#include "kalarmcalendar/kaevent.h"
+
+#include <KCalendarCore/FileStorage>
+#include <KCalendarCore/ICalFormat>
+#include <KCalendarCore/MemoryCalendar>
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <QFile>
+#include <QFont>
+#include <QStandardPaths>
+#include <QTest>
+#include <QTimeZone>
+
+using namespace KAlarmCal;
+
+QTEST_MAIN(SegmentedFileResourceTest)
+
+namespace
+{
+const int FIRST_RESOURCE_ID = 100;
+
+// Create an archived event with a given creation time.
+KAEvent archivedEvent(const QString& id, const KADateTime& created)
+{
+    KAEvent event(created, id, QStringLiteral("Archived alarm %1").arg(id),
+                  Qt::white, Qt::black, QFont(), KAEvent::SubAction::Message, 0, KAEvent::ConfirmAck);
+    event.setEventId(id);
+    event.setCategory(CalEvent::ARCHIVED);
+    event.setCreatedDateTime(created);
+    return event;
+}
+
+// Return the time at noon on a given date, so that its UTC date is the same.
+KADateTime noon(const QDate& date)
+{
+    return KADateTime(date, QTime(12, 0, 0), KADateTime::LocalZone);
+}
+
+// Write events to a calendar file in the current KAlarm format.
+bool writeCalendar(const QString& fileName, const QList<KAEvent>& events)
+{
+    KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+    for (const KAEvent& event : events)
+    {
+        KCalendarCore::Event::Ptr kcalEvent(new KCalendarCore::Event);
+        if (!event.updateKCalEvent(kcalEvent, KAEvent::UidAction::Set)
+        ||  !calendar->addEvent(kcalEvent))
+            return false;
+    }
+    KACalendar::setKAlarmVersion(calendar);
+    KCalendarCore::FileStorage storage(calendar, fileName, new KCalendarCore::ICalFormat());
+    return storage.save();
+}
+
+// Return the sorted IDs of the events in a calendar file.
+QStringList eventIds(const QString& fileName)
+{
+    KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+    KCalendarCore::FileStorage storage(calendar, fileName, new KCalendarCore::ICalFormat());
+    if (!storage.load())
+        return {};
+    QStringList ids;
+    const KCalendarCore::Event::List events = calendar->rawEvents();
+    for (const KCalendarCore::Event::Ptr& event : events)
+        ids += event->uid();
+    ids.sort();
+    return ids;
+}
+
+// Return the sorted IDs of a resource's events.
+QStringList eventIds(const Resource& resource)
+{
+    QStringList ids;
+    const QList<KAEvent> events = resource.events();
+    for (const KAEvent& event : events)
+        ids += event.id();
+    ids.sort();
+    return ids;
+}
+
+QString uid(const QString& id)
+{
+    return CalEvent::uid(id, CalEvent::ARCHIVED);
+}
+}
+
+SegmentedFileResourceTest::SegmentedFileResourceTest() = default;
+SegmentedFileResourceTest::~SegmentedFileResourceTest() = default;
+
+void SegmentedFileResourceTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(mConfigDir.isValid());
+    mConfig.reset(new KConfig(mConfigDir.filePath(QStringLiteral("kalarmresources")), KConfig::SimpleConfig));
+    const QDate today = KADateTime::currentLocalDate();
+    mMonth = QDate(today.year(), today.month(), 1);
+}
+
+void SegmentedFileResourceTest::init()
+{
+    // Use a new directory for each test, so that segment files are not shared.
+    // The previous test's resource has already been closed.
+    mDir.reset(new QTemporaryDir);
+    QVERIFY(mDir->isValid());
+}
+
+QString SegmentedFileResourceTest::calendarPath() const
+{
+    return mDir->filePath(QStringLiteral("archived.ics"));
+}
+
+QString SegmentedFileResourceTest::segmentPath(const QDate& month) const
+{
+    return mDir->filePath(QStringLiteral("archived-%1.ics").arg(month.toString(QStringLiteral("yyyy-MM"))));
+}
+
+// Create a segmented archived alarm resource for the calendar file. Each call
+// uses a new resource ID, since closed resources remain registered.
+Resource SegmentedFileResourceTest::createResource()
+{
+    const QString group = QStringLiteral("Resource_%1").arg(mResourceCount);
+    KConfigGroup config(mConfig.get(), group);
+    config.writeEntry("Id", FIRST_RESOURCE_ID + mResourceCount++);
+    config.writeEntry("Type", QStringLiteral("File"));
+    config.writePathEntry("Path", calendarPath());
+    config.writeEntry("Name", group);
+    config.writeEntry("AlarmTypes", QStringList{QStringLiteral("Archived")});
+    config.writeEntry("Enabled", QStringList{QStringLiteral("Archived")});
+    config.writeEntry("Segmented", true);
+    FileResourceSettings::Ptr settings(new FileResourceSettings(mConfig.get(), group));
+    return SegmentedFileResource::create(settings);
+}
+
+// Write a current file with one event from this month, and segment files
+// holding one event from last month and two from three months ago.
+void SegmentedFileResourceTest::writeSegmentedCalendar()
+{
+    const QDate month1 = mMonth.addMonths(-1);
+    const QDate month3 = mMonth.addMonths(-3);
+    QVERIFY(writeCalendar(calendarPath(), {archivedEvent(QStringLiteral("current"), noon(mMonth))}));
+    QVERIFY(writeCalendar(segmentPath(month1), {archivedEvent(QStringLiteral("month1"), noon(month1.addDays(14)))}));
+    QVERIFY(writeCalendar(segmentPath(month3), {archivedEvent(QStringLiteral("month3a"), noon(month3.addDays(3))),
+                                                archivedEvent(QStringLiteral("month3b"), noon(month3.addDays(20)))}));
+}
+
+// Events created in previous months are moved out of the current file into the
+// segment files for their months, and only new events go into the current file.
+void SegmentedFileResourceTest::rollOver()
+{
+    const QDate month1 = mMonth.addMonths(-1);
+    const QDate month3 = mMonth.addMonths(-3);
+    QVERIFY(writeCalendar(calendarPath(), {archivedEvent(QStringLiteral("current"), noon(mMonth)),
+                                           archivedEvent(QStringLiteral("month1"), noon(month1.addDays(14))),
+                                           archivedEvent(QStringLiteral("month3a"), noon(month3.addDays(3))),
+                                           archivedEvent(QStringLiteral("month3b"), noon(month3.addDays(20)))}));
+
+    Resource resource = createResource();
+    QVERIFY(resource.isValid());
+    QVERIFY(resource.is<SegmentedFileResource>());
+    QVERIFY(resource.isLoadDeferred());
+
+    // Adding an event loads the current file and rolls it over.
+    QVERIFY(resource.addEvent(archivedEvent(QStringLiteral("new"), KADateTime::currentUtcDateTime())));
+    QVERIFY(resource.save());
+    QCOMPARE(eventIds(calendarPath()), (QStringList{uid(QStringLiteral("current")), uid(QStringLiteral("new"))}));
+    QCOMPARE(eventIds(segmentPath(month1)), QStringList{uid(QStringLiteral("month1"))});
+    QCOMPARE(eventIds(segmentPath(month3)), (QStringList{uid(QStringLiteral("month3a")), uid(QStringLiteral("month3b"))}));
+    QVERIFY(!QFile::exists(segmentPath(mMonth.addMonths(-2))));
+
+    // Events moved into segment files remain in the resource.
+    QCOMPARE(eventIds(resource), (QStringList{uid(QStringLiteral("current")), uid(QStringLiteral("month1")),
+                                              uid(QStringLiteral("month3a")), uid(QStringLiteral("month3b")),
+                                              uid(QStringLiteral("new"))}));
+    resource.close();
+}
+
+// Loading deferred events reads the current file and every segment file.
+void SegmentedFileResourceTest::loadSegments()
+{
+    writeSegmentedCalendar();
+
+    Resource resource = createResource();
+    QVERIFY(resource.isValid());
+    QVERIFY(resource.isLoadDeferred());
+    QVERIFY(resource.events().isEmpty());
+
+    resource.loadDeferredEvents();
+    QVERIFY(!resource.isLoadDeferred());
+    QCOMPARE(eventIds(resource), (QStringList{uid(QStringLiteral("current")), uid(QStringLiteral("month1")),
+                                              uid(QStringLiteral("month3a")), uid(QStringLiteral("month3b"))}));
+
+    // The segment files are unchanged.
+    QCOMPARE(eventIds(segmentPath(mMonth.addMonths(-1))), QStringList{uid(QStringLiteral("month1"))});
+    QCOMPARE(eventIds(segmentPath(mMonth.addMonths(-3))), (QStringList{uid(QStringLiteral("month3a")), uid(QStringLiteral("month3b"))}));
+    resource.close();
+}
+
+void SegmentedFileResourceTest::purge_data()
+{
+    QTest::addColumn<bool>("loaded");
+    QTest::newRow("segments loaded")     << true;
+    QTest::newRow("segments not loaded") << false;
+}
+
+// Purging deletes whole segment files whose events were all created before the
+// cutoff date, whether or not they have been read, and leaves later segments.
+void SegmentedFileResourceTest::purge()
+{
+    QFETCH(bool, loaded);
+    writeSegmentedCalendar();
+
+    Resource resource = createResource();
+    QVERIFY(resource.isValid());
+    if (loaded)
+        resource.loadDeferredEvents();
+
+    // Only the segment from three months ago is entirely before the cutoff.
+    const int deleted = resource.prepareArchivePurge(mMonth.addMonths(-1));
+    QCOMPARE(deleted, loaded ? 2 : 0);
+    QVERIFY(!QFile::exists(segmentPath(mMonth.addMonths(-3))));
+    QCOMPARE(eventIds(segmentPath(mMonth.addMonths(-1))), QStringList{uid(QStringLiteral("month1"))});
+    QCOMPARE(eventIds(calendarPath()), QStringList{uid(QStringLiteral("current"))});
+
+    // The purged events are removed from the resource, and are not read again
+    // when the remaining segments are loaded.
+    resource.loadDeferredEvents();
+    QCOMPARE(eventIds(resource), (QStringList{uid(QStringLiteral("current")), uid(QStringLiteral("month1"))}));
+    resource.close();
+}
+
+#include "moc_segmentedfileresourcetest.cpp"
+
+// vim: et sw=4:
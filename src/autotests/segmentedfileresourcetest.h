@@ -0,0 +1,48 @@
+/*
+ *  segmentedfileresourcetest.h  -  unit tests for segmented archived alarm calendars
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <QDate>
+#include <QObject>
+#include <QTemporaryDir>
+
+#include <memory>
+
+class KConfig;
+class Resource;
+
+class SegmentedFileResourceTest : public QObject
+{
+    Q_OBJECT
+public:
+    SegmentedFileResourceTest();
+    ~SegmentedFileResourceTest() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void rollOver();
+    void loadSegments();
+    void purge_data();
+    void purge();
+
+private:
+    QString  calendarPath() const;
+    QString  segmentPath(const QDate& month) const;
+    Resource createResource();
+    void     writeSegmentedCalendar();
+
+    QTemporaryDir            mConfigDir;   // holds the resources config file for the whole test
+    std::unique_ptr<KConfig> mConfig;      // resources config, which must outlive the resources
+    std::unique_ptr<QTemporaryDir> mDir;   // holds the calendar files for the current test
+    QDate                    mMonth;       // first day of the current month
+    int                      mResourceCount {0};
+};
+
+// vim: et sw=4:
@@ -0,0 +1,135 @@
+/*
+ *  virtualclocktest.cpp  -  unit tests for the simulation virtual clock
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "virtualclocktest.h"
+
+#include "lib/virtualclock.h"
+
+#include <QFont>
+#include <QSignalSpy>
+#include <QTest>
+#include <QTimer>
+
+using namespace KAlarmCal;
+
+QTEST_GUILESS_MAIN(VirtualClockTest)
+
+namespace
+{
+const KADateTime START(QDate(2026, 3, 2), QTime(9, 0, 0), KADateTime::UTC);
+const KADateTime END = START.addSecs(3600);
+const int WAIT_MSECS = 5000;   // real time to wait for the simulation to finish
+}
+
+void VirtualClockTest::cleanup()
+{
+    delete VirtualClock::instance();
+    KADateTime::setSimulatedSystemTime(KADateTime());
+}
+
+// Timers fire in order of their virtual due times, with the simulated system
+// time set to each due time. Timers due at the same time fire in the order
+// in which they were registered, and timers due after the end time don't fire.
+void VirtualClockTest::stepping()
+{
+    if (!VirtualClock::start(START, END))
+        QSKIP("Time simulation is not available in this build");
+    QCOMPARE(KADateTime::currentUtcDateTime(), START);
+
+    QStringList fired;
+    QList<KADateTime> firedTimes;
+    auto newTimer = [&](const QString& name)
+    {
+        auto timer = new QTimer(this);
+        timer->setSingleShot(true);
+        connect(timer, &QTimer::timeout, this, [&fired, &firedTimes, name]()
+        {
+            fired += name;
+            firedTimes += KADateTime::currentUtcDateTime();
+        });
+        return timer;
+    };
+    VirtualClock::startTimer(newTimer(QStringLiteral("a")), START.addSecs(600));
+    VirtualClock::startTimer(newTimer(QStringLiteral("b")), START.addSecs(300));
+    VirtualClock::startTimer(newTimer(QStringLiteral("c")), START.addSecs(300));
+    QTimer* late = newTimer(QStringLiteral("late"));
+    VirtualClock::startTimer(late, END.addSecs(1));
+    QVERIFY(VirtualClock::isTimerScheduled(late));
+
+    QSignalSpy finished(VirtualClock::instance(), &VirtualClock::finished);
+    QVERIFY(finished.wait(WAIT_MSECS));
+    QVERIFY(!VirtualClock::isActive());
+    QCOMPARE(fired, QStringList({QStringLiteral("b"), QStringLiteral("c"), QStringLiteral("a")}));
+    QCOMPARE(firedTimes, QList<KADateTime>({START.addSecs(300), START.addSecs(300), START.addSecs(600)}));
+    QCOMPARE(VirtualClock::instance()->statistics().steps, 2);
+    QCOMPARE(KADateTime::currentUtcDateTime(), START.addSecs(600));
+}
+
+// A cancelled timer doesn't fire, and a timer which is registered again
+// fires only at its new time.
+void VirtualClockTest::stopTimer()
+{
+    if (!VirtualClock::start(START, END))
+        QSKIP("Time simulation is not available in this build");
+
+    QTimer cancelled;
+    cancelled.setSingleShot(true);
+    QSignalSpy cancelledSpy(&cancelled, &QTimer::timeout);
+    VirtualClock::startTimer(&cancelled, START.addSecs(60));
+    VirtualClock::stopTimer(&cancelled);
+    QVERIFY(!VirtualClock::isTimerScheduled(&cancelled));
+
+    QTimer moved;
+    moved.setSingleShot(true);
+    KADateTime movedTime;
+    connect(&moved, &QTimer::timeout, this, [&movedTime]() { movedTime = KADateTime::currentUtcDateTime(); });
+    VirtualClock::startTimer(&moved, START.addSecs(120));
+    VirtualClock::startTimer(&moved, START.addSecs(180));
+
+    QSignalSpy finished(VirtualClock::instance(), &VirtualClock::finished);
+    QVERIFY(finished.wait(WAIT_MSECS));
+    QCOMPARE(cancelledSpy.count(), 0);
+    QCOMPARE(movedTime, START.addSecs(180));
+    QCOMPARE(VirtualClock::instance()->statistics().steps, 1);
+}
+
+// Alarms recorded when timers fire are counted by type, and their lateness
+// relative to the virtual time is measured.
+void VirtualClockTest::alarmLateness()
+{
+    if (!VirtualClock::start(START, END))
+        QSKIP("Time simulation is not available in this build");
+
+    const QFont font;
+    const KAEvent onTime(START.addSecs(300), QStringLiteral("On time"), QStringLiteral("Message"), Qt::white, Qt::black, font,
+                         KAEvent::SubAction::Message, 0, KAEvent::ConfirmAck);
+    const KAEvent late(START.addSecs(240), QStringLiteral("Late"), QStringLiteral("Message"), Qt::white, Qt::black, font,
+                       KAEvent::SubAction::Message, 0, KAEvent::ConfirmAck);
+    QTimer timer;
+    timer.setSingleShot(true);
+    connect(&timer, &QTimer::timeout, this, [&]()
+    {
+        VirtualClock::recordAlarm(onTime, onTime.firstAlarm());
+        VirtualClock::recordAlarm(late, late.firstAlarm());
+    });
+    VirtualClock::startTimer(&timer, START.addSecs(300));
+
+    QSignalSpy finished(VirtualClock::instance(), &VirtualClock::finished);
+    QVERIFY(finished.wait(WAIT_MSECS));
+    const VirtualClock::Statistics& stats = VirtualClock::instance()->statistics();
+    QCOMPARE(stats.triggered(), 2);
+    QCOMPARE(stats.display, 2);
+    QCOMPARE(stats.command, 0);
+    QCOMPARE(stats.lateAlarms, 1);
+    QCOMPARE(stats.maxLateness, 60);
+    QCOMPARE(stats.totalLateness, 60);
+}
+
+#include "moc_virtualclocktest.cpp"
+
+// vim: et sw=4:
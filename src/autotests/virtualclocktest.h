@@ -0,0 +1,23 @@
+/*
+ *  virtualclocktest.h  -  unit tests for the simulation virtual clock
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <QObject>
+
+class VirtualClockTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void cleanup();
+    void stepping();
+    void stopTimer();
+    void alarmLateness();
+};
+
+// vim: et sw=4:
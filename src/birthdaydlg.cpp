@@ -371,14 +371,16 @@ void BirthdayDlg::setSortModelSelectionList()
         return;
 
     QStringList alarmMessageList;
-    const QList<KAEvent> activeEvents = ResourcesCalendar::events(CalEvent::ACTIVE);
-    for (const KAEvent& event : activeEvents)
+    ResourcesCalendar::EventFilter filter;
+    filter.types     = CalEvent::ACTIVE;
+    filter.action    = KAEvent::SubAction::Message;
+    filter.recurType = KARecurrence::ANNUAL_DATE;
+    ResourcesCalendar::forEachEvent(filter, [&](const KAEvent& event)
     {
-        if (event.actionSubType() == KAEvent::SubAction::Message
-        &&  event.recurType() == KARecurrence::ANNUAL_DATE
-        &&  (mPrefixText.isEmpty()  ||  event.message().startsWith(mPrefixText)))
+        if (mPrefixText.isEmpty()  ||  event.message().startsWith(mPrefixText))
             alarmMessageList.append(event.message());
-    }
+        return true;
+    });
     akonadiPlugin->setPrefixSuffix(mBirthdaySortModel, mPrefixText, mSuffixText, alarmMessageList);
 }
 
@@ -66,6 +66,8 @@ enum Option
     SUBJECT,
 #ifndef NDEBUG
     TEST_SET_TIME,
+    TEST_SIMULATE,
+    TEST_WORKLOAD,
 #endif
     TIME,
     OptTRAY,
@@ -260,6 +262,14 @@ QStringList CommandOptions::setOptions(QCommandLineParser* parser, const QString
               = new QCommandLineOption(QStringLiteral("test-set-time"),
                                        i18n("Simulate system time [[[yyyy-]mm-]dd-]hh:mm [TZ] (debug mode)"),
                                        QStringLiteral("time"));
+    mOptions[TEST_SIMULATE]
+              = new QCommandLineOption(QStringLiteral("test-simulate"),
+                                       i18n("Simulate alarm scheduling on a virtual clock until time [[[yyyy-]mm-]dd-]hh:mm [TZ], without executing alarms (debug mode)"),
+                                       QStringLiteral("time"));
+    mOptions[TEST_WORKLOAD]
+              = new QCommandLineOption(QStringLiteral("test-workload"),
+                                       i18n("Add synthetic alarms TYPE:COUNT[,TYPE:COUNT...] to a --test-simulate simulation, where TYPE is burst, minutely, deferral or latecancel (debug mode)"),
+                                       QStringLiteral("workload"));
 #endif
     mOptions[TIME]
               = new QCommandLineOption(QStringList{QStringLiteral("t"), QStringLiteral("time")},
@@ -341,6 +351,21 @@ void CommandOptions::process()
         if (!KAlarm::convertTimeString(time.toLatin1(), mSimulationTime, KADateTime::realCurrentLocalDateTime(), true))
             d->setErrorParameter(TEST_SET_TIME);
     }
+    if (mParser->isSet(*mOptions.at(TEST_SIMULATE)))
+    {
+        const QString time = mParser->value(*mOptions.at(TEST_SIMULATE));
+        const KADateTime start = mSimulationTime.isValid() ? mSimulationTime : KADateTime::realCurrentLocalDateTime();
+        if (!KAlarm::convertTimeString(time.toLatin1(), mSimulationEndTime, start, true)
+        ||  mSimulationEndTime <= start)
+            d->setErrorParameter(TEST_SIMULATE);
+    }
+    if (mParser->isSet(*mOptions.at(TEST_WORKLOAD)))
+    {
+        if (!mSimulationEndTime.isValid())
+            d->setErrorRequires(TEST_WORKLOAD, TEST_SIMULATE);
+        else if (!mSimulationWorkload.parse(mParser->value(*mOptions.at(TEST_WORKLOAD))))
+            d->setErrorParameter(TEST_WORKLOAD);
+    }
 #endif
     if (d->checkCommand(OptTRAY, TRAY))
     {
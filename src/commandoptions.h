@@ -9,6 +9,7 @@
 #pragma once
 
 #include "editdlg.h"
+#include "simulationworkload.h"
 #include "kalarmcalendar/kaevent.h"
 #include "kalarmcalendar/karecurrence.h"
 #include "kalarmcalendar/kadatetime.h"
@@ -78,6 +79,8 @@ public:
     QString             outputText() const        { return mError; }
 #ifndef NDEBUG
     KADateTime          simulationTime() const    { return mSimulationTime; }
+    KADateTime          simulationEndTime() const { return mSimulationEndTime; }
+    const SimulationWorkload& simulationWorkload() const { return mSimulationWorkload; }
 #endif
     static void         printError(const QString& errmsg);
 
@@ -120,6 +123,8 @@ private:
     bool                mDisableAll {false};     // disable all alarm monitoring
 #ifndef NDEBUG
     KADateTime          mSimulationTime;         // system time to be simulated, or invalid if none
+    KADateTime          mSimulationEndTime;      // end time for virtual clock simulation, or invalid if none
+    SimulationWorkload  mSimulationWorkload;     // synthetic alarms to add to the simulation
 #endif
 };
 
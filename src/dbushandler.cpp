@@ -13,10 +13,13 @@
 #include "kamail.h"
 #include "resources/resources.h"
 #include <kalarmadaptor.h>
+#include "kalarmcalendar/alarmtext.h"
 #include "kalarmcalendar/identities.h"
 #include "kalarmcalendar/karecurrence.h"
 #include "kalarm_debug.h"
 
+#include <QDBusMetaType>
+
 using namespace Qt::Literals::StringLiterals;
 using namespace KCalendarCore;
 
@@ -37,6 +40,7 @@ const QString REQUEST_DBUS_OBJECT(QStringLiteral("/kalarm"));   // D-Bus object
 DBusHandler::DBusHandler()
 {
     qCDebug(KALARM_LOG) << "DBusHandler:";
+    qDBusRegisterMetaType<QList<QVariantMap>>();
     new KalarmAdaptor(this);
     QDBusConnection::sessionBus().registerObject(REQUEST_DBUS_OBJECT, this);
 }
@@ -61,6 +65,77 @@ QString DBusHandler::list()
     return theApp()->dbusList();
 }
 
+/******************************************************************************
+* List pending alarms in order of their next scheduled occurrence, optionally
+* restricted to a time window, a resource and an alarm type, and paged.
+*/
+QList<QVariantMap> DBusHandler::listAlarms(int offset, int limit, const QString& startDateTime, const QString& endDateTime,
+                                           const QString& resourceId, int type)
+{
+    QList<QVariantMap> result;
+    if (!Resources::allPopulated())
+        return result;    // can't access events before calendars are loaded
+    KADateTime from, to;
+    if (!startDateTime.isEmpty())
+    {
+        from = convertDateTime(startDateTime);
+        if (!from.isValid())
+            return result;
+    }
+    if (!endDateTime.isEmpty())
+    {
+        to = convertDateTime(endDateTime);
+        if (!to.isValid())
+            return result;
+    }
+    ResourceId resId = -1;
+    if (!resourceId.isEmpty())
+    {
+        resId = EventId::getResourceId(resourceId);
+        if (resId < 0)
+        {
+            qCCritical(KALARM_LOG) << "D-Bus call listAlarms(): unknown resource:" << resourceId;
+            return result;
+        }
+    }
+    KAEvent::Action types;
+    switch (type)
+    {
+        case 0:        types = KAEvent::Action::All;  break;
+        case DISPLAY:  types = KAEvent::Action::Display;  break;
+        case COMMAND:  types = KAEvent::Action::Command;  break;
+        case EMAIL:    types = KAEvent::Action::Email;  break;
+        case AUDIO:    types = KAEvent::Action::Audio;  break;
+        default:
+            qCCritical(KALARM_LOG) << "D-Bus call listAlarms(): invalid alarm type:" << type;
+            return result;
+    }
+
+    const QList<KAEvent> events = theApp()->scheduledAlarms(qMax(offset, 0), limit, from, to, resId, types);
+    result.reserve(events.count());
+    for (const KAEvent& event : events)
+    {
+        int alarmType;
+        switch (event.actionTypes())
+        {
+            case KAEvent::Action::Command:  alarmType = COMMAND;  break;
+            case KAEvent::Action::Email:    alarmType = EMAIL;  break;
+            case KAEvent::Action::Audio:    alarmType = AUDIO;  break;
+            default:                        alarmType = DISPLAY;  break;
+        }
+        const KADateTime dateTime = event.nextTrigger(KAEvent::Trigger::Actual).effectiveKDateTime().toLocalZone();
+        QVariantMap alarm;
+        alarm[QStringLiteral("resource")] = Resources::resource(event.resourceId()).configName();
+        alarm[QStringLiteral("id")]       = event.id();
+        alarm[QStringLiteral("trigger")]  = dateTime.toString(KADateTime::ISODate);
+        alarm[QStringLiteral("type")]     = alarmType;
+        alarm[QStringLiteral("name")]     = event.name();
+        alarm[QStringLiteral("text")]     = AlarmText::summary(event, 1);
+        result += alarm;
+    }
+    return result;
+}
+
 bool DBusHandler::scheduleMessage(const QString& name, const QString& message, const QString& startDateTime, int lateCancel, unsigned flags,
                                   const QString& bgColor, const QString& fgColor, const QString& font,
                                   const QString& audioUrl, int reminderMins, const QString& recurrence,
@@ -351,6 +426,32 @@ bool DBusHandler::scheduleAudio(const QString& audioUrl, int volumePercent, cons
     return scheduleAudio(QString(), audioUrl, volumePercent, startDateTime, lateCancel, flags, recurType, recurInterval, endDateTime);
 }
 
+/******************************************************************************
+* Schedule a batch of alarms. All the alarm specifications are validated before
+* any alarm is created, and the new alarms are then added to the calendar with
+* a single save, before this method returns.
+* Reply = IDs of the new alarms, in the same order as 'alarms', or empty if any
+*         specification was invalid, the calendars have not been loaded yet, or
+*         the calendar could not be saved.
+*/
+QStringList DBusHandler::scheduleBatch(const QList<QVariantMap>& alarms)
+{
+    qCDebug(KALARM_LOG) << "DBusHandler::scheduleBatch:" << alarms.count();
+    if (!Resources::allPopulated())
+        return {};    // can't add events before calendars are loaded
+    theApp()->beginScheduleBatch();
+    for (int i = 0, count = alarms.count();  i < count;  ++i)
+    {
+        if (!scheduleAlarm(alarms[i]))
+        {
+            qCCritical(KALARM_LOG) << "D-Bus call scheduleBatch(): invalid alarm specification at index" << i;
+            theApp()->endScheduleBatch(false);
+            return {};
+        }
+    }
+    return theApp()->endScheduleBatch(true);
+}
+
 bool DBusHandler::edit(const QString& eventID)
 {
     if (!Resources::allPopulated())
@@ -381,6 +482,50 @@ bool DBusHandler::editNew(const QString& templateName)
 }
 
 
+/******************************************************************************
+* Schedule one alarm from a scheduleBatch() specification, after converting the
+* parameters from strings. The keys in 'alarm' correspond to the parameter names
+* of the scheduleXxxx() D-Bus calls, with "type" selecting which is used.
+*/
+bool DBusHandler::scheduleAlarm(const QVariantMap& alarm)
+{
+    const QString type = alarm.value(QStringLiteral("type")).toString();
+    const QString name = alarm.value(QStringLiteral("name")).toString();
+    const int lateCancel = alarm.value(QStringLiteral("lateCancel")).toInt();
+    const unsigned flags = alarm.value(QStringLiteral("flags")).toUInt();
+    KADateTime start;
+    KARecurrence recur;
+    Duration subRepeatDuration;
+    if (!convertRecurrence(start, recur, alarm.value(QStringLiteral("startDateTime")).toString(), alarm.value(QStringLiteral("recurrence")).toString(),
+                           alarm.value(QStringLiteral("subRepeatInterval")).toInt(), subRepeatDuration))
+        return false;
+    const int subRepeatCount = alarm.value(QStringLiteral("subRepeatCount")).toInt();
+    const QUrl audioFile = QUrl::fromUserInput(alarm.value(QStringLiteral("audioFile")).toString(), QString(), QUrl::AssumeLocalFile);
+
+    if (type == "message"_L1)
+        return scheduleMessage(name, alarm.value(QStringLiteral("message")).toString(), start, lateCancel, flags,
+                               alarm.value(QStringLiteral("bgColor")).toString(), alarm.value(QStringLiteral("fgColor")).toString(),
+                               alarm.value(QStringLiteral("font")).toString(), audioFile, alarm.value(QStringLiteral("reminderMins")).toInt(),
+                               recur, subRepeatDuration, subRepeatCount);
+    if (type == "file"_L1)
+        return scheduleFile(name, QUrl::fromUserInput(alarm.value(QStringLiteral("file")).toString(), QString(), QUrl::AssumeLocalFile),
+                            start, lateCancel, flags, alarm.value(QStringLiteral("bgColor")).toString(), audioFile,
+                            alarm.value(QStringLiteral("reminderMins")).toInt(), recur, subRepeatDuration, subRepeatCount);
+    if (type == "command"_L1)
+        return scheduleCommand(name, alarm.value(QStringLiteral("commandLine")).toString(), start, lateCancel, flags,
+                               recur, subRepeatDuration, subRepeatCount);
+    if (type == "email"_L1)
+        return scheduleEmail(name, alarm.value(QStringLiteral("fromID")).toString(), alarm.value(QStringLiteral("addresses")).toString(),
+                             alarm.value(QStringLiteral("subject")).toString(), alarm.value(QStringLiteral("message")).toString(),
+                             alarm.value(QStringLiteral("attachments")).toString(), start, lateCancel, flags,
+                             recur, subRepeatDuration, subRepeatCount);
+    if (type == "audio"_L1)
+        return scheduleAudio(name, alarm.value(QStringLiteral("audioFile")).toString(), alarm.value(QStringLiteral("volumePercent"), -1).toInt(),
+                             start, lateCancel, flags, recur, subRepeatDuration, subRepeatCount);
+    qCCritical(KALARM_LOG) << "D-Bus call scheduleBatch(): invalid alarm type:" << type;
+    return false;
+}
+
 /******************************************************************************
 * Schedule a message alarm, after converting the parameters from strings.
 */
@@ -14,6 +14,8 @@
 
 #include <KCalendarCore/Duration>
 
+#include <QVariantMap>
+
 class QUrl;
 
 using namespace KAlarmCal;
@@ -30,6 +32,8 @@ public Q_SLOTS:
     Q_SCRIPTABLE bool cancelEvent(const QString& eventId);
     Q_SCRIPTABLE bool triggerEvent(const QString& eventId);
     Q_SCRIPTABLE QString list();
+    Q_SCRIPTABLE QList<QVariantMap> listAlarms(int offset, int limit, const QString& startDateTime, const QString& endDateTime,
+                                               const QString& resourceId, int type);
 
     // Create a display alarm with a specified text message.
     Q_SCRIPTABLE bool scheduleMessage(const QString& name, const QString& message, const QString& startDateTime, int lateCancel, unsigned flags,
@@ -122,12 +126,17 @@ public Q_SLOTS:
     Q_SCRIPTABLE bool scheduleAudio(const QString& audioUrl, int volumePercent, const QString& startDateTime, int lateCancel,
                                     unsigned flags, int recurType, int recurInterval, const QString& endDateTime);
 
+    // Create a batch of alarms, and add them to the calendar in one go.
+    // The alarms have been saved when the call returns.
+    Q_SCRIPTABLE QStringList scheduleBatch(const QList<QVariantMap>& alarms);
+
     // Edit an alarm.
     Q_SCRIPTABLE bool edit(const QString& eventID);
     Q_SCRIPTABLE bool editNew(int type);
     Q_SCRIPTABLE bool editNew(const QString& templateName);
 
 private:
+    static bool scheduleAlarm(const QVariantMap& alarm);
     static bool scheduleMessage(const QString& name, const QString& message, const KADateTime& start, int lateCancel, unsigned flags,
                                 const QString& bgColor, const QString& fgColor, const QString& fontStr,
                                 const QUrl& audioFile, int reminderMins, const KARecurrence&,
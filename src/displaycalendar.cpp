@@ -10,6 +10,7 @@
 
 #include "mainwindow.h"
 #include "preferences.h"
+#include "lib/file.h"
 #include "lib/messagebox.h"
 #include "kalarm_debug.h"
 
@@ -20,6 +21,7 @@
 
 #include <QStandardPaths>
 #include <QDir>
+#include <QFile>
 using namespace Qt::Literals::StringLiterals;
 
 using namespace KCalendarCore;
@@ -31,14 +33,25 @@ using namespace KAlarmCal;
 namespace
 {
 const QString displayCalendarName = QStringLiteral("displaying.ics");
+const QString displayJournalName  = QStringLiteral("displaying.journal");
+
+// Journal record types. Each record occupies one line, consisting of the record
+// type followed by its base64 encoded data.
+const char JOURNAL_ADD    = '+';    // data = iCalendar text of event
+const char JOURNAL_DELETE = '-';    // data = event ID
+
+// Number of journal records which triggers merging the journal into the calendar file.
+const int MAX_JOURNAL_RECORDS = 500;
 }
 
 bool                            DisplayCalendar::mInitialised {false};
-KAEvent::List                   DisplayCalendar::mEventList;
 QHash<QString, KAEvent*>        DisplayCalendar::mEventMap;
 KCalendarCore::FileStorage::Ptr DisplayCalendar::mCalendarStorage;
 QString                         DisplayCalendar::mDisplayCalPath;
 QString                         DisplayCalendar::mDisplayICalPath;
+QString                         DisplayCalendar::mJournalPath;
+QFile*                          DisplayCalendar::mJournal {nullptr};
+int                             DisplayCalendar::mJournalCount {0};
 DisplayCalendar::CalType        DisplayCalendar::mCalType;
 bool                            DisplayCalendar::mOpen {false};
 
@@ -56,6 +69,7 @@ void DisplayCalendar::initialise()
     mDisplayICalPath = mDisplayCalPath;
     mDisplayICalPath.replace(QStringLiteral("\\.vcs$"), QStringLiteral(".ics"));
     mCalType = (mDisplayCalPath == mDisplayICalPath) ? LOCAL_ICAL : LOCAL_VCAL;    // is the calendar in ICal or VCal format?
+    mJournalPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + '/'_L1 + displayJournalName;
     mInitialised = true;
 }
 
@@ -98,8 +112,14 @@ bool DisplayCalendar::open()
     {
         mCalendarStorage->calendar().reset();
         mCalendarStorage.reset();
+        return false;
     }
-    return mOpen;
+
+    // If the journal contained any changes, they have now been applied to the
+    // calendar in memory, so merge them into the calendar file.
+    if (mJournalCount)
+        compact();
+    return true;
 }
 
 /******************************************************************************
@@ -134,18 +154,143 @@ int DisplayCalendar::load()
     }
     QString versionString;
     KACalendar::updateVersion(mCalendarStorage, versionString);   // convert events to current KAlarm format for when calendar is saved
+    mJournalCount = replayJournal();   // apply changes which weren't saved to the calendar file
     updateKAEvents();
 
     mOpen = true;
     return 1;
 }
 
+/******************************************************************************
+* Apply the changes recorded in the journal file to the calendar in memory.
+* A record which was only partly written, because KAlarm was killed while
+* writing it, is ignored.
+* Reply = number of records in the journal.
+*/
+int DisplayCalendar::replayJournal()
+{
+    QFile file(mJournalPath);
+    if (!file.exists())
+        return 0;
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCWarning(KALARM_LOG) << "DisplayCalendar::replayJournal: Error opening" << mJournalPath;
+        return 0;
+    }
+    const QByteArray journal = file.readAll();
+    file.close();
+
+    const Calendar::Ptr cal = mCalendarStorage->calendar();
+    ICalFormat format;
+    int count = 0;
+    qsizetype start = 0;
+    for (qsizetype end;  (end = journal.indexOf('\n', start)) >= 0;  start = end + 1)
+    {
+        const QByteArray record = journal.mid(start, end - start);
+        if (record.isEmpty())
+            continue;
+        ++count;
+        const QByteArray data = QByteArray::fromBase64(record.mid(1));
+        switch (record.at(0))
+        {
+            case JOURNAL_ADD:
+            {
+                MemoryCalendar::Ptr eventCal(new MemoryCalendar(cal->timeZone()));
+                if (!format.fromRawString(eventCal, data))
+                {
+                    qCWarning(KALARM_LOG) << "DisplayCalendar::replayJournal: Error parsing event";
+                    break;
+                }
+                const KCalendarCore::Event::List kcalevents = eventCal->rawEvents();
+                for (const KCalendarCore::Event::Ptr& kcalevent : kcalevents)
+                {
+                    const KCalendarCore::Event::Ptr old = cal->event(kcalevent->uid());
+                    if (old)
+                        cal->deleteEvent(old);
+                    cal->addEvent(KCalendarCore::Event::Ptr(kcalevent->clone()));
+                }
+                break;
+            }
+            case JOURNAL_DELETE:
+            {
+                const KCalendarCore::Event::Ptr kcalevent = cal->event(QString::fromUtf8(data));
+                if (kcalevent)
+                    cal->deleteEvent(kcalevent);
+                break;
+            }
+            default:
+                qCWarning(KALARM_LOG) << "DisplayCalendar::replayJournal: Invalid record type" << record.at(0);
+                break;
+        }
+    }
+    if (start < journal.size())
+        qCWarning(KALARM_LOG) << "DisplayCalendar::replayJournal: Ignoring incomplete record";
+    qCDebug(KALARM_LOG) << "DisplayCalendar::replayJournal:" << count << "records";
+    return count;
+}
+
+/******************************************************************************
+* Append a record to the journal file, opening it if necessary.
+* If the journal file can't be written, the whole calendar is saved instead.
+*/
+bool DisplayCalendar::appendJournal(char action, const QByteArray& data)
+{
+    if (!mJournal)
+    {
+        mJournal = new QFile(mJournalPath);
+        if (!mJournal->open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            qCWarning(KALARM_LOG) << "DisplayCalendar::appendJournal: Error opening" << mJournalPath;
+            delete mJournal;
+            mJournal = nullptr;
+            return saveCal();
+        }
+    }
+
+    QByteArray record = data.toBase64();
+    record.prepend(action);
+    record.append('\n');
+    if (mJournal->write(record) != record.size()  ||  !File::sync(*mJournal))
+    {
+        qCWarning(KALARM_LOG) << "DisplayCalendar::appendJournal: Error writing" << mJournalPath;
+        return compact();
+    }
+    if (++mJournalCount >= MAX_JOURNAL_RECORDS)
+        return compact();
+    return true;
+}
+
+/******************************************************************************
+* Save the whole calendar to file, and then empty the journal file.
+*/
+bool DisplayCalendar::compact()
+{
+    qCDebug(KALARM_LOG) << "DisplayCalendar::compact:" << mJournalCount << "records";
+    if (!saveCal())
+        return false;
+    if (mJournal)
+    {
+        mJournal->close();
+        delete mJournal;
+        mJournal = nullptr;
+    }
+    QFile::remove(mJournalPath);
+    mJournalCount = 0;
+    return true;
+}
+
 /******************************************************************************
 * Save the calendar.
+* Changes have already been written and synced to the journal file, so just
+* ensure that it is flushed.
 */
 bool DisplayCalendar::save()
 {
-    return saveCal();
+    if (!mOpen)
+        return false;
+    if (mJournal)
+        return mJournal->flush();
+    return true;
 }
 
 /******************************************************************************
@@ -187,6 +332,17 @@ bool DisplayCalendar::saveCal(const QString& newFile)
 */
 void DisplayCalendar::close()
 {
+    // Merge the journal into the calendar file, so that it doesn't need to be
+    // replayed the next time the calendar is opened.
+    if (mOpen  &&  mJournalCount)
+        compact();
+    if (mJournal)
+    {
+        mJournal->close();
+        delete mJournal;
+        mJournal = nullptr;
+    }
+
     if (mCalendarStorage)
     {
         mCalendarStorage->calendar().reset();
@@ -198,12 +354,8 @@ void DisplayCalendar::close()
     mOpen = false;
 
     // Events list should be empty, but just in case...
-    for (KAEvent* event : std::as_const(mEventList))
-    {
-        mEventMap.remove(event->id());
-        delete event;
-    }
-    mEventList.clear();
+    qDeleteAll(mEventMap);
+    mEventMap.clear();
 }
 
 /******************************************************************************
@@ -214,12 +366,8 @@ void DisplayCalendar::close()
 void DisplayCalendar::updateKAEvents()
 {
     qCDebug(KALARM_LOG) << "DisplayCalendar::updateKAEvents";
-    for (KAEvent* event : std::as_const(mEventList))
-    {
-        mEventMap.remove(event->id());
-        delete event;
-    }
-    mEventList.clear();
+    qDeleteAll(mEventMap);
+    mEventMap.clear();
     Calendar::Ptr cal = mCalendarStorage->calendar();
     if (!cal)
         return;
@@ -237,7 +385,6 @@ void DisplayCalendar::updateKAEvents()
             delete event;
             continue;    // ignore events without usable alarms
         }
-        mEventList += event;
         mEventMap[kcalevent->uid()] = event;
     }
 }
@@ -245,7 +392,9 @@ void DisplayCalendar::updateKAEvents()
 /******************************************************************************
 * Add the specified event to the calendar.
 * Reply = true if 'evnt' was written to the calendar. 'evnt' is updated.
-*       = false if an error occurred, in which case 'evnt' is unchanged.
+*       = false if an error occurred. If the event was added to the calendar
+*         in memory but could not be written to file, 'evnt' is updated;
+*         otherwise it is unchanged.
 */
 bool DisplayCalendar::addEvent(KAEvent& evnt)
 {
@@ -271,7 +420,6 @@ bool DisplayCalendar::addEvent(KAEvent& evnt)
     bool remove = false;
     if (!mEventMap.contains(event->id()))
     {
-        mEventList += event;
         mEventMap[event->id()] = event;
         ok = mCalendarStorage->calendar()->addEvent(kcalcEvent);
         remove = !ok;
@@ -282,17 +430,12 @@ bool DisplayCalendar::addEvent(KAEvent& evnt)
         {
             // Adding to mCalendar failed, so undo DisplayCalendar::addEvent()
             mEventMap.remove(event->id());
-            int i = mEventList.indexOf(event);
-            if (i >= 0)
-                mEventList.remove(i);
         }
         delete event;
         return false;
     }
     evnt = *event;
-    if (remove)
-        delete event;
-    return true;
+    return appendJournal(JOURNAL_ADD, ICalFormat().toICalString(kcalcEvent).toUtf8());
 }
 
 /******************************************************************************
@@ -316,9 +459,6 @@ bool DisplayCalendar::deleteEvent(const QString& eventID, bool saveit)
         {
             KAEvent* ev = it.value();
             mEventMap.erase(it);
-            int i = mEventList.indexOf(ev);
-            if (i >= 0)
-                mEventList.remove(i);
             delete ev;
         }
 
@@ -331,8 +471,10 @@ bool DisplayCalendar::deleteEvent(const QString& eventID, bool saveit)
 
         if (status != CalEvent::EMPTY)
         {
+            if (!appendJournal(JOURNAL_DELETE, id.toUtf8()))
+                return false;
             if (saveit)
-                return saveCal();
+                return save();
             return true;
         }
     }
@@ -354,6 +496,7 @@ KCalendarCore::Event::Ptr DisplayCalendar::kcalEvent(const QString& uniqueID)
 * Return all events in the calendar which contain usable alarms.
 * This method is for the display calendar only.
 * Optionally the event type can be filtered, using an OR of event types.
+* Events with usable alarms are exactly those held in the event map.
 */
 KCalendarCore::Event::List DisplayCalendar::kcalEvents(CalEvent::Type type)
 {
@@ -364,9 +507,8 @@ KCalendarCore::Event::List DisplayCalendar::kcalEvents(CalEvent::Type type)
     for (int i = 0;  i < list.count();  )
     {
         KCalendarCore::Event::Ptr event = list.at(i);
-        if (event->alarms().isEmpty()
-        ||  (type != CalEvent::EMPTY  &&  !(type & CalEvent::status(event)))
-        ||  !KAEvent(event).isValid())
+        if (!mEventMap.contains(event->uid())
+        ||  (type != CalEvent::EMPTY  &&  !(type & CalEvent::status(event))))
             list.remove(i);
         else
             ++i;
@@ -382,7 +524,7 @@ void DisplayCalendar::adjustStartOfDay()
 {
     if (!isValid())
         return;
-    KAEvent::adjustStartOfDay(mEventList);
+    KAEvent::adjustStartOfDay(mEventMap.values());
 }
 
 // vim: et sw=4:
@@ -15,12 +15,19 @@
 
 #include <QHash>
 
+class QFile;
+
 using namespace KAlarmCal;
 
 
 /** Provides read and write access to the display calendar.
  *  This stores alarms currently being displayed, to enable them to be
  *  redisplayed if KAlarm is killed and restarted.
+ *
+ *  Additions and deletions are not written to the calendar file when they are
+ *  made, but are appended to a journal file. The journal is replayed when the
+ *  calendar is opened, and merged into the calendar file when it is closed or
+ *  when the journal becomes large.
  */
 class DisplayCalendar
 {
@@ -45,13 +52,18 @@ private:
     static bool                       saveCal(const QString& newFile = QString());
     static bool                       isValid()    { return !mCalendarStorage.isNull(); }
     static void                       updateKAEvents();
+    static int                        replayJournal();
+    static bool                       appendJournal(char action, const QByteArray& data);
+    static bool                       compact();
 
     static bool                       mInitialised;        // whether the calendar has been initialised
-    static KAEvent::List              mEventList;
-    static QHash<QString, KAEvent*>   mEventMap;           // lookup of all events by UID
+    static QHash<QString, KAEvent*>   mEventMap;           // all events, indexed by UID
     static KCalendarCore::FileStorage::Ptr mCalendarStorage;
     static QString                    mDisplayCalPath;     // path of display calendar file
     static QString                    mDisplayICalPath;    // path of display iCalendar file
+    static QString                    mJournalPath;        // path of journal file
+    static QFile*                     mJournal;            // journal file, if open for appending
+    static int                        mJournalCount;       // number of records in journal file
     static CalType                    mCalType;            // mCalendar's type (ical/vcal)
     static bool                       mOpen;               // true if the calendar file is open
 };
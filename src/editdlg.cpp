@@ -636,7 +636,8 @@ void EditAlarmDlg::initValues(const KAEvent& event)
     if (!deferGroupVisible  &&  mDeferGroup)
         mDeferGroup->hide();
 
-    bool empty = ResourcesCalendar::events(CalEvent::TEMPLATE).isEmpty();
+    bool empty = !ResourcesCalendar::haveEvents(CalEvent::TEMPLATE)
+             &&  !Resources::haveDeferredEvents(CalEvent::TEMPLATE);
     if (mLoadTemplateButton)
         mLoadTemplateButton->setEnabled(!empty);
 }
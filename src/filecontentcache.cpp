@@ -0,0 +1,317 @@
+/*
+ *  filecontentcache.cpp  -  cache of the contents of files displayed by alarms
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "filecontentcache.h"
+
+#include "mainwindow.h"
+#include "kalarm_debug.h"
+
+#include <KIO/StatJob>
+#include <KIO/StoredTransferJob>
+#include <KJobWidgets>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMimeDatabase>
+#include <QStringDecoder>
+#include <QTemporaryFile>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QThreadPool>
+#include <QUrl>
+using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+const int MAX_CACHE_KBYTES = 32 * 1024;    // maximum total size of cached files
+
+int entryCost(const FileContentCache::Content& content)
+{
+    return static_cast<int>((content.data.size() + content.text.size() * sizeof(QChar)) / 1024) + 1;
+}
+
+File::Type contentType(const QString& path, const QByteArray& data)
+{
+    QMimeDatabase db;
+    QMimeType mime = db.mimeTypeForFile(path, QMimeDatabase::MatchExtension);
+    if (mime.isDefault())
+        mime = db.mimeTypeForData(data);
+    return File::fileType(mime);
+}
+
+/******************************************************************************
+* Write image data to a new temporary file.
+* Reply = the temporary file, or null if it could not be written.
+*/
+std::shared_ptr<QTemporaryFile> writeImageFile(const QByteArray& data)
+{
+    auto file = std::make_shared<QTemporaryFile>();
+    if (!file->open()  ||  file->write(data) != data.size())
+    {
+        qCWarning(KALARM_LOG) << "FileContentCache: Error writing temporary image file";
+        return {};
+    }
+    file->close();   // keep the file available to be displayed
+    return file;
+}
+
+/******************************************************************************
+* Convert the contents of a formatted text file to HTML, using the character
+* encoding declared in the file. Relative image references are resolved
+* against the file's folder, so that the images can still be found when the
+* HTML is displayed.
+* This uses fonts, so it must be called in the GUI thread.
+*/
+QString formattedText(const QByteArray& data, const QUrl& url)
+{
+    QStringDecoder decoder = QStringDecoder::decoderForHtml(data);
+    const QString html = decoder.isValid() ? QString(decoder.decode(data)) : QString::fromUtf8(data);
+    const QUrl baseUrl = url.adjusted(QUrl::RemoveFilename);
+    QTextDocument doc;
+    doc.setBaseUrl(baseUrl);
+    doc.setHtml(html);
+
+    // Find the relative image references before changing any, since changing
+    // a fragment's format invalidates the fragments.
+    struct Image { int position; int length; QTextImageFormat format; };
+    QList<Image> images;
+    for (QTextBlock block = doc.begin();  block.isValid();  block = block.next())
+    {
+        for (auto it = block.begin();  !it.atEnd();  ++it)
+        {
+            const QTextFragment fragment = it.fragment();
+            const QTextImageFormat format = fragment.charFormat().toImageFormat();
+            if (format.isValid()  &&  QUrl(format.name()).isRelative())
+                images += Image{fragment.position(), fragment.length(), format};
+        }
+    }
+    QTextCursor cursor(&doc);
+    for (Image& image : images)
+    {
+        image.format.setName(baseUrl.resolved(QUrl(image.format.name())).toString());
+        cursor.setPosition(image.position);
+        cursor.setPosition(image.position + image.length, QTextCursor::KeepAnchor);
+        cursor.setCharFormat(image.format);
+    }
+    return doc.toHtml();
+}
+}
+
+FileContentCache* FileContentCache::mInstance {nullptr};
+
+FileContentCache::FileContentCache()
+    : mCache(MAX_CACHE_KBYTES)
+{
+}
+
+FileContentCache::~FileContentCache()
+{
+    mInstance = nullptr;
+}
+
+FileContentCache* FileContentCache::instance()
+{
+    if (!mInstance)
+        mInstance = new FileContentCache;
+    return mInstance;
+}
+
+/******************************************************************************
+* Fetch the contents of a file.
+* A local file is taken from the cache if it is up to date, otherwise it is
+* read and added to the cache.
+*/
+FileContentCache::Status FileContentCache::content(const QUrl& url, Content& content)
+{
+    if (!url.isLocalFile())
+        return fetchRemote(url, content);
+
+    FileContentCache* cache = instance();
+    const QString path = url.toLocalFile();
+    std::unique_ptr<Entry> uncached;   // owns the entry if it is too big to cache
+    Entry* entry = cache->cached(path);
+    if (!entry)
+    {
+        entry = readLocalFile(path);
+        const Status status = entry->status;
+        if (status != Status::Ok)
+        {
+            delete entry;
+            return status;
+        }
+        if (!cache->canCache(entry))
+        {
+            qCDebug(KALARM_LOG) << "FileContentCache::content: Too big to cache" << path;
+            uncached.reset(entry);
+        }
+        else
+            cache->insert(path, entry);
+    }
+    else
+        qCDebug(KALARM_LOG) << "FileContentCache::content: Using cached" << path;
+
+    if (entry->content.type == File::Type::TextFormatted  &&  !entry->htmlDone)
+    {
+        // Convert formatted text to HTML. This uses fonts, so it must be done
+        // in the GUI thread.
+        entry->content.text = formattedText(entry->content.data, url);
+        entry->htmlDone = true;
+    }
+    if (entry->content.type == File::Type::Image  &&  !entry->content.imageFile)
+    {
+        // Write the image to a temporary file once, for it to be displayed
+        // from, and reuse the file until the cache entry is discarded.
+        entry->content.imageFile = writeImageFile(entry->content.data);
+        if (!entry->content.imageFile)
+            return Status::Unreadable;
+    }
+    content = entry->content;
+    return Status::Ok;
+}
+
+/******************************************************************************
+* Read a local file into the cache in a background thread, if it isn't already
+* cached and up to date.
+*/
+void FileContentCache::prefetch(const QString& fileName)
+{
+    const QUrl url = QUrl::fromUserInput(fileName, QString(), QUrl::AssumeLocalFile);
+    if (!url.isLocalFile())
+        return;
+    FileContentCache* cache = instance();
+    const QString path = url.toLocalFile();
+    if (cache->mPending.contains(path)  ||  cache->cached(path))
+        return;
+
+    qCDebug(KALARM_LOG) << "FileContentCache::prefetch:" << path;
+    cache->mPending.insert(path);
+    QThreadPool::globalInstance()->start([cache, path]()
+    {
+        Entry* entry = readLocalFile(path);
+        QMetaObject::invokeMethod(cache, [cache, path, entry]()
+        {
+            cache->mPending.remove(path);
+            if (entry->status == Status::Ok  &&  cache->canCache(entry))
+                cache->insert(path, entry);
+            else
+                delete entry;
+        }, Qt::QueuedConnection);
+    });
+}
+
+/******************************************************************************
+* Return the cache entry for a file, provided that the file is unchanged since
+* it was cached. An out of date entry is removed.
+*/
+FileContentCache::Entry* FileContentCache::cached(const QString& path)
+{
+    Entry* entry = mCache.object(path);
+    if (!entry)
+        return nullptr;
+    const QFileInfo fi(path);
+    if (fi.exists()  &&  fi.size() == entry->size  &&  fi.lastModified() == entry->modified)
+        return entry;
+    mCache.remove(path);
+    return nullptr;
+}
+
+/******************************************************************************
+* Return whether a file's contents are small enough to be cached.
+* QCache deletes an entry which costs more than the whole cache, so it must
+* not be inserted.
+*/
+bool FileContentCache::canCache(const Entry* entry) const
+{
+    return entryCost(entry->content) <= mCache.maxCost();
+}
+
+/******************************************************************************
+* Add a file's contents to the cache. Ownership of 'entry' is transferred.
+*/
+void FileContentCache::insert(const QString& path, Entry* entry)
+{
+    mCache.insert(path, entry, entryCost(entry->content));
+}
+
+/******************************************************************************
+* Read and decode a local file.
+* This may be called in any thread, and must not access the cache.
+*/
+FileContentCache::Entry* FileContentCache::readLocalFile(const QString& path)
+{
+    auto entry = new Entry;
+    const QFileInfo fi(path);
+    if (!fi.exists())
+        return entry;
+    if (fi.isDir())
+    {
+        entry->status = Status::IsDirectory;
+        return entry;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        entry->status = Status::Unreadable;
+        return entry;
+    }
+    entry->size     = fi.size();
+    entry->modified = fi.lastModified();
+    entry->content.data = file.readAll();
+    entry->content.type = contentType(path, entry->content.data);
+    switch (entry->content.type)
+    {
+        case File::Type::Image:
+        case File::Type::TextFormatted:
+            break;
+        default:
+            entry->content.text = QString::fromUtf8(entry->content.data);
+            break;
+    }
+    entry->status = Status::Ok;
+    return entry;
+}
+
+/******************************************************************************
+* Fetch a remote file's contents, without caching them.
+*/
+FileContentCache::Status FileContentCache::fetchRemote(const QUrl& url, Content& content)
+{
+    auto statJob = KIO::stat(url, KIO::StatJob::SourceSide, KIO::StatBasic, KIO::HideProgressInfo);
+    if (!statJob->exec())
+        return Status::NotFound;
+    if (statJob->statResult().isDir())
+        return Status::IsDirectory;
+
+    auto job = KIO::storedGet(url);
+    KJobWidgets::setWindow(job, MainWindow::mainMainWindow());
+    if (!job->exec())
+        return Status::Unreadable;
+    content.data = job->data();
+    content.type = contentType(url.path(), content.data);
+    switch (content.type)
+    {
+        case File::Type::Image:
+            content.text.clear();
+            content.imageFile = writeImageFile(content.data);
+            if (!content.imageFile)
+                return Status::Unreadable;
+            break;
+        case File::Type::TextFormatted:
+            content.text = formattedText(content.data, url);
+            break;
+        default:
+            content.text = QString::fromUtf8(content.data);
+            break;
+    }
+    return Status::Ok;
+}
+
+#include "moc_filecontentcache.cpp"
+
+// vim: et sw=4:
@@ -0,0 +1,91 @@
+/*
+ *  filecontentcache.h  -  cache of the contents of files displayed by alarms
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "lib/file.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QDateTime>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+#include <memory>
+
+class QTemporaryFile;
+class QUrl;
+
+/**
+ * Provides the contents of files to be displayed by file display alarms.
+ *
+ * The contents of local files are cached, keyed by the file path, and are
+ * reused for as long as the file's size and modification time are unchanged.
+ * A file can be read into the cache in a background thread before its alarm is
+ * due, by prefetch(). Remote files, and local files too big to cache, are read
+ * each time they are requested.
+ *
+ * Images are displayed from a temporary copy of the image file, which for
+ * cached files is written once and kept with the cache entry.
+ */
+class FileContentCache : public QObject
+{
+    Q_OBJECT
+public:
+    /** Result of fetching a file's contents. */
+    enum class Status { Ok, NotFound, IsDirectory, Unreadable };
+
+    /** The contents of a file. */
+    struct Content
+    {
+        QByteArray data;        // the file's raw contents
+        QString    text;        // decoded text (HTML if formatted text), or empty if an image
+        std::shared_ptr<QTemporaryFile> imageFile;   // copy of image to display it from, or null if not an image
+        File::Type type {File::Type::Unknown};
+    };
+
+    ~FileContentCache() override;
+
+    /** Fetch the contents of a file, using the cache if possible.
+     *  This reads the file synchronously if it is not already cached.
+     *  @param url      The file's URL.
+     *  @param content  Updated to contain the file's contents, if Status::Ok.
+     */
+    static Status content(const QUrl& url, Content& content);
+
+    /** Read a file into the cache in a background thread, unless it is
+     *  already cached and up to date. Remote files are ignored.
+     *  @param fileName  The file path or URL, in user input format.
+     */
+    static void prefetch(const QString& fileName);
+
+private:
+    struct Entry
+    {
+        Content   content;
+        QDateTime modified;     // file's modification time when it was read
+        qint64    size {-1};    // file's size when it was read
+        Status    status {Status::NotFound};
+        bool      htmlDone {false};  // formatted text has been converted to HTML
+    };
+
+    FileContentCache();
+    static FileContentCache* instance();
+    static Entry* readLocalFile(const QString& path);
+    static Status fetchRemote(const QUrl& url, Content& content);
+    bool          canCache(const Entry*) const;
+    void          insert(const QString& path, Entry*);
+    Entry*        cached(const QString& path);
+
+    static FileContentCache* mInstance;
+    QCache<QString, Entry>   mCache;      // cached files, keyed by path
+    QSet<QString>            mPending;    // files currently being read by prefetch()
+};
+
+// vim: et sw=4:
@@ -10,6 +10,7 @@
 
 #include "alarmlistview.h"
 #include "eventlistview.h"
+#include "findindex.h"
 #include "preferences.h"
 #include "resources/eventmodel.h"
 #include "lib/messagebox.h"
@@ -29,6 +30,9 @@
 #include <QVBoxLayout>
 #include <QGridLayout>
 #include <QRegularExpression>
+
+#include <algorithm>
+#include <functional>
 using namespace Qt::Literals::StringLiterals;
 
 using namespace KAlarmCal;
@@ -291,6 +295,21 @@ void Find::findNext(bool forward, bool checkEnd, bool fromCurrent)
     QModelIndex index;
     if (!mNoCurrentItem)
         index = mListView->selectionModel()->currentIndex();
+
+    if (!(mOptions & KFind::RegularExpression))
+    {
+        // Use the text index to find which alarms could possibly match, and
+        // search only those.
+        bool all;
+        const QSet<QString> candidates = FindIndex::instance()->candidates(mLastPattern, all);
+        if (!all)
+        {
+            index = findNextCandidate(candidates, index, forward, fromCurrent);
+            processResult(index, forward, checkEnd);
+            return;
+        }
+    }
+
     if (!fromCurrent)
         index = nextItem(index, forward);
 
@@ -299,77 +318,142 @@ void Find::findNext(bool forward, bool checkEnd, bool fromCurrent)
     bool last = false;
     for ( ;  index.isValid() && !last;  index = nextItem(index, forward))
     {
-        const KAEvent viewEvent = mListView->event(index);
-        const KAEvent* event = &viewEvent;
-        if (!fromCurrent  &&  !mStartID.isNull()  &&  mStartID == event->id())
+        const KAEvent event = mListView->event(index);
+        if (!fromCurrent  &&  !mStartID.isNull()  &&  mStartID == event.id())
             last = true;    // we've wrapped round and reached the starting alarm again
         fromCurrent = false;
-        const bool live = !event->expired();
-        if ((live  &&  !(mOptions & FIND_LIVE))
-        ||  (!live  &&  !(mOptions & FIND_ARCHIVED)))
-            continue;     // we're not searching this type of alarm
-        switch (event->actionTypes())
+        found = matches(event);
+        if (found)
+            break;
+    }
+    processResult(found ? index : QModelIndex(), forward, checkEnd);
+}
+
+/******************************************************************************
+* Search the candidate alarms returned by the text index, in list order
+* starting from 'index', until a match is found or the end is reached.
+* Reply = index of the matching alarm, or invalid if none.
+*/
+QModelIndex Find::findNextCandidate(const QSet<QString>& candidates, const QModelIndex& index, bool forward, bool fromCurrent)
+{
+    if (candidates.isEmpty())
+        return {};
+    const EventListModel* model = mListView->itemModel();
+    if (mOptions & KFind::FindBackwards)
+        forward = !forward;
+
+    // Find the list rows of the candidate alarms, in search order.
+    QList<int> rows;
+    rows.reserve(candidates.size());
+    for (const QString& id : candidates)
+    {
+        const QModelIndex ix = model->eventIndex(id);
+        if (ix.isValid())
+            rows += ix.row();
+    }
+    if (forward)
+        std::sort(rows.begin(), rows.end());
+    else
+        std::sort(rows.begin(), rows.end(), std::greater<int>());
+
+    // Returns whether row1 comes after row2 in search order.
+    auto after = [forward](int row1, int row2) { return forward ? row1 > row2 : row1 < row2; };
+
+    const int currentRow = index.isValid() ? index.row() : -1;
+    int startRow = -1;
+    if (!mStartID.isNull())
+    {
+        // If the search has wrapped round, or is about to, stop after
+        // checking the starting alarm.
+        const QModelIndex ix = model->eventIndex(mStartID);
+        if (ix.isValid()  &&  (currentRow < 0  ||  after(ix.row(), currentRow)))
+            startRow = ix.row();
+    }
+
+    for (int row : std::as_const(rows))
+    {
+        if (currentRow >= 0)
         {
-            case KAEvent::Action::Email:
-                if (!(mOptions & FIND_EMAIL))
-                    break;
-                mFind->setData(event->emailAddresses(QStringLiteral(", ")));
-                found = (mFind->find() == KFind::Match);
-                if (found)
-                    break;
-                mFind->setData(event->emailSubject());
-                found = (mFind->find() == KFind::Match);
-                if (found)
-                    break;
-                mFind->setData(event->emailAttachments().join(", "_L1));
-                found = (mFind->find() == KFind::Match);
-                if (found)
-                    break;
-                mFind->setData(event->cleanText());
-                found = (mFind->find() == KFind::Match);
-                break;
+            if (row == currentRow ? !fromCurrent : !after(row, currentRow))
+                continue;
+        }
+        if (startRow >= 0  &&  after(row, startRow))
+            break;
+        const QModelIndex ix = model->index(row, 0);
+        if (matches(mListView->event(ix)))
+            return ix;
+    }
+    return {};
+}
 
-            case KAEvent::Action::Audio:
-                if (!(mOptions & FIND_AUDIO))
-                    break;
-                mFind->setData(event->audioFile());
-                found = (mFind->find() == KFind::Match);
+/******************************************************************************
+* Check whether an alarm is of a type being searched, and if so, whether it
+* matches the search pattern.
+*/
+bool Find::matches(const KAEvent& event)
+{
+    const bool live = !event.expired();
+    if ((live  &&  !(mOptions & FIND_LIVE))
+    ||  (!live  &&  !(mOptions & FIND_ARCHIVED)))
+        return false;     // we're not searching this type of alarm
+    switch (event.actionTypes())
+    {
+        case KAEvent::Action::Email:
+            if (!(mOptions & FIND_EMAIL))
                 break;
+            mFind->setData(event.emailAddresses(QStringLiteral(", ")));
+            if (mFind->find() == KFind::Match)
+                return true;
+            mFind->setData(event.emailSubject());
+            if (mFind->find() == KFind::Match)
+                return true;
+            mFind->setData(event.emailAttachments().join(", "_L1));
+            if (mFind->find() == KFind::Match)
+                return true;
+            mFind->setData(event.cleanText());
+            return mFind->find() == KFind::Match;
+
+        case KAEvent::Action::Audio:
+            if (!(mOptions & FIND_AUDIO))
+                break;
+            mFind->setData(event.audioFile());
+            return mFind->find() == KFind::Match;
 
-            case KAEvent::Action::Command:
-                if (!(mOptions & FIND_COMMAND))
-                    break;
-                mFind->setData(event->cleanText());
-                found = (mFind->find() == KFind::Match);
+        case KAEvent::Action::Command:
+            if (!(mOptions & FIND_COMMAND))
                 break;
+            mFind->setData(event.cleanText());
+            return mFind->find() == KFind::Match;
 
-            case KAEvent::Action::Display:
-                if (event->actionSubType() == KAEvent::SubAction::File)
-                {
-                    if (!(mOptions & FIND_FILE))
-                        break;
-                    mFind->setData(event->cleanText());
-                    found = (mFind->find() == KFind::Match);
-                    break;
-                }
-                // fall through to DisplayCommand
-                [[fallthrough]];
-            case KAEvent::Action::DisplayCommand:
-                if (!(mOptions & FIND_MESSAGE))
+        case KAEvent::Action::Display:
+            if (event.actionSubType() == KAEvent::SubAction::File)
+            {
+                if (!(mOptions & FIND_FILE))
                     break;
-                mFind->setData(event->cleanText());
-                found = (mFind->find() == KFind::Match);
-                break;
-            default:
+                mFind->setData(event.cleanText());
+                return mFind->find() == KFind::Match;
+            }
+            // fall through to DisplayCommand
+            [[fallthrough]];
+        case KAEvent::Action::DisplayCommand:
+            if (!(mOptions & FIND_MESSAGE))
                 break;
-        }
-        if (found)
+            mFind->setData(event.cleanText());
+            return mFind->find() == KFind::Match;
+        default:
             break;
     }
+    return false;
+}
 
-    // Process the search result
+/******************************************************************************
+* Process the search result.
+* 'index' is the matching alarm, or invalid if no match was found.
+*/
+void Find::processResult(const QModelIndex& index, bool forward, bool checkEnd)
+{
     mNoCurrentItem = !index.isValid();
-    if (found)
+    if (index.isValid())
     {
         // A matching alarm was found - highlight it and make it current
         mFound = true;
@@ -10,6 +10,7 @@
 
 #include <QObject>
 #include <QPointer>
+#include <QSet>
 #include <QStringList>
 #include <QModelIndex>
 
@@ -18,6 +19,7 @@ class KFindDialog;
 class KFind;
 class KSeparator;
 class EventListView;
+namespace KAlarmCal { class KAEvent; }
 
 
 class Find : public QObject
@@ -39,6 +41,9 @@ private Q_SLOTS:
 
 private:
     void        findNext(bool forward, bool checkEnd, bool fromCurrent);
+    QModelIndex findNextCandidate(const QSet<QString>& candidates, const QModelIndex&, bool forward, bool fromCurrent);
+    bool        matches(const KAlarmCal::KAEvent&);
+    void        processResult(const QModelIndex&, bool forward, bool checkEnd);
     QModelIndex nextItem(const QModelIndex&, bool forward) const;
 
     EventListView*     mListView;        // parent list view
@@ -0,0 +1,184 @@
+/*
+ *  findindex.cpp  -  text index to speed up the search facility
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "findindex.h"
+
+#include "resources/resources.h"
+#include "kalarm_debug.h"
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+const int TRIGRAM_LENGTH = 3;
+
+inline quint64 trigramKey(const QChar* chars)
+{
+    return (quint64(chars[0].unicode()) << 32) | (quint64(chars[1].unicode()) << 16) | chars[2].unicode();
+}
+}
+
+FindIndex* FindIndex::mInstance = nullptr;
+
+FindIndex* FindIndex::instance()
+{
+    if (!mInstance)
+        mInstance = new FindIndex;
+    return mInstance;
+}
+
+/******************************************************************************
+* Constructor. Index the events in all resources which have already been
+* loaded, and connect to resource notifications to keep the index up to date.
+*/
+FindIndex::FindIndex()
+    : QObject()
+{
+    Resources* resources = Resources::instance();
+    connect(resources, &Resources::eventsAdded, this, &FindIndex::slotEventsAdded);
+    connect(resources, &Resources::eventUpdated, this, &FindIndex::slotEventUpdated);
+    connect(resources, &Resources::eventsRemoved, this, &FindIndex::slotEventsRemoved);
+    connect(resources, &Resources::resourceRemoved, this, &FindIndex::slotResourceRemoved);
+
+    const QList<Resource> allResources = Resources::allResources();
+    for (const Resource& resource : allResources)
+    {
+        const QList<KAEvent> events = resource.events();
+        for (const KAEvent& event : events)
+            addEvent(resource.id(), event);
+    }
+    qCDebug(KALARM_LOG) << "FindIndex: indexed" << mEventTrigrams.count() << "events";
+}
+
+/******************************************************************************
+* Find which alarms may contain a plain text pattern.
+*/
+QSet<QString> FindIndex::candidates(const QString& pattern, bool& all) const
+{
+    const QSet<quint64> patternTrigrams = trigrams(pattern);
+    all = patternTrigrams.isEmpty();
+    if (all)
+        return {};
+
+    // Start with the rarest trigram, to minimise the work in intersecting.
+    QList<const QSet<QString>*> postings;
+    for (quint64 trigram : patternTrigrams)
+    {
+        auto it = mIndex.constFind(trigram);
+        if (it == mIndex.constEnd())
+            return {};    // no alarm contains this trigram
+        postings += &it.value();
+    }
+    std::sort(postings.begin(), postings.end(),
+              [](const QSet<QString>* a, const QSet<QString>* b) { return a->size() < b->size(); });
+    QSet<QString> result = *postings.at(0);
+    for (int i = 1, count = postings.count();  i < count && !result.isEmpty();  ++i)
+        result.intersect(*postings.at(i));
+    return result;
+}
+
+void FindIndex::slotEventsAdded(Resource& resource, const QList<KAEvent>& events)
+{
+    for (const KAEvent& event : events)
+        addEvent(resource.id(), event);
+}
+
+void FindIndex::slotEventUpdated(Resource& resource, const KAEvent& event)
+{
+    addEvent(resource.id(), event);
+}
+
+void FindIndex::slotEventsRemoved(Resource& resource, const QList<KAEvent>& events)
+{
+    QSet<QString>& resourceEvents = mResourceEvents[resource.id()];
+    for (const KAEvent& event : events)
+    {
+        removeEvent(event.id());
+        resourceEvents.remove(event.id());
+    }
+}
+
+void FindIndex::slotResourceRemoved(ResourceId id)
+{
+    const QSet<QString> eventIds = mResourceEvents.take(id);
+    for (const QString& eventId : eventIds)
+        removeEvent(eventId);
+}
+
+/******************************************************************************
+* Add an event to the index, replacing any existing index entries for it.
+*/
+void FindIndex::addEvent(ResourceId resourceId, const KAEvent& event)
+{
+    const QString id = event.id();
+    removeEvent(id);
+
+    // Combine all the fields which Find searches. Separate them with newlines,
+    // which cannot occur in a search pattern, so that no trigram spans two fields.
+    QString text = event.cleanText();
+    if (event.actionTypes() == KAEvent::Action::Email)
+    {
+        text += '\n'_L1 + event.emailAddresses(QStringLiteral(", "))
+             +  '\n'_L1 + event.emailSubject()
+             +  '\n'_L1 + event.emailAttachments().join(", "_L1);
+    }
+    else if (event.actionTypes() == KAEvent::Action::Audio)
+        text += '\n'_L1 + event.audioFile();
+
+    const QSet<quint64> eventTrigrams = trigrams(text);
+    QList<quint64>& trigramList = mEventTrigrams[id];
+    trigramList.reserve(eventTrigrams.size());
+    for (quint64 trigram : eventTrigrams)
+    {
+        mIndex[trigram].insert(id);
+        trigramList += trigram;
+    }
+    mResourceEvents[resourceId].insert(id);
+}
+
+/******************************************************************************
+* Remove an event from the index.
+*/
+void FindIndex::removeEvent(const QString& eventId)
+{
+    auto it = mEventTrigrams.find(eventId);
+    if (it == mEventTrigrams.end())
+        return;
+    for (quint64 trigram : std::as_const(it.value()))
+    {
+        auto ix = mIndex.find(trigram);
+        if (ix != mIndex.end())
+        {
+            ix.value().remove(eventId);
+            if (ix.value().isEmpty())
+                mIndex.erase(ix);
+        }
+    }
+    mEventTrigrams.erase(it);
+}
+
+/******************************************************************************
+* Return the set of case-folded trigrams contained in a text.
+*/
+QSet<quint64> FindIndex::trigrams(const QString& text)
+{
+    QSet<quint64> result;
+    const QString folded = text.toCaseFolded();
+    const QChar* chars = folded.constData();
+    for (int i = 0, end = folded.size() - TRIGRAM_LENGTH;  i <= end;  ++i)
+    {
+        if (chars[i] == '\n'_L1  ||  chars[i + 1] == '\n'_L1  ||  chars[i + 2] == '\n'_L1)
+            continue;
+        result.insert(trigramKey(chars + i));
+    }
+    return result;
+}
+
+#include "moc_findindex.cpp"
+
+// vim: et sw=4:
@@ -0,0 +1,67 @@
+/*
+ *  findindex.h  -  text index to speed up the search facility
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "resources/resource.h"
+#include "kalarmcalendar/kaevent.h"
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+
+using namespace KAlarmCal;
+
+/** FindIndex holds an index of the searchable text of all alarms, to allow
+ *  Find to check only those alarms which could contain the search text.
+ *
+ *  The text fields searched by Find (message text, command, file name, email
+ *  addresses, subject and attachments, audio file) are folded to lower case
+ *  and split into overlapping three-character sequences (trigrams). A pattern
+ *  can only occur in an alarm whose text contains every trigram of the
+ *  pattern. The candidate alarms must then be checked properly, to apply the
+ *  search options and confirm the match.
+ *
+ *  The index is created when first used, and is then kept up to date from
+ *  resource event notifications.
+ */
+class FindIndex : public QObject
+{
+    Q_OBJECT
+public:
+    /** Return the unique instance, creating and populating it if necessary. */
+    static FindIndex* instance();
+
+    /** Find which alarms may contain a plain text pattern, ignoring case.
+     *  @param pattern  the text to search for.
+     *  @param all      set true if the pattern is too short for the index to
+     *                  restrict the search, in which case all alarms must be
+     *                  searched and the returned set is empty.
+     *  @return IDs of the alarms which may contain @p pattern.
+     */
+    QSet<QString> candidates(const QString& pattern, bool& all) const;
+
+private Q_SLOTS:
+    void slotEventsAdded(Resource&, const QList<KAlarmCal::KAEvent>&);
+    void slotEventUpdated(Resource&, const KAlarmCal::KAEvent&);
+    void slotEventsRemoved(Resource&, const QList<KAlarmCal::KAEvent>&);
+    void slotResourceRemoved(KAlarmCal::ResourceId);
+
+private:
+    FindIndex();
+    void addEvent(ResourceId, const KAEvent&);
+    void removeEvent(const QString& eventId);
+    static QSet<quint64> trigrams(const QString& text);
+
+    static FindIndex* mInstance;
+    QHash<quint64, QSet<QString>>    mIndex;           // IDs of events containing each trigram
+    QHash<QString, QList<quint64>>   mEventTrigrams;   // trigrams contained in each event
+    QHash<ResourceId, QSet<QString>> mResourceEvents;  // IDs of indexed events in each resource
+};
+
+// vim: et sw=4:
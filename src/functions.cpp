@@ -281,7 +281,7 @@ UpdateResult addEvent(KAEvent& event, Resource& resource, QWidget* msgParent, in
 * The events are updated with their actual event IDs.
 */
 UpdateResult addEvents(QList<KAEvent>& events, Resource& resource, QWidget* msgParent,
-                       bool allowKOrgUpdate, bool showKOrgErr)
+                       bool allowKOrgUpdate, bool showKOrgErr, int options)
 {
     qCDebug(KALARM_LOG) << "KAlarm::addEvents:" << events.count();
     if (events.isEmpty())
@@ -291,8 +291,17 @@ UpdateResult addEvents(QList<KAEvent>& events, Resource& resource, QWidget* msgP
         status.status = UPDATE_FAILED;
     else
     {
+        ResourcesCalendar::AddEventOptions rc_options = {};
+        Resources::DestOptions destOptions {};
+        if (options & USE_EVENT_ID)
+            rc_options |= ResourcesCalendar::UseEventId;
+        if (options & NO_RESOURCE_PROMPT)
+        {
+            rc_options  |= ResourcesCalendar::NoResourcePrompt;
+            destOptions |= Resources::NoResourcePrompt;
+        }
         if (!resource.isValid())
-            resource = Resources::destination(CalEvent::ACTIVE, msgParent);
+            resource = Resources::destination(CalEvent::ACTIVE, msgParent, destOptions);
         if (!resource.isValid())
         {
             qCDebug(KALARM_LOG) << "KAlarm::addEvents: No calendar";
@@ -304,7 +313,7 @@ UpdateResult addEvents(QList<KAEvent>& events, Resource& resource, QWidget* msgP
             {
                 // Save the event details in the calendar file, and get the new event ID
                 KAEvent& event = events[i];
-                if (!ResourcesCalendar::addEvent(event, resource, msgParent))
+                if (!ResourcesCalendar::addEvent(event, resource, msgParent, rc_options))
                 {
                     status.appendFailed(i);
                     status.setError(UPDATE_ERROR);
@@ -874,17 +883,22 @@ void purgeArchive(int purgeDays)
         return;
     qCDebug(KALARM_LOG) << "KAlarm::purgeArchive:" << purgeDays;
     const QDate cutoff = KADateTime::currentLocalDate().addDays(-purgeDays);
-    const Resource resource = Resources::getStandard(CalEvent::ARCHIVED, true);
+    Resource resource = Resources::getStandard(CalEvent::ARCHIVED, true);
     if (!resource.isValid())
         return;
-    QList<KAEvent> events = ResourcesCalendar::events(resource);
-    for (int i = 0;  i < events.count();  )
-    {
-        if (purgeDays  &&  events.at(i).createdDateTime().date() >= cutoff)
-            events.remove(i);
-        else
-            ++i;
-    }
+    // If the resource stores its events in time-based segments, delete whole
+    // expired segments first, so that their events don't need to be loaded.
+    // Ensure that any other events which may need purging are loaded.
+    resource.prepareArchivePurge(cutoff);
+    QList<KAEvent> events;
+    ResourcesCalendar::EventFilter filter;
+    filter.types = CalEvent::ARCHIVED;
+    ResourcesCalendar::forEachEvent(filter, [&](const KAEvent& event)
+    {
+        if (!purgeDays  ||  event.createdDateTime().date() < cutoff)
+            events += event;
+        return true;
+    }, resource);
     if (!events.isEmpty())
         ResourcesCalendar::purgeEvents(events);   // delete the events and save the calendar
 }
@@ -1665,23 +1679,6 @@ void updateEditedAlarm(EditAlarmDlg* editDlg, KAEvent& event, Resource& resource
     editDlg->close();
 }
 
-/******************************************************************************
-* Returns a list of all alarm templates.
-* If shell commands are disabled, command alarm templates are omitted.
-*/
-QList<KAEvent> templateList()
-{
-    QList<KAEvent> templates;
-    const bool includeCmdAlarms = ShellProcess::authorised();
-    const QList<KAEvent> events = ResourcesCalendar::events(CalEvent::TEMPLATE);
-    for (const KAEvent& event : events)
-    {
-        if (includeCmdAlarms  ||  !(event.actionTypes() & KAEvent::Action::Command))
-            templates.append(event);
-    }
-    return templates;
-}
-
 /******************************************************************************
 * To be called after an alarm has been edited.
 * Prompt the user to re-enable alarms if they are currently disabled, and if
@@ -1728,19 +1725,26 @@ void refreshAlarmsIfQueued()
     if (refreshAlarmsQueued)
     {
         qCDebug(KALARM_LOG) << "KAlarm::refreshAlarmsIfQueued";
+        // Reloading only notifies events which have changed. Note any display
+        // alarms which are now disabled.
+        QList<EventId> disabledIds;
+        const QMetaObject::Connection connection = QObject::connect(Resources::instance(), &Resources::eventUpdated,
+                                                                    [&disabledIds](Resource&, const KAEvent& event)
+        {
+            if (!event.enabled()  &&  event.category() == CalEvent::ACTIVE
+            &&  (event.actionTypes() & KAEvent::Action::Display))
+                disabledIds += EventId(event);
+        });
         QList<Resource> resources = Resources::enabledResources();
         for (Resource& resource : resources)
             resource.reload();
+        QObject::disconnect(connection);
 
         // Close any message displays for alarms which are now disabled
-        const QList<KAEvent> events = ResourcesCalendar::events(CalEvent::ACTIVE);
-        for (const KAEvent& event : events)
+        for (const EventId& id : std::as_const(disabledIds))
         {
-            if (!event.enabled()  &&  (event.actionTypes() & KAEvent::Action::Display))
-            {
-                MessageDisplay* win = MessageDisplay::findEvent(EventId(event));
-                delete win;
-            }
+            MessageDisplay* win = MessageDisplay::findEvent(id);
+            delete win;
         }
 
         refreshAlarmsQueued = false;
@@ -93,10 +93,6 @@ void           execNewAlarmDlg(EditAlarmDlg*, const QDate& startDate = QDate());
 KToggleAction* createAlarmEnableAction(QObject* parent);
 QAction*       createStopPlayAction(QObject* parent);
 KToggleAction* createSpreadWindowsAction(QObject* parent);
-/** Returns a list of all alarm templates.
- *  If shell commands are disabled, command alarm templates are omitted.
- */
-QList<KAEvent> templateList();
 void           outputAlarmWarnings(QWidget* parent, const KAEvent* = nullptr);
 void           refreshAlarms();
 void           refreshAlarmsIfQueued();    // must only be called from KAlarmApp::processQueue()
@@ -132,10 +128,12 @@ UpdateResult addEvent(KAEvent& event, Resource& resource, QWidget* msgParent = n
  *                    'resource' is updated with the actual resource used.
  *  @param msgParent  Parent widget for any calendar selection prompt or error
  *                    message.
+ *  @param options    USE_EVENT_ID and/or NO_RESOURCE_PROMPT. (KOrganizer updates
+ *                    are controlled by @p allowKOrgUpdate.)
  *  @return  Success status; if >= UPDATE_FAILED, all new alarms have been discarded.
  */
 UpdateResult addEvents(QList<KAEvent>& events, Resource& resource, QWidget* msgParent = nullptr,
-                       bool allowKOrgUpdate = true, bool showKOrgErr = true);
+                       bool allowKOrgUpdate = true, bool showKOrgErr = true, int options = 0);
 
 /** Save the event in the archived calendar.
  *  The event's ID is changed to an archived ID if necessary.
@@ -13,6 +13,7 @@
 #include "dbushandler.h"
 #include "displaycalendar.h"
 #include "editdlgtypes.h"
+#include "filecontentcache.h"
 #include "functions.h"
 #include "kamail.h"
 #include "mainwindow.h"
@@ -20,12 +21,16 @@
 #include "messagewindow.h"
 #include "pluginmanager.h"
 #include "resourcescalendar.h"
+#include "simulationworkload.h"
 #include "startdaytimer.h"
 #include "traywindow.h"
 #include "resources/datamodel.h"
+#include "resources/eventmodel.h"
+#include "resources/resourcedatamodelbase.h"
 #include "resources/resources.h"
 #include "lib/desktop.h"
 #include "lib/messagebox.h"
+#include "lib/virtualclock.h"
 #include "notifications_interface.h" // DBUS-generated
 #include "dbusproperties.h"          // DBUS-generated
 #include "kalarmcalendar/datetime.h"
@@ -41,6 +46,7 @@
 #include <KStandardGuiItem>
 #include <KWindowSystem>
 #include <KShell>
+#include <KCalendarCore/CalFormat>
 
 #include <QObject>
 #include <QTimer>
@@ -60,24 +66,13 @@ using namespace Qt::Literals::StringLiterals;
 namespace
 {
 const int RESOURCES_TIMEOUT = 30;   // timeout (seconds) for resources to be populated
+const qint64 FILE_PREFETCH_TIME = 120000;   // time (ms) before a file alarm is due to read the file
 
 const char FDO_NOTIFICATIONS_SERVICE[] = "org.freedesktop.Notifications";
 const char FDO_NOTIFICATIONS_PATH[]    = "/org/freedesktop/Notifications";
 
 const QLatin1StringView GENERAL_GROUP("General");
 
-/******************************************************************************
-* Find the maximum number of seconds late which a late-cancel alarm is allowed
-* to be. This is calculated as the late cancel interval, plus a few seconds
-* leeway to cater for any timing irregularities.
-*/
-inline int maxLateness(int lateCancel)
-{
-    static const int LATENESS_LEEWAY = 5;
-    int lc = (lateCancel >= 1) ? (lateCancel - 1)*60 : 0;
-    return LATENESS_LEEWAY + lc;
-}
-
 QWidget* mainWidget()
 {
     return MainWindow::mainMainWindow();
@@ -421,7 +416,10 @@ int KAlarmApp::activateInstance(const QStringList& args, const QString& workingD
     {
         options->process();
 #ifndef NDEBUG
-        if (options->simulationTime().isValid())
+        if (options->simulationEndTime().isValid())
+            startSimulation((options->simulationTime().isValid() ? options->simulationTime() : KADateTime::currentLocalDateTime()),
+                            options->simulationEndTime(), options->simulationWorkload());
+        else if (options->simulationTime().isValid())
             KAlarm::setSimulatedSystemTime(options->simulationTime());
 #endif
         CommandOptions::Command command = options->command();
@@ -807,6 +805,7 @@ bool KAlarmApp::quitIf(int exitCode, bool force, bool restoringSession)
         KAlarm::deleteRtcWakeConfig();
     }
 #endif
+    VirtualClock::stopTimer(mAlarmTimer);
     delete mAlarmTimer;     // prevent checking for alarms after deleting calendars
     mAlarmTimer = nullptr;
     mInitialised = false;   // prevent processQueue() from running
@@ -898,7 +897,10 @@ void KAlarmApp::checkNextDueAlarm()
     KADateTime nextDt;
     const KAEvent nextEvent = ResourcesCalendar::earliestAlarm(nextDt, mNotificationsInhibited);
     if (!nextEvent.isValid())
+    {
+        VirtualClock::stopTimer(mAlarmTimer);
         return;   // there are no alarms pending
+    }
     const KADateTime now = KADateTime::currentDateTime(Preferences::timeSpec());
     qint64 interval = now.msecsTo(nextDt);
     qCDebug(KALARM_LOG) << "KAlarmApp::checkNextDueAlarm: now:" << qPrintable(now.toString(QStringLiteral("%Y-%m-%d %H:%M %:Z"))) << ", next:" << qPrintable(nextDt.toString(QStringLiteral("%Y-%m-%d %H:%M %:Z"))) << ", due:" << interval;
@@ -911,6 +913,19 @@ void KAlarmApp::checkNextDueAlarm()
     }
     else
     {
+        // If the alarm displays a file, read the file in advance so that it
+        // can be displayed without delay.
+        if (interval <= FILE_PREFETCH_TIME  &&  nextEvent.actionSubType() == KAEvent::SubAction::File)
+            FileContentCache::prefetch(nextEvent.cleanText());
+
+        if (VirtualClock::isActive())
+        {
+            // Simulating: wake when the virtual clock reaches the alarm time.
+            qCDebug(KALARM_LOG) << "KAlarmApp::checkNextDueAlarm:" << nextEvent.id() << "wait for virtual clock";
+            VirtualClock::startTimer(mAlarmTimer, nextDt);
+            return;
+        }
+
         // No alarm is due yet, so set timer to wake us when it's due.
         // Check for integer overflow before setting timer.
 #ifndef HIBERNATION_SIGNAL
@@ -968,6 +983,59 @@ void KAlarmApp::startProcessQueue(bool evenIfStarted)
     }
 }
 
+/******************************************************************************
+* Start a simulation, in which alarms are scheduled from a virtual clock running
+* from startTime to endTime, and are recorded instead of being executed.
+* Any synthetic alarms in 'workload' are added to the calendar in a single batch
+* before the clock starts to advance.
+*/
+void KAlarmApp::startSimulation(const KADateTime& startTime, const KADateTime& endTime, const SimulationWorkload& workload)
+{
+    if (!VirtualClock::start(startTime, endTime))
+    {
+        std::cerr << "Time simulation is not available in this build" << std::endl;
+        return;
+    }
+    qCDebug(KALARM_LOG) << "KAlarmApp::startSimulation:" << startTime << "to" << endTime;
+    VirtualClock::setBusyFunction([this]() { return mProcessingQueue  ||  !mActionQueue.isEmpty(); });
+    connect(VirtualClock::instance(), &VirtualClock::finished, this, &KAlarmApp::slotSimulationFinished);
+    if (!workload.isEmpty())
+    {
+        // Add the alarms through the action queue, so that they are not added
+        // until the resources have been populated.
+        mActionQueue.enqueue(ActionQEntry(workload.createEvents(startTime)));
+        if (mInitialised)
+            QTimer::singleShot(0, this, &KAlarmApp::processQueue);   //NOLINT(clang-analyzer-cplusplus.NewDeleteLeaks)
+    }
+}
+
+/******************************************************************************
+* Called when a simulation has reached its end time.
+* Output the simulation statistics, and quit.
+*/
+void KAlarmApp::slotSimulationFinished()
+{
+    const VirtualClock::Statistics& stats = VirtualClock::instance()->statistics();
+    std::cout << "Simulation finished:\n"
+              << "  Alarms triggered: " << stats.triggered()
+              << " (display " << stats.display << ", command " << stats.command
+              << ", email " << stats.email << ", audio " << stats.audio << ")\n"
+              << "  Late alarms: " << stats.lateAlarms
+              << ", maximum lateness " << stats.maxLateness << "s"
+              << ", average lateness " << (stats.lateAlarms ? stats.totalLateness / stats.lateAlarms : 0) << "s\n"
+              << "  Clock steps: " << stats.steps << "\n"
+              << "  Real time: " << stats.realMsecs << "ms";
+    if (stats.realMsecs > 0)
+        std::cout << " (" << stats.triggered() * 1000 / stats.realMsecs << " alarms/s)";
+    std::cout << "\n  CPU time: " << stats.cpuMsecs << "ms";
+    if (stats.triggered())
+        std::cout << " (" << stats.cpuMsecs * 1000 / stats.triggered() << "us per alarm)";
+    if (stats.peakMemory > 0)
+        std::cout << "\n  Peak memory: " << stats.peakMemory << "kB";
+    std::cout << std::endl;
+    quitIf(0, true);
+}
+
 /******************************************************************************
 * The main processing loop for KAlarm.
 * All KAlarm operations involving opening or updating calendar files are called
@@ -1079,6 +1147,23 @@ void KAlarmApp::processQueue()
                             exitAfter = true;
                         break;
                     }
+                    case QueuedAction::AddBatch:
+                    {
+                        Resource resource = Resources::destination(CalEvent::ACTIVE, nullptr, Resources::NoResourcePrompt | Resources::UseOnlyResource);
+                        if (!resource.isValid())
+                        {
+                            qCWarning(KALARM_LOG) << "KAlarmApp::processQueue: Error! Cannot create alarms (no default calendar is defined)";
+                            ok = false;
+                        }
+                        else
+                        {
+                            const KAlarm::UpdateResult result = KAlarm::addEvents(entry.events, resource, nullptr, true, true,
+                                                                                  KAlarm::USE_EVENT_ID | KAlarm::NO_RESOURCE_PROMPT);
+                            if (result >= KAlarm::UPDATE_ERROR)
+                                ok = false;
+                        }
+                        break;
+                    }
                     case QueuedAction::List:
                     {
                         const QStringList alarms = scheduledAlarmList();
@@ -1167,6 +1252,8 @@ void KAlarmApp::processQueue()
             // Schedule the application to be woken when the next alarm is due
             checkNextDueAlarm();
         }
+        if (mActionQueue.isEmpty())
+            VirtualClock::notifyIdle();
     }
 }
 
@@ -1631,7 +1718,7 @@ void KAlarmApp::slotFDOPropertiesChanged(const QString& interface,
 QStringList KAlarmApp::scheduledAlarmList()
 {
     QStringList alarms;
-    const QList<KAEvent> events = KAlarm::getSortedActiveEvents(this);
+    const QList<KAEvent> events = KAlarm::getSortedActiveEvents(this, &mScheduledAlarmsModel);
     for (const KAEvent& event : events)
     {
         const KADateTime dateTime = event.nextTrigger(KAEvent::Trigger::Actual).effectiveKDateTime().toLocalZone();
@@ -1645,6 +1732,79 @@ QStringList KAlarmApp::scheduledAlarmList()
     return alarms;
 }
 
+/******************************************************************************
+* Return a page of pending alarms, in order of their next scheduled occurrence.
+* The alarms are read from a persistent time-sorted model, so only the rows
+* within the requested time window are examined.
+* Parameters:
+*   offset, limit = number of matching alarms to skip, and maximum number to
+*                   return (< 0 for no limit).
+*   from, to      = time window for next occurrence; invalid for no bound.
+*   resourceId    = resource to list alarms from, or -1 for all resources.
+*   types         = alarm action types to include.
+*/
+QList<KAEvent> KAlarmApp::scheduledAlarms(int offset, int limit, const KADateTime& from, const KADateTime& to,
+                                          ResourceId resourceId, KAEvent::Action types)
+{
+    QList<KAEvent> result;
+    if (!limit)
+        return result;
+    if (!mScheduledAlarmsModel)
+    {
+        mScheduledAlarmsModel = DataModel::createAlarmListModel(this);
+        mScheduledAlarmsModel->setEventTypeFilter(CalEvent::ACTIVE);
+        mScheduledAlarmsModel->sort(AlarmListModel::TimeColumn);
+    }
+    const AlarmListModel* model = mScheduledAlarmsModel;
+    auto rowTime = [model](int row)
+    {
+        return model->data(model->index(row, AlarmListModel::TimeColumn), ResourceDataModelBase::SortRole).toDateTime();
+    };
+
+    // Find the first alarm in the time window.
+    const int count = model->rowCount();
+    int row = 0;
+    if (from.isValid())
+    {
+        const QDateTime fromUtc = from.toUtc().qDateTime();
+        int end = count;
+        while (row < end)
+        {
+            const int mid = (row + end) / 2;
+            if (rowTime(mid) < fromUtc)
+                row = mid + 1;
+            else
+                end = mid;
+        }
+    }
+    const QDateTime toUtc = to.isValid() ? to.toUtc().qDateTime() : QDateTime();
+
+    for ( ;  row < count;  ++row)
+    {
+        if (toUtc.isValid()  &&  rowTime(row) > toUtc)
+            break;
+        const KAEvent event = model->event(row);
+        if (!event.enabled()  ||  event.expired())
+            continue;
+        if (resourceId >= 0  &&  event.resourceId() != resourceId)
+            continue;
+        KAEvent::Action action = event.actionTypes();
+        if (action & KAEvent::Action::Display)
+            action = KAEvent::Action::Display;   // treat command output display as a display alarm
+        if (!(action & types))
+            continue;
+        if (offset > 0)
+        {
+            --offset;
+            continue;
+        }
+        result += event;
+        if (limit > 0  &&  result.count() >= limit)
+            break;
+    }
+    return result;
+}
+
 /******************************************************************************
 * Enable or disable alarm monitoring.
 */
@@ -1756,20 +1916,43 @@ bool KAlarmApp::scheduleEvent(QueuedAction queuedActionFlags,
     {
         // Alarm is due for execution already.
         // First execute it once without adding it to the calendar file.
+        // If a batch is being scheduled, defer execution until the whole
+        // batch has been validated.
         qCDebug(KALARM_LOG) << "KAlarmApp::scheduleEvent: executing" << text;
-        if (!mInitialised
-        ||  execAlarm(event, event.firstAlarm()).status == ExecAlarmStatus::Inhibited)
+        if (mSchedulingBatch)
+            mBatchActionQueue.enqueue(ActionQEntry(event, QueuedAction::Trigger));
+        else if (!mInitialised
+             ||  execAlarm(event, event.firstAlarm()).status == ExecAlarmStatus::Inhibited)
             mActionQueue.enqueue(ActionQEntry(event, QueuedAction::Trigger));
         // If it's a recurring alarm, reschedule it for its next occurrence
-        if (!event.recurs())
-            return true;
-        KAEvent::OccurType type;
-        event.setNextOccurrence(now, type);
-        if (type == KAEvent::OccurType::None)
+        bool finished = !event.recurs();
+        if (!finished)
+        {
+            KAEvent::OccurType type;
+            event.setNextOccurrence(now, type);
+            finished = (type == KAEvent::OccurType::None);
+        }
+        if (finished)
+        {
+            if (mSchedulingBatch)
+                mBatchEventIds += QString();   // the alarm won't be stored
             return true;
+        }
         // It has recurrences in the future
     }
 
+    if (mSchedulingBatch)
+    {
+        // Hold the alarm until the batch is committed, and then add all the
+        // batch's alarms to the calendar in one go. Allocate its ID now so
+        // that it can be returned to the caller.
+        qCDebug(KALARM_LOG) << "KAlarmApp::scheduleEvent: adding new alarm to batch" << text;
+        event.setEventId(CalEvent::uid(KCalendarCore::CalFormat::createUniqueId(), CalEvent::ACTIVE));
+        mBatchEvents += event;
+        mBatchEventIds += event.id();
+        return true;
+    }
+
     // Queue the alarm for insertion into the calendar file
     qCDebug(KALARM_LOG) << "KAlarmApp::scheduleEvent: creating new alarm" << text;
     const QueuedAction qaction = static_cast<QueuedAction>(int(QueuedAction::Handle) + int(queuedActionFlags));
@@ -1779,6 +1962,90 @@ bool KAlarmApp::scheduleEvent(QueuedAction queuedActionFlags,
     return true;
 }
 
+/******************************************************************************
+* Start collecting alarms created by scheduleEvent() into a batch, so that they
+* can all be added to the calendar with a single save.
+*/
+void KAlarmApp::beginScheduleBatch()
+{
+    mBatchActionQueue.clear();
+    mBatchEvents.clear();
+    mBatchEventIds.clear();
+    mSchedulingBatch = true;
+}
+
+/******************************************************************************
+* Finish collecting a batch of alarms created by scheduleEvent().
+* If 'commit' is true, add the batch to the calendar file and save it before
+* returning; otherwise, discard it.
+* The batch can only be committed once the calendars have been loaded, and
+* when no queued calendar operation is in progress. Otherwise, or if no alarm
+* in the batch could be saved, the batch is discarded.
+* Reply = IDs of the alarms in the batch, in the order they were scheduled, or
+*         empty if the batch was discarded. An alarm which was due immediately
+*         and has no further occurrences is not stored, and has an empty ID.
+*         An alarm which could not be added to the calendar has an empty ID.
+*/
+QStringList KAlarmApp::endScheduleBatch(bool commit)
+{
+    mSchedulingBatch = false;
+    QStringList ids;
+    if (commit)
+    {
+        if (!mInitialised  ||  mProcessingQueue  ||  !Resources::allPopulated())
+            qCWarning(KALARM_LOG) << "KAlarmApp::endScheduleBatch: Error! Calendars not ready, batch discarded";
+        else
+        {
+            bool ok = true;
+            ids = mBatchEventIds;
+            if (!mBatchEvents.isEmpty())
+            {
+                qCDebug(KALARM_LOG) << "KAlarmApp::endScheduleBatch: creating" << mBatchEvents.count() << "new alarms";
+                Resource resource = Resources::destination(CalEvent::ACTIVE, nullptr, Resources::NoResourcePrompt | Resources::UseOnlyResource);
+                if (!resource.isValid())
+                {
+                    qCWarning(KALARM_LOG) << "KAlarmApp::endScheduleBatch: Error! Cannot create alarms (no default calendar is defined)";
+                    ok = false;
+                }
+                else
+                {
+                    const KAlarm::UpdateResult result = KAlarm::addEvents(mBatchEvents, resource, nullptr, true, true,
+                                                                          KAlarm::USE_EVENT_ID | KAlarm::NO_RESOURCE_PROMPT);
+                    if (result >= KAlarm::UPDATE_FAILED)
+                        ok = false;
+                    else if (!result.failed.isEmpty())
+                    {
+                        // Clear the IDs of the alarms which were not added.
+                        // mBatchEvents excludes the alarms which have empty IDs.
+                        for (int i = 0, e = 0;  i < ids.count();  ++i)
+                        {
+                            if (!ids.at(i).isEmpty())
+                            {
+                                if (result.failed.contains(e))
+                                    ids[i].clear();
+                                ++e;
+                            }
+                        }
+                    }
+                }
+            }
+            if (!ok)
+                ids.clear();
+            else if (!mBatchActionQueue.isEmpty())
+            {
+                // Execute the alarms which were due immediately.
+                while (!mBatchActionQueue.isEmpty())
+                    mActionQueue.enqueue(mBatchActionQueue.dequeue());
+                QTimer::singleShot(0, this, &KAlarmApp::processQueue);   //NOLINT(clang-analyzer-cplusplus.NewDeleteLeaks)
+            }
+        }
+    }
+    mBatchActionQueue.clear();
+    mBatchEvents.clear();
+    mBatchEventIds.clear();
+    return ids;
+}
+
 /******************************************************************************
 * Called in response to a D-Bus request to trigger or cancel an event.
 * Optionally display the event. Delete the event from the calendar file and
@@ -1849,192 +2116,7 @@ int KAlarmApp::handleEvent(const EventId& id, QueuedAction action, bool findUniq
         }
         case QueuedAction::Trigger:    // handle it if it's due, else execute it regardless
         case QueuedAction::Handle:     // handle it if it's due
-        {
-            const KADateTime now = KADateTime::currentUtcDateTime();
-            qCDebug(KALARM_LOG) << "KAlarmApp::handleEvent:" << eventID << "," << (action==QueuedAction::Trigger?"TRIGGER:":"HANDLE:") << qPrintable(now.qDateTime().toString(QStringLiteral("yyyy-MM-dd hh:mm"))) << "UTC";
-            bool updateCalAndDisplay = false;
-            bool alarmToExecuteValid = false;
-            KAAlarm alarmToExecute;
-            bool restart = false;
-            // Check all the alarms in turn.
-            // Note that the main alarm is fetched before any other alarms.
-            for (KAAlarm alarm = event.firstAlarm();
-                 alarm.isValid();
-                 alarm = (restart ? event.firstAlarm() : event.nextAlarm(alarm)), restart = false)
-            {
-                // Check if the alarm is due yet.
-                const KADateTime nextDT = alarm.dateTime(true).effectiveKDateTime();
-                const int secs = nextDT.secsTo(now);
-                if (secs < 0)
-                {
-                    // The alarm appears to be in the future.
-                    // Check if it's an invalid local time during a daylight
-                    // saving time shift, which has actually passed.
-                    if (alarm.dateTime().timeSpec() != KADateTime::LocalZone
-                    ||  nextDT > now.toTimeSpec(KADateTime::LocalZone))
-                    {
-                        // This alarm is definitely not due yet
-                        qCDebug(KALARM_LOG) << "KAlarmApp::handleEvent: Alarm" << alarm.type() << "at" << nextDT << ": not due";
-                        continue;
-                    }
-                }
-                bool reschedule = false;
-                bool rescheduleWork = false;
-                if ((event.workTimeOnly() || event.holidaysExcluded())  &&  !alarm.deferred())
-                {
-                    // The alarm is restricted to working hours and/or non-holidays
-                    // (apart from deferrals). This needs to be re-evaluated every
-                    // time it triggers, since working hours could change.
-                    if (alarm.dateTime().isDateOnly())
-                    {
-                        KADateTime dt(nextDT);
-                        dt.setDateOnly(true);
-                        reschedule = event.excludedByWorkTimeOrHoliday(dt);
-                    }
-                    else
-                        reschedule = event.excludedByWorkTimeOrHoliday(nextDT);
-                    rescheduleWork = reschedule;
-                    if (reschedule)
-                        qCDebug(KALARM_LOG) << "KAlarmApp::handleEvent: Alarm" << alarm.type() << "at" << nextDT << ": not during working hours";
-                }
-                if (!reschedule  &&  alarm.repeatAtLogin())
-                {
-                    // Alarm is to be displayed at every login.
-                    qCDebug(KALARM_LOG) << "KAlarmApp::handleEvent: REPEAT_AT_LOGIN";
-                    // Check if the main alarm is already being displayed.
-                    // (We don't want to display both at the same time.)
-                    if (alarmToExecute.isValid())
-                        continue;
-
-                    // Set the time to display if it's a display alarm
-                    alarm.setTime(now);
-                }
-                if (!reschedule  &&  event.lateCancel())
-                {
-                    // Alarm is due, and it is to be cancelled if too late.
-                    qCDebug(KALARM_LOG) << "KAlarmApp::handleEvent: LATE_CANCEL";
-                    bool cancel = false;
-                    bool tooLate = false;
-                    KAEvent::OccurType prevType = KAEvent::OccurType::None;
-                    if (alarm.dateTime().isDateOnly())
-                    {
-                        // The alarm has no time, so cancel it if its date is too far past
-                        const int maxlate = event.lateCancel() / 1440;    // maximum lateness in days
-                        KADateTime limit(DateTime(nextDT.addDays(maxlate + 1)).effectiveKDateTime());
-                        if (now >= limit)
-                        {
-                            // It's too late to display the scheduled occurrence.
-                            // Find the last previous occurrence of the alarm.
-                            DateTime next;
-                            prevType = event.previousOccurrence(now, next, KAEvent::Repeats::Return);
-                            if (KAEvent::isRecur(prevType))
-                            {
-                                limit.setDate(next.date().addDays(maxlate + 1));
-                                if (now >= limit)
-                                    tooLate = true;
-                            }
-                            else
-                                reschedule = true;
-                        }
-                    }
-                    else
-                    {
-                        // The alarm is timed. Allow it to be the permitted amount late before cancelling it.
-                        const int maxlate = maxLateness(event.lateCancel());
-                        if (secs > maxlate)
-                        {
-                            // It's over the maximum interval late.
-                            // Find the most recent occurrence of the alarm.
-                            DateTime next;
-                            prevType = event.previousOccurrence(now, next, KAEvent::Repeats::Return);
-                            if (KAEvent::isRecur(prevType))
-                            {
-                                if (next.effectiveKDateTime().secsTo(now) > maxlate)
-                                    tooLate = true;
-                            }
-                            else
-                                reschedule = true;
-                        }
-                    }
-                    if (tooLate)
-                    {
-                        // If it's past the last recurrence, and there are no
-                        // sub-repetitions to come, cancel the alarm.
-                        DateTime next;
-                        if (KAEvent::isLastRecur(prevType)
-                        &&  event.nextDateTime(now, next, KAEvent::NextRepeat) == KAEvent::TriggerType::None)
-                            cancel = true;
-                        else
-                            reschedule = true;
-                    }
-
-                    if (cancel)
-                    {
-                        // All recurrences are finished, so cancel the event
-                        event.setArchive();
-                        if (cancelAlarm(event, alarm.type(), false))
-                            return 1;   // event has been deleted
-                        updateCalAndDisplay = true;
-                        continue;
-                    }
-                }
-                if (reschedule)
-                {
-                    // The latest repetition was too long ago, so schedule the next one
-                    switch (rescheduleAlarm(event, alarm, false, (rescheduleWork ? nextDT : KADateTime())))
-                    {
-                        case 1:
-                            // A working-time-only alarm has been rescheduled and the
-                            // rescheduled time is already due. Start processing the
-                            // event again.
-                            alarmToExecuteValid = false;
-                            restart = true;
-                            break;
-                        case -1:
-                            return 1;   // event has been deleted
-                        default:
-                            break;
-                    }
-                    updateCalAndDisplay = true;
-                    continue;
-                }
-                if (!alarmToExecuteValid)
-                {
-                    qCDebug(KALARM_LOG) << "KAlarmApp::handleEvent: Alarm" << alarm.type() << ": execute";
-                    alarmToExecute = alarm;             // note the alarm to be displayed
-                    alarmToExecuteValid = true;         // only trigger one alarm for the event
-                }
-                else
-                    qCDebug(KALARM_LOG) << "KAlarmApp::handleEvent: Alarm" << alarm.type() << ": skip";
-            }
-
-            // If there is an alarm to execute, do this last after rescheduling/cancelling
-            // any others. This ensures that the updated event is only saved once to the calendar.
-            if (alarmToExecute.isValid())
-            {
-                if (execAlarm(event, alarmToExecute, Reschedule | (alarmToExecute.repeatAtLogin() ? NoExecFlag : AllowDefer)).status == ExecAlarmStatus::Inhibited)
-                    return 0;    // display alarm, but notifications are inhibited
-            }
-            else
-            {
-                if (action == QueuedAction::Trigger)
-                {
-                    // The alarm is to be executed regardless of whether it's due.
-                    // Only trigger one alarm from the event - we don't want multiple
-                    // identical messages, for example.
-                    const KAAlarm alarm = event.firstAlarm();
-                    if (alarm.isValid())
-                    {
-                        if (execAlarm(event, alarm).status == ExecAlarmStatus::Inhibited)
-                            return 0;    // display alarm, but notifications are inhibited
-                    }
-                }
-                if (updateCalAndDisplay)
-                    KAlarm::updateEvent(event);     // update the window lists and calendar file
-                else if (action != QueuedAction::Trigger) { qCDebug(KALARM_LOG) << "KAlarmApp::handleEvent: No action"; }
-            }
-            break;
-        }
+            return handleAlarms(event, (action == QueuedAction::Trigger));
         default:
             break;
     }
@@ -2057,148 +2139,54 @@ void KAlarmApp::alarmCompleted(const KAEvent& event)
 }
 
 /******************************************************************************
-* Reschedule the alarm for its next recurrence after now. If none remain,
-* delete it.  If the alarm is deleted and it is the last alarm for its event,
-* the event is removed from the calendar file and from every main window
-* instance.
-* If 'nextDt' is valid, the event is rescheduled for the next non-working
-* time occurrence after that.
-* Reply = 1 if 'nextDt' is valid and the rescheduled event is already due
-*       = -1 if the event has been deleted
-*       = 0 otherwise.
+* Execute an alarm which has been found due by the scheduler.
+* Reply = false if notifications are inhibited.
 */
-int KAlarmApp::rescheduleAlarm(KAEvent& event, const KAAlarm& alarm, bool updateCalAndDisplay, const KADateTime& nextDt)
+bool KAlarmApp::executeAlarm(KAEvent& event, const KAAlarm& alarm, bool reschedule)
 {
-    qCDebug(KALARM_LOG) << "KAlarmApp::rescheduleAlarm: Alarm type:" << alarm.type();
-    if (!ResourcesCalendar::canEventRetrigger(event))
-        return 0;
-    int reply = 0;
-    bool update = false;
-    event.startChanges();
-    if (alarm.repeatAtLogin())
-    {
-        // Leave an alarm which repeats at every login until its main alarm triggers
-        if (!event.reminderActive()  &&  event.reminderMinutes() < 0)
-        {
-            // Executing an at-login alarm: first schedule the reminder
-            // which occurs AFTER the main alarm.
-            event.activateReminderAfter(KADateTime::currentUtcDateTime());
-        }
-        // Repeat-at-login alarms are usually unchanged after triggering.
-        // Ensure that the archive flag (which was set in execAlarm()) is saved.
-        update = true;
-    }
-    else if (alarm.isReminder()  ||  alarm.deferred())
-    {
-        // It's a reminder alarm or an extra deferred alarm, so delete it
-        event.removeExpiredAlarm(alarm.type());
-        update = true;
-    }
-    else
-    {
-        // Reschedule the alarm for its next occurrence.
-        DateTime last = event.mainDateTime(false);   // note this trigger time
-        if (last != event.mainDateTime(true))
-            last = DateTime();                       // but ignore sub-repetition triggers
-        bool next = nextDt.isValid();
-        KADateTime next_dt = nextDt;
-        const KADateTime now = KADateTime::currentUtcDateTime();
-        do
-        {
-            KAEvent::OccurType type;
-            if (!event.setNextOccurrence(next ? next_dt : now, type))
-            {
-                // The next occurrence hasn't changed.
-                if (type == KAEvent::OccurType::None)
-                {
-                    // All repetitions are finished, so cancel the event
-                    qCDebug(KALARM_LOG) << "KAlarmApp::rescheduleAlarm: No occurrence";
-                    if (event.reminderMinutes() < 0  &&  last.isValid()
-                    &&  alarm.type() != KAAlarm::Type::AtLogin  &&  !event.mainExpired())
-                    {
-                        // Set the reminder which is now due after the last main alarm trigger.
-                        // Note that at-login reminders are scheduled in execAlarm().
-                        event.activateReminderAfter(last);
-                        updateCalAndDisplay = true;
-                    }
-                    if (cancelAlarm(event, alarm.type(), updateCalAndDisplay))
-                        return -1;
-                }
-            }
-            else if (KAEvent::isRecur(type) || KAEvent::isRepeat(type))
-            {
-                // The event is due by now and repetitions still remain, so rewrite the event
-                if (updateCalAndDisplay)
-                    update = true;
-            }
-            if (event.deferred())
-            {
-                // Just in case there's also a deferred alarm, ensure it's removed
-                event.removeExpiredAlarm(KAAlarm::Type::Deferred);
-                update = true;
-            }
-            if (next)
-            {
-                // The alarm is restricted to working hours and/or non-holidays.
-                // Check if the calculated next time is valid.
-                next_dt = event.mainDateTime(true).effectiveKDateTime();
-                if (event.mainDateTime(false).isDateOnly())
-                {
-                    KADateTime dt(next_dt);
-                    dt.setDateOnly(true);
-                    next = event.excludedByWorkTimeOrHoliday(dt);
-                }
-                else
-                    next = event.excludedByWorkTimeOrHoliday(next_dt);
-            }
-        } while (next && next_dt <= now);
-        reply = (next_dt.isValid() && (next_dt <= now)) ? 1 : 0;
+    const ExecAlarmFlags flags = reschedule ? Reschedule | (alarm.repeatAtLogin() ? NoExecFlag : AllowDefer) : NoExecFlag;
+    return execAlarm(event, alarm, flags).status != ExecAlarmStatus::Inhibited;
+}
 
-        if (event.reminderMinutes() < 0  &&  last.isValid()
-        &&  alarm.type() != KAAlarm::Type::AtLogin)
-        {
-            // Set the reminder which is now due after the last main alarm trigger.
-            // Note that at-login reminders are scheduled in execAlarm().
-            event.activateReminderAfter(last);
-        }
-    }
-    event.endChanges();
-    if (update)
-        KAlarm::updateEvent(event, nullptr, true, false);   // update the window lists and calendar file
-    return reply;
+/******************************************************************************
+* Return whether an event's alarms can be rescheduled.
+*/
+bool KAlarmApp::canEventRetrigger(const KAEvent& event) const
+{
+    return ResourcesCalendar::canEventRetrigger(event);
 }
 
 /******************************************************************************
-* Delete the alarm. If it is the last alarm for its event, the event is removed
-* from the calendar file and from every main window instance.
-* Reply = true if event has been deleted.
+* Save an event which has been updated by the scheduler.
 */
-bool KAlarmApp::cancelAlarm(KAEvent& event, KAAlarm::Type alarmType, bool updateCalAndDisplay)
+void KAlarmApp::updateEvent(KAEvent& event, bool saveIfReadOnly)
 {
-    qCDebug(KALARM_LOG) << "KAlarmApp::cancelAlarm";
-    if (alarmType == KAAlarm::Type::Main  &&  !event.displaying()  &&  event.toBeArchived())
-    {
-        // The event is being deleted. Save it in the archived resource first.
-        Resource resource;
-        KAEvent ev(event);
-        KAlarm::addArchivedEvent(ev, resource);
-    }
-    event.removeExpiredAlarm(alarmType);
-    if (!event.alarmCount())
-    {
-        // If it's a command alarm being executed, mark it as deleted
-        ProcData* pd = findCommandProcess(event.id());
-        if (pd)
-            pd->eventDeleted = true;
+    KAlarm::updateEvent(event, nullptr, true, saveIfReadOnly);   // update the window lists and calendar file
+}
 
-        // Delete it
-        Resource resource;
-        KAlarm::deleteEvent(event, resource, false);
-        return true;
-    }
-    if (updateCalAndDisplay)
-        KAlarm::updateEvent(event);    // update the window lists and calendar file
-    return false;
+/******************************************************************************
+* Save an event which is about to be deleted in the archived resource.
+*/
+void KAlarmApp::archiveEvent(const KAEvent& event)
+{
+    Resource resource;
+    KAEvent ev(event);
+    KAlarm::addArchivedEvent(ev, resource);
+}
+
+/******************************************************************************
+* Delete an event which has no alarms left.
+*/
+void KAlarmApp::deleteEvent(KAEvent& event)
+{
+    // If it's a command alarm being executed, mark it as deleted
+    ProcData* pd = findCommandProcess(event.id());
+    if (pd)
+        pd->eventDeleted = true;
+
+    // Delete it
+    Resource resource;
+    KAlarm::deleteEvent(event, resource, false);
 }
 
 /******************************************************************************
@@ -2243,6 +2231,15 @@ KAlarmApp::ExecAlarmResult KAlarmApp::execAlarm(KAEvent& event, const KAAlarm& a
     ExecAlarmResult result(ExecAlarmStatus::Success);
     event.setArchive();
 
+    if (VirtualClock::isActive())
+    {
+        // Simulating: record the alarm instead of executing it.
+        VirtualClock::recordAlarm(event, alarm);
+        if (flags & Reschedule)
+            rescheduleAlarm(event, alarm, true);
+        return result;
+    }
+
     switch (alarm.action())
     {
         case KAAlarm::Action::Command:
@@ -10,6 +10,7 @@
 
 /** @file kalarmapp.h - the KAlarm application object */
 
+#include "alarmscheduler.h"
 #include "eventid.h"
 #include "preferences.h"
 #include "kalarmcalendar/kaevent.h"
@@ -21,16 +22,18 @@
 namespace KCal { class Event; }
 namespace MailSend { struct JobData; }
 class Resource;
+class AlarmListModel;
 class DBusHandler;
 class MainWindow;
 class MessageWindow;
 class TrayWindow;
 class ShellProcess;
+class SimulationWorkload;
 
 using namespace KAlarmCal;
 
 
-class KAlarmApp : public QApplication
+class KAlarmApp : public QApplication, private AlarmScheduler
 {
     Q_OBJECT
 public:
@@ -107,7 +110,7 @@ public:
                                         const char* slotOutput = nullptr,
                                         const char* methodExited = nullptr);
     void               alarmCompleted(const KAEvent&);
-    void               rescheduleAlarm(KAEvent& e, const KAAlarm& a)   { rescheduleAlarm(e, a, true); }
+    void               rescheduleAlarm(KAEvent& e, const KAAlarm& a)   { AlarmScheduler::rescheduleAlarm(e, a, true); }
     void               purgeAll()             { purge(0); }
     void               commandMessage(ShellProcess*, QWidget* parent);
     void               notifyAudioPlaying(bool playing);
@@ -130,9 +133,13 @@ public:
                            reminderMinutes, recurrence, repeatInterval, repeatCount,
                            mailFromID, mailAddresses, mailSubject, mailAttachments);
     }
+    void               beginScheduleBatch();
+    QStringList        endScheduleBatch(bool commit);
     bool               dbusTriggerEvent(const EventId& eventID)   { return dbusHandleEvent(eventID, QueuedAction::Trigger); }
     bool               dbusDeleteEvent(const EventId& eventID)    { return dbusHandleEvent(eventID, QueuedAction::Cancel); }
     QString            dbusList();
+    QList<KAEvent>     scheduledAlarms(int offset, int limit, const KADateTime& from, const KADateTime& to,
+                                       ResourceId resourceId, KAEvent::Action types);
 
 public Q_SLOTS:
     void               activateByDBus(const QStringList& args, const QString& workingDirectory)
@@ -175,6 +182,7 @@ private Q_SLOTS:
     void               slotResourcePopulated(const Resource&);
     void               slotPurge()                     { purge(mArchivedPurgeDays); }
     void               slotCommandExited(ShellProcess*);
+    void               slotSimulationFinished();
     void               slotFDOPropertiesChanged(const QString& interface,
                                                 const QVariantMap& changedProperties,
                                                 const QStringList& invalidatedProperties);
@@ -191,6 +199,7 @@ private:
         Cancel     = 0x03,  // delete the alarm
         Edit       = 0x04,  // edit an alarm (command line option)
         List       = 0x05,  // list all alarms (command line option)
+        AddBatch   = 0x06,  // add a batch of new alarms to the calendar in one save
         // Modifier flags
         FindId     = 0x10,  // search all resources for unique event ID
         Exit       = 0x20,  // exit application after executing action
@@ -235,10 +244,12 @@ private:
         ActionQEntry(QueuedAction a, const EventId& id) : action(a), eventId(id) { }
         ActionQEntry(QueuedAction a, const EventId& id, const QString& resId) : action(a), eventId(id), resourceId(resId) { }
         explicit ActionQEntry(const KAEvent& e, QueuedAction a = QueuedAction::Handle) : action(a), event(e) { }
+        explicit ActionQEntry(const QList<KAEvent>& e) : action(QueuedAction::AddBatch), events(e) { }
         ActionQEntry() = default;       //cppcheck-suppress[uninitMemberVar]  user must initialise struct
         QueuedAction  action;
         EventId       eventId;
         KAEvent       event;
+        QList<KAEvent> events;      // new events for AddBatch action
         QString       resourceId;   // resource ID or name, if resources not created yet
     };
 
@@ -250,6 +261,7 @@ private:
     void               createOnlyMainWindow();
     bool               checkSystemTray();
     void               startProcessQueue(bool evenIfStarted = false);
+    void               startSimulation(const KADateTime& startTime, const KADateTime& endTime, const SimulationWorkload&);
     void               setResourcesTimeout();
     void               checkWritableCalendar();
     void               checkArchivedCalendar();
@@ -266,9 +278,12 @@ private:
                                      const QString& mailSubject = QString(),
                                      const QStringList& mailAttachments = QStringList());
     int                handleEvent(const EventId&, QueuedAction, bool findUniqueId = false);
-    int                rescheduleAlarm(KAEvent&, const KAAlarm&, bool updateCalAndDisplay,
-                                       const KADateTime& nextDt = KADateTime());
-    bool               cancelAlarm(KAEvent&, KAAlarm::Type, bool updateCalAndDisplay);
+    using AlarmScheduler::rescheduleAlarm;
+    bool               executeAlarm(KAEvent&, const KAAlarm&, bool reschedule) override;
+    bool               canEventRetrigger(const KAEvent&) const override;
+    void               updateEvent(KAEvent&, bool saveIfReadOnly = true) override;
+    void               archiveEvent(const KAEvent&) override;
+    void               deleteEvent(KAEvent&) override;
     bool               cancelReminderAndDeferral(KAEvent&);
     ShellProcess*      doShellCommand(const QString& command, const KAEvent&, const KAAlarm*,
                                       int flags = 0, QObject* receiver = nullptr,
@@ -303,6 +318,11 @@ private:
     QList<ResourceId>  mPendingPurges;          // new resources which may need to be purged when populated
     QList<ProcData*>   mCommandProcesses;       // currently active command alarm processes
     QQueue<ActionQEntry> mActionQueue;          // queued commands and actions
+    AlarmListModel*    mScheduledAlarmsModel {nullptr}; // active alarms sorted in time order, for listing
+    QQueue<ActionQEntry> mBatchActionQueue;     // actions held back until the current schedule batch is committed
+    QList<KAEvent>     mBatchEvents;            // new alarms in the current schedule batch
+    QStringList        mBatchEventIds;          // IDs of alarms in the current schedule batch
+    bool               mSchedulingBatch {false}; // scheduleEvent() is adding to a schedule batch
     QList<MessageWindow*> mRestoredWindows;     // message windows restored at startup, waiting to be displayed
     int                mEditingCmdLineAlarm {0}; // whether currently editing alarm specified on command line
     int                mPendingQuitCode;        // exit code for a pending quit
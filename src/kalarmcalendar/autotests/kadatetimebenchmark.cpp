@@ -0,0 +1,131 @@
+/*
+   This file is part of kalarmcal library, which provides access to KAlarm
+   calendar data.
+
+   SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kadatetimebenchmark.h"
+
+#include "kadatetime.h"
+#include "tztransitions.h"
+using namespace KAlarmCal;
+
+#include <QElapsedTimer>
+#include <QTest>
+
+QTEST_GUILESS_MAIN(KADateTimeBenchmark)
+
+namespace
+{
+const int SAMPLE_COUNT = 200000;   // number of date/times converted
+const int SAMPLE_STEP  = 3607;     // seconds between sample date/times
+
+// Return a list of UTC date/times spread over several years.
+QList<QDateTime> sampleTimes()
+{
+    const QDateTime start(QDate(2020, 1, 1), QTime(0, 0, 0), QTimeZone::utc());
+    QList<QDateTime> times;
+    times.reserve(SAMPLE_COUNT);
+    for (int i = 0;  i < SAMPLE_COUNT;  ++i)
+        times.append(start.addSecs(static_cast<qint64>(i) * SAMPLE_STEP));
+    return times;
+}
+
+// Create KADateTime values from time zone date/times and convert them to UTC,
+// and return the time taken in nanoseconds per conversion.
+qint64 convert(const QList<QDateTime>& zoneTimes, const QTimeZone& tz, qint64& check)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (const QDateTime& zoneTime : zoneTimes)
+    {
+        const KADateTime dt(zoneTime.date(), zoneTime.time(), tz);
+        check += dt.toUtc().qDateTime().toSecsSinceEpoch() + dt.utcOffset();
+    }
+    return timer.nsecsElapsed() / zoneTimes.count();
+}
+}
+
+void KADateTimeBenchmark::offsetLookup_data()
+{
+    QTest::addColumn<bool>("useTable");
+    QTest::newRow("QTimeZone") << false;
+    QTest::newRow("transition table") << true;
+}
+
+// Find UTC offsets using either QTimeZone or the transition table, and report
+// the time taken per lookup.
+void KADateTimeBenchmark::offsetLookup()
+{
+    QFETCH(bool, useTable);
+    const QTimeZone tz("Europe/London");
+    const QList<QDateTime> times = sampleTimes();
+
+    QList<int> expected;
+    expected.reserve(times.count());
+    for (const QDateTime& utc : times)
+        expected.append(tz.offsetFromUtc(utc));
+
+    const std::shared_ptr<const TzTransitions> table = TzTransitions::forZone(tz);
+    QVERIFY(table);
+    QList<int> offsets;
+    offsets.reserve(times.count());
+    QElapsedTimer timer;
+    timer.start();
+    if (useTable)
+    {
+        for (const QDateTime& utc : times)
+            offsets.append(table->offsetAtUtc(utc.toMSecsSinceEpoch()));
+    }
+    else
+    {
+        for (const QDateTime& utc : times)
+            offsets.append(tz.offsetFromUtc(utc));
+    }
+    const qint64 nsecs = timer.nsecsElapsed();
+
+    QCOMPARE(offsets, expected);
+    QTest::setBenchmarkResult(static_cast<qreal>(nsecs) / times.count(), QTest::WalltimeNanoseconds);
+}
+
+void KADateTimeBenchmark::conversion_data()
+{
+    QTest::addColumn<bool>("useTable");
+    QTest::newRow("QTimeZone") << false;
+    QTest::newRow("transition table") << true;
+}
+
+// Convert time zone date/times to UTC using either QTimeZone or the transition
+// table, and report the time taken per conversion.
+void KADateTimeBenchmark::conversion()
+{
+    QFETCH(bool, useTable);
+    const QTimeZone tz("America/New_York");
+    QList<QDateTime> times = sampleTimes();
+    for (QDateTime& time : times)
+        time = time.toTimeZone(tz);
+
+    // Disabling the transition table makes conversions use QTimeZone.
+    TzTransitions::setYearRange(1900, 1900);
+    qint64 expected = 0;
+    convert(times, tz, expected);
+
+    if (useTable)
+        TzTransitions::setYearRange(1970, 2100);
+    qint64 check = 0;
+    const qint64 nsecs = convert(times, tz, check);
+    TzTransitions::setYearRange(1970, 2100);
+
+    QCOMPARE(check, expected);
+    QTest::setBenchmarkResult(static_cast<qreal>(nsecs), QTest::WalltimeNanoseconds);
+}
+
+void KADateTimeBenchmark::cleanupTestCase()
+{
+    TzTransitions::setYearRange(1970, 2100);
+}
+
+#include "moc_kadatetimebenchmark.cpp"
@@ -0,0 +1,23 @@
+/*
+   This file is part of kalarmcal library, which provides access to KAlarm
+   calendar data.
+
+   SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class KADateTimeBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void offsetLookup_data();
+    void offsetLookup();
+    void conversion_data();
+    void conversion();
+    void cleanupTestCase();
+};
@@ -9,8 +9,10 @@
 
 #include "kadatetimetest.h"
 #include "kadatetime.h"
+#include "tztransitions.h"
 #include <cstdlib>
 using KAlarmCal::KADateTime;
+using KAlarmCal::TzTransitions;
 
 
 #include <QTest>
@@ -46,10 +48,12 @@ void KADateTimeTest::specConstructors()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":Europe/London");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Ensure that local time is different from UTC and different from 'london'
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Default constructor
     KADateTime::Spec invalid;
@@ -231,6 +235,7 @@ void KADateTimeTest::specConstructors()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -246,6 +251,7 @@ void KADateTimeTest::specSet()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     KADateTime::Spec spec;
     QCOMPARE(spec.type(), KADateTime::Invalid);
@@ -303,6 +309,7 @@ void KADateTimeTest::specSet()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 //////////////////////////////////////////////////////
@@ -320,6 +327,7 @@ void KADateTimeTest::qDateTime()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":Europe/London");
     ::tzset();
+    KADateTime::refreshLocalZone();
     QDateTime dtUTCtoLondon = dtUTC.toLocalTime();
     // It's now set to Qt::LocalTime, so fix the zone to the current local zone,
     // to prevent it following what is next set by tzset().
@@ -328,6 +336,7 @@ void KADateTimeTest::qDateTime()
     // Ensure that local time is different from UTC and different from 'london'
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Check time spec
     QDateTime dateTime(QDate(2020, 6, 10), QTime(10, 32, 44), dtUTCtoLondon.timeZone());
@@ -347,6 +356,7 @@ void KADateTimeTest::qDateTime()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 //////////////////////////////////////////////////////
@@ -364,6 +374,7 @@ void KADateTimeTest::constructors()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":Europe/London");
     ::tzset();
+    KADateTime::refreshLocalZone();
     QDateTime dtUTCtoLondon = dtUTC.toLocalTime();
     // It's now set to Qt::LocalTime, so fix the zone to the current local zone,
     // to prevent it following what is next set by tzset().
@@ -372,6 +383,7 @@ void KADateTimeTest::constructors()
     // Ensure that local time is different from UTC and different from 'london'
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Default constructor
     KADateTime deflt;
@@ -750,6 +762,7 @@ void KADateTimeTest::constructors()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 ///////////////////////////////////
@@ -764,6 +777,7 @@ void KADateTimeTest::toUtc()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Zone -> UTC
     KADateTime londonWinter(QDate(2005, 1, 1), QTime(0, 0, 0), london);
@@ -859,6 +873,7 @@ void KADateTimeTest::toUtc()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::toOffsetFromUtc()
@@ -869,6 +884,7 @@ void KADateTimeTest::toOffsetFromUtc()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // ***** toOffsetFromUtc(void) *****
 
@@ -1076,6 +1092,7 @@ void KADateTimeTest::toOffsetFromUtc()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::toLocalZone()
@@ -1086,6 +1103,7 @@ void KADateTimeTest::toLocalZone()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Zone -> LocalZone
     KADateTime londonWinter(QDate(2005, 1, 1), QTime(0, 0, 0), london);
@@ -1150,6 +1168,18 @@ void KADateTimeTest::toLocalZone()
     QVERIFY(utc != locUtc);
     QVERIFY(!(utc == locUtc));
 
+    // ** Change of local time zone ** //
+
+    KADateTime local(QDate(2005, 6, 6), QTime(4, 2, 30), KADateTime::LocalZone);
+    QCOMPARE(KADateTime::localZone(), QTimeZone("America/Los_Angeles"));
+    QCOMPARE(local.toUtc().time(), QTime(11, 2, 30));   // cache the UTC value
+    qputenv("TZ", ":Europe/London");
+    ::tzset();
+    KADateTime::refreshLocalZone();
+    QCOMPARE(KADateTime::localZone(), london);
+    QCOMPARE(local.toUtc().time(), QTime(3, 2, 30));
+    QCOMPARE(local.time(), QTime(4, 2, 30));
+
     // Restore the original local time zone
     if (originalZone.isEmpty()) {
         unsetenv("TZ");
@@ -1157,6 +1187,7 @@ void KADateTimeTest::toLocalZone()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::toZone()
@@ -1167,6 +1198,7 @@ void KADateTimeTest::toZone()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":Europe/London");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Zone -> Zone
     KADateTime londonWinter(QDate(2005, 1, 1), QTime(0, 0, 0), london);
@@ -1256,6 +1288,7 @@ void KADateTimeTest::toZone()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::toTimeSpec()
@@ -1267,6 +1300,7 @@ void KADateTimeTest::toTimeSpec()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     KADateTime::Spec utcSpec(KADateTime::UTC);
     KADateTime::Spec cairoSpec(cairo);
@@ -1505,6 +1539,7 @@ void KADateTimeTest::toTimeSpec()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1519,6 +1554,7 @@ void KADateTimeTest::set()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Zone
     KADateTime zoned(QDate(2005, 6, 1), london);
@@ -1741,6 +1777,7 @@ void KADateTimeTest::set()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 /////////////////////////////////////////////////////////
@@ -1756,6 +1793,7 @@ void KADateTimeTest::equal()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Date/time values
     QVERIFY(!(KADateTime(QDate(2004, 3, 1), QTime(3, 45, 2), cairo) == KADateTime(QDate(2004, 2, 28), QTime(3, 45, 3), cairo)));
@@ -1838,6 +1876,7 @@ void KADateTimeTest::equal()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 /////////////////////////////////////////////////////////
@@ -1853,6 +1892,7 @@ void KADateTimeTest::lessThan()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Date/time values
     QVERIFY(!(KADateTime(QDate(2004, 3, 1), QTime(3, 45, 2), cairo) < KADateTime(QDate(2004, 2, 28), QTime(3, 45, 3), cairo)));
@@ -1957,6 +1997,7 @@ void KADateTimeTest::lessThan()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 /////////////////////////////////////////////////////////
@@ -1972,6 +2013,7 @@ void KADateTimeTest::compare()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Date/time values
     QCOMPARE(KADateTime(QDate(2004, 3, 1), QTime(3, 45, 2), cairo).compare(KADateTime(QDate(2004, 3, 1), QTime(3, 45, 3), cairo)), KADateTime::Before);
@@ -2030,6 +2072,7 @@ void KADateTimeTest::compare()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 /////////////////////////////////////////////////////////
@@ -2045,6 +2088,7 @@ void KADateTimeTest::addSubtract()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // UTC
     KADateTime utc1(QDate(2005, 7, 6), QTime(3, 40, 0), KADateTime::UTC);
@@ -2219,6 +2263,7 @@ void KADateTimeTest::addSubtract()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::addMSecs()
@@ -2230,6 +2275,7 @@ void KADateTimeTest::addMSecs()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // UTC
     KADateTime utc1(QDate(2005, 7, 6), QTime(23, 59, 0, 100), KADateTime::UTC);
@@ -2329,6 +2375,7 @@ void KADateTimeTest::addMSecs()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::addSubtractDate()
@@ -2340,6 +2387,7 @@ void KADateTimeTest::addSubtractDate()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // UTC
     KADateTime utc1(QDate(2005, 7, 6), KADateTime::Spec(KADateTime::UTC));
@@ -2639,6 +2687,7 @@ void KADateTimeTest::addSubtractDate()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 ///////////////////////////////////////////
@@ -2653,6 +2702,7 @@ void KADateTimeTest::dstShifts()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Shift from DST to standard time for the UK in 2005 was at 2005-10-30 01:00 UTC.
     QDateTime qdt(QDate(2005, 10, 29), QTime(23, 59, 59), QTimeZone(QTimeZone::UTC));
@@ -2770,6 +2820,7 @@ void KADateTimeTest::dstShifts()
     // Shift from DST to standard time for the UK in 2022 was at 2022-10-30 01:00 UTC.
     qputenv("TZ", ":Europe/London");
     ::tzset();
+    KADateTime::refreshLocalZone();
     qdt = QDateTime(QDate(2022, 10, 30), QTime(0, 59, 59), QTimeZone(QTimeZone::LocalTime));
     dst = qdt.isDaylightTime();
     dt = KADateTime(qdt);
@@ -2880,6 +2931,54 @@ void KADateTimeTest::dstShifts()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
+}
+
+void KADateTimeTest::tzTransitions()
+{
+    const QTimeZone london("Europe/London");
+    const std::shared_ptr<const TzTransitions> table = TzTransitions::forZone(london);
+    QVERIFY(table);
+    QCOMPARE(TzTransitions::forZone(london), table);   // the table is shared
+    auto localMSecs = [](const QDate& d, const QTime& t) { return TzTransitions::localMSecs(QDateTime(d, t, QTimeZone::utc())); };
+    auto utcMSecs = [](const QDate& d, const QTime& t) { return QDateTime(d, t, QTimeZone::utc()).toMSecsSinceEpoch(); };
+
+    // UTC offsets
+    QCOMPARE(table->offsetAtUtc(utcMSecs(QDate(2005, 3, 27), QTime(0, 59, 59))), 0);
+    QCOMPARE(table->offsetAtUtc(utcMSecs(QDate(2005, 3, 27), QTime(1, 0, 0))), 3600);
+    QCOMPARE(table->offsetAtUtc(utcMSecs(QDate(2005, 10, 30), QTime(0, 59, 59))), 3600);
+    QCOMPARE(table->offsetAtUtc(utcMSecs(QDate(2005, 10, 30), QTime(1, 0, 0))), 0);
+    const int i = table->transitionIndex(utcMSecs(QDate(2005, 6, 1), QTime(0, 0, 0)));
+    QVERIFY(i >= 0);
+    QCOMPARE(table->transitionUtc(i), QDateTime(QDate(2005, 3, 27), QTime(1, 0, 0), QTimeZone::utc()));
+    QCOMPARE(table->offsetAfter(i), 3600);
+
+    // Local times
+    TzTransitions::LocalOffsets offsets;
+    QVERIFY(table->localOffsets(localMSecs(QDate(2005, 6, 1), QTime(12, 0, 0)), offsets));
+    QVERIFY(offsets.type == TzTransitions::LocalTime::Unique);
+    QCOMPARE(offsets.offset, 3600);
+    QVERIFY(table->localOffsets(localMSecs(QDate(2005, 3, 27), QTime(1, 30, 0)), offsets));
+    QVERIFY(offsets.type == TzTransitions::LocalTime::Skipped);
+    QCOMPARE(offsets.offset, 0);
+    QCOMPARE(offsets.secondOffset, 3600);
+    QVERIFY(table->localOffsets(localMSecs(QDate(2005, 3, 27), QTime(2, 0, 0)), offsets));
+    QVERIFY(offsets.type == TzTransitions::LocalTime::Unique);
+    QVERIFY(table->localOffsets(localMSecs(QDate(2005, 10, 30), QTime(0, 59, 59)), offsets));
+    QVERIFY(offsets.type == TzTransitions::LocalTime::Unique);
+    QCOMPARE(offsets.offset, 3600);
+    QVERIFY(table->localOffsets(localMSecs(QDate(2005, 10, 30), QTime(1, 30, 0)), offsets));
+    QVERIFY(offsets.type == TzTransitions::LocalTime::Ambiguous);
+    QCOMPARE(offsets.offset, 3600);
+    QCOMPARE(offsets.secondOffset, 0);
+    QCOMPARE(offsets.transitionUtc, utcMSecs(QDate(2005, 10, 30), QTime(1, 0, 0)));
+    QVERIFY(table->localOffsets(localMSecs(QDate(2005, 10, 30), QTime(2, 0, 0)), offsets));
+    QVERIFY(offsets.type == TzTransitions::LocalTime::Unique);
+    QCOMPARE(offsets.offset, 0);
+
+    // Outside the table's range
+    QVERIFY(!table->contains(utcMSecs(QDate(1960, 6, 1), QTime(0, 0, 0))));
+    QVERIFY(!table->localOffsets(localMSecs(QDate(1960, 6, 1), QTime(0, 0, 0)), offsets));
 }
 
 ////////////////////
@@ -2895,6 +2994,7 @@ void KADateTimeTest::strings_iso8601()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     KADateTime dtlocal(QDate(1999, 12, 11), QTime(3, 45, 6, 12), KADateTime::LocalZone);
     QString s = dtlocal.toString(KADateTime::ISODate);
@@ -3123,6 +3223,7 @@ void KADateTimeTest::strings_iso8601()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::strings_rfc2822()
@@ -3133,6 +3234,7 @@ void KADateTimeTest::strings_rfc2822()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     bool negZero = true;
     KADateTime dtlocal(QDate(1999, 12, 11), QTime(3, 45, 6), KADateTime::LocalZone);
@@ -3321,6 +3423,7 @@ void KADateTimeTest::strings_rfc2822()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::strings_rfc3339()
@@ -3331,6 +3434,7 @@ void KADateTimeTest::strings_rfc3339()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     bool negZero = true;
     KADateTime dtlocal(QDate(1999, 2, 9), QTime(3, 45, 6, 236), KADateTime::LocalZone);
@@ -3427,6 +3531,7 @@ void KADateTimeTest::strings_rfc3339()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::strings_qttextdate()
@@ -3437,6 +3542,7 @@ void KADateTimeTest::strings_qttextdate()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     bool negZero = true;
     KADateTime dtlocal(QDate(1999, 12, 11), QTime(3, 45, 6), KADateTime::LocalZone);
@@ -3519,6 +3625,7 @@ void KADateTimeTest::strings_qttextdate()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::strings_format()
@@ -3533,6 +3640,7 @@ void KADateTimeTest::strings_format()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     QLocale locale;
 
@@ -3749,6 +3857,7 @@ void KADateTimeTest::strings_format()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 #ifdef COMPILING_TESTS
@@ -3763,10 +3872,12 @@ void KADateTimeTest::cache()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":Europe/London");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Ensure that local time is different from UTC and different from 'london'
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     int utcHit  = KADateTime_utcCacheHit;
     int zoneHit = KADateTime_zoneCacheHit;
@@ -3838,6 +3949,7 @@ void KADateTimeTest::cache()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 #endif /* COMPILING_TESTS */
 
@@ -3847,6 +3959,7 @@ void KADateTimeTest::stream()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     // Ensure that the original contents of the KADateTime receiving a streamed value
     // don't affect the new contents.
@@ -3897,6 +4010,7 @@ void KADateTimeTest::stream()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KADateTimeTest::misc()
@@ -3905,6 +4019,7 @@ void KADateTimeTest::misc()
     QByteArray originalZone = qgetenv("TZ");   // save the original local time zone
     qputenv("TZ", ":America/Los_Angeles");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     KADateTime local = KADateTime::currentLocalDateTime();
     KADateTime utc = KADateTime::currentUtcDateTime();
@@ -3928,6 +4043,7 @@ void KADateTimeTest::misc()
         qputenv("TZ", originalZone);
     }
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 #include "moc_kadatetimetest.cpp"
@@ -32,6 +32,7 @@ private Q_SLOTS:
     void addMSecs();
     void addSubtractDate();
     void dstShifts();
+    void tzTransitions();
     void strings_iso8601();
     void strings_rfc2822();
     void strings_rfc3339();
@@ -0,0 +1,164 @@
+/*
+   This file is part of kalarmcal library, which provides access to KAlarm
+   calendar data.
+
+   SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kaeventbenchmark.h"
+
+#include "kaevent.h"
+using namespace KAlarmCal;
+
+#include <KCalendarCore/Event>
+using namespace KCalendarCore;
+
+#include <QElapsedTimer>
+#include <QTest>
+
+QTEST_GUILESS_MAIN(KAEventBenchmark)
+
+namespace
+{
+const int EVENT_COUNT = 50000;   // number of events in the benchmark calendar
+
+// Create a calendar's worth of events, with a mixture of alarm types, flags,
+// recurrences, reminders and deferrals.
+QList<KAEvent> createEvents()
+{
+    const KADateTime start(QDate(2026, 1, 1), QTime(9, 0, 0), QTimeZone("Europe/London"));
+    const QFont font(QStringLiteral("Helvetica"), 10, QFont::Bold, true);
+    QList<KAEvent> events;
+    events.reserve(EVENT_COUNT);
+    for (int i = 0;  i < EVENT_COUNT;  ++i)
+    {
+        const KADateTime dt = start.addSecs(i * 617);
+        KAEvent::SubAction action = KAEvent::SubAction::Message;
+        KAEvent::Flags flags = KAEvent::ConfirmAck;
+        switch (i % 4)
+        {
+            case 1:  action = KAEvent::SubAction::Command;  flags = KAEvent::DisplayCommand;  break;
+            case 2:  flags |= KAEvent::Beep | KAEvent::AutoClose;  break;
+            case 3:  flags = KAEvent::ExcludeHolidays | KAEvent::WorkTimeOnly;  break;
+            default:  break;
+        }
+        KAEvent event(dt, QStringLiteral("Name %1").arg(i), QStringLiteral("Alarm text %1").arg(i),
+                      Qt::white, Qt::black, font, action, (i % 3) * 5, flags);
+        event.setEventId(QStringLiteral("KAlarm-benchmark-%1").arg(i));
+        event.setCategory(CalEvent::ACTIVE);
+        switch (i % 5)
+        {
+            case 0:
+                event.setRecurDaily(1, QBitArray(7, true), -1, QDate());
+                break;
+            case 1:
+                event.setRecurAnnualByDate(1, QList<int>{dt.date().month()}, dt.date().day(), KARecurrence::Feb29_Mar1, -1, QDate());
+                break;
+            case 2:
+                event.setReminder(30, (i % 2));
+                break;
+            default:
+                break;
+        }
+        if (i % 7 == 0)
+            event.setDeferDefaultMinutes(10, (i % 2));
+        events += event;
+    }
+    return events;
+}
+}
+
+void KAEventBenchmark::fromKCalEvent()
+{
+    // Create a calendar's worth of KCalendarCore events.
+    const QList<KAEvent> events = createEvents();
+    Event::List kcalEvents;
+    kcalEvents.reserve(EVENT_COUNT);
+    for (const KAEvent& event : events)
+    {
+        Event::Ptr kcalEvent(new Event);
+        QVERIFY(event.updateKCalEvent(kcalEvent, KAEvent::UidAction::Set));
+        kcalEvents.append(kcalEvent);
+    }
+
+    // Measure the cost of constructing KAEvents from the KCalendarCore events.
+    QElapsedTimer timer;
+    timer.start();
+    int valid = 0;
+    for (const Event::Ptr& kcalEvent : std::as_const(kcalEvents))
+    {
+        const KAEvent event(kcalEvent);
+        if (event.isValid())
+            ++valid;
+    }
+    const qint64 nsecs = timer.nsecsElapsed();
+    QCOMPARE(valid, EVENT_COUNT);
+    QTest::setBenchmarkResult(static_cast<qreal>(nsecs) / EVENT_COUNT, QTest::WalltimeNanoseconds);
+}
+
+void KAEventBenchmark::updateKCalEvent_data()
+{
+    QTest::addColumn<bool>("changed");
+    QTest::newRow("unchanged") << false;
+    QTest::newRow("deferred")  << true;
+}
+
+// updateKCalEvent() only writes the properties and alarms which differ from
+// those already in the KCalendarCore event. Check that this is no slower than
+// rewriting the KCalendarCore event in full, i.e. clearing its custom
+// properties and alarms and then writing everything.
+void KAEventBenchmark::updateKCalEvent()
+{
+    QFETCH(bool, changed);
+
+    QList<KAEvent> events = createEvents();
+    Event::List diffEvents;
+    Event::List fullEvents;
+    diffEvents.reserve(EVENT_COUNT);
+    fullEvents.reserve(EVENT_COUNT);
+    for (KAEvent& event : events)
+    {
+        Event::Ptr diffEvent(new Event);
+        Event::Ptr fullEvent(new Event);
+        QVERIFY(event.updateKCalEvent(diffEvent, KAEvent::UidAction::Set));
+        QVERIFY(event.updateKCalEvent(fullEvent, KAEvent::UidAction::Set));
+        diffEvents.append(diffEvent);
+        fullEvents.append(fullEvent);
+        if (changed)
+            event.defer(event.mainDateTime().addMins(10), false);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0;  i < EVENT_COUNT;  ++i)
+        events.at(i).updateKCalEvent(diffEvents.at(i), KAEvent::UidAction::Set);
+    const qint64 diffNsecs = timer.nsecsElapsed();
+
+    timer.restart();
+    for (int i = 0;  i < EVENT_COUNT;  ++i)
+    {
+        const Event::Ptr& fullEvent = fullEvents.at(i);
+        fullEvent->startUpdates();
+        fullEvent->setCustomProperties(QMap<QByteArray, QString>());
+        fullEvent->clearAlarms();
+        events.at(i).updateKCalEvent(fullEvent, KAEvent::UidAction::Set);
+        fullEvent->endUpdates();
+    }
+    const qint64 fullNsecs = timer.nsecsElapsed();
+
+    // Both methods must give the same result.
+    for (int i = 0;  i < EVENT_COUNT;  ++i)
+    {
+        QCOMPARE(diffEvents.at(i)->customProperties(), fullEvents.at(i)->customProperties());
+        QCOMPARE(diffEvents.at(i)->alarms().count(), fullEvents.at(i)->alarms().count());
+        QCOMPARE(diffEvents.at(i)->dtStart(), fullEvents.at(i)->dtStart());
+    }
+    QVERIFY2(diffNsecs <= fullNsecs,
+             qPrintable(QStringLiteral("Updating changed items takes %1 ns per event, full rewrite %2 ns")
+                        .arg(diffNsecs / EVENT_COUNT).arg(fullNsecs / EVENT_COUNT)));
+    QTest::setBenchmarkResult(static_cast<qreal>(diffNsecs) / EVENT_COUNT, QTest::WalltimeNanoseconds);
+}
+
+#include "moc_kaeventbenchmark.cpp"
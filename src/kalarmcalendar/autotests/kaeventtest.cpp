@@ -1236,6 +1236,7 @@ void KAEventTest::toKCalEvent()
     const QByteArray originalZone = qgetenv("TZ");   // save the original system time zone
     qputenv("TZ", ":Europe/Berlin");
     ::tzset();
+    KADateTime::refreshLocalZone();
 
     {
         // Event category, UID, revision, start time using time zone, created time
@@ -1288,6 +1289,83 @@ void KAEventTest::toKCalEvent()
             QCOMPARE(kcalevent->dtStart().toTimeZone(sysTz), QDateTime(dtl.date(), dtl.time(), sysTz));
         QCOMPARE(kcalevent->created(), createdDt.qDateTime());
     }
+    {
+        // Updating an existing event leaves unchanged alarms in place
+        KAEvent event(dt, name, text, bgColour, fgColour, font, KAEvent::SubAction::Message, 3, KAEvent::ConfirmAck);
+        event.setEventId(uid);
+        event.setCategory(CalEvent::ACTIVE);
+        Event::Ptr kcalevent(new Event);
+        QVERIFY(event.updateKCalEvent(kcalevent, KAEvent::UidAction::Set, true));
+        const Alarm::List kcalalarms = kcalevent->alarms();
+        QCOMPARE(kcalalarms.size(), 1);
+        QVERIFY(event.updateKCalEvent(kcalevent, KAEvent::UidAction::Check, true));
+        QCOMPARE(kcalevent->alarms(), kcalalarms);
+        event.setLateCancel(5);
+        QVERIFY(event.updateKCalEvent(kcalevent, KAEvent::UidAction::Check, true));
+        QCOMPARE(kcalevent->alarms(), kcalalarms);
+        QStringList flags = kcalevent->customProperty("KALARM", "FLAGS").split(SC);
+        QCOMPARE(flags.size(), 3);   // must contain LATECANCEL;5 and ACKCONF
+        QCOMPARE(flags.removeAll(QStringLiteral("ACKCONF")), 1);
+        QCOMPARE(flags.at(1), QStringLiteral("5"));
+        QCOMPARE(kcalevent->customProperty("KALARM", "TYPE"), QStringLiteral("ACTIVE"));
+        event.setEnabled(false);
+        QVERIFY(event.updateKCalEvent(kcalevent, KAEvent::UidAction::Check, true));
+        QCOMPARE(kcalevent->customStatus(), QStringLiteral("DISABLED"));
+        QCOMPARE(kcalevent->alarms(), kcalalarms);
+    }
+    {
+        // Updating an existing event rewrites alarms whose KAlarm properties
+        // have changed: sub-repetition progress (NEXTREPEAT)
+        KAEvent event(dt, name, text, bgColour, fgColour, font, KAEvent::SubAction::Message, 0, KAEvent::ConfirmAck);
+        event.setEventId(uid);
+        event.setCategory(CalEvent::ACTIVE);
+        QVERIFY(event.setRecurMinutely(60, 10, KADateTime()));
+        QVERIFY(event.setRepetition(Repetition(Duration(10 * 60, Duration::Seconds), 3)));
+        Event::Ptr kcalevent(new Event);
+        QVERIFY(event.updateKCalEvent(kcalevent, KAEvent::UidAction::Set, true));
+        QCOMPARE(kcalevent->alarms().size(), 1);
+        QCOMPARE(kcalevent->alarms().at(0)->customProperty("KALARM", "NEXTREPEAT"), QStringLiteral("0"));
+        event.setNextOccurrence(dt.addSecs(15 * 60));
+        QCOMPARE(event.nextRepetition(), 2);
+        QVERIFY(event.updateKCalEvent(kcalevent, KAEvent::UidAction::Check, true));
+        QCOMPARE(kcalevent->alarms().size(), 1);
+        QCOMPARE(kcalevent->alarms().at(0)->customProperty("KALARM", "NEXTREPEAT"), QStringLiteral("2"));
+    }
+    {
+        // Colours and font (FONTCOLOR)
+        KAEvent event(dt, name, text, bgColour, fgColour, font, KAEvent::SubAction::Message, 0, KAEvent::ConfirmAck);
+        event.setEventId(uid);
+        event.setCategory(CalEvent::ACTIVE);
+        Event::Ptr kcalevent(new Event);
+        QVERIFY(event.updateKCalEvent(kcalevent, KAEvent::UidAction::Set, true));
+        const QColor newBgColour(0x20, 0x30, 0x40);
+        KAEvent event2(dt, name, text, newBgColour, fgColour, font, KAEvent::SubAction::Message, 0, KAEvent::ConfirmAck);
+        event2.setEventId(uid);
+        event2.setCategory(CalEvent::ACTIVE);
+        QVERIFY(event2.updateKCalEvent(kcalevent, KAEvent::UidAction::Check, true));
+        QCOMPARE(kcalevent->alarms().size(), 1);
+        QCOMPARE(kcalevent->alarms().at(0)->customProperty("KALARM", "FONTCOLOR").toUpper(), (QStringLiteral("#203040;#826EF0;") + font.toString()).toUpper());
+        event2.setNotify(true);
+        QVERIFY(event2.updateKCalEvent(kcalevent, KAEvent::UidAction::Check, true));
+        QCOMPARE(kcalevent->alarms().size(), 1);
+        QVERIFY(kcalevent->alarms().at(0)->customProperty("KALARM", "FONTCOLOR").isEmpty());
+    }
+    {
+        // Email identity (FLAGS)
+        const Person::List addressees{Person(QStringLiteral("Fred"), QStringLiteral("fred@freddy.com"))};
+        KAEvent event(dt, name, text, bgColour, fgColour, font, KAEvent::SubAction::Email, 0, {});
+        event.setEventId(uid);
+        event.setCategory(CalEvent::ACTIVE);
+        event.setEmail(2589, addressees, QStringLiteral("subject"), QStringList());
+        Event::Ptr kcalevent(new Event);
+        QVERIFY(event.updateKCalEvent(kcalevent, KAEvent::UidAction::Set, true));
+        QCOMPARE(kcalevent->alarms().size(), 1);
+        QCOMPARE(kcalevent->alarms().at(0)->customProperty("KALARM", "FLAGS"), QStringLiteral("EMAILID;2589"));
+        event.setEmail(3141, addressees, QStringLiteral("subject"), QStringList());
+        QVERIFY(event.updateKCalEvent(kcalevent, KAEvent::UidAction::Check, true));
+        QCOMPARE(kcalevent->alarms().size(), 1);
+        QCOMPARE(kcalevent->alarms().at(0)->customProperty("KALARM", "FLAGS"), QStringLiteral("EMAILID;3141"));
+    }
 
     // Restore the original system time zone
     if (originalZone.isEmpty())
@@ -1295,6 +1373,7 @@ void KAEventTest::toKCalEvent()
     else
         qputenv("TZ", originalZone);
     ::tzset();
+    KADateTime::refreshLocalZone();
 }
 
 void KAEventTest::setNextOccurrence()
@@ -0,0 +1,94 @@
+/*
+   This file is part of kalarmcal library, which provides access to KAlarm
+   calendar data.
+
+   SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "karecurrencetest.h"
+
+#include "karecurrence.h"
+using namespace KAlarmCal;
+
+#include <KCalendarCore/Duration>
+using namespace KCalendarCore;
+
+#include <QTest>
+
+QTEST_GUILESS_MAIN(KARecurrenceTest)
+
+void KARecurrenceTest::annualFeb29()
+{
+    // Test that next and previous recurrences of annual February 29th
+    // recurrences are correct, and stay correct when the recurrence changes.
+    const QTime time(10, 0, 0);
+    const KADateTime start(QDate(2024, 2, 29), time, KADateTime::UTC);
+
+    KARecurrence recur;
+    QVERIFY(recur.set(KARecurrence::ANNUAL_DATE, 1, -1, start, KADateTime(), KARecurrence::Feb29_Feb28));
+    QCOMPARE(recur.type(), KARecurrence::ANNUAL_DATE);
+    QCOMPARE(recur.getNextDateTime(start), KADateTime(QDate(2025, 2, 28), time, KADateTime::UTC));
+    QCOMPARE(recur.getNextDateTime(start), KADateTime(QDate(2025, 2, 28), time, KADateTime::UTC));
+    QCOMPARE(recur.getPreviousDateTime(KADateTime(QDate(2027, 1, 1), time, KADateTime::UTC)),
+             KADateTime(QDate(2026, 2, 28), time, KADateTime::UTC));
+
+    // An exception date must take effect in subsequent queries.
+    recur.addExDate(QDate(2025, 2, 28));
+    QCOMPARE(recur.getNextDateTime(start), KADateTime(QDate(2026, 2, 28), time, KADateTime::UTC));
+
+    // Changing the February 29th type must take effect in subsequent queries.
+    QVERIFY(recur.set(KARecurrence::ANNUAL_DATE, 1, -1, start, KADateTime(), KARecurrence::Feb29_Mar1));
+    QCOMPARE(recur.getNextDateTime(start), KADateTime(QDate(2025, 3, 1), time, KADateTime::UTC));
+
+    // Changing a copy must not affect the original.
+    KARecurrence copy(recur);
+    QCOMPARE(copy.getNextDateTime(start), KADateTime(QDate(2025, 3, 1), time, KADateTime::UTC));
+    copy.addExDate(QDate(2025, 3, 1));
+    QCOMPARE(copy.getNextDateTime(start), KADateTime(QDate(2026, 3, 1), time, KADateTime::UTC));
+    QCOMPARE(recur.getNextDateTime(start), KADateTime(QDate(2025, 3, 1), time, KADateTime::UTC));
+
+    QVERIFY(recur.set(KARecurrence::ANNUAL_DATE, 1, -1, start, KADateTime(), KARecurrence::Feb29_None));
+    QCOMPARE(recur.getNextDateTime(start), KADateTime(QDate(2028, 2, 29), time, KADateTime::UTC));
+    QCOMPARE(recur.getPreviousDateTime(KADateTime(QDate(2028, 2, 28), time, KADateTime::UTC)), start);
+}
+
+void KARecurrenceTest::nextPrevious()
+{
+    // Test that successive and repeated next and previous recurrence queries
+    // give correct results, including after the recurrence changes.
+    const QTime time(10, 0, 0);
+    const KADateTime start(QDate(2025, 1, 1), time, KADateTime::UTC);
+    KARecurrence recur;
+    QVERIFY(recur.set(KARecurrence::DAILY, 2, 40, start, KADateTime()));
+
+    KADateTime dt = start;
+    for (int i = 1;  i < 40;  ++i)
+    {
+        dt = recur.getNextDateTime(dt);
+        QCOMPARE(dt, start.addDays(i * 2));
+    }
+    QVERIFY(!recur.getNextDateTime(dt).isValid());
+    QCOMPARE(recur.getNextDateTime(start.addDays(71)), start.addDays(72));
+    QCOMPARE(recur.getNextDateTime(start.addDays(71)), start.addDays(72));
+    QCOMPARE(recur.getPreviousDateTime(start.addDays(71)), start.addDays(70));
+    QCOMPARE(recur.getPreviousDateTime(start.addDays(100)), start.addDays(78));
+    QCOMPARE(recur.getPreviousDateTime(start.addDays(1)), start);
+    QVERIFY(!recur.getPreviousDateTime(start).isValid());
+    QCOMPARE(recur.getNextDateTime(start.addDays(-10)), start);
+
+    recur.addExDate(QDate(2025, 3, 14));   // start + 72 days
+    QCOMPARE(recur.getNextDateTime(start.addDays(71)), start.addDays(74));
+    QCOMPARE(recur.getPreviousDateTime(start.addDays(74)), start.addDays(70));
+
+    QCOMPARE(recur.regularInterval(), Duration(2, Duration::Days));
+    QCOMPARE(recur.longestInterval(), Duration(2, Duration::Days));
+    recur.setFrequency(3);
+    QCOMPARE(recur.regularInterval(), Duration(3, Duration::Days));
+    QCOMPARE(recur.longestInterval(), Duration(3, Duration::Days));
+}
+
+#include "moc_karecurrencetest.cpp"
+
+// vim: et sw=4:
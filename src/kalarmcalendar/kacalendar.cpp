@@ -80,12 +80,9 @@ void setKAlarmVersion(const Calendar::Ptr& calendar)
 */
 int updateVersion(const FileStorage::Ptr& fileStorage, QString& versionString)
 {
-    QString subVersion;
-    const int version = Private::readKAlarmVersion(fileStorage, subVersion, versionString);
-    if (version == CurrentFormat)
-        return CurrentFormat;    // calendar is in the current KAlarm format
-    if (version == IncompatibleFormat  ||  version > KAEvent::currentCalendarVersion())
-        return IncompatibleFormat;    // calendar was created by another program, or an unknown version of KAlarm
+    const int version = checkVersion(fileStorage, versionString);
+    if (version == CurrentFormat  ||  version == IncompatibleFormat)
+        return version;
 
     // Calendar was created by an earlier version of KAlarm.
     // Convert events to current KAlarm format for when/if the calendar is saved.
@@ -96,6 +93,21 @@ int updateVersion(const FileStorage::Ptr& fileStorage, QString& versionString)
     return version;
 }
 
+/******************************************************************************
+* Check the version of KAlarm which wrote a calendar file, without converting
+* its events.
+*/
+int checkVersion(const FileStorage::Ptr& fileStorage, QString& versionString)
+{
+    QString subVersion;
+    const int version = Private::readKAlarmVersion(fileStorage, subVersion, versionString);
+    if (version == CurrentFormat)
+        return CurrentFormat;    // calendar is in the current KAlarm format
+    if (version == IncompatibleFormat  ||  version > KAEvent::currentCalendarVersion())
+        return IncompatibleFormat;    // calendar was created by another program, or an unknown version of KAlarm
+    return version;
+}
+
 } // namespace KACalendar
 
 /******************************************************************************
@@ -322,12 +334,14 @@ void setStatus(const Event::Ptr& event, Type status, const QString& param)
         case ARCHIVED:    text = staticStrings->ARCHIVED_STATUS;  break;
         case DISPLAYING:  text = staticStrings->DISPLAYING_STATUS;  break;
         default:
-            event->removeCustomProperty(KACalendar::APPNAME, staticStrings->STATUS_PROPERTY);
+            if (!event->customProperty(KACalendar::APPNAME, staticStrings->STATUS_PROPERTY).isNull())
+                event->removeCustomProperty(KACalendar::APPNAME, staticStrings->STATUS_PROPERTY);
             return;
     }
     if (!param.isEmpty())
         text += ';'_L1 + param;
-    event->setCustomProperty(KACalendar::APPNAME, staticStrings->STATUS_PROPERTY, text);
+    if (event->customProperty(KACalendar::APPNAME, staticStrings->STATUS_PROPERTY) != text)
+        event->setCustomProperty(KACalendar::APPNAME, staticStrings->STATUS_PROPERTY, text);
 }
 
 Type type(const QString& mimeType)
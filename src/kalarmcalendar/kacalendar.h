@@ -82,6 +82,16 @@ enum
  */
 KALARMCAL_EXPORT int updateVersion(const KCalendarCore::FileStorage::Ptr&, QString& versionString);
 
+/** Check the version of KAlarm which wrote a calendar file, without
+ *  converting it. The calendar's events may then be converted separately by
+ *  KAEvent::convertKCalEvents().
+ *
+ *  @param fileStorage    calendar stored in local file
+ *  @param versionString  receives calendar's KAlarm version as a string
+ *  @return as for updateVersion().
+ */
+KALARMCAL_EXPORT int checkVersion(const KCalendarCore::FileStorage::Ptr&, QString& versionString);
+
 /** Set the KAlarm version custom property for a calendar. */
 KALARMCAL_EXPORT void setKAlarmVersion(const KCalendarCore::Calendar::Ptr&);
 
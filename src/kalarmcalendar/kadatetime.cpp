@@ -1,4 +1,3 @@
-//#define SIMULATION
 /*
  *  kadatetime.cpp  -  represents a date and optional time with a time zone
  *  This file is part of kalarmcalendar library, which provides access to KAlarm
@@ -12,16 +11,22 @@
 
 #include "kadatetime.h"
 
+#include "tztransitions.h"
+
 #include <QDataStream>
 #include <QDebug>
 #include <QLocale>
+#include <QMutex>
 #include <QRegularExpression>
 #include <QSharedData>
 #include <QStringList>
 #include <QTimeZone>
 using namespace Qt::Literals::StringLiterals;
 
+#include <atomic>
+#include <chrono>
 #include <limits>
+#include <memory>
 
 namespace
 {
@@ -60,6 +65,13 @@ QDateTime toZoneTime(const QTimeZone& tz, const QDateTime& utcDateTime, bool* se
 bool checkTzTransitionOccurrence(const QDateTime& dt, const QDateTime& utcDateTime);
 int  checkTzTransitionBackwards(QTimeZone::OffsetData& transition, const QTimeZone& tz, const QDateTime& utcDateTime, const QDateTime& tzDateTime = {});
 
+// Return the shared snapshot of the local system time zone, and optionally its generation.
+QTimeZone systemZone(int* generation = nullptr);
+// Return the generation number of the local system time zone snapshot.
+int  systemZoneGeneration();
+// Re-read the local system time zone, and update the snapshot if it has changed.
+void refreshSystemZone();
+
 /** Return the Qt timespec for a QDateTime. If UTC, returns Qt::UTC.
  *  Note that QDateTime::timeSpec() returns QTimeZone for a UTC time (since Qt 6.6 approx). */
 inline Qt::TimeSpec qTimeSpec(const QDateTime& qdt)
@@ -142,7 +154,7 @@ void KADateTime::Spec::setType(SpecType type, int utcOffset)
             d->type = type;
             break;
         case KADateTime::LocalZone:
-            d->tz = QTimeZone::systemTimeZone();
+            d->tz = systemZone();
             d->type = type;
             break;
         case KADateTime::TimeZone:
@@ -191,7 +203,7 @@ QTimeZone KADateTime::Spec::namedTimeZone() const
         case KADateTime::UTC:
             return QTimeZone::utc();
         case KADateTime::LocalZone:
-            return QTimeZone::systemTimeZone();
+            return systemZone();
         default:
             return {};
     }
@@ -256,7 +268,7 @@ bool KADateTime::Spec::equivalentTo(const Spec& other) const
         if ((d->type == KADateTime::UTC && other.d->type == KADateTime::OffsetFromUTC && other.d->utcOffset == 0)
         ||  (other.d->type == KADateTime::UTC && d->type == KADateTime::OffsetFromUTC && d->utcOffset == 0))
             return true;
-        const QTimeZone local = QTimeZone::systemTimeZone();
+        const QTimeZone local = systemZone();
         if ((d->type == KADateTime::LocalZone && other.d->type == KADateTime::TimeZone && other.d->tz == local)
         ||  (other.d->type == KADateTime::LocalZone && d->type == KADateTime::TimeZone && d->tz == local))
             return true;
@@ -386,7 +398,7 @@ public:
                 break;
             case Qt::LocalTime:
                 specType = KADateTime::LocalZone;
-                mDt.setTimeZone(QTimeZone::systemTimeZone());
+                mDt.setTimeZone(systemZone(&localZoneGen));
                 break;
         }
         // Evaluate m2ndOccurrence
@@ -505,7 +517,7 @@ public:
     QTimeZone timeZoneOrLocal() const
     {
         return (specType == KADateTime::TimeZone) ? mDt.timeZone()
-             : (specType == KADateTime::LocalZone) ? QTimeZone::systemTimeZone() : QTimeZone();
+             : (specType == KADateTime::LocalZone) ? systemZone() : QTimeZone();
     }
     int  timeZoneOffset(QTimeZone& local) const;
     QDateTime toUtc(QTimeZone& local) const;
@@ -538,6 +550,7 @@ public:
     // For simulating the current time:
     static qint64        simulationOffset;    // offset to apply to current system time
     static QTimeZone     simulationLocalZone; // time zone to use
+    static QDateTime     simulationFrozenUtc; // frozen simulated time (UTC), or invalid if not frozen
 #endif
 #endif
 
@@ -551,6 +564,9 @@ private:
     // the cached UTC time, instead of Qt::LocalTime which doesn't handle historical
     // daylight savings times.
     QDateTime             mDt;
+    // For specType = LocalZone, the generation of the system time zone snapshot
+    // which mDt was last checked against.
+    mutable int           localZoneGen {-1};
 public:
     mutable QDateTime     ut;          // cached UTC equivalent of 'mDt'
 private:
@@ -570,6 +586,7 @@ QTime KADateTimePrivate::sod(0, 0, 0);
 #ifndef NDEBUG
 qint64    KADateTimePrivate::simulationOffset = 0;
 QTimeZone KADateTimePrivate::simulationLocalZone;
+QDateTime KADateTimePrivate::simulationFrozenUtc;
 #endif
 #endif
 
@@ -604,7 +621,7 @@ void KADateTimePrivate::setDtSpec(const KADateTime::Spec& s)
             mDt.setTimeZone(s.namedTimeZone());
             break;
         case KADateTime::LocalZone:
-            mDt.setTimeZone(QTimeZone::systemTimeZone());
+            mDt.setTimeZone(systemZone(&localZoneGen));
             break;
         case KADateTime::Invalid:
         default:
@@ -706,20 +723,26 @@ void KADateTimePrivate::clearSecs()
 
 /******************************************************************************
 * Return mDt, updated to current system time zone if it's LocalZone.
+* The system time zone is only compared with mDt's time zone if the shared
+* system time zone snapshot has changed since mDt was last checked.
 * Parameters:
-*   local - the local time zone if already known (if invalid, this function will
-*           fetch it if required)
+*   local - updated to the local time zone, if it's LocalZone
 */
 QDateTime KADateTimePrivate::updatedDt(QTimeZone& local) const
 {
     if (specType == KADateTime::LocalZone)
     {
-        local = QTimeZone::systemTimeZone();
-        if (mDt.timeZone() != local)
+        if (localZoneGen != systemZoneGeneration())
         {
-            const_cast<QDateTime*>(&mDt)->setTimeZone(local);
-            utcCached = convertedCached = false;
+            local = systemZone(&localZoneGen);
+            if (mDt.timeZone() != local)
+            {
+                const_cast<QDateTime*>(&mDt)->setTimeZone(local);
+                utcCached = convertedCached = false;
+            }
         }
+        else
+            local = mDt.timeZone();
     }
     return mDt;
 }
@@ -797,7 +820,7 @@ void KADateTimePrivate::setDateTime(const QDateTime& d)
         case Qt::LocalTime:
             // Qt::LocalTime doesn't handle historical daylight savings times,
             // so use the local time zone instead.
-            setDateTime(QDateTime(d.date(), d.time(), QTimeZone::systemTimeZone()));
+            setDateTime(QDateTime(d.date(), d.time(), systemZone()));
             break;
     }
 }
@@ -920,30 +943,13 @@ QDateTime KADateTimePrivate::toUtc(QTimeZone& local) const
     if (utcCached)
     {
         // Return cached UTC value
-        if (specType == KADateTime::LocalZone)
-        {
-            // LocalZone uses the dynamic current local system time zone.
-            // Check for a time zone change before using the cached UTC value.
-            if (!local.isValid())
-                local = QTimeZone::systemTimeZone();
-            if (mDt.timeZone() == local)
-            {
-//                qDebug() << "toUtc(): cached -> " << cachedUtc() << endl,
-#ifdef COMPILING_TESTS
-                ++KADateTime_utcCacheHit;
-#endif
-                return cachedUtc();
-            }
-            utcCached = false;
-        }
-        else
-        {
-//            qDebug() << "toUtc(): cached -> " << cachedUtc() << endl,
+        // LocalZone uses the dynamic current local system time zone, but
+        // updatedDt() has already discarded the cached value if it has changed.
+//        qDebug() << "toUtc(): cached -> " << cachedUtc() << endl,
 #ifdef COMPILING_TESTS
-            ++KADateTime_utcCacheHit;
+        ++KADateTime_utcCacheHit;
 #endif
-            return cachedUtc();
-        }
+        return cachedUtc();
     }
 
     // No cached UTC value, so calculate it
@@ -1172,7 +1178,7 @@ QTimeZone KADateTime::namedTimeZone() const
         case TimeZone:
             return d->timeZone();
         case LocalZone:
-            return QTimeZone::systemTimeZone();
+            return systemZone();
         default:
             return {};
     }
@@ -1269,7 +1275,7 @@ KADateTime KADateTime::toLocalZone() const
         return {};
     if (d->dateOnly())
         return KADateTime(d->date(), LocalZone);
-    QTimeZone local = QTimeZone::systemTimeZone();
+    QTimeZone local = systemZone();
     if (d->specType == TimeZone && d->timeZone() == local)
         return KADateTime(d->date(), d->time(), LocalZone);
     switch (d->specType)
@@ -1499,7 +1505,7 @@ qint64 KADateTime::daysTo(const KADateTime& t2) const
             dat = t2.d->toZone(d->timeZone(), local).date();   // this caches the converted time in t2
             break;
         case LocalZone:
-            local = QTimeZone::systemTimeZone();
+            local = systemZone();
             dat = t2.d->toZone(local, local).date();   // this caches the converted time in t2
             break;
         default:    // invalid
@@ -1518,9 +1524,9 @@ KADateTime KADateTime::currentLocalDateTime()
         dt.setSpec(LocalZone);
         return dt;
     }
-    if (KADateTimePrivate::simulationOffset)
+    if (KADateTimePrivate::simulationOffset  ||  KADateTimePrivate::simulationFrozenUtc.isValid())
     {
-        KADateTime dt = currentUtcDateTime().toZone(QTimeZone::systemTimeZone());
+        KADateTime dt = currentUtcDateTime().toZone(systemZone());
         dt.setSpec(LocalZone);
         return dt;
     }
@@ -1534,6 +1540,8 @@ KADateTime KADateTime::currentUtcDateTime()
     const KADateTime result(QDateTime::currentDateTimeUtc(), UTC);
 #ifndef NDEBUG
 #ifdef SIMULATION
+    if (KADateTimePrivate::simulationFrozenUtc.isValid())
+        return KADateTime(KADateTimePrivate::simulationFrozenUtc, UTC);
     return result.addSecs(KADateTimePrivate::simulationOffset);
 #else
     return result;
@@ -1550,7 +1558,7 @@ KADateTime KADateTime::currentDateTime(const Spec& spec)
         case UTC:
             return currentUtcDateTime();
         case TimeZone:
-            if (spec.namedTimeZone() != QTimeZone::systemTimeZone())
+            if (spec.namedTimeZone() != systemZone())
                 break;
             [[fallthrough]]; // fall through to LocalZone
         case LocalZone:
@@ -1936,7 +1944,7 @@ QString KADateTime::toString(const QString& format) const
                             tz = d->timeZone();
                             break;
                         case LocalZone:
-                            tz = QTimeZone::systemTimeZone();
+                            tz = systemZone();
                             break;
                         default:
                             break;
@@ -2840,20 +2848,33 @@ void KADateTime::setFromStringDefault(const Spec& spec)
     KADateTimePrivate::fromStringDefault() = spec;
 }
 
-void KADateTime::setSimulatedSystemTime(const KADateTime& newTime)
+QTimeZone KADateTime::localZone()
+{
+    return systemZone();
+}
+
+void KADateTime::refreshLocalZone()
+{
+    refreshSystemZone();
+}
+
+void KADateTime::setSimulatedSystemTime(const KADateTime& newTime, bool frozen)
 {
     Q_UNUSED(newTime)
+    Q_UNUSED(frozen)
 #ifdef SIMULATION
 #ifndef NDEBUG
     if (newTime.isValid())
     {
         KADateTimePrivate::simulationOffset = realCurrentLocalDateTime().secsTo_long(newTime);
         KADateTimePrivate::simulationLocalZone = newTime.namedTimeZone();
+        KADateTimePrivate::simulationFrozenUtc = frozen ? newTime.toUtc().qDateTime() : QDateTime();
     }
     else
     {
         KADateTimePrivate::simulationOffset = 0;
         KADateTimePrivate::simulationLocalZone = QTimeZone();
+        KADateTimePrivate::simulationFrozenUtc = QDateTime();
     }
 #endif
 #endif
@@ -2861,7 +2882,7 @@ void KADateTime::setSimulatedSystemTime(const KADateTime& newTime)
 
 KADateTime KADateTime::realCurrentLocalDateTime()
 {
-    return KADateTime(QDateTime::currentDateTime(), Spec(QTimeZone::systemTimeZone()));
+    return KADateTime(QDateTime::currentDateTime(), Spec(systemZone()));
 }
 
 QDebug operator<<(QDebug dbg, const KADateTime& dt)
@@ -2926,6 +2947,7 @@ QDataStream& operator>>(QDataStream& s, KADateTime& kdt)
 } // namespace KAlarmCal
 
 using KAlarmCal::KADateTime;
+using KAlarmCal::TzTransitions;
 
 namespace
 {
@@ -3530,6 +3552,32 @@ int offsetAtZoneTime(const QTimeZone& tz, const QDateTime& zoneDateTime, int* se
                 *secondOffset = InvalidOffset;
             return InvalidOffset;
     }
+    if (qTimeSpec(zoneDateTime) == Qt::TimeZone)
+    {
+        // Look up the offset in the time zone's transition table if possible,
+        // to avoid a slow QTimeZone lookup.
+        const std::shared_ptr<const TzTransitions> table = TzTransitions::forZone(tz);
+        TzTransitions::LocalOffsets offsets;
+        if (table  &&  table->localOffsets(TzTransitions::localMSecs(zoneDateTime), offsets))
+        {
+            switch (offsets.type)
+            {
+                case TzTransitions::LocalTime::Unique:
+                    if (secondOffset)
+                        *secondOffset = offsets.offset;
+                    return offsets.offset;
+                case TzTransitions::LocalTime::Ambiguous:
+                    if (secondOffset)
+                    {
+                        *secondOffset = offsets.secondOffset;
+                        return offsets.offset;
+                    }
+                    break;   // the offset depends on which occurrence zoneDateTime holds
+                case TzTransitions::LocalTime::Skipped:
+                    break;   // let QTimeZone decide how to adjust the time
+            }
+        }
+    }
     const int offset = tz.offsetFromUtc(zoneDateTime);
     if (secondOffset)
     {
@@ -3603,6 +3651,28 @@ bool checkTzTransitionOccurrence(const QDateTime& dt, const QDateTime& utcDateTi
 */
 int checkTzTransitionBackwards(QTimeZone::OffsetData& transition, const QTimeZone& tz, const QDateTime& utcDateTime, const QDateTime& tzDateTime)
 {
+    // Use the time zone's transition table if possible, to avoid slow QTimeZone lookups.
+    if (utcDateTime.isValid())
+    {
+        const std::shared_ptr<const TzTransitions> table = TzTransitions::forZone(tz);
+        const qint64 utcMSecs = utcDateTime.toMSecsSinceEpoch();
+        if (table  &&  table->contains(utcMSecs))
+        {
+            const qint64 localMSecs = tzDateTime.isValid() ? TzTransitions::localMSecs(tzDateTime)
+                                                           : utcMSecs + table->offsetAtUtc(utcMSecs) * 1000LL;
+            TzTransitions::LocalOffsets offsets;
+            if (table->localOffsets(localMSecs, offsets))
+            {
+                if (offsets.type != TzTransitions::LocalTime::Ambiguous)
+                    return 0;
+                // The local time occurs twice.
+                transition.atUtc         = QDateTime::fromMSecsSinceEpoch(offsets.transitionUtc, QTimeZone::utc());
+                transition.offsetFromUtc = offsets.secondOffset;
+                return offsets.secondOffset - offsets.offset;
+            }
+        }
+    }
+
     // Check if there is a daylight savings shift around utcDateTime.
     const QList<QTimeZone::OffsetData> transitions = tz.transitions(utcDateTime.addSecs(-10800), utcDateTime.addSecs(7200));
     if (!transitions.isEmpty())
@@ -3682,6 +3752,72 @@ const QString& longMonth(int month)   // Jan = 1, ...
     return (month >= 1 && month <= 12) ? longMonthNames.at(month - 1) : error;
 }
 
+/******************************************************************************
+* Snapshot of the local system time zone, shared by all KADateTime instances.
+* Fetching the system time zone is expensive, so instead of doing it every time
+* a LocalZone value is used, the snapshot is refreshed at intervals, or when
+* refreshSystemZone() is called. Its generation number is incremented whenever
+* the time zone changes, so that cached values can cheaply detect a change.
+*/
+struct SystemZoneSnapshot
+{
+    QTimeZone zone;
+    int       generation;
+};
+
+const std::chrono::seconds SYSTEM_ZONE_CHECK_INTERVAL(5);   // interval between checks for a time zone change
+
+QMutex                                    systemZoneMutex;
+std::shared_ptr<const SystemZoneSnapshot> systemZoneSnapshot;       // guarded by systemZoneMutex
+std::atomic<int>                          systemZoneGen {0};        // generation of systemZoneSnapshot
+std::atomic<qint64>                       systemZoneNextCheck {0};  // steady clock time for next check, in ms
+
+qint64 steadyMsecs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+int systemZoneGeneration()
+{
+    if (steadyMsecs() >= systemZoneNextCheck.load(std::memory_order_relaxed))
+        refreshSystemZone();
+    return systemZoneGen.load(std::memory_order_acquire);
+}
+
+QTimeZone systemZone(int* generation)
+{
+    systemZoneGeneration();   // refresh the snapshot if a check is due
+    std::shared_ptr<const SystemZoneSnapshot> snapshot;
+    {
+        QMutexLocker locker(&systemZoneMutex);
+        snapshot = systemZoneSnapshot;
+    }
+    if (!snapshot)
+    {
+        // Another thread is creating the initial snapshot
+        refreshSystemZone();
+        QMutexLocker locker(&systemZoneMutex);
+        snapshot = systemZoneSnapshot;
+    }
+    if (generation)
+        *generation = snapshot->generation;
+    return snapshot->zone;
+}
+
+void refreshSystemZone()
+{
+    systemZoneNextCheck.store(steadyMsecs() + std::chrono::milliseconds(SYSTEM_ZONE_CHECK_INTERVAL).count(),
+                              std::memory_order_relaxed);
+    const QTimeZone zone = QTimeZone::systemTimeZone();
+    QMutexLocker locker(&systemZoneMutex);
+    if (systemZoneSnapshot  &&  systemZoneSnapshot->zone == zone)
+        return;
+    const int generation = systemZoneGen.load(std::memory_order_relaxed) + 1;
+    systemZoneSnapshot = std::make_shared<const SystemZoneSnapshot>(SystemZoneSnapshot{zone, generation});
+    systemZoneGen.store(generation, std::memory_order_release);
+}
+
 } // namespace
 
 // vim: et sw=4:
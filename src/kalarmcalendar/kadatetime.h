@@ -134,7 +134,8 @@ class KADateTimeSpecPrivate;
  * This class provides a facility to simulate the local system time, which
  * affects all functions using or returning the system time. This facility is
  * provided for testing purposes only, and is only available if the library is
- * compiled with debug enabled. In release mode, simulation is inoperative and
+ * compiled with debug enabled and with the ENABLE_TIME_SIMULATION build option
+ * (which is on by default). In release mode, simulation is inoperative and
  * the real local system time is used at all times. Use
  * setSimulatedSystemTime() to set or clear the simulated time. To read the
  * real (not simulated) system time, use realCurrentLocalDateTime().
@@ -1376,6 +1377,27 @@ public:
      */
     static void setFromStringDefault(const Spec& spec);
 
+    /**
+     * Return the local system time zone, as used by @c LocalZone instances.
+     *
+     * The system time zone is held in a snapshot shared by all instances, which
+     * is checked for changes at most every few seconds. Call refreshLocalZone()
+     * to make a change of system time zone take effect immediately.
+     *
+     * @return the local system time zone
+     * @see refreshLocalZone()
+     */
+    static QTimeZone localZone();
+
+    /**
+     * Notify KADateTime that the local system time zone may have changed, so
+     * that @c LocalZone instances use the new time zone immediately rather
+     * than after the next periodic check.
+     *
+     * @see localZone()
+     */
+    static void refreshLocalZone();
+
     /**
      * Compare this instance with another to determine whether they are
      * simultaneous, earlier or later, and in the case of date-only values,
@@ -1483,6 +1505,10 @@ public:
      *
      * To cancel time simulation, supply an invalid @p newTime parameter.
      *
+     * If @p frozen is true, the simulated time does not advance with the real
+     * system time, but stays at @p newTime until this method is called again.
+     * This allows a virtual clock to control the current time exactly.
+     *
      * @warning This function is provided only for testing purposes, and should
      *          not be used in released code. If the library is compiled without
      *          debug enabled, setSimulatedSystemTime() has no effect.
@@ -1495,11 +1521,12 @@ public:
      *          \endcode
      *
      * @param newTime the current simulated time, or invalid to cancel simulation
+     * @param frozen  true to stop the simulated time advancing in real time
      *
      * @see currentDateTime(), currentLocalDateTime(), currentUtcDateTime(),
      *      currentLocalDate(), currentLocalTime()
      */
-    static void setSimulatedSystemTime(const KADateTime& newTime);
+    static void setSimulatedSystemTime(const KADateTime& newTime, bool frozen = false);
 
     /**
      * Return the real (not simulated) system time.
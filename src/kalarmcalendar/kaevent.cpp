@@ -13,11 +13,14 @@
 #include "alarmtext.h"
 #include "holidays.h"
 #include "identities.h"
+#include "tztransitions.h"
 #include "version.h"
 #include "kalarmcal_debug.h"
 
 #include <KLocalizedString>
 
+#include <QHash>
+
 using namespace KCalendarCore;
 
 namespace
@@ -260,7 +263,7 @@ public:
     static bool        convertRepetition(const KCalendarCore::Event::Ptr&);
     static bool        convertStartOfDay(const KCalendarCore::Event::Ptr&);
     static DateTime    readDateTime(const KCalendarCore::Event::Ptr&, bool localZone, bool dateOnly, DateTime& start);
-    static DateTime    readDateTime(const QString& param, const DateTime& eventStart);
+    static DateTime    readDateTime(QStringView param, const DateTime& eventStart);
     static QString     writeDateTime(const QDateTime& dt, bool dateOnly);
     static void        readAlarms(const KCalendarCore::Event::Ptr&, AlarmMap*, bool cmdDisplay = false);
     static void        readAlarm(const KCalendarCore::Alarm::Ptr&, AlarmData&, bool audioMain, bool cmdDisplay = false);
@@ -276,11 +279,10 @@ private:
     DateTime           latestRecurrence(const Triggers&) const;
 #endif
     void               setAudioAlarm(const KCalendarCore::Alarm::Ptr&) const;
-    KCalendarCore::Alarm::Ptr initKCalAlarm(const KCalendarCore::Event::Ptr&, const DateTime&, const QStringList& types, AlarmType = INVALID_ALARM) const;
-    KCalendarCore::Alarm::Ptr initKCalAlarm(const KCalendarCore::Event::Ptr&, int startOffsetSecs, const QStringList& types, AlarmType = INVALID_ALARM) const;
+    KCalendarCore::Alarm::Ptr initKCalAlarm(KCalendarCore::Alarm::List&, const DateTime&, const QStringList& types, AlarmType = INVALID_ALARM) const;
+    KCalendarCore::Alarm::Ptr initKCalAlarm(KCalendarCore::Alarm::List&, int startOffsetSecs, const QStringList& types, AlarmType = INVALID_ALARM) const;
     inline void        set_deferral(DeferType);
     inline void        activate_reminder(bool activate);
-    static int         transitionIndex(const QDateTime& utc, const QTimeZone::OffsetDataList& transitions);
 
 public:
     static QFont       mDefaultFont;       // default alarm message font
@@ -524,6 +526,44 @@ int              KAEventPrivate::mWorkTimeIndex = 1;
 static void setProcedureAlarm(const Alarm::Ptr&, const QString& commandLine);
 static QString reminderToString(int minutes);
 
+// Tokens in the X-KDE-KALARM-FLAGS event property.
+enum class EventFlag
+{
+    Unknown, DateOnly, LocalZone, ConfirmAck, EmailBcc, KOrganizer, NoInhibit,
+    WakeSuspend, ExcludeHolidays, WorkTimeOnly, Notify, KMailItem, Archive,
+    AtLogin, Reminder, Defer, Skip, TemplAfterTime, LateCancel, AutoClose
+};
+
+/******************************************************************************
+* Return the event flag represented by a token in the X-KDE-KALARM-FLAGS
+* property.
+*/
+static EventFlag eventFlag(QStringView token)
+{
+    static const QHash<QStringView, EventFlag> flags = {
+        { KAEventPrivate::DATE_ONLY_FLAG,        EventFlag::DateOnly },
+        { KAEventPrivate::LOCAL_ZONE_FLAG,       EventFlag::LocalZone },
+        { KAEventPrivate::CONFIRM_ACK_FLAG,      EventFlag::ConfirmAck },
+        { KAEventPrivate::EMAIL_BCC_FLAG,        EventFlag::EmailBcc },
+        { KAEventPrivate::KORGANIZER_FLAG,       EventFlag::KOrganizer },
+        { KAEventPrivate::NO_INHIBIT_FLAG,       EventFlag::NoInhibit },
+        { KAEventPrivate::WAKE_SUSPEND_FLAG,     EventFlag::WakeSuspend },
+        { KAEventPrivate::EXCLUDE_HOLIDAYS_FLAG, EventFlag::ExcludeHolidays },
+        { KAEventPrivate::WORK_TIME_ONLY_FLAG,   EventFlag::WorkTimeOnly },
+        { KAEventPrivate::NOTIFY_FLAG,           EventFlag::Notify },
+        { KAEventPrivate::KMAIL_ITEM_FLAG,       EventFlag::KMailItem },
+        { KAEventPrivate::ARCHIVE_FLAG,          EventFlag::Archive },
+        { KAEventPrivate::AT_LOGIN_TYPE,         EventFlag::AtLogin },
+        { KAEventPrivate::REMINDER_TYPE,         EventFlag::Reminder },
+        { KAEventPrivate::DEFER_FLAG,            EventFlag::Defer },
+        { KAEventPrivate::SKIP_FLAG,             EventFlag::Skip },
+        { KAEventPrivate::TEMPL_AFTER_TIME_FLAG, EventFlag::TemplAfterTime },
+        { KAEventPrivate::LATE_CANCEL_FLAG,      EventFlag::LateCancel },
+        { KAEventPrivate::AUTO_CLOSE_FLAG,       EventFlag::AutoClose }
+    };
+    return flags.value(token, EventFlag::Unknown);
+}
+
 /*=============================================================================
 = Class KAEvent
 = Corresponds to a KCalendarCore::Event instance.
@@ -683,111 +723,126 @@ KAEventPrivate::KAEventPrivate(const KCalendarCore::Event::Ptr& event)
             ++it;
     }
 
-    QString skipParam;
+    QStringView skipParam;
     bool dateOnly = false;
     bool localZone = false;
-    QStringList evFlags = event->customProperty(KACalendar::APPNAME, FLAGS_PROPERTY).split(SC, Qt::SkipEmptyParts);
-    evFlags << QString() << QString();    // to avoid having to check for end of list
+    // Parse the flags as views into the property string, to avoid creating
+    // a string for each flag.
+    const QString flagsProperty = event->customProperty(KACalendar::APPNAME, FLAGS_PROPERTY);
+    QList<QStringView> evFlags = QStringView(flagsProperty).split(SC, Qt::SkipEmptyParts);
+    evFlags << QStringView() << QStringView();    // to avoid having to check for end of list
     for (int i = 0, end = evFlags.count() - 1;  i < end;  ++i)
     {
-        QString flag = evFlags.at(i);
-        if (flag == DATE_ONLY_FLAG)
-            dateOnly = true;
-        else if (flag == LOCAL_ZONE_FLAG)
-            localZone = true;
-        else if (flag == CONFIRM_ACK_FLAG)
-            mConfirmAck = true;
-        else if (flag == EMAIL_BCC_FLAG)
-            mEmailBcc = true;
-        else if (flag == KORGANIZER_FLAG)
-            mCopyToKOrganizer = true;
-        else if (flag == NO_INHIBIT_FLAG)
-            mNoInhibit = true;
-        else if (flag == WAKE_SUSPEND_FLAG)
-            mWakeFromSuspend = true;
-        else if (flag == EXCLUDE_HOLIDAYS_FLAG)
-        {
-            mExcludeHolidays      = true;
-            mExcludeHolidayRegion = mHolidays->regionCode();
-        }
-        else if (flag == WORK_TIME_ONLY_FLAG)
-            mWorkTimeOnly = 1;
-        else if (flag == NOTIFY_FLAG)
-            mNotify = true;
-        else if (flag == KMAIL_ITEM_FLAG)
+        QStringView flag = evFlags.at(i);
+        const EventFlag evFlag = eventFlag(flag);
+        switch (evFlag)
         {
-            const KAEvent::EmailId id = evFlags.at(i + 1).toLongLong(&ok);
-            if (!ok)
-                continue;
-            mEmailId = id;
-            ++i;
-        }
-        else if (flag == KAEventPrivate::ARCHIVE_FLAG)
-            mArchive = true;
-        else if (flag == KAEventPrivate::AT_LOGIN_TYPE)
-            mArchiveRepeatAtLogin = true;
-        else if (flag == KAEventPrivate::REMINDER_TYPE)
-        {
-            flag = evFlags.at(++i);
-            if (flag == KAEventPrivate::REMINDER_ONCE_FLAG)
+            case EventFlag::DateOnly:
+                dateOnly = true;
+                break;
+            case EventFlag::LocalZone:
+                localZone = true;
+                break;
+            case EventFlag::ConfirmAck:
+                mConfirmAck = true;
+                break;
+            case EventFlag::EmailBcc:
+                mEmailBcc = true;
+                break;
+            case EventFlag::KOrganizer:
+                mCopyToKOrganizer = true;
+                break;
+            case EventFlag::NoInhibit:
+                mNoInhibit = true;
+                break;
+            case EventFlag::WakeSuspend:
+                mWakeFromSuspend = true;
+                break;
+            case EventFlag::ExcludeHolidays:
+                mExcludeHolidays      = true;
+                mExcludeHolidayRegion = mHolidays->regionCode();
+                break;
+            case EventFlag::WorkTimeOnly:
+                mWorkTimeOnly = 1;
+                break;
+            case EventFlag::Notify:
+                mNotify = true;
+                break;
+            case EventFlag::KMailItem:
             {
-                mReminderOnceOnly = true;
-                flag = evFlags.at(++i);
+                const KAEvent::EmailId id = evFlags.at(i + 1).toLongLong(&ok);
+                if (!ok)
+                    continue;
+                mEmailId = id;
+                ++i;
+                break;
             }
-            const int len = flag.length() - 1;
-            mReminderMinutes = -QStringView(flag).left(len).toInt();    // -> 0 if conversion fails
-            switch (flag.at(len).toLatin1())
+            case EventFlag::Archive:
+                mArchive = true;
+                break;
+            case EventFlag::AtLogin:
+                mArchiveRepeatAtLogin = true;
+                break;
+            case EventFlag::Reminder:
             {
-                case 'M':  break;
-                case 'H':  mReminderMinutes *= 60;  break;
-                case 'D':  mReminderMinutes *= 1440;  break;
-                default:   mReminderMinutes = 0;  break;
+                flag = evFlags.at(++i);
+                if (flag == KAEventPrivate::REMINDER_ONCE_FLAG)
+                {
+                    mReminderOnceOnly = true;
+                    flag = evFlags.at(++i);
+                }
+                const qsizetype len = flag.length() - 1;
+                mReminderMinutes = -flag.left(len).toInt();    // -> 0 if conversion fails
+                switch (len >= 0 ? flag.at(len).toLatin1() : 0)
+                {
+                    case 'M':  break;
+                    case 'H':  mReminderMinutes *= 60;  break;
+                    case 'D':  mReminderMinutes *= 1440;  break;
+                    default:   mReminderMinutes = 0;  break;
+                }
+                break;
             }
-        }
-        else if (flag == DEFER_FLAG)
-        {
-            QString mins = evFlags.at(i + 1);
-            if (mins.endsWith(QLatin1Char('D')))
+            case EventFlag::Defer:
             {
-                mDeferDefaultDateOnly = true;
-                mins.chop(1);
-            }
-            const int n = static_cast<int>(mins.toUInt(&ok));
-            if (!ok)
-                continue;
-            mDeferDefaultMinutes = n;
-            ++i;
-        }
-        else if (flag == SKIP_FLAG)
-        {
-            // Note the skip date/time, and process once the start date/time
-            // has been fetched.
-            skipParam = evFlags.at(++i);
-        }
-        else if (flag == TEMPL_AFTER_TIME_FLAG)
-        {
-            const int n = static_cast<int>(evFlags.at(i + 1).toUInt(&ok));
-            if (!ok)
-                continue;
-            mTemplateAfterTime = n;
-            ++i;
-        }
-        else if (flag == LATE_CANCEL_FLAG)
-        {
-            mLateCancel = static_cast<int>(evFlags.at(i + 1).toUInt(&ok));
-            if (ok)
+                QStringView mins = evFlags.at(i + 1);
+                if (mins.endsWith(QLatin1Char('D')))
+                {
+                    mDeferDefaultDateOnly = true;
+                    mins.chop(1);
+                }
+                const int n = static_cast<int>(mins.toUInt(&ok));
+                if (!ok)
+                    continue;
+                mDeferDefaultMinutes = n;
                 ++i;
-            if (!ok  ||  !mLateCancel)
-                mLateCancel = 1;    // invalid parameter defaults to 1 minute
-        }
-        else if (flag == AUTO_CLOSE_FLAG)
-        {
-            mLateCancel = static_cast<int>(evFlags.at(i + 1).toUInt(&ok));
-            if (ok)
+                break;
+            }
+            case EventFlag::Skip:
+                // Note the skip date/time, and process once the start date/time
+                // has been fetched.
+                skipParam = evFlags.at(++i);
+                break;
+            case EventFlag::TemplAfterTime:
+            {
+                const int n = static_cast<int>(evFlags.at(i + 1).toUInt(&ok));
+                if (!ok)
+                    continue;
+                mTemplateAfterTime = n;
                 ++i;
-            if (!ok  ||  !mLateCancel)
-                mLateCancel = 1;    // invalid parameter defaults to 1 minute
-            mAutoClose = true;
+                break;
+            }
+            case EventFlag::LateCancel:
+            case EventFlag::AutoClose:
+                mLateCancel = static_cast<int>(evFlags.at(i + 1).toUInt(&ok));
+                if (ok)
+                    ++i;
+                if (!ok  ||  !mLateCancel)
+                    mLateCancel = 1;    // invalid parameter defaults to 1 minute
+                if (evFlag == EventFlag::AutoClose)
+                    mAutoClose = true;
+                break;
+            case EventFlag::Unknown:
+                break;
         }
     }
 
@@ -1190,6 +1245,9 @@ void KAEventPrivate::copy(const KAEventPrivate& event)
 * custom properties are cleared and replaced with the KAEvent's custom
 * properties. If false, the KCalendarCore::Event's non-KAlarm custom properties
 * are left untouched.
+* Only those properties and alarms which differ from the KAEvent's data are
+* written to the KCalendarCore::Event, so that an update which changes little
+* only marks the changed fields as dirty.
 */
 bool KAEvent::updateKCalEvent(const KCalendarCore::Event::Ptr& e, UidAction u, bool setCustomProperties) const
 {
@@ -1210,32 +1268,37 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
     ev->startUpdates();   // prevent multiple update notifications
     checkRecur();         // ensure recurrence/repetition data is consistent
     const bool readOnly = ev->isReadOnly();
-    if (uidact == KAEvent::UidAction::Set)
+    if (uidact == KAEvent::UidAction::Set  &&  ev->uid() != mEventID)
         ev->setUid(mEventID);
     ev->setReadOnly(mReadOnly);
-    ev->setTransparency(Event::Transparent);
+    if (ev->transparency() != Event::Transparent)
+        ev->setTransparency(Event::Transparent);
 
     // Set up event-specific data
-    ev->setSummary(mName);
+    if (ev->summary() != mName)
+        ev->setSummary(mName);
 
-    // Set up custom properties.
+    // Set up custom properties. These are collected and compared with the
+    // event's existing properties, and are only written if they differ.
+    const QByteArray kalarmKey = "X-KDE-" + KACalendar::APPNAME + '-';
+    QMap<QByteArray, QString> properties;
     if (setCustomProperties)
-        ev->setCustomProperties(mCustomProperties);
-    ev->removeCustomProperty(KACalendar::APPNAME, FLAGS_PROPERTY);
-    ev->removeCustomProperty(KACalendar::APPNAME, NEXT_RECUR_PROPERTY);
-    ev->removeCustomProperty(KACalendar::APPNAME, REPEAT_PROPERTY);
-    ev->removeCustomProperty(KACalendar::APPNAME, LOG_PROPERTY);
-
-    QString param;
-    if (mCategory == CalEvent::DISPLAYING)
     {
-        param = QString::number(mResourceId);   // original resource ID which contained the event
-        if (mDisplayingDefer)
-            param += SC + DISP_DEFER;
-        if (mDisplayingEdit)
-            param += SC + DISP_EDIT;
+        properties = mCustomProperties;
+        // Retain the event's status property, which is set by CalEvent::setStatus().
+        const QString status = ev->customProperty(KACalendar::APPNAME, TYPE_PROPERTY);
+        if (!status.isEmpty())
+            properties[kalarmKey + TYPE_PROPERTY] = status;
     }
-    CalEvent::setStatus(ev, mCategory, param);
+    else
+    {
+        properties = ev->customProperties();
+        properties.remove(kalarmKey + FLAGS_PROPERTY);
+        properties.remove(kalarmKey + NEXT_RECUR_PROPERTY);
+        properties.remove(kalarmKey + REPEAT_PROPERTY);
+        properties.remove(kalarmKey + LOG_PROPERTY);
+    }
+
     QStringList evFlags;
     if (mStartDateTime.isDateOnly())
         evFlags += DATE_ONLY_FLAG;
@@ -1286,18 +1349,19 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
             evFlags += AT_LOGIN_TYPE;
     }
     if (!evFlags.isEmpty())
-        ev->setCustomProperty(KACalendar::APPNAME, FLAGS_PROPERTY, evFlags.join(SC));
+        properties[kalarmKey + FLAGS_PROPERTY] = evFlags.join(SC);
 
     if (mCommandXterm)
-        ev->setCustomProperty(KACalendar::APPNAME, LOG_PROPERTY, xtermURL);
+        properties[kalarmKey + LOG_PROPERTY] = xtermURL;
     else if (mCommandDisplay)
-        ev->setCustomProperty(KACalendar::APPNAME, LOG_PROPERTY, displayURL);
+        properties[kalarmKey + LOG_PROPERTY] = displayURL;
     else if (!mLogFile.isEmpty())
-        ev->setCustomProperty(KACalendar::APPNAME, LOG_PROPERTY, mLogFile);
+        properties[kalarmKey + LOG_PROPERTY] = mLogFile;
 
-    ev->setCustomStatus(mEnabled ? QString() : DISABLED_STATUS);
-    ev->setRevision(mRevision);
-    ev->clearAlarms();
+    if (mEnabled ? (ev->status() != Incidence::StatusNone) : (ev->customStatus() != DISABLED_STATUS))
+        ev->setCustomStatus(mEnabled ? QString() : DISABLED_STATUS);
+    if (ev->revision() != mRevision)
+        ev->setRevision(mRevision);
 
     /* Always set DTSTART as date/time, and use the category "DATE" to indicate
      * a date-only event, instead of calling setAllDay(). This is necessary to
@@ -1311,9 +1375,18 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
      * UTC DATE-TIME value. So always use a time relative to DTSTART instead of
      * an absolute time.
      */
-    ev->setDtStart(mStartDateTime.calendarDateTime());
-    ev->setAllDay(false);
-    ev->setDtEnd(QDateTime());
+    const QDateTime dtStart = mStartDateTime.calendarDateTime();
+    const QDateTime evStart = ev->dtStart();
+    if (evStart != dtStart  ||  evStart.timeSpec() != dtStart.timeSpec()  ||  evStart.timeZone() != dtStart.timeZone())
+        ev->setDtStart(dtStart);
+    if (ev->allDay())
+        ev->setAllDay(false);
+    if (ev->hasEndDate())
+        ev->setDtEnd(QDateTime());
+
+    // Set up the alarms. These are collected and compared with the event's
+    // existing alarms, and only those which differ are replaced.
+    Alarm::List alarms;
 
     const DateTime dtMain = archived ? mStartDateTime : mNextMainDateTime;
     int      ancillaryType = 0;   // 0 = invalid, 1 = time, 2 = offset
@@ -1329,11 +1402,10 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
         if (!archived  &&  checkRecur() != KARecurrence::NO_RECUR)
         {
             QDateTime dt = mNextMainDateTime.kDateTime().toTimeSpec(mStartDateTime.timeSpec()).qDateTime();
-            ev->setCustomProperty(KACalendar::APPNAME, NEXT_RECUR_PROPERTY,
-                                  writeDateTime(dt, mNextMainDateTime.isDateOnly()));
+            properties[kalarmKey + NEXT_RECUR_PROPERTY] = writeDateTime(dt, mNextMainDateTime.isDateOnly());
         }
         // Add the main alarm
-        initKCalAlarm(ev, 0, QStringList(), MAIN_ALARM);
+        initKCalAlarm(alarms, 0, QStringList(), MAIN_ALARM);
         ancillaryOffset = 0;
         ancillaryType = dtMain.isValid() ? 2 : 0;
     }
@@ -1346,7 +1418,7 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
             repparam = QStringLiteral("%1D:%2").arg(mRepetition.intervalDays()).arg(mRepetition.count());
         else
             repparam = QStringLiteral("%1M:%2").arg(mRepetition.intervalMinutes()).arg(mRepetition.count());
-        ev->setCustomProperty(KACalendar::APPNAME, REPEAT_PROPERTY, repparam);
+        properties[kalarmKey + REPEAT_PROPERTY] = repparam;
     }
 
     // Add subsidiary alarms
@@ -1361,7 +1433,7 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
             dtl = DateTime(KADateTime::currentLocalDate().addDays(-1), mStartDateTime.timeSpec());
         else
             dtl = KADateTime::currentUtcDateTime();
-        initKCalAlarm(ev, dtl, QStringList(AT_LOGIN_TYPE));
+        initKCalAlarm(alarms, dtl, QStringList(AT_LOGIN_TYPE));
         if (!ancillaryType  &&  dtl.isValid())
         {
             ancillaryTime = dtl;
@@ -1401,7 +1473,7 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
             // A reminder BEFORE the main alarm is active
             startOffset = -mReminderMinutes * 60;
         }
-        initKCalAlarm(ev, startOffset, QStringList(REMINDER_TYPE));
+        initKCalAlarm(alarms, startOffset, QStringList(REMINDER_TYPE));
         // Don't set ancillary time if the reminder AFTER is hidden by a deferral
         if (!ancillaryType  && (mReminderActive == ReminderType::Active || archived))
         {
@@ -1425,7 +1497,7 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
         }
         if (mDeferral == DeferType::Reminder)
             list += REMINDER_TYPE;
-        initKCalAlarm(ev, startOffset, list);
+        initKCalAlarm(alarms, startOffset, list);
         if (!ancillaryType  &&  mDeferralTime.isValid())
         {
             ancillaryOffset = startOffset;
@@ -1446,7 +1518,7 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
         }
         if (mDisplayingFlags & REMINDER)
             list += REMINDER_TYPE;
-        initKCalAlarm(ev, mDisplayingTime, list);
+        initKCalAlarm(alarms, mDisplayingTime, list);
         if (!ancillaryType  &&  mDisplayingTime.isValid())
         {
             ancillaryTime = mDisplayingTime;
@@ -1457,32 +1529,80 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
     {
         // A sound is specified
         if (ancillaryType == 2)
-            initKCalAlarm(ev, ancillaryOffset, QStringList(), AUDIO_ALARM);
+            initKCalAlarm(alarms, ancillaryOffset, QStringList(), AUDIO_ALARM);
         else
-            initKCalAlarm(ev, ancillaryTime, QStringList(), AUDIO_ALARM);
+            initKCalAlarm(alarms, ancillaryTime, QStringList(), AUDIO_ALARM);
     }
     if (!mPreAction.isEmpty())
     {
         // A pre-display action is specified
         if (ancillaryType == 2)
-            initKCalAlarm(ev, ancillaryOffset, QStringList(PRE_ACTION_TYPE), PRE_ACTION_ALARM);
+            initKCalAlarm(alarms, ancillaryOffset, QStringList(PRE_ACTION_TYPE), PRE_ACTION_ALARM);
         else
-            initKCalAlarm(ev, ancillaryTime, QStringList(PRE_ACTION_TYPE), PRE_ACTION_ALARM);
+            initKCalAlarm(alarms, ancillaryTime, QStringList(PRE_ACTION_TYPE), PRE_ACTION_ALARM);
     }
     if (!mPostAction.isEmpty())
     {
         // A post-display action is specified
         if (ancillaryType == 2)
-            initKCalAlarm(ev, ancillaryOffset, QStringList(POST_ACTION_TYPE), POST_ACTION_ALARM);
+            initKCalAlarm(alarms, ancillaryOffset, QStringList(POST_ACTION_TYPE), POST_ACTION_ALARM);
         else
-            initKCalAlarm(ev, ancillaryTime, QStringList(POST_ACTION_TYPE), POST_ACTION_ALARM);
+            initKCalAlarm(alarms, ancillaryTime, QStringList(POST_ACTION_TYPE), POST_ACTION_ALARM);
     }
 
+    // Replace any alarms which have changed. Unchanged alarms are left as they are.
+    QList<bool> matched(alarms.count(), false);
+    const Alarm::List evAlarms = ev->alarms();
+    for (const Alarm::Ptr& evAlarm : evAlarms)
+    {
+        bool found = false;
+        for (int i = 0, count = alarms.count();  i < count;  ++i)
+        {
+            // Alarm::operator==() ignores custom properties, which hold
+            // KAlarm's own alarm data, so compare them separately.
+            if (!matched.at(i)  &&  *alarms.at(i) == *evAlarm
+            &&  alarms.at(i)->customProperties() == evAlarm->customProperties())
+            {
+                matched[i] = true;
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            ev->removeAlarm(evAlarm);
+    }
+    for (int i = 0, count = alarms.count();  i < count;  ++i)
+    {
+        if (!matched.at(i))
+        {
+            alarms.at(i)->setParent(ev.data());
+            ev->addAlarm(alarms.at(i));
+        }
+    }
+
+    if (properties != ev->customProperties())
+        ev->setCustomProperties(properties);
+    QString param;
+    if (mCategory == CalEvent::DISPLAYING)
+    {
+        param = QString::number(mResourceId);   // original resource ID which contained the event
+        if (mDisplayingDefer)
+            param += SC + DISP_DEFER;
+        if (mDisplayingEdit)
+            param += SC + DISP_EDIT;
+    }
+    CalEvent::setStatus(ev, mCategory, param);
+
     if (mRecurrence)
-        mRecurrence->writeRecurrence(*ev->recurrence());
-    else
+    {
+        Recurrence recur;
+        mRecurrence->writeRecurrence(recur);
+        if (!(*ev->recurrence() == recur))
+            mRecurrence->writeRecurrence(*ev->recurrence());
+    }
+    else if (ev->recurs())
         ev->clearRecurrence();
-    if (mCreatedDateTime.isValid())
+    if (mCreatedDateTime.isValid()  &&  ev->created() != mCreatedDateTime.qDateTime())
         ev->setCreated(mCreatedDateTime.qDateTime());
     ev->setReadOnly(readOnly);
     ev->endUpdates();     // finally issue an update notification
@@ -1490,24 +1610,26 @@ bool KAEventPrivate::updateKCalEvent(const Event::Ptr& ev, KAEvent::UidAction ui
 }
 
 /******************************************************************************
-* Create a new alarm for a libkcal event, and initialise it according to the
-* alarm action. If 'types' is non-null, it is appended to the X-KDE-KALARM-TYPE
-* property value list.
+* Create a new alarm for a libkcal event, initialise it according to the alarm
+* action, and append it to 'alarms'. The alarm is not added to the event.
+* If 'types' is non-null, it is appended to the X-KDE-KALARM-TYPE property
+* value list.
 * NOTE: The variant taking a DateTime calculates the offset from mStartDateTime,
 *       which is not suitable for an alarm in a recurring event.
 */
-Alarm::Ptr KAEventPrivate::initKCalAlarm(const KCalendarCore::Event::Ptr& event, const DateTime& dt, const QStringList& types, AlarmType type) const
+Alarm::Ptr KAEventPrivate::initKCalAlarm(Alarm::List& alarms, const DateTime& dt, const QStringList& types, AlarmType type) const
 {
     const int startOffset = dt.isDateOnly() ? mStartDateTime.secsTo(dt)
                                             : mStartDateTime.calendarKDateTime().secsTo(dt.calendarKDateTime());
-    return initKCalAlarm(event, startOffset, types, type);
+    return initKCalAlarm(alarms, startOffset, types, type);
 }
 
-Alarm::Ptr KAEventPrivate::initKCalAlarm(const KCalendarCore::Event::Ptr& event, int startOffsetSecs, const QStringList& types, AlarmType type) const
+Alarm::Ptr KAEventPrivate::initKCalAlarm(Alarm::List& alarms, int startOffsetSecs, const QStringList& types, AlarmType type) const
 {
     QStringList alltypes;
     QStringList alFlags;
-    Alarm::Ptr newAlarm = event->newAlarm();
+    Alarm::Ptr newAlarm(new Alarm(nullptr));
+    alarms.append(newAlarm);
     newAlarm->setEnabled(true);
     if (type != MAIN_ALARM)
     {
@@ -1612,34 +1734,6 @@ Alarm::Ptr KAEventPrivate::initKCalAlarm(const KCalendarCore::Event::Ptr& event,
     return newAlarm;
 }
 
-/******************************************************************************
-* Find the index to the last daylight savings time transition at or before a
-* given UTC time.
-* Returns index, or -1 if before the first transition.
-*/
-int KAEventPrivate::transitionIndex(const QDateTime& utc, const QTimeZone::OffsetDataList& transitions)
-{
-    if (utc.timeSpec() != Qt::UTC || transitions.isEmpty())
-        return -1;
-    int start = 0;
-    int end = transitions.size() - 1;
-    while (start != end)
-    {
-        int i = (start + end + 1) / 2;
-        if (transitions[i].atUtc == utc)
-            return i;
-        if (transitions[i].atUtc > utc)
-        {
-            end = i - 1;
-            if (end < 0)
-                return -1;
-        }
-        else
-            start = i;
-    }
-    return start;
-}
-
 bool KAEvent::isValid() const
 {
     return d->mAlarmCount  && (d->mAlarmCount != 1 || !d->mRepeatAtLogin);
@@ -4603,7 +4697,7 @@ DateTime KAEventPrivate::readDateTime(const Event::Ptr& event, bool localZone, b
 * Read a date/time from a KCalendarCore::Event property or parameter.
 * 'eventStart' gives the date-only property and the time spec.
 */
-DateTime KAEventPrivate::readDateTime(const QString& param, const DateTime& eventStart)
+DateTime KAEventPrivate::readDateTime(QStringView param, const DateTime& eventStart)
 {
     const int SZ_YEAR  = 4;                           // number of digits in year value
     const int SZ_MONTH = 2;                           // number of digits in month value
@@ -4618,9 +4712,9 @@ DateTime KAEventPrivate::readDateTime(const QString& param, const DateTime& even
     if (param.length() >= SZ_DATE)
     {
         // The next due recurrence time is specified
-        const QDate d(QStringView(param).left(SZ_YEAR).toInt(),
-                      QStringView(param).mid(SZ_YEAR, SZ_MONTH).toInt(),
-                      QStringView(param).mid(SZ_YEAR + SZ_MONTH, SZ_DAY).toInt());
+        const QDate d(param.left(SZ_YEAR).toInt(),
+                      param.mid(SZ_YEAR, SZ_MONTH).toInt(),
+                      param.mid(SZ_YEAR + SZ_MONTH, SZ_DAY).toInt());
         if (d.isValid())
         {
             if (eventStart.isDateOnly()  &&  param.length() == SZ_DATE)
@@ -4630,9 +4724,9 @@ DateTime KAEventPrivate::readDateTime(const QString& param, const DateTime& even
             }
             else if (!eventStart.isDateOnly()  &&  param.length() == IX_TIME + SZ_TIME  &&  param[SZ_DATE] == QLatin1Char('T'))
             {
-                const QTime t(QStringView(param).mid(IX_TIME, SZ_HOUR).toInt(),
-                              QStringView(param).mid(IX_TIME + SZ_HOUR, SZ_MIN).toInt(),
-                              QStringView(param).mid(IX_TIME + SZ_HOUR + SZ_MIN, SZ_SEC).toInt());
+                const QTime t(param.mid(IX_TIME, SZ_HOUR).toInt(),
+                              param.mid(IX_TIME + SZ_HOUR, SZ_MIN).toInt(),
+                              param.mid(IX_TIME + SZ_HOUR + SZ_MIN, SZ_SEC).toInt());
                 if (t.isValid())
                 {
                     value = eventStart;
@@ -4717,8 +4811,8 @@ void KAEventPrivate::readAlarm(const Alarm::Ptr& alarm, AlarmData& data, bool au
         if (ok)
             data.nextRepeat = n;
     }
-    QString property = alarm->customProperty(KACalendar::APPNAME, KAEventPrivate::FLAGS_PROPERTY);
-    const QStringList alFlags = property.split(KAEventPrivate::SC, Qt::SkipEmptyParts);
+    const QString flagsProperty = alarm->customProperty(KACalendar::APPNAME, KAEventPrivate::FLAGS_PROPERTY);
+    const QList<QStringView> alFlags = QStringView(flagsProperty).split(KAEventPrivate::SC, Qt::SkipEmptyParts);
     switch (alarm->type())
     {
         case Alarm::Procedure:
@@ -4749,7 +4843,7 @@ void KAEventPrivate::readAlarm(const Alarm::Ptr& alarm, AlarmData& data, bool au
                 data.cleanText = AlarmText::fromCalendarText(alarm->text(), data.isEmailText);
             }
             const QString prop = alarm->customProperty(KACalendar::APPNAME, KAEventPrivate::FONT_COLOUR_PROPERTY);
-            const QStringList list = prop.split(QLatin1Char(';'), Qt::KeepEmptyParts);
+            const QList<QStringView> list = QStringView(prop).split(QLatin1Char(';'), Qt::KeepEmptyParts);
             data.bgColour = QColor(255, 255, 255);   // white
             data.fgColour = QColor(0, 0, 0);         // black
             const int n = list.count();
@@ -4757,20 +4851,20 @@ void KAEventPrivate::readAlarm(const Alarm::Ptr& alarm, AlarmData& data, bool au
             {
                 if (!list[0].isEmpty())
                 {
-                    QColor c(list[0]);
+                    const QColor c = QColor::fromString(list[0]);
                     if (c.isValid())
                         data.bgColour = c;
                 }
                 if (n > 1  &&  !list[1].isEmpty())
                 {
-                    QColor c(list[1]);
+                    const QColor c = QColor::fromString(list[1]);
                     if (c.isValid())
                         data.fgColour = c;
                 }
             }
             data.defaultFont = (n <= 2 || list[2].isEmpty());
             if (!data.defaultFont)
-                data.font.fromString(list[2]);
+                data.font.fromString(list[2].toString());
             break;
         }
         case Alarm::Email:
@@ -4794,7 +4888,7 @@ void KAEventPrivate::readAlarm(const Alarm::Ptr& alarm, AlarmData& data, bool au
             if (!prop.isEmpty())
             {
                 bool ok;
-                const QStringList list = prop.split(QLatin1Char(';'), Qt::KeepEmptyParts);
+                const QList<QStringView> list = QStringView(prop).split(QLatin1Char(';'), Qt::KeepEmptyParts);
                 data.soundVolume = list[0].toFloat(&ok);
                 if (!ok  ||  data.soundVolume > 1.0f)
                     data.soundVolume = -1;
@@ -4830,11 +4924,11 @@ void KAEventPrivate::readAlarm(const Alarm::Ptr& alarm, AlarmData& data, bool au
     bool dateDeferral = false;
     bool repeatSound  = false;
     data.type = MAIN_ALARM;
-    property = alarm->customProperty(KACalendar::APPNAME, KAEventPrivate::TYPE_PROPERTY);
-    const QStringList types = property.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    const QString typesProperty = alarm->customProperty(KACalendar::APPNAME, KAEventPrivate::TYPE_PROPERTY);
+    const QList<QStringView> types = QStringView(typesProperty).split(QLatin1Char(','), Qt::SkipEmptyParts);
     for (int i = 0, end = types.count();  i < end;  ++i)
     {
-        const QString type = types[i];
+        const QStringView type = types[i];
         if (type == KAEventPrivate::AT_LOGIN_TYPE)
             atLogin = true;
         else if (type == KAEventPrivate::FILE_TYPE  &&  data.action == KAAlarm::Action::Message)
@@ -5434,9 +5528,18 @@ void KAEventPrivate::nextWorkingTime(const Triggers& startTrigger, bool skipRepe
     // We may need to check for a full annual cycle of seasonal time changes, in
     // case it only occurs during working hours after a time change.
     const QTimeZone tz = kdt.namedTimeZone();
-    // Get time zone transitions for the next 10 years.
+    // Use time zone transitions from the start date for the next 10 years.
+    const std::shared_ptr<const TzTransitions> tzTransitions = TzTransitions::forZone(tz);
     const QDateTime endTransitionsTime = QDateTime::currentDateTimeUtc().addYears(10);
-    const QTimeZone::OffsetDataList tzTransitions = tz.transitions(mStartDateTime.qDateTime(), endTransitionsTime);
+    const int firstTransition = tzTransitions ? tzTransitions->transitionIndex(mStartDateTime.qDateTime().toMSecsSinceEpoch() - 1) + 1 : 0;
+    const int endTransition   = tzTransitions ? tzTransitions->transitionIndex(endTransitionsTime.toMSecsSinceEpoch()) + 1 : 0;
+    // Find the index to the last transition at or before a given time.
+    // Returns -1 if before the first transition.
+    auto transitionIndex = [&](const KADateTime& dt)
+    {
+        const int i = tzTransitions ? tzTransitions->transitionIndex(dt.toUtc().qDateTime().toMSecsSinceEpoch()) : -1;
+        return (i < firstTransition) ? -1 : i;
+    };
 
     if (recurTimeVaries)
     {
@@ -5571,14 +5674,14 @@ void KAEventPrivate::nextWorkingTime(const Triggers& startTrigger, bool skipRepe
                     // alarm occurs inside working hours then.
                     if (!finalDate.isValid())
                         finalDate = kdtRecur.date();
-                    const int i = KAEventPrivate::transitionIndex(kdtRecur.toUtc().qDateTime(), tzTransitions);
+                    const int i = transitionIndex(kdtRecur);
                     if (i < 0)
                         return;
                     if (i > transitionIx)
                         transitionIx = i;
-                    if (++transitionIx >= tzTransitions.count())
+                    if (++transitionIx >= endTransition)
                         return;
-                    previousOccurrence(KADateTime(tzTransitions[transitionIx].atUtc), newdt, KAEvent::Repeats::Ignore);
+                    previousOccurrence(KADateTime(tzTransitions->transitionUtc(transitionIx)), newdt, KAEvent::Repeats::Ignore);
                     kdtRecur = newdt.toTimeSpec(mWorkDayTimeSpec).effectiveKDateTime();
                     if (finalDate.daysTo(kdtRecur.date()) > 365)
                         return;
@@ -5728,14 +5831,14 @@ void KAEventPrivate::nextWorkingTime(const Triggers& startTrigger, bool skipRepe
 
             // Find the next recurrence before a seasonal time change,
             // and ensure the time change is after the last one processed.
-            const int i = KAEventPrivate::transitionIndex(kdtRecur.toUtc().qDateTime(), tzTransitions);
+            const int i = transitionIndex(kdtRecur);
             if (i < 0)
                 return;
             if (i > transitionIx)
                 transitionIx = i;
-            if (++transitionIx >= tzTransitions.count())
+            if (++transitionIx >= endTransition)
                 return;
-            kdt = KADateTime(tzTransitions[transitionIx].atUtc);
+            kdt = KADateTime(tzTransitions->transitionUtc(transitionIx));
             previousOccurrence(kdt, newdt, KAEvent::Repeats::Ignore);
             kdt = kdt.toTimeSpec(mWorkDayTimeSpec);
             kdtRecur = newdt.toTimeSpec(mWorkDayTimeSpec).effectiveKDateTime();
@@ -5913,6 +6016,11 @@ KARecurrence::Type KAEventPrivate::checkRecur() const
 * Reply = true if any conversions were done.
 */
 bool KAEvent::convertKCalEvents(const Calendar::Ptr& calendar, int calendarVersion)
+{
+    return convertKCalEvents(calendar->rawEvents(), calendarVersion);
+}
+
+bool KAEvent::convertKCalEvents(const Event::List& events, int calendarVersion)
 {
     // KAlarm pre-0.9 codes held in the alarm's DESCRIPTION property
     static const QChar   SEPARATOR        = QLatin1Char(';');
@@ -5995,10 +6103,9 @@ bool KAEvent::convertKCalEvents(const Calendar::Ptr& calendar, int calendarVersi
     const bool pre_3_12_0 = (calendarVersion < Version(3, 12, 0));
     Q_ASSERT(currentCalendarVersion() == Version(3, 12, 0));
 
-    const QTimeZone localZone = QTimeZone::systemTimeZone();
+    const QTimeZone localZone = KADateTime::localZone();
 
     bool converted = false;
-    const Event::List events = calendar->rawEvents();
     for (Event::Ptr event : events)
     {
         const Alarm::List alarms = event->alarms();
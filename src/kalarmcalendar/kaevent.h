@@ -1629,6 +1629,17 @@ public:
      */
     static bool convertKCalEvents(const KCalendarCore::Calendar::Ptr&, int calendarVersion);
 
+    /** Convert a list of events which were written by a previous version of
+     *  KAlarm, so that a calendar can be converted in stages. The events need
+     *  not belong to a calendar, so that they may be converted in a thread
+     *  other than that of the calendar.
+     *  @param events           events to be converted.
+     *  @param calendarVersion  KAlarm calendar format version of @p events, as
+     *                          for convertKCalEvents(const Calendar::Ptr&, int).
+     *  @return @c true if any conversions were done.
+     */
+    static bool convertKCalEvents(const KCalendarCore::Event::List& events, int calendarVersion);
+
     /** Return a list of pointers to a list of KAEvent objects. */
     static List ptrList(QList<KAEvent>& events);
 
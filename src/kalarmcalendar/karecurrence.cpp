@@ -16,11 +16,15 @@
 #include <QDate>
 #include <QLocale>
 
+#include <algorithm>
+
 using namespace KCalendarCore;
 
 namespace
 {
 QDateTime msecs0(const KAlarmCal::KADateTime&);
+
+const int WINDOW_SIZE = 16;   // maximum number of occurrences to retain in the occurrence window
 }
 
 namespace KAlarmCal
@@ -36,17 +40,46 @@ public:
     Recurrence_p& operator=(const Recurrence_p& r) = delete;
 };
 
-class Q_DECL_HIDDEN KARecurrence::Private
+class Q_DECL_HIDDEN KARecurrence::Private : public Recurrence::RecurrenceObserver
 {
 public:
-    Private() = default;
-    explicit Private(const Recurrence& r) : mRecurrence(r) {}
+    Private()  { mRecurrence.addObserver(this); }
+    explicit Private(const Recurrence& r) : mRecurrence(r)  { mRecurrence.addObserver(this); }
+    Private(const Private& p)
+        : mRecurrence(p.mRecurrence)
+        , mFeb29Type(p.mFeb29Type)
+        , mCachedType(p.mCachedType)
+        , mCachedDayPosMask(p.mCachedDayPosMask)
+    { mRecurrence.addObserver(this); }
+    ~Private() override
+    {
+        mRecurrence.removeObserver(this);
+        delete mAnnualRecurrence;
+    }
+    Private& operator=(const Private&) = delete;
     void clear()
     {
         mRecurrence.clear();
         mFeb29Type  = Feb29_None;
         mCachedType = -1;
         mCachedDayPosMask = 0;
+        clearCache();
+    }
+    void recurrenceUpdated(Recurrence*) override  { clearCache(); }
+    const Recurrence& annualRecurrence(const KARecurrence* q) const;
+    QDateTime nextDateTime(const Recurrence&, const QDateTime& preDateTime) const;
+    QDateTime previousDateTime(const Recurrence&, const QDateTime& afterDateTime) const;
+    Duration longestInterval(const KARecurrence* q) const;
+    Duration regularInterval(const KARecurrence* q) const;
+    void clearCache() const
+    {
+        delete mAnnualRecurrence;
+        mAnnualRecurrence = nullptr;
+        mWindowStart = QDateTime();
+        mWindow.clear();
+        mWindowEnded = false;
+        mHaveLongestInterval = false;
+        mHaveRegularInterval = false;
     }
     bool set(Type, int freq, int count, int f29, const KADateTime& start, const KADateTime& end);
     bool init(RecurrenceRule::PeriodType, int freq, int count, int feb29Type, const KADateTime& start, const KADateTime& end);
@@ -62,6 +95,16 @@ public:
     Feb29Type        mFeb29Type = Feb29_None;    // yearly recurrence on Feb 29th (leap years) / Mar 1st (non-leap years)
     mutable int      mCachedType = -1;
     unsigned         mCachedDayPosMask = 0;
+    mutable Recurrence* mAnnualRecurrence = nullptr;   // annual recurrence as written by writeRecurrence(), or null if not yet created
+    // Window of occurrences found by getNextDateTime(). This contains all
+    // occurrences after mWindowStart, up to and including the last in mWindow.
+    mutable QDateTime        mWindowStart;
+    mutable QList<QDateTime> mWindow;
+    mutable bool             mWindowEnded = false;   // there are no occurrences after the window
+    mutable Duration         mLongestInterval;
+    mutable Duration         mRegularInterval;
+    mutable bool             mHaveLongestInterval = false;
+    mutable bool             mHaveRegularInterval = false;
 };
 
 QTimeZone KARecurrence::Private::toTimeZone(const KADateTime::Spec& spec)
@@ -157,6 +200,7 @@ bool KARecurrence::set(Type t, int freq, int count, const KADateTime& start, con
 bool KARecurrence::Private::set(Type recurType, int freq, int count, int f29, const KADateTime& start, const KADateTime& end)
 {
     mCachedType = -1;
+    clearCache();
     RecurrenceRule::PeriodType rrtype;
     switch (recurType)
     {
@@ -259,6 +303,7 @@ bool KARecurrence::Private::init(RecurrenceRule::PeriodType recurType, int freq,
             startdt.setDate(QDate(year, 2, 29));
         }
         mFeb29Type = feb29Type;
+        clearCache();
     }
     mRecurrence.setStartDateTime(msecs0(startdt), dateOnly);   // sets recurrence all-day if date-only
     cacheDayPosMask();
@@ -304,6 +349,7 @@ void KARecurrence::fix()
 void KARecurrence::Private::fix()
 {
     mCachedType = -1;
+    clearCache();
     mFeb29Type = Feb29_None;
     int convert = 0;
     int days[2] = { 0, 0 };
@@ -611,6 +657,21 @@ void KARecurrence::Private::writeRecurrence(const KARecurrence* q, Recurrence& r
     }
 }
 
+/******************************************************************************
+* Return the KCal::Recurrence equivalent of an annual recurrence, including any
+* additional recurrence rules for February 29th. This is created the first time
+* it is needed, and is discarded whenever the recurrence changes.
+*/
+const Recurrence& KARecurrence::Private::annualRecurrence(const KARecurrence* q) const
+{
+    if (!mAnnualRecurrence)
+    {
+        mAnnualRecurrence = new Recurrence;
+        writeRecurrence(q, *mAnnualRecurrence);
+    }
+    return *mAnnualRecurrence;
+}
+
 KADateTime KARecurrence::startDateTime() const
 {
     return KADateTime(d->mRecurrence.startDateTime());
@@ -832,13 +893,9 @@ KADateTime KARecurrence::getNextDateTime(const KADateTime& preDateTime) const
     {
         case ANNUAL_DATE:
         case ANNUAL_POS:
-        {
-            Recurrence recur;
-            writeRecurrence(recur);
-            return KADateTime(recur.getNextDateTime(msecs0(preDateTime)));
-        }
+            return KADateTime(d->nextDateTime(d->annualRecurrence(this), msecs0(preDateTime)));
         default:
-            return KADateTime(d->mRecurrence.getNextDateTime(msecs0(preDateTime)));
+            return KADateTime(d->nextDateTime(d->mRecurrence, msecs0(preDateTime)));
     }
 }
 
@@ -851,14 +908,71 @@ KADateTime KARecurrence::getPreviousDateTime(const KADateTime& afterDateTime) co
     {
         case ANNUAL_DATE:
         case ANNUAL_POS:
+            return KADateTime(d->previousDateTime(d->annualRecurrence(this), msecs0(afterDateTime)));
+        default:
+            return KADateTime(d->previousDateTime(d->mRecurrence, msecs0(afterDateTime)));
+    }
+}
+
+/******************************************************************************
+* Get the next time a recurrence occurs, strictly after a specified time.
+* Successive occurrences are retained in a window, so that repeated queries,
+* and queries for the occurrence after the last one found, can be answered
+* without evaluating the recurrence rules again.
+*/
+QDateTime KARecurrence::Private::nextDateTime(const Recurrence& recur, const QDateTime& preDateTime) const
+{
+    if (!preDateTime.isValid())
+        return recur.getNextDateTime(preDateTime);
+    if (mWindowStart.isValid()  &&  preDateTime >= mWindowStart)
+    {
+        auto it = std::upper_bound(mWindow.cbegin(), mWindow.cend(), preDateTime);
+        if (it != mWindow.cend())
+            return *it;
+        if (mWindowEnded)
+            return {};
+        if (!mWindow.isEmpty()  &&  preDateTime == mWindow.constLast())
         {
-            Recurrence recur;
-            writeRecurrence(recur);
-            return KADateTime(recur.getPreviousDateTime(msecs0(afterDateTime)));
+            // Extend the window by one occurrence, discarding the earliest
+            // occurrence if the window is full.
+            const QDateTime next = recur.getNextDateTime(preDateTime);
+            if (!next.isValid())
+                mWindowEnded = true;
+            else
+            {
+                if (mWindow.count() >= WINDOW_SIZE)
+                    mWindowStart = mWindow.takeFirst();
+                mWindow.append(next);
+            }
+            return next;
         }
-        default:
-            return KADateTime(d->mRecurrence.getPreviousDateTime(msecs0(afterDateTime)));
     }
+
+    // Start a new window.
+    const QDateTime next = recur.getNextDateTime(preDateTime);
+    mWindowStart = preDateTime;
+    mWindow.clear();
+    mWindowEnded = !next.isValid();
+    if (!mWindowEnded)
+        mWindow.append(next);
+    return next;
+}
+
+/******************************************************************************
+* Get the previous time a recurrence occurred, strictly before a specified time.
+* The window of occurrences found by nextDateTime() is used if it contains the
+* answer.
+*/
+QDateTime KARecurrence::Private::previousDateTime(const Recurrence& recur, const QDateTime& afterDateTime) const
+{
+    if (mWindowStart.isValid()  &&  afterDateTime.isValid()  &&  afterDateTime > mWindowStart
+    &&  (mWindowEnded  ||  (!mWindow.isEmpty()  &&  afterDateTime <= mWindow.constLast())))
+    {
+        auto it = std::lower_bound(mWindow.cbegin(), mWindow.cend(), afterDateTime);
+        if (it != mWindow.cbegin())
+            return *(--it);
+    }
+    return recur.getPreviousDateTime(afterDateTime);
 }
 
 /******************************************************************************
@@ -867,7 +981,8 @@ KADateTime KARecurrence::getPreviousDateTime(const KADateTime& afterDateTime) co
 */
 bool KARecurrence::recursOn(const QDate& dt, const KADateTime::Spec& timeSpec) const
 {
-    if (!d->mRecurrence.recursOn(dt, Private::toTimeZone(timeSpec)))
+    const QTimeZone tz = Private::toTimeZone(timeSpec);
+    if (!d->mRecurrence.recursOn(dt, tz))
         return false;
     if (dt != d->mRecurrence.startDate())
         return true;
@@ -878,7 +993,7 @@ bool KARecurrence::recursOn(const QDate& dt, const KADateTime::Spec& timeSpec) c
     const RecurrenceRule::List rulelist = d->mRecurrence.rRules();
     for (const RecurrenceRule* rule : rulelist)
     {
-        if (rule->recursOn(dt, Private::toTimeZone(timeSpec)))
+        if (rule->recursOn(dt, tz))
             return true;
     }
     const auto dtlist = d->mRecurrence.rDateTimes();
@@ -1021,15 +1136,25 @@ int KARecurrence::Private::combineDurations(const RecurrenceRule* rrule1, const
 */
 Duration KARecurrence::longestInterval() const
 {
-    const int freq = d->mRecurrence.frequency();
-    switch (type())
+    if (!d->mHaveLongestInterval)
+    {
+        d->mLongestInterval = d->longestInterval(this);
+        d->mHaveLongestInterval = true;
+    }
+    return d->mLongestInterval;
+}
+
+Duration KARecurrence::Private::longestInterval(const KARecurrence* q) const
+{
+    const int freq = mRecurrence.frequency();
+    switch (q->type())
     {
         case MINUTELY:
             return {freq * 60, Duration::Seconds};
 
         case DAILY:
         {
-            const QList<RecurrenceRule::WDayPos> dayps = d->mRecurrence.defaultRRuleConst()->byDays();
+            const QList<RecurrenceRule::WDayPos> dayps = mRecurrence.defaultRRuleConst()->byDays();
             if (dayps.isEmpty())
                 return {freq, Duration::Days};
 
@@ -1069,7 +1194,7 @@ Duration KARecurrence::longestInterval() const
             {
                 // It will recur on the same day of the week every time.
                 // Ensure that the day is a day which is not excluded.
-                if (ds[d->mRecurrence.startDate().dayOfWeek() - 1])
+                if (ds[mRecurrence.startDate().dayOfWeek() - 1])
                     return {freq, Duration::Days};
                 break;
             }
@@ -1078,7 +1203,7 @@ Duration KARecurrence::longestInterval() const
         {
             // Find which days of the week it recurs on, and if on more than
             // one, reduce the maximum interval accordingly.
-            const QBitArray ds = d->mRecurrence.days();
+            const QBitArray ds = mRecurrence.days();
             int first = -1;
             int last  = -1;
             int maxgap = 1;
@@ -1116,7 +1241,7 @@ Duration KARecurrence::longestInterval() const
         {
             // Find which months of the year it recurs on, and if on more than
             // one, reduce the maximum interval accordingly.
-            const QList<int> months = d->mRecurrence.yearMonths();  // month list is sorted
+            const QList<int> months = mRecurrence.yearMonths();  // month list is sorted
             if (months.isEmpty())
                 break;    // no months recur
             if (months.count() == 1)
@@ -1156,14 +1281,24 @@ Duration KARecurrence::longestInterval() const
 */
 Duration KARecurrence::regularInterval() const
 {
-    int freq = d->mRecurrence.frequency();
-    switch (type())
+    if (!d->mHaveRegularInterval)
+    {
+        d->mRegularInterval = d->regularInterval(this);
+        d->mHaveRegularInterval = true;
+    }
+    return d->mRegularInterval;
+}
+
+Duration KARecurrence::Private::regularInterval(const KARecurrence* q) const
+{
+    int freq = mRecurrence.frequency();
+    switch (q->type())
     {
         case MINUTELY:
             return {freq * 60, Duration::Seconds};
         case DAILY:
         {
-            const QList<RecurrenceRule::WDayPos> dayps = d->mRecurrence.defaultRRuleConst()->byDays();
+            const QList<RecurrenceRule::WDayPos> dayps = mRecurrence.defaultRRuleConst()->byDays();
             if (dayps.isEmpty())
                 return {freq, Duration::Days};
             // After applying the frequency, the specified days of the week
@@ -1179,7 +1314,7 @@ Duration KARecurrence::regularInterval() const
             {
                 // It will recur on the same day of the week every time.
                 // Check whether that day is in the list of included days.
-                if (ds[d->mRecurrence.startDate().dayOfWeek() - 1])
+                if (ds[mRecurrence.startDate().dayOfWeek() - 1])
                     return {freq, Duration::Days};
                 break;
             }
@@ -1197,7 +1332,7 @@ Duration KARecurrence::regularInterval() const
         }
         case WEEKLY:
         {
-            const QList<RecurrenceRule::WDayPos> dayps = d->mRecurrence.defaultRRuleConst()->byDays();
+            const QList<RecurrenceRule::WDayPos> dayps = mRecurrence.defaultRRuleConst()->byDays();
             if (dayps.isEmpty())
                 return {freq * 7, Duration::Days};
             // The specified days of the week occur every week in which the
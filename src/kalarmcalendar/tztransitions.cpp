@@ -0,0 +1,171 @@
+/*
+ *  tztransitions.cpp  -  table of time zone offset transitions
+ *  This file is part of kalarmcalendar library, which provides access to KAlarm
+ *  calendar data.
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "tztransitions.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+
+#include <algorithm>
+
+namespace
+{
+
+const qint64 MSECS_PER_DAY = 86400 * 1000;
+const qint64 EPOCH_JULIAN_DAY = 2440588;   // Julian day number of 1970-01-01
+
+QMutex   tableMutex;
+QHash<QByteArray, std::shared_ptr<const KAlarmCal::TzTransitions>> tables;   // guarded by tableMutex
+int      tableFirstYear = 1970;      // guarded by tableMutex
+int      tableLastYear  = 2100;      // guarded by tableMutex
+
+}
+
+namespace KAlarmCal
+{
+
+/******************************************************************************
+* Return the shared transition table for a time zone, creating it if necessary.
+*/
+std::shared_ptr<const TzTransitions> TzTransitions::forZone(const QTimeZone& tz)
+{
+    if (!tz.isValid())
+        return {};
+    const QByteArray id = tz.id();
+    QMutexLocker locker(&tableMutex);
+    auto it = tables.constFind(id);
+    if (it != tables.constEnd())
+        return it.value();
+
+    std::shared_ptr<const TzTransitions> table;
+    if (tz.hasTransitions()  ||  tz.isUtcOrFixedOffset())
+        table.reset(new TzTransitions(tz, tableFirstYear, tableLastYear));
+    tables.insert(id, table);
+    return table;
+}
+
+/******************************************************************************
+* Set the range of years covered by transition tables.
+*/
+void TzTransitions::setYearRange(int firstYear, int lastYear)
+{
+    QMutexLocker locker(&tableMutex);
+    tableFirstYear = firstYear;
+    tableLastYear  = std::max(firstYear, lastYear);
+    tables.clear();
+}
+
+/******************************************************************************
+* Return the wall clock time of a date/time, as if it were a UTC time.
+*/
+qint64 TzTransitions::localMSecs(const QDateTime& dt)
+{
+    return (dt.date().toJulianDay() - EPOCH_JULIAN_DAY) * MSECS_PER_DAY + dt.time().msecsSinceStartOfDay();
+}
+
+TzTransitions::TzTransitions(const QTimeZone& tz, int firstYear, int lastYear)
+{
+    const QDateTime start(QDate(firstYear, 1, 1), QTime(0, 0, 0), QTimeZone::utc());
+    const QDateTime end(QDate(lastYear + 1, 1, 1), QTime(0, 0, 0), QTimeZone::utc());
+    mStart = start.toMSecsSinceEpoch();
+    mEnd   = end.toMSecsSinceEpoch();
+    mInitialOffset = tz.offsetFromUtc(start);
+    if (tz.hasTransitions())
+    {
+        const QTimeZone::OffsetDataList transitions = tz.transitions(start, end);
+        mTransitions.reserve(transitions.count());
+        int offset = mInitialOffset;
+        for (const QTimeZone::OffsetData& transition : transitions)
+        {
+            // Ignore transitions which only change the zone abbreviation or
+            // standard/daylight status.
+            if (transition.offsetFromUtc != offset  &&  transition.atUtc > start)
+            {
+                mTransitions.append({transition.atUtc.toMSecsSinceEpoch(), transition.offsetFromUtc});
+                offset = transition.offsetFromUtc;
+            }
+        }
+    }
+}
+
+/******************************************************************************
+* Return the UTC offset at a UTC time.
+*/
+int TzTransitions::offsetAtUtc(qint64 utcMSecs) const
+{
+    const int i = transitionIndex(utcMSecs);
+    return (i < 0) ? mInitialOffset : mTransitions.at(i).offset;
+}
+
+/******************************************************************************
+* Return the index to the last transition at or before a UTC time.
+*/
+int TzTransitions::transitionIndex(qint64 utcMSecs) const
+{
+    const auto it = std::upper_bound(mTransitions.cbegin(), mTransitions.cend(), utcMSecs,
+                                     [](qint64 utc, const Transition& t) { return utc < t.atUtc; });
+    return static_cast<int>(it - mTransitions.cbegin()) - 1;
+}
+
+QDateTime TzTransitions::transitionUtc(int index) const
+{
+    return QDateTime::fromMSecsSinceEpoch(mTransitions.at(index).atUtc, QTimeZone::utc());
+}
+
+/******************************************************************************
+* Find the UTC offsets applicable to a local time.
+* Around a transition, the local times between (transition + earlier offset)
+* and (transition + later offset) either occur twice or are skipped. Each
+* transition is taken to start at the earlier of these local times, which
+* keeps the transition start times in order since transitions are far apart
+* compared to the size of offset changes.
+*/
+bool TzTransitions::localOffsets(qint64 localMSecs, LocalOffsets& offsets) const
+{
+    if (localMSecs < mStart + MSECS_PER_DAY  ||  localMSecs >= mEnd - MSECS_PER_DAY)
+        return false;
+
+    // Find the last transition whose local start time is at or before localMSecs.
+    int start = 0;
+    int end = mTransitions.count();
+    while (start < end)
+    {
+        const int i = (start + end) / 2;
+        const qint64 localStart = mTransitions.at(i).atUtc + std::min(offsetBefore(i), mTransitions.at(i).offset) * 1000LL;
+        if (localStart <= localMSecs)
+            start = i + 1;
+        else
+            end = i;
+    }
+    const int i = start - 1;
+    offsets = LocalOffsets();
+    if (i < 0)
+    {
+        offsets.offset = offsets.secondOffset = mInitialOffset;
+        return true;
+    }
+
+    const Transition& transition = mTransitions.at(i);
+    const int before = offsetBefore(i);
+    offsets.offset = offsets.secondOffset = transition.offset;
+    if (localMSecs < transition.atUtc + std::max(before, transition.offset) * 1000LL)
+    {
+        offsets.type = (transition.offset < before) ? LocalTime::Ambiguous : LocalTime::Skipped;
+        offsets.offset        = before;
+        offsets.secondOffset  = transition.offset;
+        offsets.transitionUtc = transition.atUtc;
+    }
+    return true;
+}
+
+} // namespace KAlarmCal
+
+// vim: et sw=4:
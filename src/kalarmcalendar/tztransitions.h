@@ -0,0 +1,121 @@
+/*
+ *  tztransitions.h  -  table of time zone offset transitions
+ *  This file is part of kalarmcalendar library, which provides access to KAlarm
+ *  calendar data.
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "kalarmcal_export.h"
+
+#include <QList>
+#include <QTimeZone>
+
+#include <memory>
+
+class QDateTime;
+
+namespace KAlarmCal
+{
+
+/**
+ * @short Table of UTC offset transitions for a time zone.
+ *
+ * TzTransitions holds a precomputed list of the UTC offset changes in a time
+ * zone over a range of years, so that the UTC offset at any time in the range
+ * can be found by a binary search instead of by querying QTimeZone, which may
+ * involve expensive ICU or tzfile lookups.
+ *
+ * One table is created for each time zone when it is first requested, and is
+ * shared throughout the process. Times outside the table's year range should
+ * be handled by QTimeZone instead.
+ *
+ * Times are expressed as milliseconds since the epoch. A local time is its
+ * wall clock date and time, expressed as if it were a UTC time.
+ *
+ * @author David Jarvie <djarvie@kde.org>
+ */
+class KALARMCAL_EXPORT TzTransitions
+{
+public:
+    /** How a local time maps onto UTC. */
+    enum class LocalTime
+    {
+        Unique,      //!< the local time occurs once
+        Ambiguous,   //!< the local time occurs twice, due to the clocks going back
+        Skipped      //!< the local time does not occur, due to the clocks going forward
+    };
+
+    /** The UTC offsets applicable to a local time. */
+    struct LocalOffsets
+    {
+        LocalTime type {LocalTime::Unique};
+        int    offset {0};          //!< UTC offset in seconds (of first occurrence, or before the skip)
+        int    secondOffset {0};    //!< UTC offset of second occurrence (or after the skip), else = offset
+        qint64 transitionUtc {0};   //!< if not Unique, UTC time of the transition
+    };
+
+    /** Return the transition table for a time zone, creating it if necessary.
+     *  @return table, or null if @p tz is invalid or does not provide
+     *          transition data.
+     */
+    static std::shared_ptr<const TzTransitions> forZone(const QTimeZone& tz);
+
+    /** Set the range of years covered by transition tables, and discard all
+     *  existing tables. The default range is 1970 to 2100.
+     */
+    static void setYearRange(int firstYear, int lastYear);
+
+    /** Return the wall clock time of a date/time, in milliseconds, expressed
+     *  as if it were a UTC time. */
+    static qint64 localMSecs(const QDateTime&);
+
+    /** Return whether a UTC time is within the table's range. */
+    bool contains(qint64 utcMSecs) const   { return utcMSecs >= mStart  &&  utcMSecs < mEnd; }
+
+    /** Return the UTC offset in seconds at a UTC time, which must be within
+     *  the table's range. */
+    int offsetAtUtc(qint64 utcMSecs) const;
+
+    /** Find the UTC offsets applicable to a local time.
+     *  @return false if the local time is outside the table's range.
+     */
+    bool localOffsets(qint64 localMSecs, LocalOffsets& offsets) const;
+
+    /** Return the number of transitions in the table. */
+    int count() const   { return mTransitions.count(); }
+
+    /** Return the index to the last transition at or before a UTC time.
+     *  @return index, or -1 if before the first transition.
+     */
+    int transitionIndex(qint64 utcMSecs) const;
+
+    /** Return the UTC time of a transition. */
+    QDateTime transitionUtc(int index) const;
+
+    /** Return the UTC offset in seconds after a transition. */
+    int offsetAfter(int index) const   { return mTransitions.at(index).offset; }
+
+private:
+    struct Transition
+    {
+        qint64 atUtc;    // UTC time of transition
+        int    offset;   // UTC offset after transition
+    };
+
+    TzTransitions(const QTimeZone&, int firstYear, int lastYear);
+    int offsetBefore(int index) const   { return index ? mTransitions.at(index - 1).offset : mInitialOffset; }
+
+    QList<Transition> mTransitions;       // transitions within the table's range, in order
+    qint64            mStart;             // start of range (UTC)
+    qint64            mEnd;               // end of range (UTC)
+    int               mInitialOffset {0}; // UTC offset at start of range
+};
+
+} // namespace KAlarmCal
+
+// vim: et sw=4:
@@ -17,10 +17,17 @@
 #include <KFileItem>
 
 #include <QDir>
+#include <QFile>
 #include <QRegularExpression>
 #include <QFileDialog>
 using namespace Qt::Literals::StringLiterals;
 
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace File
 {
 
@@ -138,6 +145,21 @@ QString pathOrUrl(const QString& url)
     return match.hasMatch() ? url.mid(match.capturedEnd(0) - 1) : url;
 }
 
+/******************************************************************************
+* Flush a file's data to the storage device, so that it survives a crash or
+* power loss.
+*/
+bool sync(QFile& file)
+{
+    if (!file.flush())
+        return false;
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
 /******************************************************************************
 * Display a modal dialog to choose an existing file, initially highlighting
 * any specified file.
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <QString>
+class QFile;
 class QMimeType;
 class QUrl;
 
@@ -47,6 +48,11 @@ bool showFileErrMessage(const QString& filename, Error, Error blankError, QWidge
 /** If a url string is a local file, strip off the 'file:/' prefix. */
 QString pathOrUrl(const QString& url);
 
+/** Flush an open file's data to the storage device.
+ *  @return true if successful, false if error.
+ */
+bool sync(QFile& file);
+
 /* Display a modal dialog to choose a file, initially highlighting any
  * specified file. */
 bool browseFile(QString& file, const QString& caption, QString& defaultDir,
@@ -8,6 +8,7 @@
 
 #include "synchtimer.h"
 
+#include "virtualclock.h"
 #include "kalarm_debug.h"
 
 #include <QTimer>
@@ -26,10 +27,49 @@ SynchTimer::SynchTimer()
 
 SynchTimer::~SynchTimer()
 {
+    VirtualClock::stopTimer(mTimer);
     delete mTimer;
     mTimer = nullptr;
 }
 
+/******************************************************************************
+* Return whether the timer is running, either in real time or waiting for the
+* virtual clock.
+*/
+bool SynchTimer::isTimerActive() const
+{
+    return mTimer->isActive()  ||  VirtualClock::isTimerScheduled(mTimer);
+}
+
+/******************************************************************************
+* Start the timer as a single shot. If the virtual clock is running, the timer
+* is triggered when the virtual clock reaches the trigger time.
+*/
+void SynchTimer::startTimer(qint64 msecs)
+{
+    if (VirtualClock::isActive())
+        VirtualClock::startTimer(mTimer, KADateTime::currentUtcDateTime().addMSecs(msecs));
+    else
+        mTimer->start(msecs);
+}
+
+void SynchTimer::stopTimer()
+{
+    VirtualClock::stopTimer(mTimer);
+    mTimer->stop();
+}
+
+/******************************************************************************
+* Return the current local date/time, which is the virtual clock time if the
+* virtual clock is running.
+*/
+QDateTime SynchTimer::currentDateTime()
+{
+    if (VirtualClock::isActive())
+        return KADateTime::currentLocalDateTime().qDateTime();
+    return QDateTime::currentDateTime();
+}
+
 /******************************************************************************
 * Connect to the timer. The timer is started if necessary.
 */
@@ -41,7 +81,7 @@ void SynchTimer::connecT(QObject* receiver, const char* member)
     connect(mTimer, SIGNAL(timeout()), receiver, member);
     mConnections.append(connection);
     connect(receiver, &QObject::destroyed, this, &SynchTimer::slotReceiverGone);
-    if (!mTimer->isActive())
+    if (!isTimerActive())
     {
         connect(mTimer, &QTimer::timeout, this, &SynchTimer::slotTimer);
         start();
@@ -75,7 +115,7 @@ void SynchTimer::disconnecT(QObject* receiver, const char* member)
         if (mConnections.isEmpty())
         {
             mTimer->disconnect();
-            mTimer->stop();
+            stopTimer();
         }
     }
 }
@@ -104,8 +144,8 @@ MinuteTimer* MinuteTimer::instance()
 void MinuteTimer::slotTimer()
 {
     qCDebug(KALARM_LOG) << "MinuteTimer::slotTimer";
-    int interval = 62 - QTime::currentTime().second();
-    mTimer->start(interval * 1000);     // execute a single shot
+    int interval = 62 - currentDateTime().time().second();
+    startTimer(interval * 1000);     // execute a single shot
 }
 
 
@@ -166,13 +206,13 @@ void DailyTimer::changeTime(const QTime& newTimeOfDay, bool triggerMissed)
 {
     if (mFixed)
         return;
-    if (mTimer->isActive())
+    if (isTimerActive())
     {
-        mTimer->stop();
+        stopTimer();
         bool triggerNow = false;
         if (triggerMissed)
         {
-            QTime now = QTime::currentTime();
+            QTime now = currentDateTime().time();
             if (now >= newTimeOfDay  &&  now < mTime)
             {
                 // The trigger time is now earlier and it has already arrived today.
@@ -182,7 +222,7 @@ void DailyTimer::changeTime(const QTime& newTimeOfDay, bool triggerMissed)
         }
         mTime = newTimeOfDay;
         if (triggerNow)
-            mTimer->start(0);    // trigger immediately
+            startTimer(0);    // trigger immediately
         else
             start();
     }
@@ -198,7 +238,7 @@ void DailyTimer::changeTime(const QTime& newTimeOfDay, bool triggerMissed)
 void DailyTimer::start()
 {
     // TIMEZONE = local time
-    const QDateTime now = QDateTime::currentDateTime();
+    const QDateTime now = currentDateTime();
     // Find out whether to trigger today or tomorrow.
     // In preference, use the last trigger date to determine this, since
     // that will avoid possible errors due to daylight savings time changes.
@@ -213,7 +253,7 @@ void DailyTimer::start()
     else
         next = QDateTime(now.date().addDays(1), mTime);
     const qint64 interval = next.toSecsSinceEpoch() - now.toSecsSinceEpoch();
-    mTimer->start(interval * 1000);    // execute a single shot
+    startTimer(interval * 1000);    // execute a single shot
     qCDebug(KALARM_LOG) << "DailyTimer::start: at" << mTime.hour() << ":" << mTime.minute() << ": interval =" << interval/3600 << ":" << (interval/60)%60 << ":" << interval%60;
 }
 
@@ -226,11 +266,11 @@ void DailyTimer::start()
 void DailyTimer::slotTimer()
 {
     // TIMEZONE = local time
-    const QDateTime now = QDateTime::currentDateTime();
+    const QDateTime now = currentDateTime();
     mLastDate = now.date();
     const QDateTime next = QDateTime(mLastDate.addDays(1), mTime);
     const qint64 interval = next.toSecsSinceEpoch() - now.toSecsSinceEpoch();
-    mTimer->start(interval * 1000);    // execute a single shot
+    startTimer(interval * 1000);    // execute a single shot
     qCDebug(KALARM_LOG) << "DailyTimer::slotTimer: at" << mTime.hour() << ":" << mTime.minute() << ": interval =" << interval/3600 << ":" << (interval/60)%60 << ":" << interval%60;
 }
 
@@ -12,6 +12,7 @@
 
 #include <QByteArray>
 #include <QDate>
+#include <QDateTime>
 #include <QList>
 #include <QObject>
 #include <QTime>
@@ -45,6 +46,10 @@ protected:
     void              connecT(QObject* receiver, const char* member);
     virtual void      disconnecT(QObject* receiver, const char* member = nullptr);
     bool              hasConnections() const   { return !mConnections.isEmpty(); }
+    bool              isTimerActive() const;
+    void              startTimer(qint64 msecs);
+    void              stopTimer();
+    static QDateTime  currentDateTime();
 
     QTimer*           mTimer;
 
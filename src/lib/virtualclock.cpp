@@ -0,0 +1,232 @@
+/*
+ *  virtualclock.cpp  -  virtual clock to drive alarm scheduling in simulations
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "virtualclock.h"
+
+#include "kalarm_debug.h"
+
+#include <QTimer>
+
+#ifndef Q_OS_WIN
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+const int BUSY_CHECK_INTERVAL = 20;   // ms between checks for the application becoming idle
+
+// Return the peak resident memory of the process, in kilobytes.
+long peakMemory()
+{
+#ifndef Q_OS_WIN
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return usage.ru_maxrss;
+#endif
+    return 0;
+}
+}
+
+VirtualClock* VirtualClock::mInstance = nullptr;
+
+VirtualClock::VirtualClock(const KADateTime& startTime, const KADateTime& endTime)
+    : mNow(startTime)
+    , mEnd(endTime)
+{
+    mStepTimer = new QTimer(this);
+    mStepTimer->setSingleShot(true);
+    connect(mStepTimer, &QTimer::timeout, this, &VirtualClock::step);
+}
+
+VirtualClock::~VirtualClock()
+{
+    if (mInstance == this)
+        mInstance = nullptr;
+}
+
+/******************************************************************************
+* Start the virtual clock, and freeze the simulated system time at the start
+* time.
+*/
+bool VirtualClock::start(const KADateTime& startTime, const KADateTime& endTime)
+{
+    if (mInstance)
+        return false;
+    KADateTime::setSimulatedSystemTime(startTime, true);
+    if (KADateTime::currentUtcDateTime() != startTime)
+    {
+        // The current time can't be simulated in this build.
+        KADateTime::setSimulatedSystemTime(KADateTime());
+        qCWarning(KALARM_LOG) << "VirtualClock::start: Time simulation is not available";
+        return false;
+    }
+    qCDebug(KALARM_LOG) << "VirtualClock::start:" << startTime << "to" << endTime;
+    mInstance = new VirtualClock(startTime, endTime);
+    mInstance->mActive = true;
+    mInstance->mRealTime.start();
+    mInstance->mCpuStart = std::clock();
+    return true;
+}
+
+void VirtualClock::setBusyFunction(const std::function<bool()>& busy)
+{
+    if (mInstance)
+        mInstance->mBusy = busy;
+}
+
+/******************************************************************************
+* Register a timer to fire when the virtual clock reaches a given time.
+*/
+void VirtualClock::startTimer(QTimer* timer, const KADateTime& due)
+{
+    if (!isActive())
+        return;
+    timer->stop();
+    mInstance->mTimers[timer] = {timer, due, mInstance->mNextOrder++};
+    mInstance->scheduleStep();
+}
+
+void VirtualClock::stopTimer(QTimer* timer)
+{
+    if (isActive()  &&  mInstance->mTimers.remove(timer))
+        mInstance->scheduleStep();
+}
+
+bool VirtualClock::isTimerScheduled(QTimer* timer)
+{
+    return isActive()  &&  mInstance->mTimers.contains(timer);
+}
+
+/******************************************************************************
+* Called when the application has become idle, to advance the clock without
+* waiting for the next busy check.
+*/
+void VirtualClock::notifyIdle()
+{
+    if (isActive()  &&  mInstance->mWaitingForIdle)
+    {
+        mInstance->mWaitingForIdle = false;
+        mInstance->mStepTimer->start(0);
+    }
+}
+
+/******************************************************************************
+* Record an alarm which has been triggered, and how late it was.
+*/
+void VirtualClock::recordAlarm(const KAEvent& event, const KAAlarm& alarm)
+{
+    if (!isActive())
+        return;
+    Statistics& stats = mInstance->mStatistics;
+    switch (alarm.action())
+    {
+        case KAAlarm::Action::Command:
+            if (!event.commandDisplay())
+            {
+                ++stats.command;
+                break;
+            }
+            [[fallthrough]];
+        case KAAlarm::Action::Message:
+        case KAAlarm::Action::File:
+            ++stats.display;
+            break;
+        case KAAlarm::Action::Email:
+            ++stats.email;
+            break;
+        case KAAlarm::Action::Audio:
+            ++stats.audio;
+            break;
+    }
+    const qint64 lateness = alarm.dateTime().effectiveKDateTime().secsTo(mInstance->mNow);
+    if (lateness > 0)
+    {
+        ++stats.lateAlarms;
+        stats.totalLateness += lateness;
+        if (lateness > stats.maxLateness)
+            stats.maxLateness = lateness;
+    }
+}
+
+void VirtualClock::scheduleStep()
+{
+    if (!mStepTimer->isActive())
+        mStepTimer->start(0);
+}
+
+/******************************************************************************
+* Advance the virtual clock to the earliest registered timer, and fire it.
+* If the application is still processing the last timer, wait until it is idle.
+*/
+void VirtualClock::step()
+{
+    if (!mActive)
+        return;
+    for (int i = mFired.count();  --i >= 0;  )
+    {
+        if (!mFired.at(i)  ||  !mFired.at(i)->isActive())
+            mFired.removeAt(i);
+    }
+    if (!mFired.isEmpty())
+    {
+        mStepTimer->start(0);   // wait until the fired timers have timed out
+        return;
+    }
+    if (mBusy && mBusy())
+    {
+        // Wait until the application is idle. It should call notifyIdle(),
+        // but check periodically in case it doesn't.
+        mWaitingForIdle = true;
+        mStepTimer->start(BUSY_CHECK_INTERVAL);
+        return;
+    }
+    mWaitingForIdle = false;
+
+    // Find the earliest registered timer. Timers which are due at the same
+    // time are fired in the order in which they were registered.
+    const Pending* next = nullptr;
+    for (auto it = mTimers.begin();  it != mTimers.end();  )
+    {
+        if (!it->timer)
+            it = mTimers.erase(it);   // the timer has been deleted
+        else
+        {
+            if (!next  ||  it->due < next->due  ||  (it->due == next->due && it->order < next->order))
+                next = &it.value();
+            ++it;
+        }
+    }
+    if (!next  ||  next->due > mEnd)
+    {
+        // There is nothing more to do before the end time.
+        mActive = false;
+        mStatistics.realMsecs = mRealTime.elapsed();
+        mStatistics.cpuMsecs = (std::clock() - mCpuStart) * 1000 / CLOCKS_PER_SEC;
+        mStatistics.peakMemory = peakMemory();
+        qCDebug(KALARM_LOG) << "VirtualClock::step: Simulation finished:" << mStatistics.triggered() << "alarms in" << mStatistics.realMsecs << "ms";
+        Q_EMIT finished();
+        return;
+    }
+
+    QTimer* timer = next->timer;
+    const KADateTime due = next->due;
+    mTimers.remove(timer);
+    if (due > mNow)
+    {
+        mNow = due;
+        KADateTime::setSimulatedSystemTime(mNow, true);
+        ++mStatistics.steps;
+    }
+    mFired.append(timer);
+    timer->start(0);
+    mStepTimer->start(0);
+}
+
+#include "moc_virtualclock.cpp"
+
+// vim: et sw=4:
@@ -0,0 +1,138 @@
+/*
+ *  virtualclock.h  -  virtual clock to drive alarm scheduling in simulations
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+/* @file virtualclock.h - virtual clock to drive alarm scheduling in simulations */
+
+#include "kalarmcalendar/kadatetime.h"
+#include "kalarmcalendar/kaevent.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+
+#include <ctime>
+#include <functional>
+
+class QTimer;
+
+using namespace KAlarmCal;
+
+/** VirtualClock drives alarm scheduling from a simulated clock instead of the
+ *  real system time, for load testing the scheduler.
+ *
+ *  When the virtual clock is active, timers which would normally wait in real
+ *  time are instead registered with the virtual clock by startTimer(). Once the
+ *  application is idle, the clock advances straight to the earliest registered
+ *  time, sets the simulated system time to it, and fires the timer. Alarm
+ *  actions are not executed, but are recorded by recordAlarm().
+ *
+ *  The simulation ends when no timer is due before the end time.
+ *
+ *  The virtual clock is only available in debug builds of the kalarmcalendar
+ *  library with simulation enabled (see KADateTime::setSimulatedSystemTime()).
+ *
+ *  @author David Jarvie <djarvie@kde.org>
+ */
+class VirtualClock : public QObject
+{
+    Q_OBJECT
+public:
+    /** Statistics for the alarms executed during the simulation. */
+    struct Statistics
+    {
+        int    display {0};        // number of display alarms triggered
+        int    command {0};        // number of command alarms triggered
+        int    email {0};          // number of email alarms triggered
+        int    audio {0};          // number of audio alarms triggered
+        qint64 totalLateness {0};  // total lateness of alarms, in virtual seconds
+        qint64 maxLateness {0};    // maximum lateness of an alarm, in virtual seconds
+        int    lateAlarms {0};     // number of alarms triggered after their due time
+        int    steps {0};          // number of times the clock has advanced
+        qint64 realMsecs {0};      // real time taken by the simulation
+        qint64 cpuMsecs {0};       // CPU time used by the simulation
+        long   peakMemory {0};     // peak resident memory of the process in kB, or 0 if unknown
+
+        int triggered() const   { return display + command + email + audio; }
+    };
+
+    ~VirtualClock() override;
+
+    /** Start the virtual clock.
+     *  @param startTime  The initial virtual time.
+     *  @param endTime    The time at which to end the simulation.
+     *  @return true if started, false if simulation is not available.
+     */
+    static bool start(const KADateTime& startTime, const KADateTime& endTime);
+
+    /** Return whether the virtual clock is running. */
+    static bool isActive()   { return mInstance  &&  mInstance->mActive; }
+
+    /** Return the virtual clock instance, or null if it has not been started. */
+    static VirtualClock* instance()   { return mInstance; }
+
+    /** Set a function which returns whether the application is busy, in which
+     *  case the clock will not advance until it is idle. */
+    static void setBusyFunction(const std::function<bool()>& busy);
+
+    /** Make a single shot timer fire when the virtual clock reaches a given
+     *  time, replacing any time previously set for it. */
+    static void startTimer(QTimer* timer, const KADateTime& due);
+
+    /** Cancel a timer registered by startTimer(). */
+    static void stopTimer(QTimer* timer);
+
+    /** Return whether a timer is waiting for the virtual clock. */
+    static bool isTimerScheduled(QTimer* timer);
+
+    /** Notify that the application has finished processing, so that the
+     *  clock can advance if it is waiting for the application to be idle. */
+    static void notifyIdle();
+
+    /** Record an alarm which has been triggered, instead of executing it. */
+    static void recordAlarm(const KAEvent&, const KAAlarm&);
+
+    /** Return the statistics for the simulation so far. */
+    const Statistics& statistics() const   { return mStatistics; }
+
+Q_SIGNALS:
+    /** Emitted when the simulation has reached its end time. */
+    void finished();
+
+private Q_SLOTS:
+    void step();
+
+private:
+    struct Pending
+    {
+        QPointer<QTimer> timer;
+        KADateTime       due;     // virtual time at which to fire the timer
+        quint64          order;   // sequence number, to order timers which are due together
+    };
+
+    VirtualClock(const KADateTime& startTime, const KADateTime& endTime);
+    void scheduleStep();
+
+    static VirtualClock*      mInstance;
+    QHash<QTimer*, Pending>   mTimers;      // timers waiting for the virtual clock
+    quint64                   mNextOrder {0};
+    QList<QPointer<QTimer>>   mFired;       // timers fired but not yet timed out
+    std::function<bool()>     mBusy;        // returns whether the application is busy
+    QTimer*                   mStepTimer;   // schedules the next clock advance
+    QElapsedTimer             mRealTime;    // real time since the simulation started
+    std::clock_t              mCpuStart {0};   // CPU time when the simulation started
+    KADateTime                mNow;         // current virtual time
+    KADateTime                mEnd;         // time at which the simulation ends
+    Statistics                mStatistics;
+    bool                      mActive {false};
+    bool                      mWaitingForIdle {false};   // waiting for the application to be idle
+};
+
+// vim: et sw=4:
@@ -8,6 +8,7 @@
 
 #include "messagewindow.h"
 #include "messagenotification.h"
+#include "messagesummary.h"
 
 #include "deferdlg.h"
 #include "displaycalendar.h"
@@ -24,18 +25,29 @@ using namespace KAlarmCal;
 using namespace KCalendarCore;
 
 
+namespace
+{
+// Maximum number of alarm message windows to create. Further alarms are shown
+// in the message summary window.
+const int MAX_MESSAGE_WINDOWS = 10;
+}
+
 bool MessageDisplay::mRedisplayed = false;
 
 /******************************************************************************
 * Create a new instance of a MessageDisplay, the derived class being dependent
 * on 'event.notify()'.
+* If the maximum number of message windows already exists, the alarm is shown
+* in the message summary window instead of in a new window.
 */
 MessageDisplay* MessageDisplay::create(const KAEvent& event, const KAAlarm& alarm, int flags)
 {
     if (event.notify())
         return new MessageNotification(event, alarm, flags & ~AlwaysHide);
-    else
-        return new MessageWindow(event, alarm, flags);
+    if (MessageSummaryItem::canSummarise(event, flags)
+    &&  (MessageSummaryWindow::exists()  ||  MessageWindow::windowCount(true) >= MAX_MESSAGE_WINDOWS))
+        return new MessageSummaryItem(event, alarm, flags);
+    return new MessageWindow(event, alarm, flags);
 }
 
 /******************************************************************************
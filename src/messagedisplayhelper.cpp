@@ -12,6 +12,7 @@
 #include "messagedisplay.h"
 
 #include "displaycalendar.h"
+#include "filecontentcache.h"
 #include "functions.h"
 #include "kalarm.h"
 #include "kalarmapp.h"
@@ -33,17 +34,12 @@
 #include <KAboutData>
 #include <KLocalizedString>
 #include <KConfig>
-#include <KIO/StatJob>
-#include <KIO/StoredTransferJob>
-#include <KJobWidgets>
 #include <KNotification>
 
 #include <QByteArray>
 #include <QLocale>
-#include <QMimeDatabase>
 #include <QRegularExpression>
 #include <QTemporaryFile>
-#include <QTextBrowser>
 #include <QThread>
 #include <QTimeZone>
 #include <QTimer>
@@ -66,6 +62,7 @@ enum
 };
 
 QList<MessageDisplayHelper*>   MessageDisplayHelper::mInstanceList;
+QMultiHash<EventId, MessageDisplayHelper*> MessageDisplayHelper::mEventIndex;
 QHash<EventId, unsigned>       MessageDisplayHelper::mErrorMessages;
 // There can only be one audio thread at a time: trying to play multiple
 // sound files simultaneously would result in a cacophony.
@@ -131,6 +128,8 @@ MessageDisplayHelper::MessageDisplayHelper(MessageDisplay* parent, const KAEvent
     }
 
     mInstanceList.append(this);
+    if (!mEventId.isEmpty())
+        mEventIndex.insert(mEventId, this);
     if (event.autoClose())
         mCloseTime = alarm.dateTime().effectiveKDateTime().toUtc().qDateTime().addSecs(event.lateCancel() * 60);
 }
@@ -192,7 +191,8 @@ MessageDisplayHelper::~MessageDisplayHelper()
         mAudioThread->setParent(nullptr);
     mErrorMessages.remove(mEventId);
     mInstanceList.removeAll(this);
-    delete mTempFile;
+    if (!mErrorWindow)
+        mEventIndex.remove(mEventId, this);
     if (!mNoPostAction  &&  !mEvent.postAction().isEmpty())
         theApp()->alarmCompleted(mEvent);
 }
@@ -238,64 +238,30 @@ void MessageDisplayHelper::initTexts()
 
                 // Display contents of file
                 const QUrl url = QUrl::fromUserInput(mMessage, QString(), QUrl::AssumeLocalFile);
-
-                auto statJob = KIO::stat(url, KIO::StatJob::SourceSide, KIO::StatBasic, KIO::HideProgressInfo);
-                const bool exists = statJob->exec();
-                const bool isDir = statJob->statResult().isDir();
-
-                bool opened = false;
-                if (exists && !isDir)
+                FileContentCache::Content content;
+                const FileContentCache::Status status = FileContentCache::content(url, content);
+                switch (status)
                 {
-                    auto job = KIO::storedGet(url);
-                    KJobWidgets::setWindow(job, MainWindow::mainMainWindow());
-                    if (job->exec())
-                    {
-                        opened = true;
-                        const QByteArray data = job->data();
-
-                        QMimeDatabase db;
-                        QMimeType mime = db.mimeTypeForUrl(url);
-                        if (mime.name() == "application/octet-stream"_L1)
-                            mime = db.mimeTypeForData(mTempFile);
-                        mTexts.fileType = File::fileType(mime);
-                        switch (mTexts.fileType)
+                    case FileContentCache::Status::Ok:
+                        mTexts.fileType = content.type;
+                        if (mTexts.fileType == File::Type::Image)
                         {
-                            case File::Type::Image:
-                            case File::Type::TextFormatted:
-                                delete mTempFile;
-                                mTempFile = new QTemporaryFile;
-                                if (mTempFile->open())
-                                    mTempFile->write(data);
-                                break;
-                            default:
-                                break;
+                            // Keep the cached copy of the image file until it has been displayed.
+                            mImageFile = content.imageFile;
+                            mTexts.message = QLatin1StringView(R"(<div align="center"><img src=")") + mImageFile->fileName() + QLatin1StringView(R"("></div>)");
                         }
-
-                        switch (mTexts.fileType)
-                        {
-                            case File::Type::Image:
-                                mTexts.message = QLatin1StringView(R"(<div align="center"><img src=")") + mTempFile->fileName() + QLatin1StringView(R"("></div>)");
-                                mTempFile->close();   // keep the file available to be displayed
-                                break;
-                            case File::Type::TextFormatted:
-                            {
-                                QTextBrowser browser;
-                                browser.setSource(QUrl::fromLocalFile(mTempFile->fileName()));
-                                mTexts.message = browser.toHtml();
-                                delete mTempFile;
-                                mTempFile = nullptr;
-                                break;
-                            }
-                            default:
-                                mTexts.message = QString::fromUtf8(data);
-                                break;
-                        }
-                    }
-                }
-
-                if (!exists || isDir || !opened)
-                {
-                    mErrorMsgs += isDir ? i18nc("@info", "File is a folder") : exists ? i18nc("@info", "Failed to open file") : i18nc("@info", "File not found");
+                        else
+                            mTexts.message = content.text;
+                        break;
+                    case FileContentCache::Status::IsDirectory:
+                        mErrorMsgs += i18nc("@info", "File is a folder");
+                        break;
+                    case FileContentCache::Status::Unreadable:
+                        mErrorMsgs += i18nc("@info", "Failed to open file");
+                        break;
+                    case FileContentCache::Status::NotFound:
+                        mErrorMsgs += i18nc("@info", "File not found");
+                        break;
                 }
                 break;
             }
@@ -696,7 +662,7 @@ bool MessageDisplayHelper::readPropertyValues(const KConfigGroup& config)
     mShowEdit            = false;
     // Temporarily initialise mResource and mEventId - they will be set by redisplayAlarm()
     mResource            = Resources::resource(resourceId);
-    mEventId             = EventId(resourceId, eventId);
+    setEventId(EventId(resourceId, eventId));
     if (mAlarmType == KAAlarm::Type::Invalid)
         return false;
     qCDebug(KALARM_LOG) << "MessageDisplayHelper::readProperties:" << eventId;
@@ -739,7 +705,7 @@ void MessageDisplayHelper::showRestoredAlarm()
 void MessageDisplayHelper::redisplayAlarm()
 {
     mResource = Resources::resourceForEvent(mEventId.eventId());
-    mEventId.setResourceId(mResource.id());
+    setEventId(EventId(mResource.id(), mEventId.eventId()));
     qCDebug(KALARM_LOG) << "MessageDisplayHelper::redisplayAlarm:" << mEventId;
     // Delete any already existing display for the same event
     MessageDisplay* duplicate = findEvent(mEventId, mParent);
@@ -787,7 +753,8 @@ bool MessageDisplayHelper::alarmShowing(KAEvent& event)
         if (DisplayCalendar::open())
         {
             DisplayCalendar::deleteEvent(dispEvent.id());   // in case it already exists
-            DisplayCalendar::addEvent(dispEvent);
+            if (!DisplayCalendar::addEvent(dispEvent))
+                qCWarning(KALARM_LOG) << "MessageDisplayHelper::alarmShowing: Error saving alarm to displaying calendar:" << dispEvent.id();
             DisplayCalendar::save();
         }
     }
@@ -795,6 +762,20 @@ bool MessageDisplayHelper::alarmShowing(KAEvent& event)
     return true;
 }
 
+/******************************************************************************
+* Set the event ID of the alarm being displayed, and update the event ID index.
+*/
+void MessageDisplayHelper::setEventId(const EventId& eventId)
+{
+    if (!mErrorWindow)
+    {
+        mEventIndex.remove(mEventId, this);
+        if (!eventId.isEmpty())
+            mEventIndex.insert(eventId, this);
+    }
+    mEventId = eventId;
+}
+
 /******************************************************************************
 * Returns the existing message display (if any) which is showing the event with
 * the specified ID.
@@ -803,10 +784,10 @@ MessageDisplay* MessageDisplayHelper::findEvent(const EventId& eventId, MessageD
 {
     if (!eventId.isEmpty())
     {
-        for (const MessageDisplayHelper* h : std::as_const(mInstanceList))
+        for (auto it = mEventIndex.constFind(eventId);  it != mEventIndex.cend() && it.key() == eventId;  ++it)
         {
-            if (h->mParent != exclude  &&  h->mEventId == eventId  &&  !h->mErrorWindow)
-                return h->mParent;
+            if (it.value()->mParent != exclude)
+                return it.value()->mParent;
         }
     }
     return nullptr;
@@ -1175,8 +1156,7 @@ bool MessageDisplayHelper::activateAutoClose()
 */
 void MessageDisplayHelper::displayComplete(bool audio)
 {
-    delete mTempFile;
-    mTempFile = nullptr;
+    mImageFile.reset();
     if (audio)
         playAudio();
     if (mRescheduleEvent)
@@ -19,6 +19,8 @@
 #include <QPointer>
 #include <QDateTime>
 
+#include <memory>
+
 class KConfigGroup;
 class QTemporaryFile;
 class AudioPlayerThread;
@@ -146,8 +148,10 @@ private:
     bool    haveErrorMessage(unsigned msg) const;
     void    clearErrorMessage(unsigned msg) const;
     void    redisplayAlarm();
+    void    setEventId(const EventId&);
 
     static QList<MessageDisplayHelper*> mInstanceList; // list of existing message displays
+    static QMultiHash<EventId, MessageDisplayHelper*> mEventIndex; // alarm (not error) displays, by event ID
     static QHash<EventId, unsigned> mErrorMessages; // error messages currently displayed, by event ID
     // Sound file playing
     static QPointer<QThread>     mAudioThread;    // container of thread to play audio file in
@@ -195,7 +199,7 @@ public:
     bool                mSpeak;                   // the message should be spoken via kttsd
 private:
     DisplayTexts        mTexts;                   // texts to display in alarm message
-    QTemporaryFile*     mTempFile {nullptr};      // temporary file used to display image/HTML
+    std::shared_ptr<QTemporaryFile> mImageFile;   // temporary file used to display image
     QByteArray          mCommandOutput;           // cumulative output from command
     bool                mCommandHaveStdout {false}; // true if some stdout has been received from command
     bool                mNoRecordCmdError {false}; // don't record command alarm errors
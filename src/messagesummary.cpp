@@ -0,0 +1,566 @@
+/*
+ *  messagesummary.cpp  -  displays excess alarm messages in a single paged window
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "messagesummary.h"
+#include "messagedisplayhelper.h"
+
+#include "resourcescalendar.h"
+#include "lib/messagebox.h"
+#include "lib/pushbutton.h"
+#include "kalarm_debug.h"
+
+#include <KLocalizedString>
+#include <KSqueezedTextLabel>
+#include <KStandardGuiItem>
+
+#include <QApplication>
+#include <QCloseEvent>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QTextBrowser>
+#include <QVBoxLayout>
+using namespace Qt::Literals::StringLiterals;
+
+using namespace KAlarmCal;
+
+QPointer<MessageSummaryWindow> MessageSummaryWindow::mInstance;
+
+/******************************************************************************
+* Construct a summary display for the specified alarm.
+* The alarm's texts are not initialised until its page is first displayed.
+*/
+MessageSummaryItem::MessageSummaryItem(const KAEvent& event, const KAAlarm& alarm, int flags)
+    : QObject()
+    , MessageDisplay(event, alarm, flags)
+{
+    qCDebug(KALARM_LOG) << "MessageSummaryItem():" << mEventId();
+    mEnableEdit = mShowEdit();
+    if (!mNoDefer())
+    {
+        mEnableDefer = true;
+        mHelper->setDeferralLimit(mEvent());  // ensure that button is disabled when alarm can't be deferred any more
+    }
+    connect(mHelper, &MessageDisplayHelper::textsChanged, this, &MessageSummaryItem::textsChanged);
+    connect(mHelper, &MessageDisplayHelper::autoCloseNow, this, &MessageSummaryItem::closeDisplay);
+}
+
+MessageSummaryItem::~MessageSummaryItem()
+{
+    qCDebug(KALARM_LOG) << "~MessageSummaryItem" << mEventId();
+    if (mShown  &&  MessageSummaryWindow::exists())
+        MessageSummaryWindow::instance()->removeItem(this);
+}
+
+/******************************************************************************
+* Return whether an alarm can be displayed in the summary window.
+* Command output alarms are excluded, since their texts can't be deferred until
+* the alarm is viewed.
+*/
+bool MessageSummaryItem::canSummarise(const KAEvent& event, int flags)
+{
+    if (flags & (AlwaysHide | NoInitView))
+        return false;
+    switch (event.actionSubType())
+    {
+        case KAEvent::SubAction::Message:
+        case KAEvent::SubAction::File:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/******************************************************************************
+* Set up the alarm's texts.
+*/
+void MessageSummaryItem::setUpDisplay()
+{
+    if (!mInitialised)
+    {
+        mHelper->initTexts();
+        mInitialised = true;
+    }
+}
+
+/******************************************************************************
+* Return the alarm's texts, initialising them if necessary.
+*/
+const MessageDisplayHelper::DisplayTexts& MessageSummaryItem::texts()
+{
+    setUpDisplay();
+    return mHelper->texts();
+}
+
+QWidget* MessageSummaryItem::displayParent()
+{
+    return MessageSummaryWindow::instance();
+}
+
+/******************************************************************************
+* Acknowledge the alarm, and remove it from the summary window.
+*/
+void MessageSummaryItem::closeDisplay()
+{
+    if (!mHelper->closeEvent())
+        return;
+    if (mShown)
+    {
+        MessageSummaryWindow::instance()->removeItem(this);
+        mShown = false;
+    }
+    deleteLater();
+}
+
+/******************************************************************************
+* Add the alarm to the summary window.
+* Reschedule or delete the event from the calendar file.
+*/
+void MessageSummaryItem::showDisplay()
+{
+    if (mShown  ||  !mHelper->activateAutoClose())
+        return;
+    mShown = true;
+    MessageSummaryWindow::instance()->addItem(this);
+    if (mAlarmType() != KAAlarm::Type::Invalid)
+        mHelper->displayComplete(false);   // reschedule; audio is played when the alarm is viewed
+}
+
+void MessageSummaryItem::raiseDisplay()
+{
+    if (mShown)
+        MessageSummaryWindow::instance()->showItem(this);
+}
+
+/******************************************************************************
+* Show the alarm's page, re-output any required audio notification, and
+* reschedule the alarm in the calendar file.
+*/
+void MessageSummaryItem::repeat(const KAAlarm& alarm)
+{
+    if (mEventId().isEmpty())
+        return;
+    KAEvent event = ResourcesCalendar::event(mEventId());
+    if (event.isValid())
+    {
+        mAlarmType() = alarm.type();    // store new alarm type for use if it is later deferred
+        mAudioPlayed = false;
+        raiseDisplay();
+        if (mHelper->alarmShowing(event))
+            ResourcesCalendar::updateEvent(event);
+    }
+}
+
+bool MessageSummaryItem::hasDefer() const
+{
+    return mEnableDefer;
+}
+
+/******************************************************************************
+* Show the Defer button when it was previously hidden.
+*/
+void MessageSummaryItem::showDefer()
+{
+    if (!mEnableDefer)
+    {
+        mNoDefer() = false;
+        mEnableDefer = true;
+        mHelper->setDeferralLimit(mEvent());    // disable button when alarm can't be deferred any more
+        textsChanged();
+    }
+}
+
+/******************************************************************************
+* Update and show the alarm's trigger time.
+*/
+void MessageSummaryItem::showDateTime(const KAEvent& event, const KAAlarm& alarm)
+{
+    if (mHelper->updateDateTime(event, alarm))
+        textsChanged();
+}
+
+/******************************************************************************
+* Convert a reminder display into a normal alarm display.
+*/
+void MessageSummaryItem::cancelReminder(const KAEvent& event, const KAAlarm& alarm)
+{
+    if (mHelper->cancelReminder(event, alarm))
+    {
+        showDefer();
+        textsChanged();
+    }
+}
+
+/******************************************************************************
+* Called by MessageDisplayHelper to confirm that the alarm should be
+* acknowledged.
+*/
+bool MessageSummaryItem::confirmAcknowledgement()
+{
+    if (!mNoCloseConfirm())
+    {
+        // Ask for confirmation of acknowledgement. Use warningYesNo() because its default is No.
+        if (KAMessageBox::warningYesNo(displayParent(), i18nc("@info", "Do you really want to acknowledge this alarm?"),
+                                       i18nc("@action:button", "Acknowledge Alarm"), KGuiItem(i18nc("@action:button", "Acknowledge")), KStandardGuiItem::cancel())
+            != KMessageBox::ButtonCode::PrimaryAction)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MessageSummaryItem::isDeferButtonEnabled() const
+{
+    return mEnableDefer;
+}
+
+void MessageSummaryItem::enableDeferButton(bool enable)
+{
+    mEnableDefer = enable;
+    textsChanged();
+}
+
+void MessageSummaryItem::enableEditButton(bool enable)
+{
+    mEnableEdit = enable;
+    textsChanged();
+}
+
+void MessageSummaryItem::editDlgCancelled()
+{
+    enableEditButton(true);
+}
+
+/******************************************************************************
+* Called when the alarm's page has been displayed.
+* The first time, output any required audio notification.
+*/
+void MessageSummaryItem::activated()
+{
+    if (!mAudioPlayed)
+    {
+        mAudioPlayed = true;
+        playAudio();
+    }
+}
+
+/******************************************************************************
+* Display the alarm edit dialog.
+*/
+void MessageSummaryItem::edit()
+{
+    if (mHelper->createEdit())
+    {
+        mEnableEdit = false;
+        textsChanged();
+        mHelper->executeEdit();
+    }
+}
+
+/******************************************************************************
+* Display the defer dialog.
+*/
+void MessageSummaryItem::defer()
+{
+    DeferDlgData* data = createDeferDlg(this, false);
+    executeDeferDlg(data);
+}
+
+/******************************************************************************
+* Called when the alarm's texts or button states have changed.
+*/
+void MessageSummaryItem::textsChanged()
+{
+    if (mShown  &&  MessageSummaryWindow::exists())
+        MessageSummaryWindow::instance()->itemChanged(this);
+}
+
+
+/******************************************************************************
+* Construct the summary window.
+*/
+MessageSummaryWindow::MessageSummaryWindow()
+    : MainWindowBase(nullptr, Qt::WindowStaysOnTopHint | Qt::WindowDoesNotAcceptFocus)
+{
+    qCDebug(KALARM_LOG) << "MessageSummaryWindow()";
+    setAttribute(Qt::WA_DeleteOnClose);
+    setObjectName("MessageSummaryWindow"_L1);    // used by LikeBack
+    setCaption(i18nc("@title:window", "Alarms"));
+
+    QWidget* topWidget = new QWidget(this);
+    setCentralWidget(topWidget);
+    auto topLayout = new QVBoxLayout(topWidget);
+
+    mPageLabel = new QLabel(topWidget);
+    topLayout->addWidget(mPageLabel, 0, Qt::AlignHCenter);
+
+    mTimeLabel = new QLabel(topWidget);
+    mTimeLabel->setFrameStyle(QFrame::StyledPanel);
+    mTimeLabel->setAlignment(Qt::AlignHCenter);
+    mTimeLabel->setWhatsThis(i18nc("@info:whatsthis", "The scheduled date/time for the message (as opposed to the actual time of display)."));
+    topLayout->addWidget(mTimeLabel, 0, Qt::AlignHCenter);
+
+    mFileLabel = new KSqueezedTextLabel(topWidget);
+    mFileLabel->setFrameStyle(QFrame::StyledPanel);
+    mFileLabel->setTextInteractionFlags(Qt::TextSelectableByMouse | Qt::TextSelectableByKeyboard);
+    mFileLabel->setWhatsThis(i18nc("@info:whatsthis", "The file whose contents are displayed below"));
+    topLayout->addWidget(mFileLabel, 0, Qt::AlignHCenter);
+
+    mText = new QTextBrowser(topWidget);
+    mText->setWhatsThis(i18nc("@info:whatsthis", "The alarm message"));
+    topLayout->addWidget(mText, 1);
+
+    auto buttonLayout = new QHBoxLayout();
+    topLayout->addLayout(buttonLayout);
+
+    mPreviousButton = new PushButton(KStandardGuiItem::back(KStandardGuiItem::UseRTL), topWidget);
+    mPreviousButton->setFocusPolicy(Qt::ClickFocus);    // don't allow keyboard selection
+    connect(mPreviousButton, &QAbstractButton::clicked, this, &MessageSummaryWindow::slotPrevious);
+    buttonLayout->addWidget(mPreviousButton);
+
+    mNextButton = new PushButton(KStandardGuiItem::forward(KStandardGuiItem::UseRTL), topWidget);
+    mNextButton->setFocusPolicy(Qt::ClickFocus);    // don't allow keyboard selection
+    connect(mNextButton, &QAbstractButton::clicked, this, &MessageSummaryWindow::slotNext);
+    buttonLayout->addWidget(mNextButton);
+    buttonLayout->addStretch();
+
+    mOkButton = new PushButton(KStandardGuiItem::close(), topWidget);
+    // Prevent accidental acknowledgement of the message if the user is typing when the window appears
+    mOkButton->clearFocus();
+    mOkButton->setFocusPolicy(Qt::ClickFocus);    // don't allow keyboard selection
+    mOkButton->setToolTip(i18nc("@info:tooltip", "Acknowledge the alarm"));
+    connect(mOkButton, &QAbstractButton::clicked, this, &MessageSummaryWindow::slotOk);
+    buttonLayout->addWidget(mOkButton);
+
+    mEditButton = new PushButton(i18nc("@action:button", "Edit..."), topWidget);
+    mEditButton->setFocusPolicy(Qt::ClickFocus);    // don't allow keyboard selection
+    mEditButton->setToolTip(i18nc("@info:tooltip", "Edit the alarm"));
+    connect(mEditButton, &QAbstractButton::clicked, this, &MessageSummaryWindow::slotEdit);
+    buttonLayout->addWidget(mEditButton);
+
+    mDeferButton = new PushButton(i18nc("@action:button", "Defer..."), topWidget);
+    mDeferButton->setFocusPolicy(Qt::ClickFocus);    // don't allow keyboard selection
+    mDeferButton->setToolTip(i18nc("@info:tooltip", "Defer the alarm until later"));
+    connect(mDeferButton, &QAbstractButton::clicked, this, &MessageSummaryWindow::slotDefer);
+    buttonLayout->addWidget(mDeferButton);
+}
+
+MessageSummaryWindow::~MessageSummaryWindow()
+{
+    qCDebug(KALARM_LOG) << "~MessageSummaryWindow";
+}
+
+/******************************************************************************
+* Return the unique summary window, creating it if necessary.
+*/
+MessageSummaryWindow* MessageSummaryWindow::instance()
+{
+    if (!mInstance)
+        mInstance = new MessageSummaryWindow;
+    return mInstance;
+}
+
+/******************************************************************************
+* Add an alarm to the end of the window's pages, and show the window.
+*/
+void MessageSummaryWindow::addItem(MessageSummaryItem* item)
+{
+    mItems.append(item);
+    if (mCurrent < 0)
+        showPage(0);
+    else
+        updateButtons();
+    if (!isVisible())
+    {
+        show();
+        MessageDisplayHelper::wakeScreen();
+    }
+}
+
+/******************************************************************************
+* Remove an alarm from the window. If no alarms remain, delete the window.
+*/
+void MessageSummaryWindow::removeItem(MessageSummaryItem* item)
+{
+    const int index = mItems.indexOf(item);
+    if (index < 0)
+        return;
+    mItems.removeAt(index);
+    if (mItems.isEmpty())
+    {
+        mCurrent = -1;
+        if (!mClosing)
+        {
+            hide();
+            deleteLater();
+        }
+        return;
+    }
+    if (index < mCurrent)
+        --mCurrent;
+    else if (index == mCurrent)
+    {
+        showPage(qMin(mCurrent, static_cast<int>(mItems.count()) - 1));
+        return;
+    }
+    updateButtons();
+}
+
+/******************************************************************************
+* Display the page for an alarm, and raise the window.
+*/
+void MessageSummaryWindow::showItem(MessageSummaryItem* item)
+{
+    const int index = mItems.indexOf(item);
+    if (index >= 0)
+    {
+        showPage(index);
+        raise();
+    }
+}
+
+/******************************************************************************
+* Called when an alarm's texts or button states have changed.
+*/
+void MessageSummaryWindow::itemChanged(MessageSummaryItem* item)
+{
+    if (item == currentItem())
+        showPage(mCurrent);
+}
+
+MessageSummaryItem* MessageSummaryWindow::currentItem() const
+{
+    return (mCurrent >= 0  &&  mCurrent < mItems.count()) ? mItems.at(mCurrent) : nullptr;
+}
+
+/******************************************************************************
+* Display the page for the alarm at the specified index.
+*/
+void MessageSummaryWindow::showPage(int index)
+{
+    mCurrent = index;
+    MessageSummaryItem* item = currentItem();
+    if (!item)
+        return;
+    const MessageDisplayHelper::DisplayTexts& texts = item->texts();
+
+    mTimeLabel->setText(texts.timeFull);
+    mTimeLabel->setVisible(!texts.timeFull.isEmpty());
+
+    QPalette pal = mText->viewport()->palette();
+    pal.setColor(mText->viewport()->backgroundRole(), item->mBgColour());
+    mText->viewport()->setPalette(pal);
+    mText->clear();
+    mText->setTextColor(item->mFgColour());
+    mText->setCurrentFont(item->mFont());
+    QString errors;
+    if (!item->mErrorMsgs().isEmpty())
+        errors = item->mErrorMsgs().join(QLatin1Char('\n'));
+    if (item->mAction() == KAEvent::SubAction::File)
+    {
+        mFileLabel->setText(texts.fileName);
+        mFileLabel->show();
+        if (!errors.isEmpty())
+            mText->setPlainText(errors);
+        else if (texts.fileType == File::Type::Image  ||  texts.fileType == File::Type::TextFormatted)
+            mText->setHtml(texts.message);
+        else
+            mText->setPlainText(texts.message);
+    }
+    else
+    {
+        mFileLabel->hide();
+        mText->setPlainText(errors.isEmpty() ? texts.message : texts.message + QLatin1Char('\n') + errors);
+    }
+
+    updateButtons();
+    item->activated();
+}
+
+/******************************************************************************
+* Set the page indicator, and the button states for the current alarm.
+*/
+void MessageSummaryWindow::updateButtons()
+{
+    MessageSummaryItem* item = currentItem();
+    mPageLabel->setText(i18nc("@label", "Alarm %1 of %2", mCurrent + 1, mItems.count()));
+    mPreviousButton->setEnabled(mCurrent > 0);
+    mNextButton->setEnabled(mCurrent < mItems.count() - 1);
+    mEditButton->setVisible(item  &&  item->mShowEdit());
+    mEditButton->setEnabled(item  &&  item->mEnableEdit  &&  !item->mEditDlg());
+    mDeferButton->setVisible(item  &&  !item->mNoDefer());
+    mDeferButton->setEnabled(item  &&  item->mEnableDefer  &&  !item->mDisableDeferral());
+}
+
+void MessageSummaryWindow::slotPrevious()
+{
+    if (mCurrent > 0)
+        showPage(mCurrent - 1);
+}
+
+void MessageSummaryWindow::slotNext()
+{
+    if (mCurrent < mItems.count() - 1)
+        showPage(mCurrent + 1);
+}
+
+/******************************************************************************
+* Called when the OK button is clicked, to acknowledge the current alarm.
+*/
+void MessageSummaryWindow::slotOk()
+{
+    MessageSummaryItem* item = currentItem();
+    if (item)
+        item->closeDisplay();
+}
+
+void MessageSummaryWindow::slotEdit()
+{
+    MessageSummaryItem* item = currentItem();
+    if (item)
+        item->edit();
+}
+
+void MessageSummaryWindow::slotDefer()
+{
+    MessageSummaryItem* item = currentItem();
+    if (item)
+        item->defer();
+}
+
+/******************************************************************************
+* Called when the window is closed by the user.
+* After confirmation, acknowledge all the alarms which it displays.
+*/
+void MessageSummaryWindow::closeEvent(QCloseEvent* ce)
+{
+    if (!mItems.isEmpty()  &&  !qApp->isSavingSession())
+    {
+        if (KAMessageBox::warningContinueCancel(this, i18ncp("@info", "Do you really want to acknowledge this alarm?",
+                                                                      "Do you really want to acknowledge all %1 alarms?", mItems.count()),
+                                                i18nc("@action:button", "Acknowledge Alarm"), KGuiItem(i18nc("@action:button", "Acknowledge")))
+            != KMessageBox::Continue)
+        {
+            ce->ignore();
+            return;
+        }
+        mClosing = true;
+        const QList<MessageSummaryItem*> items = mItems;
+        for (MessageSummaryItem* item : items)
+        {
+            item->mHelper->mNoCloseConfirm = true;   // the user has already confirmed
+            item->closeDisplay();
+        }
+        mClosing = false;
+    }
+    MainWindowBase::closeEvent(ce);
+}
+
+#include "moc_messagesummary.cpp"
+
+// vim: et sw=4:
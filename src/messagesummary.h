@@ -0,0 +1,135 @@
+/*
+ *  messagesummary.h  -  displays excess alarm messages in a single paged window
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "mainwindowbase.h"
+#include "messagedisplay.h"
+
+#include <QPointer>
+
+class QCloseEvent;
+class QLabel;
+class QTextBrowser;
+class KSqueezedTextLabel;
+class PushButton;
+class MessageSummaryWindow;
+
+using namespace KAlarmCal;
+
+/**
+ * MessageSummaryItem: An alarm message which is displayed as one page of the
+ * message summary window, instead of in its own message window.
+ *
+ * This is used when the maximum number of message windows is already being
+ * displayed, so that when many alarms trigger together (e.g. on resuming from
+ * suspend), they don't each create a window. The alarm's texts are not set up
+ * until its page is first displayed.
+ */
+class MessageSummaryItem : public QObject, public MessageDisplay
+{
+    Q_OBJECT
+public:
+    MessageSummaryItem(const KAEvent&, const KAAlarm&, int flags);
+    ~MessageSummaryItem() override;
+
+    /** Return whether an alarm is suitable for display in the summary window. */
+    static bool canSummarise(const KAEvent&, int flags);
+
+    QWidget* displayParent() override;
+    void closeDisplay() override;
+    void showDisplay() override;
+    void raiseDisplay() override;
+
+    void                repeat(const KAAlarm&) override;
+    bool                hasDefer() const override;
+    void                showDefer() override;
+    void                showDateTime(const KAEvent&, const KAAlarm&) override;
+    void                cancelReminder(const KAEvent&, const KAAlarm&) override;
+
+protected:
+    bool confirmAcknowledgement() override;
+    void setUpDisplay() override;
+    bool isDeferButtonEnabled() const override;
+    void enableDeferButton(bool enable) override;
+    void enableEditButton(bool enable) override;
+    void editDlgCancelled() override;
+
+private Q_SLOTS:
+    void textsChanged();
+
+private:
+    const MessageDisplayHelper::DisplayTexts& texts();
+    void                activated();
+    void                edit();
+    void                defer();
+
+    bool                mEnableDefer {false};     // whether to enable the Defer button
+    bool                mEnableEdit {false};      // whether to enable the Edit button
+    bool                mInitialised {false};     // setUpDisplay() has been called to create the texts
+    bool                mShown {false};           // true once the alarm has been added to the summary window
+    bool                mAudioPlayed {false};     // true once the alarm's audio has been played
+
+friend class MessageSummaryWindow;
+};
+
+/**
+ * MessageSummaryWindow: A window which displays MessageSummaryItem alarms,
+ * one page per alarm, each with its own acknowledge and defer buttons.
+ * There is only ever one instance, which is deleted when its last alarm has
+ * been acknowledged or deferred.
+ */
+class MessageSummaryWindow : public MainWindowBase
+{
+    Q_OBJECT
+public:
+    ~MessageSummaryWindow() override;
+
+    /** Return the summary window, creating it if necessary. */
+    static MessageSummaryWindow* instance();
+
+    /** Return whether the summary window currently exists. */
+    static bool exists()   { return !mInstance.isNull(); }
+
+    void addItem(MessageSummaryItem*);
+    void removeItem(MessageSummaryItem*);
+    void showItem(MessageSummaryItem*);
+    void itemChanged(MessageSummaryItem*);
+
+protected:
+    void closeEvent(QCloseEvent*) override;
+
+private Q_SLOTS:
+    void slotPrevious();
+    void slotNext();
+    void slotOk();
+    void slotEdit();
+    void slotDefer();
+
+private:
+    MessageSummaryWindow();
+    MessageSummaryItem* currentItem() const;
+    void                showPage(int index);
+    void                updateButtons();
+
+    static QPointer<MessageSummaryWindow> mInstance;
+    QList<MessageSummaryItem*> mItems;            // alarms displayed, in order of display
+    int                 mCurrent {-1};            // index of the alarm currently displayed
+    QLabel*             mPageLabel;               // "Alarm n of N"
+    QLabel*             mTimeLabel;               // trigger time label
+    KSqueezedTextLabel* mFileLabel;               // file name, for file alarms
+    QTextBrowser*       mText;                    // alarm message or file contents
+    PushButton*         mPreviousButton;
+    PushButton*         mNextButton;
+    PushButton*         mOkButton;
+    PushButton*         mEditButton;
+    PushButton*         mDeferButton;
+    bool                mClosing {false};         // all alarms are being acknowledged
+};
+
+// vim: et sw=4:
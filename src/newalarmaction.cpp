@@ -147,7 +147,9 @@ void NewAlarmAction::slotCalendarStatusChanged()
 {
     // Find whether there are any writable active alarm calendars
     bool active = !Resources::enabledResources(CalEvent::ACTIVE, true).isEmpty();
-    bool haveEvents = DataModel::allTemplateListModel()->haveEvents();
+    // Templates whose loading has been deferred may exist.
+    bool haveEvents = DataModel::allTemplateListModel()->haveEvents()
+                   || Resources::haveDeferredEvents(CalEvent::TEMPLATE);
     mTemplateAction->setEnabled(active && haveEvents);
     setEnabled(active);
 }
@@ -387,7 +387,7 @@ KADateTime::Spec Preferences::timeSpec()
 QTimeZone Preferences::timeSpecAsZone()
 {
     const QByteArray zoneId = self()->mBase_TimeZone.toLatin1();
-    return zoneId.isEmpty() ? QTimeZone::systemTimeZone() : QTimeZone(zoneId);
+    return zoneId.isEmpty() ? KADateTime::localZone() : QTimeZone(zoneId);
 }
 
 void Preferences::setTimeSpec(const KADateTime::Spec& spec)
@@ -398,6 +398,7 @@ void Preferences::setTimeSpec(const KADateTime::Spec& spec)
 void Preferences::timeZoneChange(const QString& zone)
 {
     Q_UNUSED(zone);
+    KADateTime::refreshLocalZone();
     Q_EMIT mInstance->timeZoneChanged(timeSpec());
 }
 
@@ -0,0 +1,269 @@
+/*
+ *  calendarconverter.cpp  -  converts calendar events to current KAlarm format in the background
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "calendarconverter.h"
+
+#include "kalarmcalendar/kacalendar.h"
+#include "kalarmcalendar/kaevent.h"
+#include "kalarm_debug.h"
+
+#include <KCalendarCore/FileStorage>
+#include <KCalendarCore/ICalFormat>
+#include <KCalendarCore/MemoryCalendar>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QPointer>
+#include <QThreadPool>
+#include <QTimeZone>
+
+#include <algorithm>
+using namespace Qt::Literals::StringLiterals;
+
+using namespace KAlarmCal;
+
+const int CalendarConverter::ChunkSize = 200;
+
+namespace
+{
+const QString SOURCE_FILE(QStringLiteral("source"));        // progress file identifying the calendar file
+const QString CHUNK_FILE(QStringLiteral("chunk-%1.ics"));   // progress file holding converted events
+const QString CHUNK_FILES(QStringLiteral("chunk-*.ics"));   // name filter for chunk progress files
+
+int  chunkNumber(const QString& fileName);
+KCalendarCore::Event::List readChunkFiles(const QString& progressDir);
+bool writeChunkFile(const QString& fileName, const KCalendarCore::Event::List& events);
+}
+
+CalendarConverter::CalendarConverter(const KCalendarCore::Event::List& events, int version, const QString& progressDir, QObject* parent)
+    : QObject(parent)
+    , mProgressDir(progressDir)
+    , mVersion(version)
+{
+    for (const KCalendarCore::Event::Ptr& event : events)
+        mPending.insert(event->uid(), event);
+}
+
+CalendarConverter::~CalendarConverter()
+{
+    qCDebug(KALARM_LOG) << "CalendarConverter::~CalendarConverter:" << mProgressDir << mPending.count() << "events not converted";
+}
+
+/******************************************************************************
+* Start converting events. If the progress directory contains events converted
+* previously from the same calendar file, restore them first.
+*/
+void CalendarConverter::start(const QByteArray& sourceHash)
+{
+    if (mStarted)
+        return;
+    mStarted = true;
+    qCDebug(KALARM_LOG) << "CalendarConverter::start:" << mProgressDir << mPending.count() << "events";
+
+    // Check whether the progress files relate to this version of the calendar file.
+    const QString id = QString::fromLatin1(sourceHash.toHex()) + ':'_L1 + QString::number(mVersion);
+    QFile source(mProgressDir + '/'_L1 + SOURCE_FILE);
+    bool resume = false;
+    if (source.open(QIODevice::ReadOnly))
+    {
+        resume = (QString::fromLatin1(source.readAll()).trimmed() == id);
+        source.close();
+    }
+    if (!resume)
+    {
+        discardProgress(mProgressDir);
+        if (!QDir().mkpath(mProgressDir)  ||  !source.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            qCWarning(KALARM_LOG) << "CalendarConverter::start: Cannot write progress file in" << mProgressDir;
+        else
+        {
+            source.write(id.toLatin1());
+            source.close();
+        }
+        convertNextChunk();
+        return;
+    }
+
+    // Restore the events which were converted previously, in a background thread.
+    // Number new chunk files after the highest existing one. Note that the
+    // chunk numbers may not be contiguous, if writing a chunk failed.
+    const QStringList fileNames = QDir(mProgressDir).entryList({CHUNK_FILES}, QDir::Files);
+    for (const QString& fileName : fileNames)
+        mChunkIndex = std::max(mChunkIndex, chunkNumber(fileName) + 1);
+    QPointer<CalendarConverter> converter(this);
+    const QString progressDir = mProgressDir;
+    QThreadPool::globalInstance()->start([converter, progressDir]()
+    {
+        const KCalendarCore::Event::List events = readChunkFiles(progressDir);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [converter, events]()
+        {
+            if (converter)
+            {
+                qCDebug(KALARM_LOG) << "CalendarConverter: Restored" << events.count() << "converted events";
+                converter->chunkConverted(events);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+/******************************************************************************
+* Convert the next chunk of events in a background thread.
+*/
+void CalendarConverter::convertNextChunk()
+{
+    if (mPending.isEmpty())
+    {
+        qCDebug(KALARM_LOG) << "CalendarConverter: Conversion complete" << mProgressDir;
+        mFinished = true;
+        Q_EMIT finished();
+        return;
+    }
+
+    // Clone the events, so that the calendar's events are never accessed
+    // by the background thread.
+    KCalendarCore::Event::List chunk;
+    chunk.reserve(std::min<qsizetype>(ChunkSize, mPending.count()));
+    for (auto it = mPending.constBegin();  it != mPending.constEnd()  &&  chunk.count() < ChunkSize;  ++it)
+        chunk += KCalendarCore::Event::Ptr(it.value()->clone());
+
+    QPointer<CalendarConverter> converter(this);
+    const int version = mVersion;
+    const QString fileName = mProgressDir + '/'_L1 + CHUNK_FILE.arg(mChunkIndex++);
+    QThreadPool::globalInstance()->start([converter, chunk, version, fileName]()
+    {
+        KAEvent::convertKCalEvents(chunk, version);
+        writeChunkFile(fileName, chunk);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [converter, chunk]()
+        {
+            if (converter)
+                converter->chunkConverted(chunk);
+        }, Qt::QueuedConnection);
+    });
+}
+
+/******************************************************************************
+* Called in the main thread when a chunk of events has been converted or
+* restored. Notify the converted events, and start on the next chunk.
+*/
+void CalendarConverter::chunkConverted(const KCalendarCore::Event::List& events)
+{
+    if (mFinished)
+        return;   // finish() has already converted all events
+    KCalendarCore::Event::List converted;
+    converted.reserve(events.count());
+    for (const KCalendarCore::Event::Ptr& event : events)
+    {
+        if (mPending.remove(event->uid()))
+            converted += event;
+    }
+    if (!converted.isEmpty())
+        Q_EMIT eventsConverted(converted);
+    convertNextChunk();
+}
+
+/******************************************************************************
+* Convert all remaining events in the calling thread, without waiting for any
+* background conversion.
+*/
+void CalendarConverter::finish()
+{
+    if (mFinished)
+        return;
+    qCDebug(KALARM_LOG) << "CalendarConverter::finish:" << mProgressDir << mPending.count() << "events";
+    KCalendarCore::Event::List events;
+    events.reserve(mPending.count());
+    for (auto it = mPending.constBegin();  it != mPending.constEnd();  ++it)
+        events += KCalendarCore::Event::Ptr(it.value()->clone());
+    KAEvent::convertKCalEvents(events, mVersion);
+    mPending.clear();
+    if (!events.isEmpty())
+        Q_EMIT eventsConverted(events);
+    mFinished = true;
+    Q_EMIT finished();
+}
+
+/******************************************************************************
+* Remove the progress files in a progress directory.
+*/
+void CalendarConverter::discardProgress(const QString& progressDir)
+{
+    QDir dir(progressDir);
+    if (dir.exists())
+    {
+        qCDebug(KALARM_LOG) << "CalendarConverter::discardProgress:" << progressDir;
+        dir.removeRecursively();
+    }
+}
+
+namespace
+{
+
+/******************************************************************************
+* Return the number of a chunk progress file, or -1 if the name is invalid.
+*/
+int chunkNumber(const QString& fileName)
+{
+    static const int prefixLength = CHUNK_FILE.indexOf("%1"_L1);
+    static const int suffixLength = CHUNK_FILE.size() - prefixLength - 2;
+    bool ok;
+    const int number = QStringView(fileName).mid(prefixLength, fileName.size() - prefixLength - suffixLength).toInt(&ok);
+    return ok ? number : -1;
+}
+
+/******************************************************************************
+* Read all the converted events held in chunk progress files.
+* This is called in a background thread.
+*/
+KCalendarCore::Event::List readChunkFiles(const QString& progressDir)
+{
+    KCalendarCore::Event::List events;
+    const QDir dir(progressDir);
+    const QStringList fileNames = dir.entryList({CHUNK_FILES}, QDir::Files);
+    for (const QString& fileName : fileNames)
+    {
+        KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+        KCalendarCore::FileStorage storage(calendar, dir.filePath(fileName), new KCalendarCore::ICalFormat());
+        if (!storage.load())
+        {
+            // Ignore a chunk which was not completely written.
+            qCWarning(KALARM_LOG) << "CalendarConverter: Error reading progress file" << fileName;
+            continue;
+        }
+        // Clone the events, to detach them from the temporary calendar.
+        const KCalendarCore::Event::List chunk = calendar->rawEvents();
+        for (const KCalendarCore::Event::Ptr& event : chunk)
+            events += KCalendarCore::Event::Ptr(event->clone());
+    }
+    return events;
+}
+
+/******************************************************************************
+* Write converted events to a chunk progress file.
+* This is called in a background thread.
+*/
+bool writeChunkFile(const QString& fileName, const KCalendarCore::Event::List& events)
+{
+    KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+    for (const KCalendarCore::Event::Ptr& event : events)
+        calendar->addEvent(KCalendarCore::Event::Ptr(event->clone()));
+    KACalendar::setKAlarmVersion(calendar);
+    KCalendarCore::FileStorage storage(calendar, fileName, new KCalendarCore::ICalFormat());
+    if (!storage.save())
+    {
+        qCWarning(KALARM_LOG) << "CalendarConverter: Error writing progress file" << fileName;
+        QFile::remove(fileName);
+        return false;
+    }
+    return true;
+}
+
+}
+
+#include "moc_calendarconverter.cpp"
+
+// vim: et sw=4:
@@ -0,0 +1,85 @@
+/*
+ *  calendarconverter.h  -  converts calendar events to current KAlarm format in the background
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <KCalendarCore/Event>
+
+#include <QHash>
+#include <QObject>
+
+/**
+ * Converts the events in a calendar written by an old version of KAlarm to
+ * the current KAlarm format, in chunks in a background thread, so that the
+ * user interface and alarm scheduling are not blocked by a large calendar.
+ *
+ * Each chunk of events is cloned before conversion, so that the calendar's
+ * own events are never accessed outside the main thread. Converted events are
+ * passed back in eventsConverted(), for the resource to substitute for the
+ * originals in its calendar and make available immediately.
+ *
+ * Each converted chunk is also written to a progress file, so that if the
+ * application exits before conversion is complete, the converted events are
+ * restored next time instead of being converted again. The progress files
+ * are only used if the calendar file is unchanged.
+ */
+class CalendarConverter : public QObject
+{
+    Q_OBJECT
+public:
+    /** Constructor.
+     *  @param events       The unconverted events.
+     *  @param version      The KAlarm calendar format version of the events.
+     *  @param progressDir  Directory to hold progress files.
+     *  @param parent       Parent object.
+     */
+    CalendarConverter(const KCalendarCore::Event::List& events, int version, const QString& progressDir, QObject* parent = nullptr);
+    ~CalendarConverter() override;
+
+    /** Start converting events, after restoring any events converted
+     *  previously from the same calendar file.
+     *  @param sourceHash  Hash of the calendar file's contents.
+     */
+    void start(const QByteArray& sourceHash);
+
+    /** Convert all remaining events immediately, in the calling thread.
+     *  The events are notified by eventsConverted(), followed by finished().
+     *  Any conversion still in progress in the background is ignored.
+     */
+    void finish();
+
+    /** Return the number of events still to be converted. */
+    int pendingCount() const   { return mPending.count(); }
+
+    /** Remove any progress files in a progress directory. */
+    static void discardProgress(const QString& progressDir);
+
+    /** The number of events converted in each chunk. */
+    static const int ChunkSize;
+
+Q_SIGNALS:
+    /** Emitted in the main thread when a chunk of events has been converted
+     *  or restored. The events have the same UIDs as the originals. */
+    void eventsConverted(const KCalendarCore::Event::List& events);
+
+    /** Emitted when all events have been converted. */
+    void finished();
+
+private:
+    void convertNextChunk();
+    void chunkConverted(const KCalendarCore::Event::List& events);
+
+    QHash<QString, KCalendarCore::Event::Ptr> mPending;   // unconverted events, indexed by UID
+    QString      mProgressDir;     // directory containing progress files
+    int          mVersion;         // KAlarm calendar format version of unconverted events
+    int          mChunkIndex {0};  // index of next chunk's progress file
+    bool         mStarted {false};
+    bool         mFinished {false};  // finished() has been emitted
+};
+
+// vim: et sw=4:
@@ -68,6 +68,12 @@ void DataModel::updateCalendarToCurrentFormat(Resource& resource, bool ignoreKee
         ResourceDataModelBase::mInstance->updateCalendarToCurrentFormat(resource, ignoreKeepFormat, parent);
 }
 
+void DataModel::setTimeToVisibleEvents(const QObject* view, const QSet<QString>& eventIds)
+{
+    if (ResourceDataModelBase::mInstance)
+        ResourceDataModelBase::mInstance->setTimeToVisibleEvents(view, eventIds);
+}
+
 ResourceListModel* DataModel::createResourceListModel(QObject* parent)
 {
     return ResourceDataModelBase::mInstance ? ResourceDataModelBase::mInstance->createResourceListModel(parent) : nullptr;
@@ -10,6 +10,8 @@
 
 #include "kalarmcalendar/kacalendar.h"
 
+#include <QSet>
+
 class Resource;
 class ResourceListModel;
 class ResourceFilterCheckListModel;
@@ -66,6 +68,14 @@ public:
     /** Update a resource's backend calendar file to the current KAlarm format. */
     static void updateCalendarToCurrentFormat(Resource&, bool ignoreKeepFormat, QObject* parent);
 
+    /** Set the events currently displayed in a view's time-to-alarm column.
+     *  Only displayed events have their time-to-alarm values refreshed each
+     *  minute; other events are refreshed when they become displayed.
+     *  @param view      the view displaying the events.
+     *  @param eventIds  IDs of the displayed events, or empty if none.
+     */
+    static void setTimeToVisibleEvents(const QObject* view, const QSet<QString>& eventIds);
+
     static ResourceListModel* createResourceListModel(QObject* parent);
     static ResourceFilterCheckListModel* createResourceFilterCheckListModel(QObject* parent);
     static AlarmListModel*    createAlarmListModel(QObject* parent);
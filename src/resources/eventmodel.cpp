@@ -12,22 +12,411 @@
 #include "resources.h"
 #include "preferences.h"
 
+#include <algorithm>
 
-/*============================================================================*/
+
+/*=============================================================================
+= Class: FlatEventModel
+= Proxy model which presents the events in a resource data model as a flat
+= list, restricted to events of specified alarm types in enabled resources.
+=============================================================================*/
+
+FlatEventModel::FlatEventModel(CalEvent::Types types, QObject* parent)
+    : QAbstractProxyModel(parent)
+    , mAlarmTypes(types)
+{
+    Resources* resources = Resources::instance();
+    connect(resources, &Resources::eventsAdded,       this, &FlatEventModel::slotEventsAdded);
+    connect(resources, &Resources::resourcePopulated, this, &FlatEventModel::slotResourcePopulated);
+    connect(resources, &Resources::settingsChanged,   this, &FlatEventModel::slotResourceSettingsChanged);
+}
+
+/******************************************************************************
+* Set the data model, and populate this model from it.
+*/
+void FlatEventModel::setDataModel(QAbstractItemModel* model)
+{
+    beginResetModel();
+    setSourceModel(model);
+    connect(model, &QAbstractItemModel::rowsInserted,         this, &FlatEventModel::slotSourceRowsInserted);
+    connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &FlatEventModel::slotSourceRowsAboutToBeRemoved);
+    connect(model, &QAbstractItemModel::dataChanged,          this, &FlatEventModel::slotSourceDataChanged);
+    connect(model, &QAbstractItemModel::modelReset,           this, &FlatEventModel::slotSourceReset);
+    connect(model, &QAbstractItemModel::layoutChanged,        this, &FlatEventModel::slotSourceReset);
+    populate();
+    endResetModel();
+}
+
+/******************************************************************************
+* Fill the model with all the data model's events which should be included.
+*/
+void FlatEventModel::populate()
+{
+    mRows.clear();
+    QAbstractItemModel* model = sourceModel();
+    for (int r = 0, rcount = model->rowCount();  r < rcount;  ++r)
+    {
+        const QModelIndex resourceIx = model->index(r, 0);
+        const Resource resource = (*mResourceFunction)(resourceIx);
+        if (!resource.isValid())
+            continue;
+        for (int row = 0, count = model->rowCount(resourceIx);  row < count;  ++row)
+        {
+            const QModelIndex ix = model->index(row, 0, resourceIx);
+            if (acceptRow(ix, resource))
+                mRows += Row{QPersistentModelIndex(ix), resource};
+        }
+    }
+}
+
+/******************************************************************************
+* Return the event in a specified row.
+*/
+KAEvent FlatEventModel::event(int row) const
+{
+    if (row < 0  ||  row >= mRows.count())
+        return {};
+    return (*mEventFunction)(mRows.at(row).source);
+}
+
+/******************************************************************************
+* Return the resource containing the event in a specified row.
+*/
+Resource FlatEventModel::resource(int row) const
+{
+    if (row < 0  ||  row >= mRows.count())
+        return {};
+    return mRows.at(row).resource;
+}
+
+/******************************************************************************
+* Return the sort keys for the event in a specified row.
+*/
+const ResourceDataModelBase::EventSortKeys* FlatEventModel::sortKeys(int row) const
+{
+    if (row < 0  ||  row >= mRows.count())
+        return nullptr;
+    return (*mSortKeysFunction)(mRows.at(row).source);
+}
+
+/******************************************************************************
+* Return the index to a specified event.
+*/
+QModelIndex FlatEventModel::eventIndex(const QString& eventId) const
+{
+    return mapFromSource((*mEventIndexFunction)(eventId));
+}
+
+QModelIndex FlatEventModel::mapToSource(const QModelIndex& proxyIndex) const
+{
+    if (!proxyIndex.isValid()  ||  proxyIndex.row() >= mRows.count())
+        return {};
+    const QPersistentModelIndex& source = mRows.at(proxyIndex.row()).source;
+    return source.sibling(source.row(), proxyIndex.column());
+}
+
+QModelIndex FlatEventModel::mapFromSource(const QModelIndex& sourceIndex) const
+{
+    if (!sourceIndex.isValid())
+        return {};
+    const QModelIndex sourceParent = sourceIndex.parent();
+    if (!sourceParent.isValid())
+        return {};   // it's a resource, not an event
+    const int row = findRow(sourceParent.row(), sourceIndex.row());
+    if (row >= mRows.count())
+        return {};
+    const QPersistentModelIndex& source = mRows.at(row).source;
+    if (source.row() != sourceIndex.row()  ||  source.parent() != sourceParent)
+        return {};   // the event isn't included in this model
+    return index(row, sourceIndex.column());
+}
+
+QModelIndex FlatEventModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (parent.isValid()  ||  row < 0  ||  row >= mRows.count()  ||  column < 0  ||  column >= columnCount())
+        return {};
+    return createIndex(row, column);
+}
+
+QModelIndex FlatEventModel::parent(const QModelIndex& index) const
+{
+    Q_UNUSED(index);
+    return {};
+}
+
+int FlatEventModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : mRows.count();
+}
+
+int FlatEventModel::columnCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return ResourceDataModelBase::ColumnCount;
+}
+
+bool FlatEventModel::hasChildren(const QModelIndex& parent) const
+{
+    return !parent.isValid()  &&  !mRows.isEmpty();
+}
+
+/******************************************************************************
+* Return the indexes which match a data value in the 'start' index column.
+* Event IDs are looked up directly, instead of searching every row.
+*/
+QModelIndexList FlatEventModel::match(const QModelIndex& start, int role, const QVariant& value, int hits, Qt::MatchFlags flags) const
+{
+    if (role == ResourceDataModelBase::EventIdRole)
+    {
+        QModelIndexList result;               //clazy:exclude=inefficient-qlist
+        const QModelIndex ix = eventIndex(value.toString());
+        if (ix.isValid())
+            result += ix.siblingAtColumn(start.column());
+        return result;
+    }
+    return QAbstractProxyModel::match(start, role, value, hits, flags);
+}
+
+/******************************************************************************
+* Called when rows have been inserted into the data model.
+* If resources have been inserted, add their events.
+*/
+void FlatEventModel::slotSourceRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (!parent.isValid())
+    {
+        for (int r = first;  r <= last;  ++r)
+        {
+            const QModelIndex resourceIx = sourceModel()->index(r, 0);
+            const int count = sourceModel()->rowCount(resourceIx);
+            if (count)
+                updateRows(resourceIx, 0, count - 1);
+        }
+    }
+    else if (!parent.parent().isValid())
+        updateRows(parent, first, last);
+}
+
+/******************************************************************************
+* Called when rows are about to be removed from the data model.
+* Remove the corresponding events, or all events of removed resources.
+*/
+void FlatEventModel::slotSourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+    int start, end;
+    if (!parent.isValid())
+    {
+        start = findRow(first, 0);
+        end   = findRow(last + 1, 0);
+    }
+    else
+    {
+        start = findRow(parent.row(), first);
+        end   = findRow(parent.row(), last + 1);
+    }
+    if (end > start)
+    {
+        beginRemoveRows(QModelIndex(), start, end - 1);
+        mRows.remove(start, end - start);
+        endRemoveRows();
+    }
+}
+
+/******************************************************************************
+* Called when data has changed in the data model.
+* If events have changed in a way which could affect whether they are included,
+* re-evaluate them; then pass on the change notification.
+*/
+void FlatEventModel::slotSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QList<int>& roles)
+{
+    const QModelIndex sourceParent = topLeft.parent();
+    if (!sourceParent.isValid())
+        return;   // resources aren't included in this model
+    if (topLeft.column() == 0
+    &&  (roles.isEmpty()  ||  roles.contains(ResourceDataModelBase::StatusRole)))
+        updateRows(sourceParent, topLeft.row(), bottomRight.row());
+
+    // The changed events which are in this model occupy consecutive rows.
+    const int start = findRow(sourceParent.row(), topLeft.row());
+    const int end   = findRow(sourceParent.row(), bottomRight.row() + 1);
+    if (end > start)
+        Q_EMIT dataChanged(index(start, topLeft.column()), index(end - 1, bottomRight.column()), roles);
+}
+
+/******************************************************************************
+* Called when the data model has been reset.
+*/
+void FlatEventModel::slotSourceReset()
+{
+    beginResetModel();
+    populate();
+    endResetModel();
+}
+
+/******************************************************************************
+* Called when events have been added to a resource.
+* Events are not included until their resource contains them, which may occur
+* after they have been added to the data model.
+*/
+void FlatEventModel::slotEventsAdded(Resource& resource, const QList<KAEvent>& events)
+{
+    if (!(resource.enabledTypes() & mAlarmTypes))
+        return;    // the resource isn't included in this model
+    for (const KAEvent& evnt : events)
+    {
+        const QModelIndex ix = (*mEventIndexFunction)(evnt.id());
+        if (ix.isValid())
+            updateRows(ix.parent(), ix.row(), ix.row());
+    }
+}
+
+/******************************************************************************
+* Called when a resource has been initially populated.
+*/
+void FlatEventModel::slotResourcePopulated(Resource& resource)
+{
+    if (resource.enabledTypes() & mAlarmTypes)
+        updateResource(resource);
+}
+
+/******************************************************************************
+* Called when a resource parameter or status has changed.
+* If the resource's enabled status has changed, add or remove its events.
+*/
+void FlatEventModel::slotResourceSettingsChanged(Resource& resource, ResourceType::Changes change)
+{
+    if (resource.isValid()  &&  (change & ResourceType::Enabled))
+        updateResource(resource);
+}
+
+/******************************************************************************
+* Re-evaluate which of a resource's events should be included in the model.
+*/
+void FlatEventModel::updateResource(const Resource& resource)
+{
+    if (!sourceModel())
+        return;
+    const QModelIndex resourceIx = (*mResourceIndexFunction)(resource);
+    if (!resourceIx.isValid())
+        return;
+    const int count = sourceModel()->rowCount(resourceIx);
+    if (count)
+        updateRows(resourceIx, 0, count - 1);
+    else
+    {
+        const int start = findRow(resourceIx.row(), 0);
+        const int end   = findRow(resourceIx.row() + 1, 0);
+        if (end > start)
+        {
+            beginRemoveRows(QModelIndex(), start, end - 1);
+            mRows.remove(start, end - start);
+            endRemoveRows();
+        }
+    }
+}
+
+/******************************************************************************
+* Re-evaluate whether a range of a resource's events in the data model should
+* be included in the model, and add or remove them accordingly.
+*/
+void FlatEventModel::updateRows(const QModelIndex& sourceParent, int first, int last)
+{
+    const Resource resource = (*mResourceFunction)(sourceParent);
+    const int resourceRow = sourceParent.row();
+    auto isPresent = [&](int row, int sourceRow)
+    {
+        if (row >= mRows.count())
+            return false;
+        const QPersistentModelIndex& source = mRows.at(row).source;
+        return source.row() == sourceRow  &&  source.parent().row() == resourceRow;
+    };
+
+    int row = findRow(resourceRow, first);
+    for (int i = first;  i <= last;  )
+    {
+        const bool present = isPresent(row, i);
+        const bool accept  = resource.isValid()  &&  acceptRow(sourceModel()->index(i, 0, sourceParent), resource);
+        if (present == accept)
+        {
+            if (present)
+                ++row;
+            ++i;
+        }
+        else if (present)
+        {
+            beginRemoveRows(QModelIndex(), row, row);
+            mRows.removeAt(row);
+            endRemoveRows();
+            ++i;
+        }
+        else
+        {
+            // Insert this event, together with any immediately following
+            // events which also need to be inserted.
+            QList<Row> newRows{Row{QPersistentModelIndex(sourceModel()->index(i, 0, sourceParent)), resource}};
+            while (++i <= last  &&  !isPresent(row, i))
+            {
+                const QModelIndex ix = sourceModel()->index(i, 0, sourceParent);
+                if (!acceptRow(ix, resource))
+                    break;
+                newRows += Row{QPersistentModelIndex(ix), resource};
+            }
+            beginInsertRows(QModelIndex(), row, row + newRows.count() - 1);
+            for (const Row& newRow : std::as_const(newRows))
+                mRows.insert(row++, newRow);
+            endInsertRows();
+        }
+    }
+}
+
+/******************************************************************************
+* Determine whether a data model event should be included in the model.
+*/
+bool FlatEventModel::acceptRow(const QModelIndex& sourceIndex, const Resource& resource) const
+{
+    const KAEvent evnt = (*mEventFunction)(sourceIndex);
+    if (!evnt.isValid())
+        return false;
+    if (!(evnt.category() & mAlarmTypes))
+        return false;   // the event has the wrong alarm type
+    // Only include the event once the resource contains it, and if the
+    // resource is enabled for its alarm type.
+    return resource.containsEvent(evnt.id());
+}
+
+/******************************************************************************
+* Return the first row whose data model position is not before a given
+* resource row and event row. The rows are held in data model order.
+*/
+int FlatEventModel::findRow(int resourceRow, int eventRow) const
+{
+    const std::pair<int, int> key(resourceRow, eventRow);
+    auto it = std::lower_bound(mRows.constBegin(), mRows.constEnd(), key,
+                               [](const Row& row, const std::pair<int, int>& k)
+                               {
+                                   return std::make_pair(row.source.parent().row(), row.source.row()) < k;
+                               });
+    return static_cast<int>(it - mRows.constBegin());
+}
+
+
+/*=============================================================================
+= Class: EventListModel
+= Proxy model to sort a flat list of events from a resource data model.
+=============================================================================*/
 
 EventListModel::EventListModel(CalEvent::Types types, QObject* parent)
     : QSortFilterProxyModel(parent)
     , mAlarmTypes(types == CalEvent::EMPTY ? CalEvent::ACTIVE | CalEvent::ARCHIVED | CalEvent::TEMPLATE : types)
 {
-    setSourceModel(new KDescendantsProxyModel(this));
+    mFlatModel = new FlatEventModel(mAlarmTypes, this);
+    setSourceModel(mFlatModel);
     setSortRole(ResourceDataModelBase::SortRole);
     setDynamicSortFilter(true);
 
-    Resources* resources = Resources::instance();
-    connect(resources, &Resources::eventsAdded,       this, &EventListModel::slotRowsInserted);
-    connect(resources, &Resources::eventsRemoved,     this, &EventListModel::slotRowsRemoved);
-    connect(resources, &Resources::resourcePopulated, this, &EventListModel::slotResourcePopulated);
-    connect(resources, &Resources::settingsChanged,   this, &EventListModel::resourceSettingsChanged);
+    connect(this, &QAbstractItemModel::rowsInserted, this, &EventListModel::slotRowsChanged);
+    connect(this, &QAbstractItemModel::rowsRemoved,  this, &EventListModel::slotRowsChanged);
+    connect(this, &QAbstractItemModel::modelReset,   this, &EventListModel::slotRowsChanged);
 }
 
 /******************************************************************************
@@ -43,9 +432,9 @@ KAEvent EventListModel::event(int row) const
 */
 KAEvent EventListModel::event(const QModelIndex& index) const
 {
-    auto proxyModel = static_cast<KDescendantsProxyModel*>(sourceModel());
-    const QModelIndex dataIndex = proxyModel->mapToSource(mapToSource(index));
-    return (*mEventFunction)(dataIndex);
+    if (!index.isValid())
+        return {};
+    return mFlatModel->event(mapToSource(index).row());
 }
 
 /******************************************************************************
@@ -53,9 +442,7 @@ KAEvent EventListModel::event(const QModelIndex& index) const
 */
 KAEvent EventListModel::eventForSourceRow(int sourceRow) const
 {
-    auto proxyModel = static_cast<KDescendantsProxyModel*>(sourceModel());
-    const QModelIndex dataIndex = proxyModel->mapToSource(proxyModel->index(sourceRow, 0));
-    return (*mEventFunction)(dataIndex);
+    return mFlatModel->event(sourceRow);
 }
 
 /******************************************************************************
@@ -63,8 +450,7 @@ KAEvent EventListModel::eventForSourceRow(int sourceRow) const
 */
 QModelIndex EventListModel::eventIndex(const QString& eventId) const
 {
-    auto proxyModel = static_cast<KDescendantsProxyModel*>(sourceModel());
-    return mapFromSource(proxyModel->mapFromSource(((*mEventIndexFunction)(eventId))));
+    return mapFromSource(mFlatModel->eventIndex(eventId));
 }
 
 /******************************************************************************
@@ -115,37 +501,7 @@ int EventListModel::columnCount(const QModelIndex& parent) const
 
 QVariant EventListModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
-    return static_cast<KDescendantsProxyModel*>(sourceModel())->sourceModel()->headerData(section, orientation, role + mHeaderDataRoleOffset);
-}
-
-/******************************************************************************
-* Determine whether a source model item is included in this model.
-* This also determines whether it is counted in rowCount().
-*/
-bool EventListModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
-{
-    // Get the resource which contains this event.
-    auto proxyModel = static_cast<KDescendantsProxyModel*>(sourceModel());
-    const QModelIndex dataIndex = proxyModel->mapToSource(proxyModel->index(sourceRow, 0, sourceParent));
-    const QString eventId = dataIndex.data(ResourceDataModelBase::EventIdRole).toString();
-    if (eventId.isEmpty())
-        return false;   // this row doesn't contain an event
-    const ResourceId id = dataIndex.data(ResourceDataModelBase::ParentResourceIdRole).toLongLong();
-    if (id < 0)
-        return false;   // the parent item isn't a resource
-    const Resource resource = Resources::resource(id);
-    if (!resource.isValid())
-        return false;   // invalidly configured resource
-
-    // Get the event.
-    const KAEvent evnt = resource.event(eventId);
-    if (!evnt.isValid())
-        return false;
-    if (!(evnt.category() & mAlarmTypes))
-        return false;   // the event has the wrong alarm type
-    if (!resource.isEnabled(evnt.category()))
-        return false;   // the resource is disabled for this alarm type
-    return true;
+    return mFlatModel->sourceModel()->headerData(section, orientation, role + mHeaderDataRoleOffset);
 }
 
 bool EventListModel::filterAcceptsColumn(int sourceColumn, const QModelIndex& sourceParent) const
@@ -156,67 +512,37 @@ bool EventListModel::filterAcceptsColumn(int sourceColumn, const QModelIndex& so
 }
 
 /******************************************************************************
-* Called when a Resource has been initially populated.
+* Compare two source model items for sorting.
+* The events' sort keys are cached in the data model, so that sorting doesn't
+* need to re-evaluate trigger times and texts for every comparison.
 */
-void EventListModel::slotResourcePopulated(Resource& resource)
+bool EventListModel::lessThan(const QModelIndex& sourceLeft, const QModelIndex& sourceRight) const
 {
-    if (!(resource.enabledTypes() & mAlarmTypes))
-        return;    // the resource isn't included in this model
-
-    invalidate();
-}
-
-/******************************************************************************
-* Called when rows have been inserted into the model.
-*
-* Note that during initialisation, rows are inserted into the source model
-* before they are added to the Resource. Until they have been added to the
-* Resource, they will be filtered out by filterAcceptsRow() (and therefore
-* omitted by rowCount()), because Resource::event(eventId) will not find them.
-* This method is called when the eventsAdded() signal indicates that they have
-* now been added to the Resource.
-*/
-void EventListModel::slotRowsInserted(Resource& resource)
-{
-    if (!(resource.enabledTypes() & mAlarmTypes))
-        return;    // the resource isn't included in this model
-
-    if (!mHaveEvents  &&  rowCount())
-    {
-        mHaveEvents = true;
-        Q_EMIT haveEventsStatus(true);
-    }
-}
-
-/******************************************************************************
-* Called when rows have been deleted from the model.
-*/
-void EventListModel::slotRowsRemoved(Resource& resource)
-{
-    if (!(resource.enabledTypes() & mAlarmTypes))
-        return;    // the resource isn't included in this model
-
-    if (mHaveEvents  &&  !rowCount())
+    if (sortRole() == ResourceDataModelBase::SortRole  &&  !isSortLocaleAware())
     {
-        mHaveEvents = false;
-        Q_EMIT haveEventsStatus(false);
+        const auto left  = mFlatModel->sortKeys(sourceLeft.row());
+        const auto right = mFlatModel->sortKeys(sourceRight.row());
+        if (left  &&  right)
+        {
+            bool handled;
+            const bool result = ResourceDataModelBase::sortKeyLessThan(sourceLeft.column(), *left, *right, sortCaseSensitivity(), handled);
+            if (handled)
+                return result;
+        }
     }
+    return QSortFilterProxyModel::lessThan(sourceLeft, sourceRight);
 }
 
 /******************************************************************************
-* Called when a resource parameter or status has changed.
-* If the resource's enabled status has changed, re-filter the list to add or
-* remove its alarms.
+* Called when rows have been added to or removed from the model.
 */
-void EventListModel::resourceSettingsChanged(Resource& resource, ResourceType::Changes change)
+void EventListModel::slotRowsChanged()
 {
-    if (!resource.isValid())
-        return;
-    if (change == ResourceType::Enabled)
+    const bool have = rowCount();
+    if (have != mHaveEvents)
     {
-        // Ensure that items for a newly enabled resource are always ordered
-        // correctly. Note that invalidateFilter() is not adequate for this.
-        invalidate();
+        mHaveEvents = have;
+        Q_EMIT haveEventsStatus(have);
     }
 }
 
@@ -255,6 +581,16 @@ void AlarmListModel::setEventTypeFilter(CalEvent::Types types)
     // 'types' doesn't include any alarm types not included in the model.
     types &= alarmTypes();
 
+    // If archived alarms are to be shown, ensure that they are loaded, and
+    // that they remain loaded for as long as they are shown.
+    if (this != mAllInstance)
+    {
+        if (types & CalEvent::ARCHIVED)
+            Resources::loadDeferredEvents(CalEvent::ARCHIVED, this);
+        else
+            Resources::releaseDeferredEvents(this, CalEvent::ARCHIVED);
+    }
+
     if (this != mAllInstance
     &&  types != mFilterTypes)
     {
@@ -312,13 +648,14 @@ void AlarmListModel::setDateFilter(const QList<QDate>& dates, bool force)
 
 bool AlarmListModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
 {
-    if (!EventListModel::filterAcceptsRow(sourceRow, sourceParent))
-        return false;
+    Q_UNUSED(sourceParent);
     if (mFilterTypes == CalEvent::EMPTY)
         return false;
+    const KAEvent ev = eventForSourceRow(sourceRow);
+    if (!(ev.category() & mFilterTypes))
+        return false;
     if (!mFilterDates.isEmpty())
     {
-        const KAEvent ev = eventForSourceRow(sourceRow);
         if (ev.category() != CalEvent::ACTIVE)
             return false;    // only include active alarms in the filter
         const KADateTime::Spec timeSpec = Preferences::timeSpec();
@@ -385,8 +722,7 @@ bool AlarmListModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourcePa
                 return false;
         }
     }
-    const int type = sourceModel()->data(sourceModel()->index(sourceRow, 0, sourceParent), ResourceDataModelBase::StatusRole).toInt();
-    return static_cast<CalEvent::Type>(type) & mFilterTypes;
+    return true;
 }
 
 bool AlarmListModel::filterAcceptsColumn(int sourceCol, const QModelIndex& ix) const
@@ -600,13 +936,10 @@ void TemplateListModel::setAlarmActionsEnabled(KAEvent::Action types)
 
 bool TemplateListModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
 {
-    if (!EventListModel::filterAcceptsRow(sourceRow, sourceParent))
-        return false;
+    Q_UNUSED(sourceParent);
     if (mActionsFilter == KAEvent::Action::All)
         return true;
-    const QModelIndex sourceIndex = sourceModel()->index(sourceRow, 0, sourceParent);
-    const KAEvent::Action actions = static_cast<KAEvent::Action>(sourceModel()->data(sourceIndex, ResourceDataModelBase::AlarmActionsRole).toInt());
-    return actions & mActionsFilter;
+    return eventForSourceRow(sourceRow).actionTypes() & mActionsFilter;
 }
 
 bool TemplateListModel::filterAcceptsColumn(int sourceCol, const QModelIndex&) const
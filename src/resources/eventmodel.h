@@ -9,18 +9,101 @@
 #pragma once
 
 #include "resource.h"
+#include "resourcedatamodelbase.h"
 #include "kalarmcalendar/kacalendar.h"
 
-#include <KDescendantsProxyModel>
-
+#include <QAbstractProxyModel>
+#include <QPersistentModelIndex>
 #include <QSortFilterProxyModel>
 
 using namespace KAlarmCal;
 
+/*=============================================================================
+= Class: FlatEventModel
+= Proxy model which presents the events in a resource data model as a flat
+= list, restricted to events of specified alarm types in enabled resources.
+= Rows are added and removed individually as the data model and the resources
+= change, so the model never needs to be re-filtered as a whole.
+=============================================================================*/
+class FlatEventModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+public:
+    /** Constructor. Note that initialise() must be called to complete the construction.
+     *  @param types  The alarm types (active/archived/template) included in this model
+     */
+    FlatEventModel(CalEvent::Types types, QObject* parent);
+
+    /** To be called after construction, to set the data model.
+     *  @tparam DataModel  The data model class to use as the source model. It must
+     *                     have the following methods:
+     *                       static Model* instance(); - returns the unique instance.
+     *                       KAEvent     event(const QModelIndex&) const;
+     *                       QModelIndex eventIndex(const QString&) const;
+     *                       Resource    resource(const QModelIndex&) const;
+     *                       QModelIndex resourceIndex(const Resource&) const;
+     *                       const EventSortKeys* eventSortKeys(const QModelIndex&) const;
+     */
+    template <class DataModel> void initialise();
+
+    /** Return the event in a specified row. */
+    KAEvent      event(int row) const;
+    using QObject::event;   // prevent warning about hidden virtual method
+
+    /** Return the resource containing the event in a specified row. */
+    Resource     resource(int row) const;
+
+    /** Return the sort keys for the event in a specified row, or null if none. */
+    const ResourceDataModelBase::EventSortKeys* sortKeys(int row) const;
+
+    /** Return the index to a specified event. */
+    QModelIndex  eventIndex(const QString& eventId) const;
+
+    QModelIndex  mapToSource(const QModelIndex& proxyIndex) const override;
+    QModelIndex  mapFromSource(const QModelIndex& sourceIndex) const override;
+    QModelIndex  index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex  parent(const QModelIndex& index) const override;
+    int          rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int          columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    bool         hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndexList match(const QModelIndex& start, int role, const QVariant& value, int hits = 1, Qt::MatchFlags flags = Qt::MatchFlags(Qt::MatchStartsWith | Qt::MatchWrap)) const override;
+
+private Q_SLOTS:
+    void slotSourceRowsInserted(const QModelIndex& parent, int first, int last);
+    void slotSourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+    void slotSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QList<int>& roles);
+    void slotSourceReset();
+    void slotEventsAdded(Resource&, const QList<KAlarmCal::KAEvent>&);
+    void slotResourcePopulated(Resource&);
+    void slotResourceSettingsChanged(Resource&, ResourceType::Changes);
+
+private:
+    struct Row
+    {
+        QPersistentModelIndex source;    // the event's index in the data model
+        Resource              resource;  // the resource containing the event
+    };
+
+    void setDataModel(QAbstractItemModel*);
+    void populate();
+    void updateResource(const Resource&);
+    void updateRows(const QModelIndex& sourceParent, int first, int last);
+    bool acceptRow(const QModelIndex& sourceIndex, const Resource&) const;
+    int  findRow(int resourceRow, int eventRow) const;
+
+    QList<Row>      mRows;    // the events in the model, in data model order
+    KAEvent         (*mEventFunction)(const QModelIndex&) {nullptr};  // function to fetch event from data model
+    QModelIndex     (*mEventIndexFunction)(const QString&) {nullptr};  // function to fetch event index from data model
+    Resource        (*mResourceFunction)(const QModelIndex&) {nullptr};  // function to fetch resource from data model
+    QModelIndex     (*mResourceIndexFunction)(const Resource&) {nullptr};  // function to fetch resource index from data model
+    const ResourceDataModelBase::EventSortKeys* (*mSortKeysFunction)(const QModelIndex&) {nullptr};  // function to fetch sort keys from data model
+    CalEvent::Types mAlarmTypes;   // only include events with these alarm types
+};
+
 /*=============================================================================
 = Class: EventListModel
-= Proxy model to filter a resource data model to restrict its contents to
-= events, not resources, containing specified alarm types in enabled resources.
+= Proxy model to sort a flat list of events from a resource data model, which
+= contains specified alarm types in enabled resources.
 =============================================================================*/
 class EventListModel : public QSortFilterProxyModel
 {
@@ -34,6 +117,9 @@ public:
      *                       static Model* instance(); - returns the unique instance.
      *                       KAEvent     event(const QModelIndex&) const;
      *                       QModelIndex eventIndex(const QString&) const;
+     *                       Resource    resource(const QModelIndex&) const;
+     *                       QModelIndex resourceIndex(const Resource&) const;
+     *                       const EventSortKeys* eventSortKeys(const QModelIndex&) const;
      *                       int         headerDataEventRoleOffset() const;
      */
     template <class DataModel>
@@ -74,6 +160,9 @@ protected:
      *                       static Model* instance(); - returns the unique instance.
      *                       KAEvent     event(const QModelIndex&) const;
      *                       QModelIndex eventIndex(const QString&) const;
+     *                       Resource    resource(const QModelIndex&) const;
+     *                       QModelIndex resourceIndex(const Resource&) const;
+     *                       const EventSortKeys* eventSortKeys(const QModelIndex&) const;
      *                       int         headerDataEventRoleOffset() const;
      */
     template <class DataModel> void initialise();
@@ -81,18 +170,18 @@ protected:
     /** Return the event for a given source model row. */
     KAEvent eventForSourceRow(int sourceRow) const;
 
-    bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
     bool filterAcceptsColumn(int sourceColumn, const QModelIndex& sourceParent) const override;
 
+    /** Compare two items using the events' cached sort keys, if the sort
+     *  role is SortRole.
+     */
+    bool lessThan(const QModelIndex& sourceLeft, const QModelIndex& sourceRight) const override;
+
 private Q_SLOTS:
-    void slotResourcePopulated(Resource&);
-    void slotRowsInserted(Resource&);
-    void slotRowsRemoved(Resource&);
-    void resourceSettingsChanged(Resource&, ResourceType::Changes);
+    void slotRowsChanged();
 
 private:
-    KAEvent      (*mEventFunction)(const QModelIndex&) {nullptr};  // function to fetch event from data model
-    QModelIndex  (*mEventIndexFunction)(const QString&) {nullptr};  // function to fetch event index from data model
+    FlatEventModel* mFlatModel;                 // source model containing the events
     CalEvent::Types mAlarmTypes {CalEvent::EMPTY};  // only include events with these alarm types
     int             mHeaderDataRoleOffset {0};  // offset for base class to add to headerData() role
     bool            mHaveEvents {false};        // there are events in this model
@@ -233,12 +322,20 @@ EventListModel* EventListModel::create(CalEvent::Types types, QObject* parent)
     return model;
 }
 
+template <class DataModel> void FlatEventModel::initialise()
+{
+    mEventFunction         = [](const QModelIndex& ix) { return DataModel::instance()->event(ix); };
+    mEventIndexFunction    = [](const QString& id) { return DataModel::instance()->eventIndex(id); };
+    mResourceFunction      = [](const QModelIndex& ix) { return DataModel::instance()->resource(ix); };
+    mResourceIndexFunction = [](const Resource& r) { return DataModel::instance()->resourceIndex(r); };
+    mSortKeysFunction      = [](const QModelIndex& ix) { return DataModel::instance()->eventSortKeys(ix); };
+    setDataModel(DataModel::instance());
+}
+
 template <class DataModel> void EventListModel::initialise()
 {
-    static_cast<KDescendantsProxyModel*>(sourceModel())->setSourceModel(DataModel::instance());
+    mFlatModel->initialise<DataModel>();
     mHeaderDataRoleOffset = DataModel::instance()->headerDataEventRoleOffset();
-    mEventFunction      = [](const QModelIndex& ix) { return DataModel::instance()->event(ix); };
-    mEventIndexFunction = [](const QString& id) { return DataModel::instance()->eventIndex(id); };
 }
 
 template <class DataModel>
@@ -13,11 +13,35 @@
 #include "singlefileresourceconfigdialog.h"
 #include "resources.h"
 #include "lib/autoqpointer.h"
+#include "lib/virtualclock.h"
 #include "kalarmcalendar/version.h"
 #include "kalarm_debug.h"
 
 #include <KLocalizedString>
 
+#include <QTimer>
+
+#include <algorithm>
+
+namespace
+{
+const int IDLE_UNLOAD_DELAY = 10 * 60 * 1000;   // unload deferred-load events after 10 minutes' idleness
+
+// Return the creation date of the oldest archived event in a list. If there
+// are none, today's date is returned, since any archived events added later
+// will have been created no earlier.
+template <class Events>
+QDate oldestArchived(const Events& events)
+{
+    QDate oldest = KADateTime::currentLocalDate();
+    for (const KAEvent& event : events)
+    {
+        if (event.category() == CalEvent::ARCHIVED)
+            oldest = std::min(oldest, event.createdDateTime().date());
+    }
+    return oldest;
+}
+}
 
 FileResource::FileResource(FileResourceSettings::Ptr settings)
     : ResourceType(settings->id())
@@ -336,6 +360,19 @@ bool FileResource::load(bool readThroughCache)
             return false;
         }
 
+        if (!mLoadWanted  &&  !(alarmTypes() & CalEvent::ACTIVE)  &&  deferLoad())
+        {
+            // The resource's events are not needed for scheduling alarms,
+            // so don't load them until they are actually needed.
+            qCDebug(KALARM_LOG) << "FileResource::load: Deferring load" << displayName();
+            mLoadDeferred = true;
+            setStatus(Status::Ready);
+            QHash<QString, KAEvent> noEvents;
+            setLoadedEvents(noEvents);
+            return true;
+        }
+        mLoadDeferred = false;
+
         // Do the actual loading.
         QHash<QString, KAEvent> newEvents;
         switch (doLoad(newEvents, readThroughCache, errorMessage))
@@ -356,6 +393,77 @@ bool FileResource::load(bool readThroughCache)
     return false;
 }
 
+/******************************************************************************
+* Load the resource's events if loading has been deferred until they are needed.
+* Restart the period after which they may be unloaded again.
+*/
+void FileResource::loadDeferredEvents()
+{
+    if (alarmTypes() & CalEvent::ACTIVE)
+        return;   // loading is never deferred for active alarms
+    mLoadWanted = true;
+    if (!mIdleTimer)
+    {
+        mIdleTimer = new QTimer(this);
+        mIdleTimer->setSingleShot(true);
+        mIdleTimer->setInterval(IDLE_UNLOAD_DELAY);
+        connect(mIdleTimer, &QTimer::timeout, this, &FileResource::slotIdle);
+    }
+    mIdleTimer->start();
+    if (mLoadDeferred)
+    {
+        qCDebug(KALARM_LOG) << "FileResource::loadDeferredEvents:" << displayName();
+        load();
+    }
+}
+
+/******************************************************************************
+* Prepare for purging archived events, by ensuring that they are loaded.
+* If loading has been deferred, and no archived event was created before the
+* cutoff date, no event can have expired, so the events are not loaded.
+*/
+int FileResource::prepareArchivePurge(const QDate& cutoff)
+{
+    if (mLoadDeferred  &&  mSettings)
+    {
+        const QDate oldest = mSettings->oldestArchivedDate();
+        if (oldest.isValid()  &&  oldest > cutoff)
+        {
+            qCDebug(KALARM_LOG) << "FileResource::prepareArchivePurge: Nothing to purge" << displayName();
+            return 0;
+        }
+    }
+    loadDeferredEvents();
+    return 0;
+}
+
+/******************************************************************************
+* Called when the resource's events have not been needed for a while.
+* If nothing still needs them, save any changes and unload them.
+*/
+void FileResource::slotIdle()
+{
+    if (mLoadDeferred  ||  !mLoadWanted)
+        return;
+    if (Resources::deferredEventsHeld(alarmTypes()))
+    {
+        mIdleTimer->start();
+        return;
+    }
+    if (isWritable(CalEvent::EMPTY))
+        save();
+    if (!deferLoad())
+        return;   // the resource can't be loaded again on demand
+    qCDebug(KALARM_LOG) << "FileResource::slotIdle: Unloading" << displayName();
+    if (mSettings  &&  (alarmTypes() & CalEvent::ARCHIVED))
+        mSettings->setOldestArchivedDate(oldestArchived(events()));
+    mLoadWanted   = false;
+    mLoadDeferred = true;
+    QHash<QString, KAEvent> noEvents;
+    setLoadedEvents(noEvents);
+    doUnload();
+}
+
 /******************************************************************************
 * Called when the resource has loaded, to finish setting it up.
 */
@@ -378,9 +486,9 @@ void FileResource::loaded(bool success, QHash<QString, KAEvent>& newEvents, cons
         // Set any command execution error flags for the events.
         // These are stored in the KAlarm config file, not the alarm
         // calendar, since they are specific to the user's local system.
-        bool changed = false;
-        QHash<QString, KAEvent::CmdErr> cmdErrors = mSettings->commandErrors();
-        for (auto errit = cmdErrors.begin();  errit != cmdErrors.end();  )
+        QStringList staleIds;
+        const QHash<QString, KAEvent::CmdErr>& cmdErrors = mSettings->commandErrors();
+        for (auto errit = cmdErrors.constBegin();  errit != cmdErrors.constEnd();  ++errit)
         {
             auto evit = newEvents.find(errit.key());
             if (evit != newEvents.end())
@@ -389,20 +497,25 @@ void FileResource::loaded(bool success, QHash<QString, KAEvent>& newEvents, cons
                 if (event.category() == CalEvent::ACTIVE)
                 {
                     event.setCommandError(errit.value());
-                    ++errit;
                     continue;
                 }
             }
             // The event for this command error doesn't exist, or is not active,
             // so remove this command error from the settings.
-            errit = cmdErrors.erase(errit);
-            changed = true;
+            staleIds += errit.key();
         }
 
-        if (changed)
-            mSettings->setCommandErrors(cmdErrors);
+        // Events which have not yet been converted to the current format
+        // are not yet present, so don't treat their command errors as stale.
+        if (!staleIds.isEmpty()  &&  isLoadComplete())
+            mSettings->removeCommandErrors(staleIds);
     }
 
+    // Record the oldest archived event, so that purging archived events can
+    // be skipped without loading the calendar when nothing can have expired.
+    if (alarmTypes() & CalEvent::ARCHIVED)
+        mSettings->setOldestArchivedDate(oldestArchived(newEvents));
+
     // Update the list of loaded events for the resource.
     setLoadedEvents(newEvents);
 }
@@ -413,6 +526,12 @@ void FileResource::loaded(bool success, QHash<QString, KAEvent>& newEvents, cons
 bool FileResource::save(QString* errorMessage, bool writeThroughCache, bool force)
 {
     qCDebug(KALARM_LOG) << "FileResource::save:" << displayName();
+    if (writeInhibited())
+    {
+        // Don't overwrite the user's calendar with the results of a simulation.
+        qCDebug(KALARM_LOG) << "FileResource::save: Not saved after simulation" << displayName();
+        return true;
+    }
     if (!checkSave())
         return false;
 
@@ -488,6 +607,19 @@ void FileResource::saved(bool success, const QString& errorMessage)
 bool FileResource::addEvent(const KAEvent& event)
 {
     qCDebug(KALARM_LOG) << "FileResource::addEvent:" << event.id();
+    if (mLoadDeferred  &&  isValid()  &&  isEnabled(CalEvent::EMPTY)  &&  isWritable(event.category())
+    &&  !writeInhibited()  &&  doAppendEvent(event))
+    {
+        // The event has been stored without loading the calendar.
+        // It will be read along with the other events when they are needed.
+        // Note that active alarm calendars are never deferred, so there
+        // is no command error to record.
+        const QDate oldest = mSettings->oldestArchivedDate();
+        if (event.category() == CalEvent::ARCHIVED  &&  oldest.isValid())
+            mSettings->setOldestArchivedDate(std::min(oldest, event.createdDateTime().date()));
+        return true;
+    }
+    FileResource::loadDeferredEvents();   // the calendar must be loaded in order to write to it
     if (!isValid())
         qCWarning(KALARM_LOG) << "FileResource::addEvent: Resource invalid!" << displayName();
     else if (!isEnabled(CalEvent::EMPTY))
@@ -504,11 +636,7 @@ bool FileResource::addEvent(const KAEvent& event)
             // Add this event's command error to the settings.
             if (event.category() == CalEvent::ACTIVE
             &&  event.commandError() != KAEvent::CmdErr::None)
-            {
-                QHash<QString, KAEvent::CmdErr> cmdErrors = mSettings->commandErrors();
-                cmdErrors[event.id()] = event.commandError();
-                mSettings->setCommandErrors(cmdErrors);
-            }
+                mSettings->setCommandError(event.id(), event.commandError());
         }
 
         scheduleSave();
@@ -524,6 +652,7 @@ bool FileResource::addEvent(const KAEvent& event)
 bool FileResource::updateEvent(const KAEvent& event, bool saveIfReadOnly)
 {
     qCDebug(KALARM_LOG) << "FileResource::updateEvent:" << event.id();
+    FileResource::loadDeferredEvents();   // the calendar must be loaded in order to write to it
     if (!isValid())
         qCWarning(KALARM_LOG) << "FileResource::updateEvent: Resource invalid!" << displayName();
     else if (!isEnabled(CalEvent::EMPTY))
@@ -564,6 +693,7 @@ bool FileResource::updateEvent(const KAEvent& event, bool saveIfReadOnly)
 bool FileResource::deleteEvent(const KAEvent& event)
 {
     qCDebug(KALARM_LOG) << "FileResource::deleteEvent:" << event.id();
+    FileResource::loadDeferredEvents();   // the calendar must be loaded in order to write to it
     if (!isValid())
         qCWarning(KALARM_LOG) << "FileResource::deleteEvent: Resource invalid!" << displayName();
     else if (!isEnabled(CalEvent::EMPTY))
@@ -576,11 +706,7 @@ bool FileResource::deleteEvent(const KAEvent& event)
         setDeletedEvents({event});
 
         if (mSettings  &&  mSettings->isEnabled(CalEvent::ACTIVE))
-        {
-            QHash<QString, KAEvent::CmdErr> cmdErrors = mSettings->commandErrors();
-            if (cmdErrors.remove(event.id()))
-                mSettings->setCommandErrors(cmdErrors);
-        }
+            mSettings->setCommandError(event.id(), KAEvent::CmdErr::None);
 
         scheduleSave();
         return true;
@@ -588,6 +714,16 @@ bool FileResource::deleteEvent(const KAEvent& event)
     return false;
 }
 
+/******************************************************************************
+* Return whether writing to backend storage is inhibited. This is the case once
+* a scheduler simulation has started, including after it has finished, since
+* the events in memory no longer reflect reality.
+*/
+bool FileResource::writeInhibited()
+{
+    return VirtualClock::instance() != nullptr;
+}
+
 /******************************************************************************
 * Save a command error change to the settings.
 */
@@ -596,33 +732,11 @@ void FileResource::handleCommandErrorChange(const KAEvent& event)
     if (!mSettings)
         return;
     // Update command errors held in the settings, if appropriate.
-    bool changed = false;
-    QHash<QString, KAEvent::CmdErr> cmdErrors = mSettings->commandErrors();
-    if (event.category() != CalEvent::ACTIVE
-    ||  event.commandError() == KAEvent::CmdErr::None)
-    {
-        if (cmdErrors.remove(event.id()))
-            changed = true;
-    }
-    else if (event.category() == CalEvent::ACTIVE)
-    {
-        auto it = cmdErrors.find(event.id());
-        if (it == cmdErrors.end())
-        {
-            cmdErrors[event.id()] = event.commandError();
-            changed = true;
-        }
-        else if (event.commandError() != it.value())
-        {
-            it.value() = event.commandError();
-            changed = true;
-        }
-    }
-    if (changed)
-    {
-        mSettings->setCommandErrors(cmdErrors);
+    // The settings only write the change to the config file after a delay, so
+    // that repeated changes don't each cause the file to be rewritten.
+    const KAEvent::CmdErr error = (event.category() == CalEvent::ACTIVE) ? event.commandError() : KAEvent::CmdErr::None;
+    if (mSettings->setCommandError(event.id(), error))
         Resources::notifyEventUpdated(this, event);
-    }
 }
 
 /******************************************************************************
@@ -635,7 +749,9 @@ bool FileResource::updateStorageFormat(Resource& res)
         qCCritical(KALARM_LOG) << "FileResource::updateStorageFormat: Error: Not a FileResource:" << res.displayName();
         return false;
     }
-    return resource<FileResource>(res)->updateStorageFmt();
+    FileResource* fileResource = resource<FileResource>(res);
+    fileResource->loadDeferredEvents();
+    return fileResource->updateStorageFmt();
 }
 
 /******************************************************************************
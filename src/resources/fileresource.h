@@ -16,6 +16,7 @@
 #include <QHash>
 
 class FileResourceSettings;
+class QTimer;
 
 using namespace KAlarmCal;
 
@@ -220,6 +221,23 @@ public:
     /** Return the current status of the resource. */
     Status status() const    { return mStatus; }
 
+    /** Load the resource's events, if loading has been deferred until they
+     *  are needed. The idle period after which they may be unloaded again is
+     *  restarted.
+     */
+    void loadDeferredEvents() override;
+
+    /** Return whether the resource has deferred loading its events until
+     *  they are needed.
+     */
+    bool isLoadDeferred() const override   { return mLoadDeferred; }
+
+    /** Prepare for purging archived events, by loading the resource's events
+     *  if loading has been deferred. Loading is skipped if no archived event
+     *  was created before @p cutoff.
+     */
+    int prepareArchivePurge(const QDate& cutoff) override;
+
     /** Load the resource from the file, and fetch all events.
      *  If loading is initiated, Resources::resourcePopulated() will be emitted
      *  on completion.
@@ -312,6 +330,29 @@ protected:
      */
     virtual int doLoad(QHash<QString, KAEvent>& newEvents, bool readThroughCache, QString& errorMessage) = 0;
 
+    /** This method is called for a resource which contains no active alarms,
+     *  by load() when its events have not yet been asked for, and before
+     *  unloading its events when they are no longer needed. It allows derived
+     *  classes to defer loading until the events are needed.
+     *  If loading can be deferred, derived classes must set mCompatibility and
+     *  mVersion without loading the events.
+     *  The default is not to defer loading.
+     *  @return true if loading has been deferred, false to load now.
+     */
+    virtual bool deferLoad()   { return false; }
+
+    /** This method is called when the events of a resource which defers
+     *  loading have not been needed for some time, to allow derived classes to
+     *  discard their loaded calendar data. Any changes have already been saved.
+     */
+    virtual void doUnload()  {}
+
+    /** Return whether all the resource's events have been loaded. This is
+     *  false while events are still being converted to the current KAlarm
+     *  format after loading has completed.
+     */
+    virtual bool isLoadComplete() const   { return true; }
+
     /** To be called by derived classes on completion of loading the resource,
      *  only if doLoad() initiated but did not complete loading.
      *  @param success    true if loading succeeded, false if failed.
@@ -353,6 +394,11 @@ protected:
      */
     bool checkSave();
 
+    /** Return whether writing to backend storage is inhibited, because a
+     *  scheduler simulation has been run. Changes are then only held in memory.
+     */
+    static bool writeInhibited();
+
     /** To be called by derived classes on completion of saving the resource,
      *  only if doSave() initiated but did not complete saving.
      *  @param success    true if saving succeeded, false if failed.
@@ -364,6 +410,15 @@ protected:
      */
     virtual bool doAddEvent(const KAEvent&) = 0;
 
+    /** This method is called by addEvent() when loading the resource has been
+     *  deferred, to allow derived classes to write an event to the backend
+     *  storage without loading the resource's existing events.
+     *  The default is not to do this.
+     *  @return true if the event has been written, false to load the resource
+     *          and add the event using doAddEvent().
+     */
+    virtual bool doAppendEvent(const KAEvent&)   { return false; }
+
     /** This method is called by updateEvent() to allow derived classes to update
      *  an event in the resource. The event's UID must be unchanged.
      */
@@ -395,10 +450,16 @@ typedef QHash<const QString&, KACalendar::Compat>  CompatibilityMap;  // indexed
 CompatibilityMap    mCompatibilityMap;  // whether individual events are in compatible format
 */
 
+private Q_SLOTS:
+    void slotIdle();
+
 private:
     void handleEnabledChange(Changes changes, CalEvent::Types oldEnabled);
 
-    Status mStatus {Status::Unusable};    // current status of resource
+    Status  mStatus {Status::Unusable};    // current status of resource
+    QTimer* mIdleTimer {nullptr};          // times how long events have not been needed
+    bool    mLoadDeferred {false};         // loading events is deferred until they're needed
+    bool    mLoadWanted {false};           // events have been needed since last unloaded
 };
 
 // vim: et sw=4:
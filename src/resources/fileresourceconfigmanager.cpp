@@ -9,6 +9,7 @@
 #include "fileresourceconfigmanager.h"
 
 #include "resources.h"
+#include "segmentedfileresource.h"
 #include "singlefileresource.h"
 #include "fileresourcecalendarupdater.h"
 #include "kalarm_debug.h"
@@ -125,6 +126,8 @@ void FileResourceConfigManager::createResources(QObject* parent, bool ignoreKeep
 */
 FileResourceConfigManager::~FileResourceConfigManager()
 {
+    for (const ResourceData& data : std::as_const(mResources))
+        data.settings->saveCommandErrors();
     writeConfig();
     delete mConfig;
     mInstance = nullptr;
@@ -243,6 +246,8 @@ Resource FileResourceConfigManager::createResource(const FileResourceSettings::P
     switch (settings->storageType())
     {
         case FileResourceSettings::File:
+            if (settings->segmented())
+                return SegmentedFileResource::create(settings);
             return SingleFileResource::create(settings);
         case FileResourceSettings::Directory:   // not currently intended to be implemented
         default:
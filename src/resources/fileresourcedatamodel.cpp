@@ -43,6 +43,8 @@ private:
     Resource owner;  // resource containing this KAEvent, or null
 public:
     Type type;
+    mutable EventTexts texts;    // if type Event, cached texts derived from the KAEvent
+    mutable EventSortKeys sortKeys;  // if type Event, cached sort values for the KAEvent
 
     explicit Node(Resource& r) : ritem(r), type(Type::Resource) {}
     Node(KAEvent* e, Resource& r) : eitem(e), owner(r), type(Type::Event) {}
@@ -145,6 +147,8 @@ void FileResourceDataModel::initialise()
     Preferences::connect(&Preferences::disabledColourChanged, this, &FileResourceDataModel::slotUpdateDisabledColour);
     Preferences::connect(&Preferences::holidaysChanged, this, &FileResourceDataModel::slotUpdateHolidays);
     Preferences::connect(&Preferences::workTimeChanged, this, &FileResourceDataModel::slotUpdateWorkingHours);
+    Preferences::connect(&Preferences::startOfDayChanged, this, &FileResourceDataModel::slotUpdateStartOfDay);
+    Preferences::connect(&Preferences::timeZoneChanged, this, &FileResourceDataModel::slotUpdateTimeZone);
 }
 
 /******************************************************************************
@@ -270,6 +274,25 @@ KAEvent FileResourceDataModel::event(const QModelIndex& ix) const
     return {};
 }
 
+/******************************************************************************
+* Return the sort keys for the event referred to by an index, or null if the
+* index is not for an event.
+*/
+const ResourceDataModelBase::EventSortKeys* FileResourceDataModel::eventSortKeys(const QModelIndex& ix) const
+{
+    if (ix.isValid())
+    {
+        const Node* node = reinterpret_cast<Node*>(ix.internalPointer());
+        if (node)
+        {
+            const KAEvent* event = node->event();
+            if (event)
+                return &sortKeys(*event, node->sortKeys, &node->texts);
+        }
+    }
+    return nullptr;
+}
+
 /******************************************************************************
 * Return the index to a specified event.
 */
@@ -501,13 +524,135 @@ void FileResourceDataModel::slotMigrationCompleted()
 
 /******************************************************************************
 * Signal every minute that the time-to-alarm values have changed.
+* Only the events currently displayed in views are signalled. The others are
+* left stale, and are signalled when they are next displayed. On a change of
+* date, all events are signalled, since date-only alarms' values change then.
 */
 static bool checkEvent_isActive(const KAEvent* event)
 { return event->category() == CalEvent::ACTIVE; }
 
 void FileResourceDataModel::slotUpdateTimeTo()
 {
-    signalDataChanged(&checkEvent_isActive, TimeToColumn, TimeToColumn, QModelIndex());
+    ++mTimeToTick;
+    const QDate today = KADateTime::currentLocalDate();
+    if (today != mTimeToDate)
+    {
+        mTimeToDate = today;
+        mTimeToFullTick = mTimeToTick;
+        mTimeToRefreshed.clear();
+        signalDataChanged(&checkEvent_isActive, TimeToColumn, TimeToColumn, QModelIndex());
+        return;
+    }
+
+    signalTimeToChanged(mTimeToIndexes.keys());
+}
+
+/******************************************************************************
+* Set the events currently displayed in a view's time-to-alarm column.
+* Any newly displayed events whose time-to-alarm values are stale are signalled.
+* Persistent indexes are held for all displayed events, so that their rows
+* don't need to be searched for every minute.
+*/
+void FileResourceDataModel::setTimeToVisibleEvents(const QObject* view, const QSet<QString>& eventIds)
+{
+    if (eventIds.isEmpty())
+        mTimeToViews.remove(view);
+    else
+        mTimeToViews[view] = eventIds;
+
+    // Discard indexes for events which are no longer displayed in any view,
+    // or whose rows have been removed.
+    QSet<QString> allIds;
+    for (auto it = mTimeToViews.constBegin(), end = mTimeToViews.constEnd();  it != end;  ++it)
+        allIds.unite(it.value());
+    for (auto it = mTimeToIndexes.begin();  it != mTimeToIndexes.end();  )
+    {
+        if (!it.value().isValid()  ||  !allIds.contains(it.key()))
+            it = mTimeToIndexes.erase(it);
+        else
+            ++it;
+    }
+
+    // Find the rows of newly displayed events, grouping them by resource so
+    // as to scan each resource's events only once.
+    QHash<Resource, QHash<const Node*, QString>> resourceNodes;
+    for (const QString& id : eventIds)
+    {
+        if (mTimeToIndexes.contains(id))
+            continue;
+        const Node* node = mEventNodes.value(id, nullptr);
+        if (node)
+            resourceNodes[node->parent()].insert(node, id);
+    }
+    for (auto rit = resourceNodes.constBegin(), rend = resourceNodes.constEnd();  rit != rend;  ++rit)
+    {
+        auto it = mResourceNodes.constFind(rit.key());
+        if (it == mResourceNodes.constEnd())
+            continue;
+        const QHash<const Node*, QString>& nodes = rit.value();
+        const QList<Node*>& eventNodes = it.value();
+        int found = 0;
+        for (int row = 0, count = eventNodes.count();  row < count  &&  found < nodes.count();  ++row)
+        {
+            Node* node = eventNodes.at(row);
+            auto nit = nodes.constFind(node);
+            if (nit != nodes.constEnd())
+            {
+                mTimeToIndexes[nit.value()] = QPersistentModelIndex(createIndex(row, TimeToColumn, node));
+                ++found;
+            }
+        }
+    }
+
+    QList<QString> stale;
+    for (const QString& id : eventIds)
+    {
+        if (mTimeToRefreshed.value(id, mTimeToFullTick) < mTimeToTick)
+            stale += id;
+    }
+    if (!stale.isEmpty())
+        signalTimeToChanged(stale);
+}
+
+/******************************************************************************
+* Emit the dataChanged() signal for the time-to-alarm column of specified
+* displayed active events, and record them as being up to date.
+* The events' rows are obtained from their persistent indexes.
+*/
+void FileResourceDataModel::signalTimeToChanged(const QList<QString>& eventIds)
+{
+    QHash<Resource, QList<int>> resourceRows;
+    for (const QString& id : eventIds)
+    {
+        const QPersistentModelIndex ix = mTimeToIndexes.value(id);
+        if (!ix.isValid())
+            continue;
+        const Node* node = static_cast<Node*>(ix.internalPointer());
+        const KAEvent* evnt = node->event();
+        if (!evnt  ||  !checkEvent_isActive(evnt))
+            continue;
+        resourceRows[node->parent()] += ix.row();
+        mTimeToRefreshed[id] = mTimeToTick;
+    }
+
+    for (auto it = resourceRows.begin(), end = resourceRows.end();  it != end;  ++it)
+    {
+        const QModelIndex resourceIx = resourceIndex(it.key());
+        if (!resourceIx.isValid())
+            continue;
+        // For efficiency, emit a single signal for each group of
+        // consecutive events, rather than a separate signal for each event.
+        QList<int>& rows = it.value();
+        std::sort(rows.begin(), rows.end());
+        for (int i = 0, count = rows.count();  i < count;  )
+        {
+            const int row = rows.at(i);
+            int lastRow = row;
+            while (++i < count  &&  rows.at(i) == lastRow + 1)
+                ++lastRow;
+            Q_EMIT dataChanged(index(row, TimeToColumn, resourceIx), index(lastRow, TimeToColumn, resourceIx));
+        }
+    }
 }
 
 /******************************************************************************
@@ -549,6 +694,7 @@ static bool checkEvent_excludesHolidays(const KAEvent* event)
 void FileResourceDataModel::slotUpdateHolidays()
 {
     qCDebug(KALARM_LOG) << "FileResourceDataModel::slotUpdateHolidays";
+    invalidateSortKeys();
     Q_ASSERT(TimeToColumn == TimeColumn + 1);  // signal should be emitted only for TimeTo and Time columns
     signalDataChanged(&checkEvent_excludesHolidays, TimeColumn, TimeToColumn, QModelIndex());
 }
@@ -566,10 +712,47 @@ static bool checkEvent_workTimeOnly(const KAEvent* event)
 void FileResourceDataModel::slotUpdateWorkingHours()
 {
     qCDebug(KALARM_LOG) << "FileResourceDataModel::slotUpdateWorkingHours";
+    invalidateSortKeys();
     Q_ASSERT(TimeToColumn == TimeColumn + 1);  // signal should be emitted only for TimeTo and Time columns
     signalDataChanged(&checkEvent_workTimeOnly, TimeColumn, TimeToColumn, QModelIndex());
 }
 
+/******************************************************************************
+* Called when the start-of-day time has changed.
+* Update the times of all date-only alarms, since their effective times (used
+* for sorting) depend on the start-of-day time.
+*/
+static bool checkEvent_isDateOnly(const KAEvent* event)
+{
+    return event->startDateTime().isDateOnly();
+}
+
+void FileResourceDataModel::slotUpdateStartOfDay()
+{
+    qCDebug(KALARM_LOG) << "FileResourceDataModel::slotUpdateStartOfDay";
+    invalidateSortKeys();
+    Q_ASSERT(TimeToColumn == TimeColumn + 1);  // signal should be emitted only for TimeTo and Time columns
+    signalDataChanged(&checkEvent_isDateOnly, TimeColumn, TimeToColumn, QModelIndex());
+}
+
+/******************************************************************************
+* Called when the default time zone has changed.
+* Update the times of all alarms, since their displayed and sort times depend
+* on the time zone.
+*/
+static bool checkEvent_all(const KAEvent*)
+{
+    return true;
+}
+
+void FileResourceDataModel::slotUpdateTimeZone()
+{
+    qCDebug(KALARM_LOG) << "FileResourceDataModel::slotUpdateTimeZone";
+    invalidateSortKeys();
+    Q_ASSERT(TimeToColumn == TimeColumn + 1);  // signal should be emitted only for TimeTo and Time columns
+    signalDataChanged(&checkEvent_all, TimeColumn, TimeToColumn, QModelIndex());
+}
+
 /******************************************************************************
 * Called when loading of a resource is complete.
 */
@@ -692,6 +875,8 @@ void FileResourceDataModel::slotEventUpdated(Resource& resource, const KAEvent&
             if (oldEvent)
             {
                 *oldEvent = event;
+                node->texts = EventTexts();
+                node->sortKeys = EventSortKeys();
 
                 const QList<Node *> eventNodes = mResourceNodes.value(resource);
                 int row = eventNodes.indexOf(node);
@@ -747,7 +932,9 @@ bool FileResourceDataModel::deleteEvents(Resource& resource, const QList<KAEvent
         {
             Node* node = eventNodes.at(row);
             eventNodes.removeAt(row);
-            mEventNodes.remove(node->event()->id());
+            const QString eventId = node->event()->id();
+            mEventNodes.remove(eventId);
+            mTimeToRefreshed.remove(eventId);
             delete node;
         } while (++row <= lastRow);
         endRemoveRows();
@@ -885,6 +1072,7 @@ int FileResourceDataModel::removeResourceEvents(QList<Node*>& eventNodes)
         {
             const QString eventId = evnt->id();
             mEventNodes.remove(eventId);
+            mTimeToRefreshed.remove(eventId);
             ++count;
         }
         delete node;
@@ -1119,7 +1307,7 @@ QVariant FileResourceDataModel::data(const QModelIndex& ix, int role) const
                     return node->parent().id();
                 const Resource resp = node->parent();
                 bool handled;
-                const QVariant value = eventData(role, ix.column(), *evnt, resp, handled);
+                const QVariant value = eventData(role, ix.column(), *evnt, resp, handled, &node->texts);
                 if (handled)
                     return value;
             }
@@ -13,6 +13,7 @@
 #include "kalarmcalendar/kaevent.h"
 
 #include <QAbstractItemModel>
+#include <QPersistentModelIndex>
 
 class QDialog;
 class QLabel;
@@ -60,6 +61,11 @@ public:
     KAEvent event(const QModelIndex&) const;
     using QObject::event;   // prevent warning about hidden virtual method
 
+    /** Return the sort keys for the event referred to by an index.
+     *  @return  the event's sort keys, or null if the index is not for an event.
+     */
+    const EventSortKeys* eventSortKeys(const QModelIndex&) const;
+
     QModelIndex    eventIndex(const KAEvent&) const;
     QModelIndex    eventIndex(const QString& eventId) const;
 
@@ -115,6 +121,9 @@ protected:
     /** Update a resource's backend calendar file to the current KAlarm format. */
     void updateCalendarToCurrentFormat(Resource&, bool ignoreKeepFormat, QObject* parent) override;
 
+    /** Set the events currently displayed in a view's time-to-alarm column. */
+    void setTimeToVisibleEvents(const QObject* view, const QSet<QString>& eventIds) override;
+
     ResourceListModel* createResourceListModel(QObject* parent) override;
     ResourceFilterCheckListModel* createResourceFilterCheckListModel(QObject* parent) override;
     AlarmListModel*    createAlarmListModel(QObject* parent) override;
@@ -134,6 +143,8 @@ private Q_SLOTS:
     void     slotUpdateDisabledColour(const QColor&);
     void     slotUpdateHolidays();
     void     slotUpdateWorkingHours();
+    void     slotUpdateStartOfDay();
+    void     slotUpdateTimeZone();
     /** Add a resource and all its events. */
     void     addResource(Resource&);
     void     slotResourceLoaded(Resource&);
@@ -153,6 +164,7 @@ private:
     explicit FileResourceDataModel(QObject* parent = nullptr);
     void     initialise();
     void     signalDataChanged(bool (*checkFunc)(const KAEvent*), int startColumn, int endColumn, const QModelIndex& parent);
+    void     signalTimeToChanged(const QList<QString>& eventIds);
     void     showMigrationMessage(bool create);
 
     /** Remove a resource's events. */
@@ -172,6 +184,12 @@ private:
     QList<Resource>       mResources;
     QHash<QString, Node*> mEventNodes;  // each event ID, mapped to its node.
     bool                  mHaveEvents;  // there are events in this model
+    QHash<const QObject*, QSet<QString>> mTimeToViews;  // events displayed in each view's time-to column
+    QHash<QString, QPersistentModelIndex> mTimeToIndexes;  // index of each event displayed in a time-to column
+    QHash<QString, int>   mTimeToRefreshed;  // minute tick when each event's time-to was last signalled
+    int                   mTimeToTick {0};      // number of minute ticks so far
+    int                   mTimeToFullTick {0};  // minute tick when all events' time-to was last signalled
+    QDate                 mTimeToDate;          // local date when all events' time-to was last signalled
     int                   mMigrationState;    // current resource migration state
     QDialog*              mMigrationMessage {nullptr};  // user message about migration state
     QLabel*               mMigrationMessageText1;
@@ -12,6 +12,7 @@
 #include <KConfigGroup>
 
 #include <QFileInfo>
+#include <QTimer>
 using namespace Qt::Literals::StringLiterals;
 
 namespace
@@ -27,8 +28,10 @@ const char* KEY_ENABLED      = "Enabled";
 const char* KEY_STANDARD     = "Standard";
 const char* KEY_READONLY     = "ReadOnly";
 const char* KEY_KEEPFORMAT   = "KeepFormat";
+const char* KEY_SEGMENTED    = "Segmented";     // no UI: set by editing the config file
 const char* KEY_UPDATEFORMAT = "UpdateFormat";
 const char* KEY_HASH         = "Hash";
+const char* KEY_OLDEST       = "OldestArchived";
 const char* KEY_CMDERRORS    = "CommandErrors";
 // Config file values
 const QLatin1StringView STORAGE_FILE("File");
@@ -41,6 +44,8 @@ const QLatin1StringView CMD_ERROR_PRE_VALUE("Pre");
 const QLatin1StringView CMD_ERROR_POST_VALUE("Post");
 const QLatin1StringView CMD_ERROR_PRE_POST_VALUE("PrePost");
 const QLatin1Char   CMD_ERROR_SEPARATOR(':');
+
+const int COMMAND_ERROR_SAVE_DELAY = 5000;   // delay (ms) before writing command error changes to config
 }
 
 /******************************************************************************
@@ -75,6 +80,8 @@ FileResourceSettings::FileResourceSettings(Storage storageType,
 
 FileResourceSettings::~FileResourceSettings()
 {
+    saveCommandErrors();   // don't lose command error changes made in the last few seconds
+    delete mCommandErrorTimer;
     delete mConfigGroup;
 }
 
@@ -94,7 +101,9 @@ bool FileResourceSettings::readConfig()
     mReadOnly          = mConfigGroup->readEntry(KEY_READONLY, false);
     mKeepFormat        = mConfigGroup->readEntry(KEY_KEEPFORMAT, false);
     mUpdateFormat      = mConfigGroup->readEntry(KEY_UPDATEFORMAT, false);
+    mSegmented         = mConfigGroup->readEntry(KEY_SEGMENTED, false);
     mHash              = QByteArray::fromHex(mConfigGroup->readEntry(KEY_HASH, QByteArray()));
+    mOldestArchived    = mConfigGroup->readEntry(KEY_OLDEST, QDate());
     mAlarmTypes        = readAlarmTypes(KEY_ALARMTYPES);
     mEnabled           = readAlarmTypes(KEY_ENABLED);
     mStandard          = readAlarmTypes(KEY_STANDARD);
@@ -185,6 +194,7 @@ bool FileResourceSettings::createConfig(KConfig* config, const QString& resource
     writeConfigKeepFormat(false);
     writeConfigUpdateFormat(false);
     writeConfigHash(false);
+    writeConfigOldestArchived(false);
     writeConfigCommandErrors(false);
     mConfigGroup->sync();
     return true;
@@ -441,6 +451,11 @@ ResourceType::Changes FileResourceSettings::setKeepFormat(bool keep, bool sync)
     return ResourceType::KeepFormat;
 }
 
+bool FileResourceSettings::segmented() const
+{
+    return mSegmented;
+}
+
 bool FileResourceSettings::updateFormat() const
 {
     return mUpdateFormat;
@@ -472,7 +487,22 @@ void FileResourceSettings::setHash(const QByteArray& hash, bool sync)
     }
 }
 
-QHash<QString, KAEvent::CmdErr> FileResourceSettings::commandErrors() const
+QDate FileResourceSettings::oldestArchivedDate() const
+{
+    return mOldestArchived;
+}
+
+void FileResourceSettings::setOldestArchivedDate(const QDate& date, bool sync)
+{
+    if (date != mOldestArchived)
+    {
+        mOldestArchived = date;
+        if (mConfigGroup)
+            writeConfigOldestArchived(sync);
+    }
+}
+
+const QHash<QString, KAEvent::CmdErr>& FileResourceSettings::commandErrors() const
 {
     return mCommandErrors;
 }
@@ -482,11 +512,85 @@ void FileResourceSettings::setCommandErrors(const QHash<QString, KAEvent::CmdErr
     if (cmdErrors != mCommandErrors)
     {
         mCommandErrors = cmdErrors;
+        if (mCommandErrorTimer)
+            mCommandErrorTimer->stop();
         if (mConfigGroup)
             writeConfigCommandErrors(sync);
     }
 }
 
+KAEvent::CmdErr FileResourceSettings::commandError(const QString& eventId) const
+{
+    return mCommandErrors.value(eventId, KAEvent::CmdErr::None);
+}
+
+bool FileResourceSettings::setCommandError(const QString& eventId, KAEvent::CmdErr error)
+{
+    if (error == KAEvent::CmdErr::None)
+    {
+        if (!mCommandErrors.remove(eventId))
+            return false;
+    }
+    else
+    {
+        auto it = mCommandErrors.find(eventId);
+        if (it == mCommandErrors.end())
+            mCommandErrors.insert(eventId, error);
+        else if (it.value() != error)
+            it.value() = error;
+        else
+            return false;
+    }
+    commandErrorsChanged();
+    return true;
+}
+
+bool FileResourceSettings::removeCommandErrors(const QStringList& eventIds)
+{
+    bool changed = false;
+    for (const QString& id : eventIds)
+        if (mCommandErrors.remove(id))
+            changed = true;
+    if (changed)
+        commandErrorsChanged();
+    return changed;
+}
+
+/******************************************************************************
+* Write pending command error changes to the config, if any.
+*/
+void FileResourceSettings::saveCommandErrors()
+{
+    if (mCommandErrorTimer  &&  mCommandErrorTimer->isActive())
+    {
+        mCommandErrorTimer->stop();
+        if (mConfigGroup)
+            writeConfigCommandErrors(true);
+    }
+}
+
+/******************************************************************************
+* Called when the command errors have been changed.
+* Start the timer to write them to the config, so that a rapid succession of
+* changes (e.g. from a command alarm which repeatedly fails and succeeds)
+* results in only one write. If the timer is already running, leave it, so
+* that a continuous stream of changes is still written periodically.
+*/
+void FileResourceSettings::commandErrorsChanged()
+{
+    if (!mConfigGroup)
+        return;
+    if (!mCommandErrorTimer)
+    {
+        mCommandErrorTimer = new QTimer;
+        mCommandErrorTimer->setSingleShot(true);
+        mCommandErrorTimer->setInterval(COMMAND_ERROR_SAVE_DELAY);
+        QObject::connect(mCommandErrorTimer, &QTimer::timeout, mCommandErrorTimer, [this]() { writeConfigCommandErrors(true); });
+    }
+    if (!mCommandErrorTimer->isActive())
+        mCommandErrorTimer->start();
+}
+
 /******************************************************************************
 * Validate settings against each other, and amend to be consistent.
 * Note that this validation cannot be done in the setXxxxx() methods, since
@@ -609,6 +713,16 @@ void FileResourceSettings::writeConfigHash(bool sync)
         mConfigGroup->sync();
 }
 
+void FileResourceSettings::writeConfigOldestArchived(bool sync)
+{
+    if (mOldestArchived.isValid())
+        mConfigGroup->writeEntry(KEY_OLDEST, mOldestArchived);
+    else
+        mConfigGroup->deleteEntry(KEY_OLDEST);
+    if (sync)
+        mConfigGroup->sync();
+}
+
 void FileResourceSettings::writeConfigCommandErrors(bool sync)
 {
     QStringList cmdErrs;
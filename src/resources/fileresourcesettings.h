@@ -15,11 +15,13 @@
 #include <QUrl>
 #include <QColor>
 #include <QByteArray>
+#include <QDate>
 #include <QSharedPointer>
 #include <QHash>
 
 class KConfig;
 class KConfigGroup;
+class QTimer;
 
 using namespace KAlarmCal;
 
@@ -240,6 +242,14 @@ public:
      */
     ResourceType::Changes setKeepFormat(bool keep, bool save = true);
 
+    /** Return whether the resource is configured to store archived alarms in
+     *  monthly segment files, instead of all in the single calendar file.
+     *  This is only applicable to a local file which contains only archived
+     *  alarms. It is set by the config key 'Segmented', which can only be
+     *  edited in the config file (see SegmentedFileResource and the handbook).
+     */
+    bool segmented() const;
+
     /** Return whether the user has chosen to update the calendar storage
      *  format to the current KAlarm format.
      */
@@ -265,11 +275,23 @@ public:
      */
     void setHash(const QByteArray& hash, bool save = true);
 
+    /** Return the creation date of the oldest archived alarm in the calendar,
+     *  as recorded when its events were last loaded or unloaded.
+     *  @return oldest creation date, or invalid if not known.
+     */
+    QDate oldestArchivedDate() const;
+
+    /** Set the creation date of the oldest archived alarm in the calendar.
+     *  @param date  oldest creation date, or invalid if not known
+     *  @param save  whether to save the config
+     */
+    void setOldestArchivedDate(const QDate& date, bool save = true);
+
     /** Return the command error data for all events in the resource which have
      *  command errors.
      *  @return command error types, indexed by event ID.
      */
-    QHash<QString, KAEvent::CmdErr> commandErrors() const;
+    const QHash<QString, KAEvent::CmdErr>& commandErrors() const;
 
     /** Set the command error data for all events in the resource which have
      *  command errors.
@@ -278,6 +300,29 @@ public:
      */
     void setCommandErrors(const QHash<QString, KAEvent::CmdErr>& cmdErrors, bool save = true);
 
+    /** Return the command error for one event.
+     *  @return command error type, or CmdErr::None if none.
+     */
+    KAEvent::CmdErr commandError(const QString& eventId) const;
+
+    /** Set or clear the command error for one event.
+     *  The change is not written to the config immediately; changes are
+     *  accumulated and written together after a short delay.
+     *  @param eventId  event ID
+     *  @param error    command error type, or CmdErr::None to clear it.
+     *  @return true if the command error has changed.
+     */
+    bool setCommandError(const QString& eventId, KAEvent::CmdErr error);
+
+    /** Clear the command errors for a number of events.
+     *  The change is written to the config after a short delay.
+     *  @return true if any command error has been removed.
+     */
+    bool removeCommandErrors(const QStringList& eventIds);
+
+    /** Write any pending command error changes to the config. */
+    void saveCommandErrors();
+
 protected:
     /** Set the resource's unique ID.
      *  This method can only be called when initialising the instance.
@@ -302,7 +347,9 @@ private:
     void writeConfigKeepFormat(bool save);
     void writeConfigUpdateFormat(bool save);
     void writeConfigHash(bool save);
+    void writeConfigOldestArchived(bool save);
     void writeConfigCommandErrors(bool save);
+    void commandErrorsChanged();
 
     KConfigGroup*     mConfigGroup {nullptr}; // the config group holding all this resource's config
                                               // Until this is set, no notifications will be made
@@ -311,7 +358,9 @@ private:
     QString         mDisplayLocation;  // displayable location of file or directory
     QString         mDisplayName;      // name for user display
     QByteArray      mHash;             // hash of the calendar file contents
+    QDate           mOldestArchived;   // creation date of oldest archived alarm
     QHash<QString, KAEvent::CmdErr> mCommandErrors;  // event IDs and their command error types
+    QTimer*         mCommandErrorTimer {nullptr};  // timer to write command error changes to config
     QColor          mBackgroundColour; // background colour to display the resource and its alarms
     Storage         mStorageType {Storage::None};  // how the calendar is stored
     CalEvent::Types mAlarmTypes {CalEvent::EMPTY}; // alarm types which the resource contains
@@ -320,6 +369,7 @@ private:
     bool            mReadOnly {false};     // the resource is read-only
     bool            mKeepFormat {false};   // do not update the calendar file to the current KAlarm format
     bool            mUpdateFormat {false}; // request to update the calendar file to the current KAlarm format
+    bool            mSegmented {false};    // archived alarms are stored in monthly segment files
 };
 
 // vim: et sw=4:
@@ -241,6 +241,22 @@ bool Resource::isPopulated() const
     return mResource.isNull() ? false : mResource->isPopulated();
 }
 
+void Resource::loadDeferredEvents()
+{
+    if (!mResource.isNull())
+        mResource->loadDeferredEvents();
+}
+
+bool Resource::isLoadDeferred() const
+{
+    return mResource.isNull() ? false : mResource->isLoadDeferred();
+}
+
+int Resource::prepareArchivePurge(const QDate& cutoff)
+{
+    return mResource.isNull() ? 0 : mResource->prepareArchivePurge(cutoff);
+}
+
 bool Resource::save(QString* errorMessage, bool writeThroughCache)
 {
     return mResource.isNull() ? false : mResource->save(errorMessage, writeThroughCache);
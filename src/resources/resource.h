@@ -292,6 +292,23 @@ public:
     /** Return whether the resource has fully loaded. */
     bool isPopulated() const;
 
+    /** Load any events whose loading the resource has deferred until they
+     *  are actually needed.
+     */
+    void loadDeferredEvents();
+
+    /** Return whether the resource has deferred loading some or all of its
+     *  events until they are actually needed.
+     */
+    bool isLoadDeferred() const;
+
+    /** Prepare for purging archived events created before @p cutoff, by
+     *  deleting any stored segments which contain only such events, and
+     *  loading any other archived events whose loading has been deferred.
+     *  @return number of loaded events deleted.
+     */
+    int prepareArchivePurge(const QDate& cutoff);
+
     /** Save the resource.
      *  Saving is not performed if the resource is disabled.
      *  If the resource is cached, it will be saved to the cache file (which
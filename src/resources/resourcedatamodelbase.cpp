@@ -20,6 +20,8 @@
 #include <QApplication>
 #include <QIcon>
 #include <QRegularExpression>
+
+#include <limits>
 using namespace Qt::Literals::StringLiterals;
 
 
@@ -35,6 +37,7 @@ QPixmap* ResourceDataModelBase::mCommandIcon = nullptr;
 QPixmap* ResourceDataModelBase::mEmailIcon   = nullptr;
 QPixmap* ResourceDataModelBase::mAudioIcon   = nullptr;
 QSize    ResourceDataModelBase::mIconSize;
+int      ResourceDataModelBase::mSortKeyGeneration = 0;
 
 /******************************************************************************
 * Constructor.
@@ -228,7 +231,8 @@ QVariant ResourceDataModelBase::resourceData(int& role, const Resource& resource
 * Return the data for a given role, for a specified event.
 */
 QVariant ResourceDataModelBase::eventData(int role, int column, const KAEvent& event,
-                                          const Resource& resource, bool& handled) const
+                                          const Resource& resource, bool& handled,
+                                          EventTexts* texts) const
 {
     if (roleHandled(role))   // Ensure that roleHandled() is coded correctly
     {
@@ -422,9 +426,23 @@ QVariant ResourceDataModelBase::eventData(int role, int column, const KAEvent& e
                         break;
                     case Qt::DisplayRole:
                     case SortRole:
-                        return AlarmText::summary(event, 1);
+                        if (!texts)
+                            return AlarmText::summary(event, 1);
+                        if (!texts->haveSummary)
+                        {
+                            texts->summary = AlarmText::summary(event, 1);
+                            texts->haveSummary = true;
+                        }
+                        return texts->summary;
                     case Qt::ToolTipRole:
-                        return AlarmText::summary(event, 10);
+                        if (!texts)
+                            return AlarmText::summary(event, 10);
+                        if (!texts->haveTooltip)
+                        {
+                            texts->tooltip = AlarmText::summary(event, 10);
+                            texts->haveTooltip = true;
+                        }
+                        return texts->tooltip;
                     default:
                         break;
                 }
@@ -512,10 +530,118 @@ QString ResourceDataModelBase::repeatText(const KAEvent& event)
     return repText.isEmpty() ? event.repetitionText(true) : repText;
 }
 
+/******************************************************************************
+* Return an event's sort keys, evaluating them if necessary.
+*/
+const ResourceDataModelBase::EventSortKeys& ResourceDataModelBase::sortKeys(const KAEvent& event, EventSortKeys& keys, EventTexts* texts)
+{
+    if (keys.generation == mSortKeyGeneration)
+        return keys;
+
+    // Time column
+    const DateTime next = event.expired() ? DateTime() : event.nextTrigger(KAEvent::Trigger::Actual);
+    const DateTime due = event.expired() ? event.startDateTime() : next;
+    keys.time = due.isValid() ? due.effectiveKDateTime().toUtc().qDateTime().toMSecsSinceEpoch()
+                              : std::numeric_limits<qint64>::max();
+
+    // Time-to column: the time relative to now is evaluated when comparing.
+    if (event.expired())
+    {
+        keys.timeToType = EventSortKeys::TimeTo::Expired;
+        keys.timeTo     = 0;
+    }
+    else if (next.isDateOnly())
+    {
+        keys.timeToType = EventSortKeys::TimeTo::DateOnly;
+        keys.timeTo     = QDate(1970, 1, 1).daysTo(next.date());
+    }
+    else
+    {
+        keys.timeToType = EventSortKeys::TimeTo::Timed;
+        keys.timeTo     = next.effectiveKDateTime().toUtc().toSecsSinceEpoch();
+    }
+
+    keys.repeat = repeatOrderValue(event);
+    keys.colour = (event.actionTypes() == KAEvent::Action::Display) ? event.bgColour().rgb() : 0;
+    keys.type   = static_cast<int>(event.actionSubType());
+    keys.name   = event.name().toUpper();
+    if (texts)
+    {
+        if (!texts->haveSummary)
+        {
+            texts->summary = AlarmText::summary(event, 1);
+            texts->haveSummary = true;
+        }
+        keys.text = texts->summary;
+    }
+    else
+        keys.text = AlarmText::summary(event, 1);
+    keys.generation = mSortKeyGeneration;
+    return keys;
+}
+
+/******************************************************************************
+* Compare two events' sort keys for a column.
+*/
+bool ResourceDataModelBase::sortKeyLessThan(int column, const EventSortKeys& left, const EventSortKeys& right,
+                                            Qt::CaseSensitivity cs, bool& handled)
+{
+    handled = true;
+    switch (column)
+    {
+        case TimeColumn:
+            return left.time < right.time;
+        case TimeToColumn:
+        {
+            using TimeTo = EventSortKeys::TimeTo;
+            if (left.timeToType == TimeTo::Expired  ||  right.timeToType == TimeTo::Expired)
+                return left.timeToType == TimeTo::Expired  &&  right.timeToType != TimeTo::Expired;
+            if (left.timeToType == right.timeToType)
+                return left.timeTo < right.timeTo;
+            // One is date-only and the other has a time: compare the number
+            // of minutes from now, as for the SortRole value.
+            const KADateTime now = KADateTime::currentUtcDateTime();
+            auto minutesTo = [&now](const EventSortKeys& keys) -> qint64
+            {
+                if (keys.timeToType == TimeTo::DateOnly)
+                    return (keys.timeTo - QDate(1970, 1, 1).daysTo(now.date())) * 1440;
+                return (keys.timeTo - now.toSecsSinceEpoch() + 59) / 60;
+            };
+            return minutesTo(left) < minutesTo(right);
+        }
+        case RepeatColumn:
+            return left.repeat < right.repeat;
+        case ColourColumn:
+            return left.colour < right.colour;
+        case TypeColumn:
+            return left.type < right.type;
+        case NameColumn:
+        case TemplateNameColumn:
+            return left.name.compare(right.name, cs) < 0;
+        case TextColumn:
+            return left.text.compare(right.text, cs) < 0;
+        default:
+            handled = false;
+            return false;
+    }
+}
+
 /******************************************************************************
 * Return a string for sorting the repetition column.
 */
 QString ResourceDataModelBase::repeatOrder(const KAEvent& event)
+{
+    const qint64 value = repeatOrderValue(event);
+    const int repOrder    = static_cast<int>(value / 100000000);
+    const int repInterval = static_cast<int>(value % 100000000);
+    return QStringLiteral("%1%2").arg(static_cast<char>('0' + repOrder)).arg(repInterval, 8, 10, '0'_L1);
+}
+
+/******************************************************************************
+* Return a numeric value for sorting the Repeat column. It has the same order
+* as the string returned by repeatOrder().
+*/
+qint64 ResourceDataModelBase::repeatOrderValue(const KAEvent& event)
 {
     int repOrder = 0;
     int repInterval = 0;
@@ -548,7 +674,7 @@ QString ResourceDataModelBase::repeatOrder(const KAEvent& event)
                 break;
         }
     }
-    return QStringLiteral("%1%2").arg(static_cast<char>('0' + repOrder)).arg(repInterval, 8, 10, '0'_L1);
+    return static_cast<qint64>(repOrder) * 100000000 + repInterval;
 }
 
 /******************************************************************************
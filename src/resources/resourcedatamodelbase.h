@@ -12,6 +12,7 @@
 #include "preferences.h"
 #include "kalarmcalendar/kacalendar.h"
 
+#include <QSet>
 #include <QSize>
 
 class Resource;
@@ -93,6 +94,31 @@ public:
     /** Return the time-to-alarm text. */
     static QString timeToAlarmText(const DateTime&);
 
+    /** Values used to sort events by each column, which are costly to
+     *  evaluate. They are evaluated when first required, and are then held
+     *  until the event is changed.
+     */
+    struct EventSortKeys
+    {
+        enum class TimeTo { Expired, DateOnly, Timed };
+        qint64  time {0};            // next trigger time, in UTC milliseconds since epoch
+        qint64  timeTo {0};          // next trigger, in days since epoch if date-only, else UTC seconds
+        qint64  repeat {0};          // recurrence type and interval
+        quint32 colour {0};          // background colour
+        int     type {0};            // action sub-type
+        QString name;                // name, in upper case
+        QString text;                // single line alarm text summary
+        TimeTo  timeToType {TimeTo::Expired};  // type of value held in 'timeTo'
+        int     generation {-1};     // value of mSortKeyGeneration when evaluated
+    };
+
+    /** Compare two events' sort keys for a column, in the same order as
+     *  comparing their SortRole values.
+     *  @param handled  updated to true if the column has sort keys, else false.
+     */
+    static bool sortKeyLessThan(int column, const EventSortKeys& left, const EventSortKeys& right,
+                                Qt::CaseSensitivity, bool& handled);
+
 protected:
     ResourceDataModelBase();
 
@@ -125,6 +151,9 @@ protected:
     /** Update a resource's backend calendar file to the current KAlarm format. */
     virtual void updateCalendarToCurrentFormat(Resource&, bool ignoreKeepFormat, QObject* parent) = 0;
 
+    /** Set the events currently displayed in a view's time-to-alarm column. */
+    virtual void setTimeToVisibleEvents(const QObject* view, const QSet<QString>& eventIds) = 0;
+
     virtual ResourceListModel* createResourceListModel(QObject* parent) = 0;
     virtual ResourceFilterCheckListModel* createResourceFilterCheckListModel(QObject* parent) = 0;
     virtual AlarmListModel*    createAlarmListModel(QObject* parent) = 0;
@@ -146,10 +175,36 @@ protected:
      */
     QVariant resourceData(int& role, const Resource&, bool& handled) const;
 
+    /** Texts derived from an event's alarm text, which are costly to
+     *  evaluate. Each is evaluated when first required, and is then held
+     *  until the event is changed.
+     */
+    struct EventTexts
+    {
+        QString summary;                 // single line summary, also used for sorting
+        QString tooltip;                 // multi-line summary, for tooltip
+        bool    haveSummary {false};     // 'summary' has been evaluated
+        bool    haveTooltip {false};     // 'tooltip' has been evaluated
+    };
+
     /** Return the model data for an event.
      *  @param handled  updated to true if the reply is valid, else set to false.
+     *  @param texts    if non-null, holds the event's cached texts, which are
+     *                  used or updated as necessary.
+     */
+    QVariant eventData(int role, int column, const KAEvent& event, const Resource&, bool& handled,
+                       EventTexts* texts = nullptr) const;
+
+    /** Return an event's sort keys, evaluating them if they are not already
+     *  held in @p keys or are out of date.
+     *  @param texts  if non-null, holds the event's cached texts.
+     */
+    static const EventSortKeys& sortKeys(const KAEvent& event, EventSortKeys& keys, EventTexts* texts = nullptr);
+
+    /** Mark all events' sort keys as out of date, when a setting which
+     *  affects alarm trigger times has changed.
      */
-    QVariant eventData(int role, int column, const KAEvent& event, const Resource&, bool& handled) const;
+    static void invalidateSortKeys()   { ++mSortKeyGeneration; }
 
     /** Called when a resource notifies a message to display to the user. */
     void handleResourceMessage(ResourceType::MessageType, const QString& message, const QString& details);
@@ -171,6 +226,7 @@ protected:
 
     static QString  repeatText(const KAEvent&);
     static QString  repeatOrder(const KAEvent&);
+    static qint64   repeatOrderValue(const KAEvent&);
     static QString  whatsThisText(int column);
     static QPixmap* eventIcon(const KAEvent&);
 
@@ -183,6 +239,7 @@ private:
     static QPixmap* mEmailIcon;
     static QPixmap* mAudioIcon;
     static QSize    mIconSize;      // maximum size of any icon
+    static int      mSortKeyGeneration;  // incremented when all sort keys become out of date
 
     int  mMigrationStatus {-1};     // migration status, -1 = no, 0 = initiated, 1 = complete
     bool mCreationStatus {false};   // previously configured calendar creation status
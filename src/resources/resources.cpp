@@ -25,6 +25,7 @@ QHash<ResourceId, Resource> Resources::mResources;
 
 bool Resources::mCreated {false};
 bool Resources::mPopulated {false};
+QHash<const QObject*, CalEvent::Types> Resources::mDeferredHolders;
 
 
 Resources* Resources::instance()
@@ -370,6 +371,75 @@ void Resources::adjustStartOfDay()
         it.value().adjustStartOfDay();
 }
 
+/******************************************************************************
+* Called when alarms of a given type are about to be displayed or searched.
+* Load any of their events whose loading has been deferred.
+* If 'holder' is specified, record that it needs the events until it is
+* destroyed or releases them.
+*/
+void Resources::loadDeferredEvents(CalEvent::Type type, const QObject* holder)
+{
+    if (holder)
+    {
+        auto it = mDeferredHolders.find(holder);
+        if (it == mDeferredHolders.end())
+        {
+            connect(holder, &QObject::destroyed, instance(), [holder]() { mDeferredHolders.remove(holder); });
+            mDeferredHolders[holder] = type;
+        }
+        else
+            it.value() |= type;
+    }
+    const QList<Resource> resources = enabledResources(type);
+    for (Resource resource : resources)
+        resource.loadDeferredEvents();
+}
+
+/******************************************************************************
+* Record that 'holder' no longer needs events of the specified alarm type.
+*/
+void Resources::releaseDeferredEvents(const QObject* holder, CalEvent::Type type)
+{
+    auto it = mDeferredHolders.find(holder);
+    if (it != mDeferredHolders.end())
+    {
+        it.value() &= ~type;
+        if (!it.value())
+        {
+            mDeferredHolders.erase(it);
+            disconnect(holder, &QObject::destroyed, instance(), nullptr);
+        }
+    }
+}
+
+/******************************************************************************
+* Return whether any object currently needs events of the specified types.
+*/
+bool Resources::deferredEventsHeld(CalEvent::Types types)
+{
+    for (auto it = mDeferredHolders.constBegin();  it != mDeferredHolders.constEnd();  ++it)
+    {
+        if (it.value() & types)
+            return true;
+    }
+    return false;
+}
+
+/******************************************************************************
+* Return whether any enabled resource for an alarm type has deferred loading
+* its events.
+*/
+bool Resources::haveDeferredEvents(CalEvent::Type type)
+{
+    const QList<Resource> resources = enabledResources(type);
+    for (const Resource& resource : resources)
+    {
+        if (resource.isLoadDeferred())
+            return true;
+    }
+    return false;
+}
+
 /******************************************************************************
 * Called after a new resource has been created, when it has completed its
 * initialisation.
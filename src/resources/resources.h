@@ -162,6 +162,31 @@ public:
      */
     static void adjustStartOfDay();
 
+    /** To be called when alarms of a given type are about to be displayed or
+     *  searched, to load any of their events whose loading has been deferred
+     *  until they are needed.
+     *  @param type    alarm type which is needed.
+     *  @param holder  if non-null, the events are needed for as long as
+     *                 @p holder exists, or until releaseDeferredEvents() is
+     *                 called for it. Otherwise, they are needed only briefly.
+     */
+    static void loadDeferredEvents(CalEvent::Type type, const QObject* holder = nullptr);
+
+    /** Notify that alarms of a given type are no longer needed by @p holder,
+     *  so that resources which defer loading may unload them when idle.
+     */
+    static void releaseDeferredEvents(const QObject* holder, CalEvent::Type type);
+
+    /** Return whether alarms of any of the specified types are currently
+     *  held by a caller of loadDeferredEvents().
+     */
+    static bool deferredEventsHeld(CalEvent::Types types);
+
+    /** Return whether any enabled resource for an alarm type has deferred
+     *  loading its events, so that they may exist although not loaded.
+     */
+    static bool haveDeferredEvents(CalEvent::Type type);
+
     /** Called to notify that a new resource has completed its initialisation,
      *  in order to emit the resourceAdded() signal. */
     static void notifyNewResourceInitialised(Resource&);
@@ -309,6 +334,7 @@ private:
     static QHash<ResourceId, Resource> mResources;   // contains all ResourceType instances with an ID
     static bool                        mCreated;     // all resources have been created
     static bool                        mPopulated;   // all resources have been loaded once
+    static QHash<const QObject*, CalEvent::Types> mDeferredHolders;  // objects needing alarm types to be loaded
 
     friend class ResourceType;
 };
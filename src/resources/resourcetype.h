@@ -331,6 +331,26 @@ public:
      */
     virtual bool isPopulated() const   { return mLoaded; }
 
+    /** Load any events whose loading the resource has deferred until they
+     *  are actually needed, e.g. older segments of a segmented archive.
+     *  The default implementation does nothing.
+     */
+    virtual void loadDeferredEvents()  {}
+
+    /** Return whether the resource has deferred loading some or all of its
+     *  events until they are actually needed.
+     */
+    virtual bool isLoadDeferred() const   { return false; }
+
+    /** Prepare for purging archived events created before @p cutoff.
+     *  Any stored segments of the resource which contain only such events are
+     *  deleted without being loaded, and any other archived events which may
+     *  need to be purged are loaded if their loading has been deferred.
+     *  The default implementation does nothing.
+     *  @return number of events deleted which were currently loaded.
+     */
+    virtual int prepareArchivePurge(const QDate& cutoff)  { Q_UNUSED(cutoff); return 0; }
+
     /** Save the resource.
      *  Saving is not performed if the resource is disabled.
      *  If the resource is cached, it will be saved to the cache file (which
@@ -0,0 +1,436 @@
+/*
+ *  segmentedfileresource.cpp  -  archived alarm calendar held in monthly segment files
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "segmentedfileresource.h"
+
+#include "resources.h"
+#include "kalarmcalendar/kacalendar.h"
+#include "kalarmcalendar/kaevent.h"
+#include "kalarm_debug.h"
+
+#include <KCalendarCore/ICalFormat>
+
+#include <KLocalizedString>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTimeZone>
+using namespace Qt::Literals::StringLiterals;
+
+using namespace KAlarmCal;
+
+namespace
+{
+const QString SEGMENT_MONTH_FORMAT(QStringLiteral("yyyy-MM"));   // date format in segment file names
+}
+
+Resource SegmentedFileResource::create(FileResourceSettings::Ptr settings)
+{
+    if (!settings  ||  !settings->isValid())
+        return Resource::null();    // return invalid Resource
+    if (!settings->segmented()
+    ||  !settings->url().isLocalFile()
+    ||  settings->alarmTypes() != CalEvent::ARCHIVED)
+    {
+        if (settings->segmented())
+            qCWarning(KALARM_LOG) << "SegmentedFileResource::create: Segmented storage is only available for local archived alarm files:" << settings->displayLocation();
+        return SingleFileResource::create(settings);
+    }
+    Resource resource = Resources::resource(settings->id());
+    if (!resource.isValid())
+    {
+        // A resource with this ID doesn't exist, so create a new resource.
+        addResource(new SegmentedFileResource(settings), resource);
+    }
+    return resource;
+}
+
+/******************************************************************************
+* Constructor.
+* The base class constructor loads the current file. Segment files are only
+* listed here, not read.
+*/
+SegmentedFileResource::SegmentedFileResource(FileResourceSettings::Ptr settings)
+    : SingleFileResource(settings)
+{
+    qCDebug(KALARM_LOG) << "SegmentedFileResource: Starting" << displayName();
+    findSegments();
+    rollOver();
+}
+
+/******************************************************************************
+* Destructor.
+*/
+SegmentedFileResource::~SegmentedFileResource()
+{
+    qCDebug(KALARM_LOG) << "SegmentedFileResource::~SegmentedFileResource" << displayName();
+    QString errorMessage;
+    saveSegments(errorMessage);
+}
+
+/******************************************************************************
+* Read all segment files which have not already been read, and add their
+* events to the resource.
+*/
+void SegmentedFileResource::loadDeferredEvents()
+{
+    SingleFileResource::loadDeferredEvents();
+    if (mSegmentsLoaded  ||  !isEnabled(CalEvent::ARCHIVED))
+        return;
+    qCDebug(KALARM_LOG) << "SegmentedFileResource::loadDeferredEvents:" << displayId() << mSegments.count() << "segments";
+    mSegmentsLoaded = true;
+    QHash<QString, KAEvent> events;
+    for (auto it = mSegments.begin();  it != mSegments.end();  ++it)
+    {
+        if (!it.value().calendar)
+            openSegment(it.key(), it.value(), events);
+    }
+    if (!events.isEmpty())
+        setUpdatedEvents(events.values());
+}
+
+/******************************************************************************
+* Delete the segment files whose events were all created before 'cutoff'.
+* Segment files are deleted without being read. Only the events from segment
+* files which have already been read need to be removed from the resource.
+* The current file is loaded if necessary, but other segment files are not.
+*/
+int SegmentedFileResource::prepareArchivePurge(const QDate& cutoff)
+{
+    FileResource::loadDeferredEvents();
+    if (!isWritable(CalEvent::ARCHIVED)  ||  writeInhibited())
+        return 0;
+    rollOver();   // ensure that previous months' events are not in the current file
+
+    QList<KAEvent> deleted;
+    for (auto it = mSegments.begin();  it != mSegments.end()  &&  it.key().addMonths(1) <= cutoff;  )
+    {
+        if (QFile::exists(it.value().fileName)  &&  !QFile::remove(it.value().fileName))
+        {
+            qCWarning(KALARM_LOG) << "SegmentedFileResource::prepareArchivePurge:" << displayId() << "Error deleting" << it.value().fileName;
+            ++it;
+            continue;
+        }
+        qCDebug(KALARM_LOG) << "SegmentedFileResource::prepareArchivePurge:" << displayId() << "Deleted" << it.value().fileName;
+        if (it.value().calendar)
+        {
+            const KCalendarCore::Event::List kcalEvents = it.value().calendar->rawEvents();
+            for (const KCalendarCore::Event::Ptr& kcalEvent : kcalEvents)
+            {
+                const QString id = kcalEvent->uid();
+                const KAEvent event = ResourceType::event(id, true);
+                if (event.isValid())
+                    deleted += event;
+                mSegmentEvents.remove(id);
+            }
+        }
+        it = mSegments.erase(it);
+    }
+    if (!deleted.isEmpty())
+        setDeletedEvents(deleted);
+    return deleted.count();
+}
+
+/******************************************************************************
+* Close the resource.
+*/
+void SegmentedFileResource::close()
+{
+    QString errorMessage;
+    saveSegments(errorMessage);
+    mSegments.clear();
+    mSegmentEvents.clear();
+    SingleFileResource::close();
+}
+
+/******************************************************************************
+* Load the current file. The events from any segment files which have already
+* been read are included, so that they are retained by the resource.
+*/
+int SegmentedFileResource::doLoad(QHash<QString, KAEvent>& newEvents, bool readThroughCache, QString& errorMessage)
+{
+    const int result = SingleFileResource::doLoad(newEvents, readThroughCache, errorMessage);
+    if (result == 1)
+    {
+        findSegments();
+        for (auto it = mSegments.constBegin();  it != mSegments.constEnd();  ++it)
+        {
+            if (it.value().calendar)
+            {
+                const KCalendarCore::Event::List kcalEvents = it.value().calendar->rawEvents();
+                for (const KCalendarCore::Event::Ptr& kcalEvent : kcalEvents)
+                {
+                    const KAEvent event = ResourceType::event(kcalEvent->uid(), true);
+                    if (event.isValid())
+                        newEvents[event.id()] = event;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/******************************************************************************
+* Discard the loaded data for the current file and all segment files, after the
+* events have not been needed for a while. Any changes have already been saved.
+*/
+void SegmentedFileResource::doUnload()
+{
+    for (auto it = mSegments.begin();  it != mSegments.end();  ++it)
+    {
+        it.value().calendar.reset();
+        it.value().fileStorage.reset();
+    }
+    mSegmentEvents.clear();
+    mSegmentsLoaded = false;
+    mCurrentMonth = QDate();   // check for roll-over again once reloaded
+    SingleFileResource::doUnload();
+}
+
+/******************************************************************************
+* Save the current file, and any modified segment files.
+*/
+int SegmentedFileResource::doSave(bool writeThroughCache, bool force, QString& errorMessage)
+{
+    if (!saveSegments(errorMessage))
+    {
+        setStatus(Status::Broken);
+        return -1;
+    }
+    return SingleFileResource::doSave(writeThroughCache, force, errorMessage);
+}
+
+/******************************************************************************
+* Called from addEvent() to add an event to the resource.
+* New events always go into the current file.
+*/
+bool SegmentedFileResource::doAddEvent(const KAEvent& event)
+{
+    rollOver();
+    return SingleFileResource::doAddEvent(event);
+}
+
+/******************************************************************************
+* Called from addEvent() to add an event to the resource when loading has been
+* deferred. Roll-over needs the current file to be loaded, so only append the
+* event to it if roll-over has already been done this month.
+*/
+bool SegmentedFileResource::doAppendEvent(const KAEvent& event)
+{
+    const QDate today = KADateTime::currentLocalDate();
+    if (mRolledOverMonth != QDate(today.year(), today.month(), 1))
+        return false;
+    return SingleFileResource::doAppendEvent(event);
+}
+
+/******************************************************************************
+* Called from updateEvent() to update an event in the resource.
+*/
+bool SegmentedFileResource::doUpdateEvent(const KAEvent& event)
+{
+    auto evit = mSegmentEvents.constFind(event.id());
+    if (evit == mSegmentEvents.constEnd())
+        return SingleFileResource::doUpdateEvent(event);
+
+    auto it = mSegments.find(evit.value());
+    const KCalendarCore::Event::Ptr kcalEvent = (it != mSegments.end()  &&  it.value().calendar)
+                                              ? it.value().calendar->event(event.id()) : KCalendarCore::Event::Ptr();
+    if (!kcalEvent)
+    {
+        qCWarning(KALARM_LOG) << "SegmentedFileResource::doUpdateEvent:" << displayId() << "Event not found" << event.id();
+        return false;
+    }
+    it.value().calendar->deleteEventInstances(kcalEvent);
+    event.updateKCalEvent(kcalEvent, KAEvent::UidAction::Set);
+    it.value().calendar->setModified(true);
+    return true;
+}
+
+/******************************************************************************
+* Called from deleteEvent() to delete an event from the resource.
+*/
+bool SegmentedFileResource::doDeleteEvent(const KAEvent& event)
+{
+    auto evit = mSegmentEvents.find(event.id());
+    if (evit == mSegmentEvents.end())
+        return SingleFileResource::doDeleteEvent(event);
+
+    auto it = mSegments.find(evit.value());
+    mSegmentEvents.erase(evit);
+    const KCalendarCore::Event::Ptr kcalEvent = (it != mSegments.end()  &&  it.value().calendar)
+                                              ? it.value().calendar->event(event.id()) : KCalendarCore::Event::Ptr();
+    if (!kcalEvent  ||  !it.value().calendar->deleteEvent(kcalEvent))
+    {
+        qCWarning(KALARM_LOG) << "SegmentedFileResource::doDeleteEvent:" << displayId() << "Event not found" << event.id();
+        return false;
+    }
+    return true;
+}
+
+/******************************************************************************
+* Return the name of the segment file for a given month.
+*/
+QString SegmentedFileResource::segmentFileName(const QDate& month) const
+{
+    const QFileInfo fi(mSettings->url().toLocalFile());
+    const QString suffix = fi.suffix();
+    return fi.path() + '/'_L1 + fi.completeBaseName() + '-'_L1 + month.toString(SEGMENT_MONTH_FORMAT)
+         + (suffix.isEmpty() ? QString() : '.'_L1 + suffix);
+}
+
+/******************************************************************************
+* Find the segment files which exist for the resource, without reading them.
+*/
+void SegmentedFileResource::findSegments()
+{
+    if (!mSettings)
+        return;
+    const QFileInfo fi(mSettings->url().toLocalFile());
+    const QString prefix = fi.completeBaseName() + '-'_L1;
+    const QString suffix = fi.suffix().isEmpty() ? QString() : '.'_L1 + fi.suffix();
+    const QStringList files = fi.dir().entryList({prefix + "????-??"_L1 + suffix}, QDir::Files);
+    for (const QString& file : files)
+    {
+        const QDate month = QDate::fromString(file.mid(prefix.length(), SEGMENT_MONTH_FORMAT.length()), SEGMENT_MONTH_FORMAT);
+        if (month.isValid()  &&  !mSegments.contains(month))
+            mSegments[month].fileName = fi.path() + '/'_L1 + file;
+    }
+}
+
+/******************************************************************************
+* Read a segment file, and fetch its events into 'events'. If the file doesn't
+* exist, an empty calendar is created for it.
+*/
+bool SegmentedFileResource::openSegment(const QDate& month, Segment& segment, QHash<QString, KAEvent>& events)
+{
+    qCDebug(KALARM_LOG) << "SegmentedFileResource::openSegment:" << displayId() << segment.fileName;
+    segment.calendar.reset(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+    segment.fileStorage.reset(new KCalendarCore::FileStorage(segment.calendar, segment.fileName, new KCalendarCore::ICalFormat()));
+    if (QFile::exists(segment.fileName)  &&  !segment.fileStorage->load())
+    {
+        qCCritical(KALARM_LOG) << "SegmentedFileResource::openSegment: Error loading file " << segment.fileName;
+        segment.fileStorage.reset();
+        segment.calendar.reset();
+        return false;
+    }
+    if (segment.calendar->incidences().isEmpty())
+        KACalendar::setKAlarmVersion(segment.calendar);
+
+    const KCalendarCore::Event::List kcalEvents = segment.calendar->rawEvents();
+    for (const KCalendarCore::Event::Ptr& kcalEvent : kcalEvents)
+    {
+        KAEvent event(kcalEvent);
+        if (!event.isValid())
+            continue;
+        event.setResourceId(mSettings->id());
+        event.setCompatibility(mCompatibility);
+        mSegmentEvents[event.id()] = month;
+        events[event.id()] = event;
+    }
+    segment.calendar->setModified(false);
+    return true;
+}
+
+/******************************************************************************
+* Write all modified segment files. A segment file which no longer contains any
+* events is deleted.
+*/
+bool SegmentedFileResource::saveSegments(QString& errorMessage)
+{
+    bool success = true;
+    for (auto it = mSegments.begin();  it != mSegments.end();  )
+    {
+        Segment& segment = it.value();
+        if (!segment.calendar  ||  !segment.calendar->isModified())
+        {
+            ++it;
+            continue;
+        }
+        if (segment.calendar->rawEvents().isEmpty())
+        {
+            qCDebug(KALARM_LOG) << "SegmentedFileResource::saveSegments:" << displayId() << "Deleting empty segment" << segment.fileName;
+            QFile::remove(segment.fileName);
+            it = mSegments.erase(it);
+            continue;
+        }
+        KACalendar::setKAlarmVersion(segment.calendar);
+        if (!segment.fileStorage->save())    // this sets calendar->modified to false
+        {
+            qCCritical(KALARM_LOG) << "SegmentedFileResource::saveSegments:" << displayId() << "Failed to save calendar to file " << segment.fileName;
+            errorMessage = xi18nc("@info", "Could not save file <filename>%1</filename>.", segment.fileName);
+            success = false;
+        }
+        ++it;
+    }
+    return success;
+}
+
+/******************************************************************************
+* If the month has changed since the last check, move all events created in
+* previous months out of the current file into their monthly segment files.
+*/
+void SegmentedFileResource::rollOver()
+{
+    const QDate today = KADateTime::currentLocalDate();
+    const QDate month(today.year(), today.month(), 1);
+    if (month == mCurrentMonth  ||  isLoadDeferred()  ||  !isWritable(CalEvent::ARCHIVED))
+        return;
+    mCurrentMonth = month;
+    mRolledOverMonth = month;
+
+    QHash<QString, KAEvent> segmentEvents;   // events newly read from segment files
+    int moved = 0;
+    const QList<KAEvent> evnts = events();
+    for (const KAEvent& event : evnts)
+    {
+        if (mSegmentEvents.contains(event.id()))
+            continue;   // the event is already in a segment file
+        const QDate evMonth = segmentMonth(event);
+        if (!evMonth.isValid()  ||  evMonth >= month)
+            continue;
+
+        Segment& segment = mSegments[evMonth];
+        if (!segment.calendar)
+        {
+            if (segment.fileName.isEmpty())
+                segment.fileName = segmentFileName(evMonth);
+            if (!openSegment(evMonth, segment, segmentEvents))
+                continue;
+        }
+        KCalendarCore::Event::Ptr kcalEvent(new KCalendarCore::Event);
+        event.updateKCalEvent(kcalEvent, KAEvent::UidAction::Set);
+        if (!segment.calendar->addEvent(kcalEvent))
+            continue;
+        SingleFileResource::doDeleteEvent(event);   // remove from the current file
+        mSegmentEvents[event.id()] = evMonth;
+        ++moved;
+    }
+
+    if (moved)
+    {
+        qCDebug(KALARM_LOG) << "SegmentedFileResource::rollOver:" << displayId() << "Moved" << moved << "events to segment files";
+        scheduleSave();
+    }
+    if (!segmentEvents.isEmpty())
+        setUpdatedEvents(segmentEvents.values());
+}
+
+/******************************************************************************
+* Return the first day of the month in which an event was created, which
+* determines the segment which holds it.
+*/
+QDate SegmentedFileResource::segmentMonth(const KAEvent& event)
+{
+    const QDate created = event.createdDateTime().date();
+    return created.isValid() ? QDate(created.year(), created.month(), 1) : QDate();
+}
+
+#include "moc_segmentedfileresource.cpp"
+
+// vim: et sw=4:
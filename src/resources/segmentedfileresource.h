@@ -0,0 +1,128 @@
+/*
+ *  segmentedfileresource.h  -  archived alarm calendar held in monthly segment files
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "singlefileresource.h"
+
+#include <QDate>
+#include <QMap>
+
+using namespace KAlarmCal;
+
+/**
+ * Archived alarm calendar resource stored in a local file, whose older events
+ * are held in separate monthly segment files alongside it.
+ *
+ * The resource's configured file holds archived events created in the current
+ * month. At the start of each month, events created in earlier months are
+ * moved into the segment file for the month of their creation, named
+ * <base>-YYYY-MM.<suffix>. New archived events are therefore only ever written
+ * to the small current file, and purging old archived events deletes whole
+ * segment files without reading them.
+ *
+ * Segment files are only read when archived alarms are displayed (see
+ * loadDeferredEvents()), or when an event needs to be moved into one of them.
+ * Like the current file, they are unloaded again once no longer needed.
+ * Expired segments are deleted by prepareArchivePurge(), which is called
+ * before archived alarms are purged.
+ *
+ * Segmented storage is enabled for a resource by setting the key
+ *     Segmented=true
+ * in its Resource_N group in the 'kalarmresources' config file, while KAlarm
+ * is not running, as described in the handbook. It only takes effect for a
+ * local file containing only archived alarms; any other resource with the key
+ * set is handled as an ordinary SingleFileResource. Removing the key again
+ * leaves any existing segment files unread, so their archived alarms will no
+ * longer be shown.
+ */
+class SegmentedFileResource : public SingleFileResource
+{
+    Q_OBJECT
+public:
+    /** Construct a new SegmentedFileResource, if @p settings specify a
+     *  segmented archived alarm calendar in a local file. Otherwise, construct
+     *  a new SingleFileResource.
+     *  Initialises the resource and initiates loading its events.
+     */
+    static Resource create(FileResourceSettings::Ptr settings);
+
+protected:
+    /** Constructor.
+     *  Initialises the resource and initiates loading its events.
+     */
+    explicit SegmentedFileResource(FileResourceSettings::Ptr settings);
+
+public:
+    ~SegmentedFileResource() override;
+
+    /** Load the current file if its loading has been deferred, and the events
+     *  in all segment files which have not yet been read.
+     */
+    void loadDeferredEvents() override;
+
+    /** Delete all segment files containing only events created before
+     *  @p cutoff, and load the current file if its loading has been deferred.
+     *  @return number of loaded events deleted.
+     */
+    int prepareArchivePurge(const QDate& cutoff) override;
+
+    /** Close the resource. This saves any unsaved data. */
+    void close() override;
+
+protected:
+    /** Load the current file, together with any segment files which have
+     *  already been read.
+     */
+    int doLoad(QHash<QString, KAEvent>& newEvents, bool readThroughCache, QString& errorMessage) override;
+
+    /** Discard the loaded data for the current file and all segment files. */
+    void doUnload() override;
+
+    /** Save the current file and any segment files which have been modified. */
+    int doSave(bool writeThroughCache, bool force, QString& errorMessage) override;
+
+    /** Add an event to the current file, after first moving any events from
+     *  previous months out of it.
+     */
+    bool doAddEvent(const KAEvent&) override;
+
+    /** Append an event to the current file without loading it, provided
+     *  that no roll-over of events into segment files is due.
+     */
+    bool doAppendEvent(const KAEvent&) override;
+
+    /** Update an event in whichever file holds it. */
+    bool doUpdateEvent(const KAEvent&) override;
+
+    /** Delete an event from whichever file holds it. */
+    bool doDeleteEvent(const KAEvent&) override;
+
+private:
+    struct Segment
+    {
+        QString                            fileName;
+        KCalendarCore::MemoryCalendar::Ptr calendar;   // null if the file hasn't been read
+        KCalendarCore::FileStorage::Ptr    fileStorage;
+    };
+
+    QString segmentFileName(const QDate& month) const;
+    void    findSegments();
+    bool    openSegment(const QDate& month, Segment&, QHash<QString, KAEvent>& events);
+    bool    saveSegments(QString& errorMessage);
+    void    rollOver();
+    static QDate segmentMonth(const KAEvent&);
+
+    QMap<QDate, Segment>  mSegments;      // segment files, indexed by first day of month
+    QHash<QString, QDate> mSegmentEvents; // loaded events held in segment files, and their segment
+    QDate                 mCurrentMonth;  // first day of month held in the current file
+    QDate                 mRolledOverMonth;  // month for which roll-over has been done (kept when unloaded)
+    bool                  mSegmentsLoaded {false};  // all segment files have been read
+};
+
+// vim: et sw=4:
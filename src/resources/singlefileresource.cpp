@@ -2,7 +2,7 @@
  *  singlefileresource.cpp  -  calendar resource held in a single file
  *  Program:  kalarm
  *  Partly based on ICalResourceBase and SingleFileResource in kdepim-runtime.
- *  SPDX-FileCopyrightText: 2009-2025 David Jarvie <djarvie@kde.org>
+ *  SPDX-FileCopyrightText: 2009-2026 David Jarvie <djarvie@kde.org>
  *  SPDX-FileCopyrightText: 2008 Bertjan Broeksema <broeksema@kde.org>
  *  SPDX-FileCopyrightText: 2008 Volker Krause <vkrause@kde.org>
  *  SPDX-FileCopyrightText: 2006 Till Adam <adam@kde.org>
@@ -12,9 +12,11 @@
 
 #include "singlefileresource.h"
 
+#include "calendarconverter.h"
 #include "resources.h"
 #include "kalarmcalendar/kacalendar.h"
 #include "kalarmcalendar/kaevent.h"
+#include "lib/file.h"
 #include "kalarm_debug.h"
 
 #include <KCalendarCore/ICalFormat>
@@ -32,6 +34,8 @@
 #include <QTimer>
 #include <QTimeZone>
 #include <QEventLoopLocker>
+
+#include <algorithm>
 using namespace Qt::Literals::StringLiterals;
 
 using namespace KCalendarCore;
@@ -115,6 +119,14 @@ bool SingleFileResource::updateStorageFmt()
         qCCritical(KALARM_LOG) << "SingleFileResource::updateStorageFormat:" << displayId() << "Calendar not open";
         return false;
     }
+    if (mConverter)
+    {
+        // Events are still being converted to the current format.
+        // Update the storage once they have all been converted.
+        qCDebug(KALARM_LOG) << "SingleFileResource::updateStorageFormat:" << displayId() << "Deferred until conversion is complete";
+        mUpdateFormatPending = true;
+        return true;
+    }
 
     QString versionString;
     if (KACalendar::updateVersion(mFileStorage, versionString) != KACalendar::CurrentFormat)
@@ -127,6 +139,7 @@ bool SingleFileResource::updateStorageFmt()
     mCompatibility = KACalendar::Current;
     mVersion = KACalendar::CurrentFormat;
     save(nullptr, true, true);
+    CalendarConverter::discardProgress(conversionProgressDir());
 
     mSettings->setUpdateFormat(false);
     mSettings->save();
@@ -296,6 +309,56 @@ int SingleFileResource::doLoad(QHash<QString, KAEvent>& newEvents, bool readThro
     return 1;     // success
 }
 
+/******************************************************************************
+* Called by load() to determine whether loading can be deferred until the
+* events are needed. This is only done for an existing local file in the
+* current KAlarm format, which doesn't need to be converted or created. Only
+* the calendar header is read, to find its KAlarm format version.
+*/
+bool SingleFileResource::deferLoad()
+{
+    if (!mSettings  ||  !mSettings->url().isLocalFile())
+        return false;
+    const QString fileName = mSettings->url().toLocalFile();
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    static const QByteArray versionProperty = "X-KDE-" + KACalendar::APPNAME + "-VERSION:";
+    while (!file.atEnd())
+    {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.startsWith("BEGIN:VEVENT"))
+            break;   // the calendar header has ended
+        if (line.startsWith(versionProperty))
+        {
+            if (line.mid(versionProperty.size()) != KAEvent::currentCalendarVersionString())
+                break;
+            mCompatibility = KACalendar::Current;
+            mVersion       = KACalendar::CurrentFormat;
+            mFileReadOnly  = !QFileInfo(fileName).isWritable();
+            return true;
+        }
+    }
+    return false;
+}
+
+/******************************************************************************
+* Discard the loaded calendar data, after the events have not been needed for a
+* while. Any changes have already been saved.
+*/
+void SingleFileResource::doUnload()
+{
+    qCDebug(KALARM_LOG) << "SingleFileResource::doUnload:" << displayId();
+    stopConversion();
+    if (mSettings  &&  mSettings->url().isLocalFile())
+        KDirWatch::self()->removeFile(mSettings->url().toLocalFile());
+    mLoadedEvents.clear();
+    mCalendar.reset();      // ensure that load() re-reads the file
+    mFileStorage.reset();
+    mJournalLoaded = false;
+}
+
 /******************************************************************************
 * Called when loading fails.
 * If the resource file doesn't exist or can't be created, the resource is still
@@ -324,6 +387,19 @@ int SingleFileResource::doSave(bool writeThroughCache, bool force, QString& erro
 
     if (!force  &&  mCalendar  &&  !mCalendar->isModified())
         return 1;    // there are no changes to save
+    if (mConverter)
+    {
+        // Don't save a calendar which is only partly converted to the current
+        // format. The calendar remains modified, and is saved once the
+        // background conversion has finished.
+        qCDebug(KALARM_LOG) << "SingleFileResource::save:" << displayId() << "Deferred until conversion is complete";
+        mSaveAfterConversion      = true;
+        mSaveAfterConversionCache = mSaveAfterConversionCache || writeThroughCache;
+        mSaveAfterConversionForce = mSaveAfterConversionForce || force;
+        return 0;
+    }
+    if (!mCalendar  &&  isLoadDeferred())
+        return 1;    // the calendar hasn't been loaded, so there is nothing to save
 
     if (mSaveUrl.isEmpty())
     {
@@ -379,6 +455,12 @@ int SingleFileResource::doSave(bool writeThroughCache, bool force, QString& erro
         setStatus(Status::Broken);
         return -1;
     }
+    if (mJournalLoaded)
+    {
+        // The journal's events are now in the calendar file.
+        QFile::remove(journalPath());
+        mJournalLoaded = false;
+    }
 
     if (!isLocalFile  &&  writeThroughCache)
     {
@@ -425,13 +507,22 @@ void SingleFileResource::close()
     if (mDownloadJob)
         mDownloadJob->kill();
 
+    if (mConverter)
+    {
+        // Complete any background conversion now, so that the calendar can be
+        // saved. This saves the calendar if a save was deferred.
+        mConverter->finish();
+    }
     save(nullptr, true);   // write through cache
+    if (mSettings)
+        mSettings->saveCommandErrors();
     // If a remote file upload job has been started, the use of QEventLoopLocker
     // in doSave() should ensure that it continues to completion even if the
     // destructor for this instance is executed.
 
     if (mSettings  &&  mSettings->url().isLocalFile())
         KDirWatch::self()->removeFile(mSettings->url().toLocalFile());
+    stopConversion();
     mCalendar.reset();
     mFileStorage.reset();
     setStatus(Status::Closed);
@@ -468,6 +559,99 @@ bool SingleFileResource::doAddEvent(const KAEvent& event)
     return addLoadedEvent(kcalEvent);
 }
 
+/******************************************************************************
+* Called from addEvent() to add an event to the resource when loading has been
+* deferred. Append the event to the resource's journal file, without reading
+* the calendar file. The calendar file itself is not touched, so that a failure
+* while writing can never damage it; the journal is merged into it the next
+* time the calendar is loaded and saved.
+* This is only done for a local file, which deferLoad() has found to be in the
+* current KAlarm format.
+*/
+bool SingleFileResource::doAppendEvent(const KAEvent& event)
+{
+    if (mCalendar  ||  !mSettings  ||  !mSettings->url().isLocalFile()  ||  mCompatibility != KACalendar::Current
+    ||  mFileReadOnly)
+        return false;
+    const QString path = journalPath();
+    QDir().mkpath(QFileInfo(path).path());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qCWarning(KALARM_LOG) << "SingleFileResource::appendEvent:" << displayId() << "Error opening" << path;
+        return false;
+    }
+
+    KCalendarCore::Event::Ptr kcalEvent(new KCalendarCore::Event);
+    event.updateKCalEvent(kcalEvent, KAEvent::UidAction::Set);
+    QByteArray record = KCalendarCore::ICalFormat().toICalString(kcalEvent).toUtf8().toBase64();
+    record.append('\n');
+    if (file.write(record) != record.size()  ||  !File::sync(file))
+    {
+        qCWarning(KALARM_LOG) << "SingleFileResource::appendEvent:" << displayId() << "Error writing" << path;
+        return false;
+    }
+    qCDebug(KALARM_LOG) << "SingleFileResource::appendEvent:" << displayId() << event.id();
+    return true;
+}
+
+/******************************************************************************
+* Add the events recorded in the journal file to the calendar in memory.
+* A record which was only partly written, because KAlarm was killed while
+* writing it, is ignored. Events which are already in the calendar are ignored,
+* in case the journal was not deleted after the calendar was last saved.
+* Reply = number of events added to the calendar.
+*/
+int SingleFileResource::replayJournal()
+{
+    QFile file(journalPath());
+    if (!file.exists())
+        return 0;
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCWarning(KALARM_LOG) << "SingleFileResource::replayJournal:" << displayId() << "Error opening" << file.fileName();
+        return 0;
+    }
+    const QByteArray journal = file.readAll();
+    file.close();
+
+    KCalendarCore::ICalFormat format;
+    int count = 0;
+    qsizetype start = 0;
+    for (qsizetype end;  (end = journal.indexOf('\n', start)) >= 0;  start = end + 1)
+    {
+        const QByteArray record = journal.mid(start, end - start);
+        if (record.isEmpty())
+            continue;
+        KCalendarCore::MemoryCalendar::Ptr eventCal(new KCalendarCore::MemoryCalendar(mCalendar->timeZone()));
+        if (!format.fromRawString(eventCal, QByteArray::fromBase64(record)))
+        {
+            qCWarning(KALARM_LOG) << "SingleFileResource::replayJournal:" << displayId() << "Error parsing event";
+            continue;
+        }
+        const KCalendarCore::Event::List kcalEvents = eventCal->rawEvents();
+        for (const KCalendarCore::Event::Ptr& kcalEvent : kcalEvents)
+        {
+            if (!mCalendar->event(kcalEvent->uid())
+            &&  mCalendar->addEvent(KCalendarCore::Event::Ptr(kcalEvent->clone())))
+                ++count;
+        }
+    }
+    if (start < journal.size())
+        qCWarning(KALARM_LOG) << "SingleFileResource::replayJournal:" << displayId() << "Ignoring incomplete record";
+    qCDebug(KALARM_LOG) << "SingleFileResource::replayJournal:" << displayId() << count << "events";
+    return count;
+}
+
+/******************************************************************************
+* Return the path of the journal file which holds events added while loading
+* was deferred.
+*/
+QString SingleFileResource::journalPath() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/journal-"_L1 + identifier();
+}
+
 /******************************************************************************
 * Add an event to the list of loaded events.
 */
@@ -561,7 +745,7 @@ bool SingleFileResource::readLocalFile(const QString& fileName, QString& errorMe
     if (mFileReadOnly  &&  !QFileInfo(fileName).size())
         return true;
     const QByteArray newHash = calculateHash(fileName);
-    if (newHash == mCurrentHash)
+    if (newHash == mCurrentHash  &&  mCalendar)
         qCDebug(KALARM_LOG) << "SingleFileResource::readLocalFile:" << displayId() << "hash unchanged";
     else
     {
@@ -571,6 +755,8 @@ bool SingleFileResource::readLocalFile(const QString& fileName, QString& errorMe
             mSaveUrl.clear(); // reset so we don't accidentally overwrite the file
             return false;
         }
+        if (mConverter)
+            mConverter->start(newHash);
         if (mCurrentHash.isEmpty())
         {
             // This is the very first time the file has been read, so store
@@ -592,7 +778,14 @@ bool SingleFileResource::readLocalFile(const QString& fileName, QString& errorMe
 bool SingleFileResource::readFromFile(const QString& fileName, QString& errorMessage)
 {
     qCDebug(KALARM_LOG) << "SingleFileResource::readFromFile:" << fileName;
+    stopConversion();
     mLoadedEvents.clear();
+
+    // Keep the previously loaded calendar, to find which events are unchanged.
+    const KCalendarCore::MemoryCalendar::Ptr oldCalendar = mCalendar;
+    const KACalendar::Compat oldCompatibility = mCompatibility;
+    const int oldVersion = mVersion;
+
     mCalendar.reset(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
     mFileStorage.reset(new KCalendarCore::FileStorage(mCalendar, fileName, new KCalendarCore::ICalFormat()));
     const bool result = mFileStorage->load();
@@ -608,21 +801,200 @@ bool SingleFileResource::readFromFile(const QString& fileName, QString& errorMes
         KACalendar::setKAlarmVersion(mCalendar);
         mSettings->setKeepFormat(false);
     }
+
+    QString versionString;
+    const int version = KACalendar::checkVersion(mFileStorage, versionString);
+    if (version == KACalendar::CurrentFormat)
+        CalendarConverter::discardProgress(conversionProgressDir());
+    else if (version != KACalendar::IncompatibleFormat
+         &&  mCalendar->rawEvents().count() > CalendarConverter::ChunkSize)
+    {
+        // The calendar is in an old format, and is large. To avoid blocking,
+        // convert its events to the current format in the background, and
+        // add each event to the resource once it has been converted.
+        qCDebug(KALARM_LOG) << "SingleFileResource::readFromFile:" << displayId() << "Converting from version" << versionString << "in background";
+        mVersion = version;
+        mCompatibility = KACalendar::Convertible;
+        KCalendarCore::Event::List kcalEvents;
+        const KCalendarCore::Event::List events = mCalendar->events();
+        for (const KCalendarCore::Event::Ptr& kcalEvent : events)
+        {
+            if (!kcalEvent->alarms().isEmpty())
+                kcalEvents += kcalEvent;
+        }
+        mConverter = new CalendarConverter(kcalEvents, version, conversionProgressDir(), this);
+        connect(mConverter, &CalendarConverter::eventsConverted, this, &SingleFileResource::slotEventsConverted);
+        connect(mConverter, &CalendarConverter::finished, this, &SingleFileResource::slotConversionFinished);
+        mCalendar->setModified(false);
+        return true;
+    }
     mCompatibility = getCompatibility(mFileStorage, mVersion);
 
+    // Add any events which were appended to the journal while loading was
+    // deferred. The journal is deleted once they have been saved to the file.
+    mJournalLoaded = false;
+    if (mCompatibility == KACalendar::Current  &&  QFile::exists(journalPath()))
+    {
+        if (replayJournal())
+            mJournalLoaded = true;
+        else
+            QFile::remove(journalPath());   // its events are all in the file already
+    }
+
+    // Events which are unchanged since the calendar was last read can reuse
+    // their existing KAEvent instances, provided that the calendar format is
+    // unchanged.
+    const bool reuse = oldCalendar  &&  mCompatibility == oldCompatibility  &&  mVersion == oldVersion;
+
     // Retrieve events from the calendar
+    int unchanged = 0;
     const KCalendarCore::Event::List events = mCalendar->events();
     for (const KCalendarCore::Event::Ptr& kcalEvent : std::as_const(events))
     {
         if (kcalEvent->alarms().isEmpty())
             qCDebug(KALARM_LOG) << "SingleFileResource::readFromFile:" << displayId() << "KCalendarCore::Event has no alarms:" << kcalEvent->uid();
+        else if (reuse  &&  reuseLoadedEvent(kcalEvent, oldCalendar))
+            ++unchanged;
         else
             addLoadedEvent(kcalEvent);
     }
-    mCalendar->setModified(false);
+    if (reuse)
+        qCDebug(KALARM_LOG) << "SingleFileResource::readFromFile:" << displayId() << unchanged << "of" << mLoadedEvents.count() << "events unchanged";
+    mCalendar->setModified(mJournalLoaded);
+    if (mJournalLoaded  &&  isWritable(CalEvent::EMPTY))
+        scheduleSave();   // merge the journal into the calendar file
     return true;
 }
 
+/******************************************************************************
+* If an event read from the calendar file is identical to the event in the
+* previously loaded calendar, add the resource's existing KAEvent for it to the
+* list of loaded events, instead of constructing a new one.
+* The revision and last modification time are compared first, since they
+* normally change whenever an event is updated. KCalendarCore's comparison
+* operator ignores custom properties of alarms, which hold KAlarm data, so the
+* KAlarm (X-KDE-KALARM) custom properties of the event and each of its alarms
+* are compared explicitly.
+* Reply = false if the event has changed, or has not previously been loaded.
+*/
+bool SingleFileResource::reuseLoadedEvent(const KCalendarCore::Event::Ptr& kcalEvent, const KCalendarCore::MemoryCalendar::Ptr& oldCalendar)
+{
+    const KCalendarCore::Event::Ptr oldKcalEvent = oldCalendar->event(kcalEvent->uid());
+    if (!oldKcalEvent
+    ||  oldKcalEvent->revision() != kcalEvent->revision()
+    ||  oldKcalEvent->lastModified() != kcalEvent->lastModified()
+    ||  oldKcalEvent->customProperties() != kcalEvent->customProperties())
+        return false;
+    const KCalendarCore::Alarm::List oldAlarms = oldKcalEvent->alarms();
+    const KCalendarCore::Alarm::List alarms    = kcalEvent->alarms();
+    if (oldAlarms.count() != alarms.count())
+        return false;
+    for (int i = 0, count = alarms.count();  i < count;  ++i)
+    {
+        if (oldAlarms.at(i)->customProperties() != alarms.at(i)->customProperties())
+            return false;
+    }
+    if (*oldKcalEvent != *kcalEvent)
+        return false;
+    const KAEvent evnt = event(kcalEvent->uid(), true);
+    if (!evnt.isValid())
+        return false;
+    mLoadedEvents[evnt.id()] = evnt;
+    return true;
+}
+
+/******************************************************************************
+* Called when a chunk of events has been converted to the current KAlarm format
+* in the background. Replace the original events in the calendar, and add them
+* to the resource.
+*/
+void SingleFileResource::slotEventsConverted(const KCalendarCore::Event::List& kcalEvents)
+{
+    if (!mCalendar  ||  !mSettings)
+        return;
+    const bool modified = mCalendar->isModified();
+    const QHash<QString, KAEvent::CmdErr>& cmdErrors = mSettings->commandErrors();
+    QList<KAEvent> events;
+    events.reserve(kcalEvents.count());
+    for (const KCalendarCore::Event::Ptr& kcalEvent : kcalEvents)
+    {
+        const KCalendarCore::Event::Ptr original = mCalendar->event(kcalEvent->uid());
+        if (original)
+            mCalendar->deleteEvent(original);
+        mCalendar->addEvent(kcalEvent);
+        if (addLoadedEvent(kcalEvent))
+        {
+            KAEvent& event = mLoadedEvents[kcalEvent->uid()];
+            if (event.category() == CalEvent::ACTIVE)
+            {
+                auto it = cmdErrors.constFind(event.id());
+                if (it != cmdErrors.constEnd())
+                    event.setCommandError(it.value());
+            }
+            events += event;
+        }
+    }
+    mCalendar->setModified(modified);
+    qCDebug(KALARM_LOG) << "SingleFileResource::slotEventsConverted:" << displayId() << events.count() << "events," << mConverter->pendingCount() << "remaining";
+    if (!events.isEmpty())
+        setUpdatedEvents(events);
+}
+
+/******************************************************************************
+* Called when all events have been converted to the current KAlarm format in
+* the background. Perform any storage format update or save which was
+* deferred during conversion.
+*/
+void SingleFileResource::slotConversionFinished()
+{
+    qCDebug(KALARM_LOG) << "SingleFileResource::slotConversionFinished:" << displayId();
+    mConverter->deleteLater();
+    mConverter = nullptr;
+    if (mCalendar)
+    {
+        // Set the new calendar version, as for a calendar converted in one pass.
+        const bool modified = mCalendar->isModified();
+        KACalendar::setKAlarmVersion(mCalendar);
+        mCalendar->setModified(modified);
+    }
+    if (mUpdateFormatPending)
+    {
+        mUpdateFormatPending = false;
+        updateStorageFmt();
+    }
+    if (mSaveAfterConversion)
+    {
+        const bool writeThroughCache = mSaveAfterConversionCache;
+        const bool force             = mSaveAfterConversionForce;
+        mSaveAfterConversion = mSaveAfterConversionCache = mSaveAfterConversionForce = false;
+        save(nullptr, writeThroughCache, force);
+    }
+}
+
+/******************************************************************************
+* Stop any background conversion of the calendar's events.
+*/
+void SingleFileResource::stopConversion()
+{
+    if (mConverter)
+    {
+        mConverter->disconnect(this);
+        mConverter->deleteLater();
+        mConverter = nullptr;
+    }
+    mUpdateFormatPending = false;
+    mSaveAfterConversion = mSaveAfterConversionCache = mSaveAfterConversionForce = false;
+}
+
+/******************************************************************************
+* Return the directory in which to hold progress files for the background
+* conversion of an old format calendar.
+*/
+QString SingleFileResource::conversionProgressDir() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/upgrade-"_L1 + identifier();
+}
+
 /******************************************************************************
 * Write calendar data to the given file.
 */
@@ -20,6 +20,7 @@ namespace KIO {
 class FileCopyJob;
 }
 class KJob;
+class CalendarConverter;
 class QTimer;
 
 using namespace KAlarmCal;
@@ -105,6 +106,20 @@ protected:
      */
     int doLoad(QHash<QString, KAEvent>& newEvents, bool readThroughCache, QString& errorMessage) override;
 
+    /** Defer loading if the calendar is a local file in the current KAlarm
+     *  format. The file's format is determined from its header, without
+     *  reading its events.
+     *  @return true if loading has been deferred, false to load now.
+     */
+    bool deferLoad() override;
+
+    /** Discard the loaded calendar data. */
+    void doUnload() override;
+
+    /** Return whether all events have been loaded, i.e. whether conversion
+     *  of an old format calendar is complete. */
+    bool isLoadComplete() const override   { return !mConverter; }
+
     /** This method is called by save() to allow derived classes to implement
      *  saving the resource to its backend.
      *  If the resource is cached, it should be saved to the cache file (which
@@ -157,6 +172,12 @@ protected:
      */
     bool doAddEvent(const KAEvent&) override;
 
+    /** This method is called by addEvent() when loading has been deferred.
+     *  The event is appended to the resource's journal file, without reading
+     *  the calendar file.
+     */
+    bool doAppendEvent(const KAEvent&) override;
+
     /** This method is called by updateEvent() to allow derived classes to update
      *  an event in the resource. The event's UID must be unchanged.
      */
@@ -199,9 +220,16 @@ private Q_SLOTS:
     void slotUploadJobResult(KJob*);
     void updateFormat()    { updateStorageFmt(); }
     bool addLoadedEvent(const KCalendarCore::Event::Ptr&);
+    bool reuseLoadedEvent(const KCalendarCore::Event::Ptr&, const KCalendarCore::MemoryCalendar::Ptr& oldCalendar);
+    void slotEventsConverted(const KCalendarCore::Event::List&);
+    void slotConversionFinished();
 
 private:
     void setLoadFailure(bool exists, Status);
+    QString conversionProgressDir() const;
+    QString journalPath() const;
+    int     replayJournal();
+    void stopConversion();
 
     QUrl               mSaveUrl;   // current local file for save() to use (may be temporary)
     KIO::FileCopyJob*  mDownloadJob {nullptr};
@@ -213,6 +241,12 @@ private:
     QTimer*            mSaveTimer {nullptr};  // timer to enable multiple saves to be grouped
     bool               mSavePendingCache;     // writeThroughCache parameter for delayed save()
     bool               mFileReadOnly {false}; // the calendar file is a read-only local file
+    bool               mJournalLoaded {false};  // the journal's events have been added to mCalendar
+    CalendarConverter* mConverter {nullptr};  // converts an old format calendar in the background
+    bool               mUpdateFormatPending {false};  // update storage format once conversion is complete
+    bool               mSaveAfterConversion {false};  // save once conversion is complete
+    bool               mSaveAfterConversionCache {false};  // writeThroughCache parameter for deferred save
+    bool               mSaveAfterConversionForce {false};  // force parameter for deferred save
 };
 
 // vim: et sw=4:
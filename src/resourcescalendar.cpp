@@ -15,11 +15,18 @@
 
 #include <KCalendarCore/CalFormat>
 
+#include <QCollator>
+
+#include <algorithm>
+#include <vector>
+
 using namespace KAlarmCal;
 
 
 ResourcesCalendar*             ResourcesCalendar::mInstance {nullptr};
 ResourcesCalendar::ResourceMap ResourcesCalendar::mResourceMap;
+QHash<ResourceId, ResourcesCalendar::EventIndex> ResourcesCalendar::mEventIndex;
+ResourcesCalendar::TemplateIndex ResourcesCalendar::mTemplateIndex;
 ResourcesCalendar::EarliestMap ResourcesCalendar::mEarliestAlarm;
 ResourcesCalendar::EarliestMap ResourcesCalendar::mEarliestNoInhibitAlarm;
 QSet<QString>                  ResourcesCalendar::mPendingAlarms;
@@ -104,12 +111,19 @@ void ResourcesCalendar::removeKAEvents(ResourceId key, bool closing, CalEvent::T
             else
                 remove = evnt.category() & types;
             if (remove)
+            {
+                unindexEvent(key, *it);
+                unindexTemplate(key, *it);
                 removed = true;
+            }
             else
                 retained.insert(*it);
         }
         if (retained.isEmpty())
+        {
             mResourceMap.erase(rit);
+            mEventIndex.remove(key);
+        }
         else
             eventIds.swap(retained);
     }
@@ -194,6 +208,8 @@ void ResourcesCalendar::slotEventUpdated(Resource& resource, const KAEvent& even
     const bool added = !mResourceMap[key].contains(event.id());
     qCDebug(KALARM_LOG) << "ResourcesCalendar::slotEventUpdated: resource" << resource.displayId() << (added ? "added" : "updated") << event.id();
     mResourceMap[key].insert(event.id());
+    indexEvent(key, event);
+    indexTemplate(key, event);
 
     if ((resource.alarmTypes() & CalEvent::ACTIVE)
     &&  event.category() == CalEvent::ACTIVE)
@@ -518,6 +534,8 @@ CalEvent::Type ResourcesCalendar::deleteEventInternal(const QString& eventID, co
         mWakeSuspendTimers[key].remove(eventID);   // this cancels the timer
 
     mResourceMap[key].remove(eventID);
+    unindexEvent(key, eventID);
+    unindexTemplate(key, eventID);
     mInactiveEvents.remove(eventID);
     if (mEarliestAlarm.value(key)          == eventID
     ||  mEarliestNoInhibitAlarm.value(key) == eventID)
@@ -639,15 +657,62 @@ KAEvent ResourcesCalendar::templateEvent(const QString& templateName)
 {
     if (templateName.isEmpty())
         return {};
-    const QList<KAEvent> eventlist = events(CalEvent::TEMPLATE);
-    for (const KAEvent& evnt : eventlist)
+    Resources::loadDeferredEvents(CalEvent::TEMPLATE);
+    const QList<EventId> ids = mTemplateIndex.byName.value(templateName);
+    for (const EventId& id : ids)
     {
-        if (evnt.name() == templateName)
+        const KAEvent evnt = Resources::resource(id.resourceId()).event(id.eventId());
+        if (evnt.isValid())
             return evnt;
     }
     return {};
 }
 
+/******************************************************************************
+* Return the names of all alarm templates, in locale-aware order.
+* The names are only sorted again after the set of templates has changed,
+* using precomputed collation keys.
+*/
+QStringList ResourcesCalendar::templateNames(bool includeCommands)
+{
+    Resources::loadDeferredEvents(CalEvent::TEMPLATE);
+    if (!mTemplateIndex.sortedValid)
+    {
+        const QCollator collator;
+        std::vector<std::pair<QCollatorSortKey, TemplateIndex::SortedName>> keys;
+        keys.reserve(mTemplateIndex.byName.count());
+        for (auto it = mTemplateIndex.byName.constBegin();  it != mTemplateIndex.byName.constEnd();  ++it)
+        {
+            bool commandOnly = true;
+            for (const EventId& id : it.value())
+            {
+                if (!mTemplateIndex.entries.value(id.resourceId()).value(id.eventId()).command)
+                {
+                    commandOnly = false;
+                    break;
+                }
+            }
+            keys.emplace_back(collator.sortKey(it.key()), TemplateIndex::SortedName{it.key(), commandOnly});
+        }
+        std::sort(keys.begin(), keys.end(),
+                  [](const auto& a, const auto& b) { return a.first.compare(b.first) < 0; });
+        mTemplateIndex.sorted.clear();
+        mTemplateIndex.sorted.reserve(keys.size());
+        for (const auto& key : keys)
+            mTemplateIndex.sorted.append(key.second);
+        mTemplateIndex.sortedValid = true;
+    }
+
+    QStringList names;
+    names.reserve(mTemplateIndex.sorted.count());
+    for (const TemplateIndex::SortedName& sortedName : std::as_const(mTemplateIndex.sorted))
+    {
+        if (includeCommands  ||  !sortedName.commandOnly)
+            names += sortedName.name;
+    }
+    return names;
+}
+
 /******************************************************************************
 * Return all events with the specified ID, from all calendars.
 */
@@ -676,36 +741,167 @@ QList<KAEvent> ResourcesCalendar::events(CalEvent::Types type)
 QList<KAEvent> ResourcesCalendar::events(CalEvent::Types type, const Resource& resource)
 {
     QList<KAEvent> list;
+    if (type == CalEvent::EMPTY)
+    {
+        if (resource.isValid())
+        {
+            ResourceMap::ConstIterator rit = mResourceMap.constFind(resource.id());
+            if (rit != mResourceMap.constEnd())
+                list = eventsForResource(resource, rit.value());
+        }
+        else
+        {
+            for (ResourceMap::ConstIterator rit = mResourceMap.constBegin();  rit != mResourceMap.constEnd();  ++rit)
+                list += eventsForResource(Resources::resource(rit.key()), rit.value());
+        }
+        return list;
+    }
+
+    EventFilter filter;
+    filter.types = type;
+    forEachEvent(filter, [&list](const KAEvent& evnt)
+    {
+        list += evnt;
+        return true;
+    }, resource);
+    return list;
+}
+
+/******************************************************************************
+* Visit each event which matches a filter.
+* The visitor must not add or delete events while the search is in progress.
+*/
+bool ResourcesCalendar::forEachEvent(const EventFilter& filter, const EventVisitor& visitor, const Resource& resource)
+{
     if (resource.isValid())
     {
-        const ResourceId key = resource.id();
-        ResourceMap::ConstIterator rit = mResourceMap.constFind(key);
-        if (rit == mResourceMap.constEnd())
-            return list;
-        const QList<KAEvent> evnts = eventsForResource(resource, rit.value());
-        if (type == CalEvent::EMPTY)
-            return evnts;
-        for (const KAEvent& evnt : evnts)
-            if (type & evnt.category())
-                list += evnt;
+        auto it = mEventIndex.constFind(resource.id());
+        if (it == mEventIndex.constEnd())
+            return true;
+        return forEachEvent(resource, it.value(), filter, visitor);
     }
-    else
+    for (auto it = mEventIndex.constBegin();  it != mEventIndex.constEnd();  ++it)
+    {
+        if (!forEachEvent(Resources::resource(it.key()), it.value(), filter, visitor))
+            return false;
+    }
+    return true;
+}
+
+/******************************************************************************
+* Visit each event in one resource which matches a filter.
+* The smallest index set which the filter selects is scanned, and each of its
+* events is checked against the remaining criteria before it is fetched.
+*/
+bool ResourcesCalendar::forEachEvent(const Resource& resource, const EventIndex& index,
+                                     const EventFilter& filter, const EventVisitor& visitor)
+{
+    // Find the index sets which contain the required alarm types.
+    QList<const QSet<QString>*> categorySets;
+    qsizetype count = index.keys.count();
+    if (filter.types != CalEvent::EMPTY)
     {
-        for (ResourceMap::ConstIterator rit = mResourceMap.constBegin();  rit != mResourceMap.constEnd();  ++rit)
+        count = 0;
+        for (CalEvent::Type type : {CalEvent::ACTIVE, CalEvent::ARCHIVED, CalEvent::TEMPLATE, CalEvent::DISPLAYING})
         {
-            const Resource res = Resources::resource(rit.key());
-            const QList<KAEvent> evnts = eventsForResource(res, rit.value());
-            if (type == CalEvent::EMPTY)
-                list += evnts;
-            else
+            if (filter.types & type)
             {
-                for (const KAEvent& evnt : evnts)
-                    if (type & evnt.category())
-                        list += evnt;
+                auto it = index.categories.constFind(type);
+                if (it != index.categories.constEnd())
+                {
+                    categorySets += &it.value();
+                    count += it.value().count();
+                }
             }
         }
+        if (!count)
+            return true;
     }
-    return list;
+
+    // Use the action or recurrence type index instead, if it is smaller.
+    const QSet<QString>* smallest = nullptr;
+    if (filter.action)
+    {
+        auto it = index.actions.constFind(static_cast<int>(*filter.action));
+        if (it == index.actions.constEnd())
+            return true;
+        if (it.value().count() < count)
+        {
+            smallest = &it.value();
+            count = smallest->count();
+        }
+    }
+    if (filter.recurType)
+    {
+        auto it = index.recurTypes.constFind(*filter.recurType);
+        if (it == index.recurTypes.constEnd())
+            return true;
+        if (it.value().count() < count)
+            smallest = &it.value();
+    }
+
+    auto visit = [&](const QString& eventId) -> bool
+    {
+        auto kit = index.keys.constFind(eventId);
+        if (kit == index.keys.constEnd())
+            return true;
+        const EventIndex::Keys& keys = kit.value();
+        if ((filter.types != CalEvent::EMPTY  &&  !(filter.types & keys.category))
+        ||  (filter.action  &&  keys.action != *filter.action)
+        ||  (filter.recurType  &&  keys.recurType != *filter.recurType))
+            return true;
+        const KAEvent evnt = resource.event(eventId);
+        if (!evnt.isValid())
+            return true;
+        return visitor(evnt);
+    };
+
+    if (smallest)
+    {
+        for (const QString& eventId : *smallest)
+            if (!visit(eventId))
+                return false;
+    }
+    else if (filter.types == CalEvent::EMPTY)
+    {
+        for (auto it = index.keys.constBegin();  it != index.keys.constEnd();  ++it)
+            if (!visit(it.key()))
+                return false;
+    }
+    else
+    {
+        for (const QSet<QString>* eventIds : std::as_const(categorySets))
+            for (const QString& eventId : *eventIds)
+                if (!visit(eventId))
+                    return false;
+    }
+    return true;
+}
+
+/******************************************************************************
+* Return whether there are any events of the specified alarm types.
+*/
+bool ResourcesCalendar::haveEvents(CalEvent::Types types, const Resource& resource)
+{
+    auto haveTypes = [types](const EventIndex& index)
+    {
+        if (types == CalEvent::EMPTY)
+            return !index.keys.isEmpty();
+        for (auto it = index.categories.constBegin();  it != index.categories.constEnd();  ++it)
+            if (types & it.key())
+                return true;
+        return false;
+    };
+
+    if (resource.isValid())
+    {
+        auto it = mEventIndex.constFind(resource.id());
+        return it != mEventIndex.constEnd()  &&  haveTypes(it.value());
+    }
+    for (const EventIndex& index : std::as_const(mEventIndex))
+        if (haveTypes(index))
+            return true;
+    return false;
 }
 
 /******************************************************************************
@@ -743,16 +939,9 @@ void ResourcesCalendar::checkForDisabledAlarms(bool oldEnabled, bool newEnabled)
 */
 void ResourcesCalendar::checkForDisabledAlarms()
 {
-    bool disabled = false;
-    const QList<KAEvent> eventlist = events(CalEvent::ACTIVE);
-    for (const KAEvent& evnt : eventlist)
-    {
-        if (!evnt.enabled())
-        {
-            disabled = true;
-            break;
-        }
-    }
+    EventFilter filter;
+    filter.types = CalEvent::ACTIVE;
+    const bool disabled = !forEachEvent(filter, [](const KAEvent& evnt) { return evnt.enabled(); });
     if (disabled != mHaveDisabledAlarms)
     {
         mHaveDisabledAlarms = disabled;
@@ -932,6 +1121,117 @@ QList<KAEvent> ResourcesCalendar::eventsForResource(const Resource& resource, co
     return evnts;
 }
 
+/******************************************************************************
+* Add an event to the secondary indexes, or update its index entries.
+*/
+void ResourcesCalendar::indexEvent(ResourceId key, const KAEvent& event)
+{
+    const EventIndex::Keys keys{event.category(), event.actionSubType(), event.recurType()};
+    EventIndex& index = mEventIndex[key];
+    auto it = index.keys.constFind(event.id());
+    if (it != index.keys.constEnd())
+    {
+        const EventIndex::Keys& old = it.value();
+        if (old.category == keys.category  &&  old.action == keys.action  &&  old.recurType == keys.recurType)
+            return;   // the event's index entries are unchanged
+        unindexEvent(key, event.id());
+    }
+    index.keys.insert(event.id(), keys);
+    index.categories[keys.category].insert(event.id());
+    index.actions[static_cast<int>(keys.action)].insert(event.id());
+    index.recurTypes[keys.recurType].insert(event.id());
+}
+
+/******************************************************************************
+* Remove an event from the secondary indexes.
+*/
+void ResourcesCalendar::unindexEvent(ResourceId key, const QString& eventId)
+{
+    auto iit = mEventIndex.find(key);
+    if (iit == mEventIndex.end())
+        return;
+    EventIndex& index = iit.value();
+    auto kit = index.keys.find(eventId);
+    if (kit == index.keys.end())
+        return;
+
+    auto removeId = [&eventId](QHash<int, QSet<QString>>& sets, int setKey)
+    {
+        auto it = sets.find(setKey);
+        if (it != sets.end())
+        {
+            it.value().remove(eventId);
+            if (it.value().isEmpty())
+                sets.erase(it);   // an empty set would make haveEvents() wrong
+        }
+    };
+    removeId(index.categories, kit.value().category);
+    removeId(index.actions, static_cast<int>(kit.value().action));
+    removeId(index.recurTypes, kit.value().recurType);
+    index.keys.erase(kit);
+}
+
+/******************************************************************************
+* Add or update an event in the template name index, if it is a template.
+*/
+void ResourcesCalendar::indexTemplate(ResourceId key, const KAEvent& event)
+{
+    if (event.category() != CalEvent::TEMPLATE)
+    {
+        unindexTemplate(key, event.id());
+        return;
+    }
+    const TemplateIndex::Entry entry{event.name(), (event.actionTypes() & KAEvent::Action::Command) != 0};
+    const auto rit = mTemplateIndex.entries.constFind(key);
+    if (rit != mTemplateIndex.entries.constEnd())
+    {
+        const auto it = rit.value().constFind(event.id());
+        if (it != rit.value().constEnd())
+        {
+            if (it.value().name == entry.name  &&  it.value().command == entry.command)
+                return;   // the template's index entry is unchanged
+            unindexTemplate(key, event.id());
+        }
+    }
+    mTemplateIndex.entries[key].insert(event.id(), entry);
+    mTemplateIndex.byName[entry.name].append(EventId(key, event.id()));
+    setTemplatesChanged();
+}
+
+/******************************************************************************
+* Remove an event from the template name index.
+*/
+void ResourcesCalendar::unindexTemplate(ResourceId key, const QString& eventId)
+{
+    auto rit = mTemplateIndex.entries.find(key);
+    if (rit == mTemplateIndex.entries.end())
+        return;
+    auto it = rit.value().find(eventId);
+    if (it == rit.value().end())
+        return;
+    auto nit = mTemplateIndex.byName.find(it.value().name);
+    if (nit != mTemplateIndex.byName.end())
+    {
+        nit.value().removeOne(EventId(key, eventId));
+        if (nit.value().isEmpty())
+            mTemplateIndex.byName.erase(nit);
+    }
+    rit.value().erase(it);
+    if (rit.value().isEmpty())
+        mTemplateIndex.entries.erase(rit);
+    setTemplatesChanged();
+}
+
+/******************************************************************************
+* Note that the set of templates has changed.
+*/
+void ResourcesCalendar::setTemplatesChanged()
+{
+    mTemplateIndex.sortedValid = false;
+    if (mInstance)
+        Q_EMIT mInstance->templatesChanged();
+}
+
 #include "moc_resourcescalendar.cpp"
 
 // vim: et sw=4:
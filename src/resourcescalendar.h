@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include "eventid.h"
 #include "kernelwakealarm.h"
 #include "resources/resource.h"
 #include "kalarmcalendar/kaevent.h"
@@ -15,7 +16,8 @@
 #include <QHash>
 #include <QObject>
 
-class EventId;
+#include <functional>
+#include <optional>
 
 using namespace KAlarmCal;
 
@@ -50,10 +52,48 @@ public:
     using QObject::event;
     static KAEvent        event(const EventId& uniqueId, bool findUniqueId = false);
     static KAEvent        templateEvent(const QString& templateName);
+
+    /** Return the names of all alarm templates, sorted in locale-aware order.
+     *  A name which is used by more than one template is only returned once.
+     *  The sorted list is cached until the set of templates changes.
+     *  @param includeCommands  Whether to include command alarm templates.
+     */
+    static QStringList    templateNames(bool includeCommands = true);
+
     static QList<KAEvent> events(const QString& uniqueId);
     static QList<KAEvent> events(const Resource&, CalEvent::Types = CalEvent::EMPTY);
     static QList<KAEvent> events(CalEvent::Types s = CalEvent::EMPTY);
 
+    /** Criteria for selecting events in forEachEvent(). */
+    struct EventFilter
+    {
+        CalEvent::Types                   types {CalEvent::EMPTY};  // alarm types, or EMPTY for all types
+        std::optional<KAEvent::SubAction> action;      // action sub-type, if any
+        std::optional<KARecurrence::Type> recurType;   // recurrence type, if any
+    };
+
+    /** Function called by forEachEvent() for each matching event.
+     *  @return  true to continue, false to stop visiting events.
+     */
+    using EventVisitor = std::function<bool(const KAEvent&)>;
+
+    /** Visit each event which matches a filter, without building a list of
+     *  events. The secondary indexes are used to find the matching events, so
+     *  that the time taken is proportional to the number of matching events.
+     *  @param filter    Criteria which events must match.
+     *  @param visitor   Function to call for each matching event.
+     *  @param resource  Resource to restrict the search to, or invalid for all.
+     *  @return  false if @p visitor stopped the search, else true.
+     */
+    static bool           forEachEvent(const EventFilter& filter, const EventVisitor& visitor,
+                                       const Resource& resource = Resource());
+
+    /** Return whether there are any events of the specified alarm types.
+     *  @param types     Alarm types to check for, or EMPTY for any type.
+     *  @param resource  Resource to check, or invalid for all.
+     */
+    static bool           haveEvents(CalEvent::Types types, const Resource& resource = Resource());
+
     /** Options for addEvent(). May be OR'ed together. */
     enum AddEventOption
     {
@@ -77,6 +117,10 @@ Q_SIGNALS:
     void                  haveDisabledAlarmsChanged(bool haveDisabled);
     void                  atLoginEventAdded(const KAlarmCal::KAEvent&);
 
+    /** Emitted when an alarm template has been added, removed or renamed,
+     *  or its action type has changed between command and non-command. */
+    void                  templatesChanged();
+
 private Q_SLOTS:
     void                  slotResourceSettingsChanged(Resource&, ResourceType::Changes);
     void                  slotResourcesPopulated();
@@ -99,6 +143,13 @@ private:
     void                  checkForDisabledAlarms();
     void                  checkForDisabledAlarms(bool oldEnabled, bool newEnabled);
     static QList<KAEvent> eventsForResource(const Resource&, const QSet<QString>& eventIds);
+    struct EventIndex;
+    static bool           forEachEvent(const Resource&, const EventIndex&, const EventFilter&, const EventVisitor&);
+    static void           indexEvent(ResourceId, const KAEvent&);
+    static void           unindexEvent(ResourceId, const QString& eventId);
+    static void           indexTemplate(ResourceId, const KAEvent&);
+    static void           unindexTemplate(ResourceId, const QString& eventId);
+    static void           setTemplatesChanged();
     void                  setKernelWakeSuspend();
     static void           checkKernelWakeSuspend(ResourceId, const KAlarmCal::KAEvent&);
 
@@ -107,7 +158,43 @@ private:
     typedef QHash<ResourceId, QSet<QString>> ResourceMap;  // event IDs for each resource
     typedef QHash<ResourceId, QString> EarliestMap;  // event ID of earliest alarm, for each resource
 
+    // Secondary indexes of the events in each resource.
+    struct EventIndex
+    {
+        struct Keys
+        {
+            CalEvent::Type     category;
+            KAEvent::SubAction action;
+            KARecurrence::Type recurType;
+        };
+        QHash<QString, Keys>      keys;          // index keys for each event ID
+        QHash<int, QSet<QString>> categories;    // event IDs for each CalEvent::Type
+        QHash<int, QSet<QString>> actions;       // event IDs for each KAEvent::SubAction
+        QHash<int, QSet<QString>> recurTypes;    // event IDs for each KARecurrence::Type
+    };
+
+    // Index of alarm templates by name.
+    struct TemplateIndex
+    {
+        struct Entry
+        {
+            QString name;
+            bool    command;   // it's a command alarm template
+        };
+        struct SortedName
+        {
+            QString name;
+            bool    commandOnly;   // all templates with this name are command alarms
+        };
+        QHash<ResourceId, QHash<QString, Entry>> entries;   // index entries for each resource and event ID
+        QHash<QString, QList<EventId>>           byName;    // template IDs for each template name
+        QList<SortedName>                        sorted;    // cached template names in locale-aware order
+        bool                                     sortedValid {false};
+    };
+
     static ResourceMap    mResourceMap;
+    static QHash<ResourceId, EventIndex> mEventIndex;   // secondary indexes, by resource
+    static TemplateIndex  mTemplateIndex;      // alarm templates by name
     static EarliestMap    mEarliestAlarm;        // alarm with earliest trigger time, by resource
     static EarliestMap    mEarliestNoInhibitAlarm; // non-inhibitable alarm with earliest trigger time, by resource
     static QSet<QString>  mPendingAlarms;      // IDs of alarms which are currently being processed after triggering
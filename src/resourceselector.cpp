@@ -451,9 +451,12 @@ void ResourceSelector::importCalendar()
 */
 void ResourceSelector::exportCalendar()
 {
-    const Resource resource = currentResource();
+    Resource resource = currentResource();
     if (resource.isValid())
+    {
+        resource.loadDeferredEvents();   // ensure that all the alarms are loaded
         KAlarm::exportAlarms(ResourcesCalendar::events(resource), this);
+    }
 }
 
 /******************************************************************************
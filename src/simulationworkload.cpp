@@ -0,0 +1,121 @@
+/*
+ *  simulationworkload.cpp  -  synthetic alarm workloads for scheduling simulations
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "simulationworkload.h"
+
+#include "kalarmcalendar/datetime.h"
+#include "kalarmcalendar/repetition.h"
+#include "kalarm_debug.h"
+
+#include <KCalendarCore/CalFormat>
+#include <KCalendarCore/Duration>
+
+#include <QFont>
+
+namespace
+{
+const int MINUTELY_INTERVAL    = 10;   // minutes between minutely alarm recurrences
+const int MINUTELY_COUNT       = 12;   // number of minutely alarm recurrences
+const int MINUTELY_REPEATS     = 3;    // number of sub-repetitions of each recurrence
+const int MINUTELY_REPEAT_SECS = 120;  // interval between sub-repetitions
+const int DEFERRAL_MINUTES     = 60;   // minutes between deferred alarm recurrences
+const int DEFERRAL_COUNT       = 2;    // number of deferred alarm recurrences
+const int LATE_CANCEL_INTERVAL = 5;    // minutes between late-cancel alarm recurrences
+const int LATE_CANCEL_COUNT    = 12;   // number of late-cancel alarm recurrences
+const int LATE_CANCEL_MISSED   = 3;    // number of late-cancel recurrences before the simulation start
+}
+
+/******************************************************************************
+* Parse a workload specification of the form TYPE:COUNT[,TYPE:COUNT...].
+*/
+bool SimulationWorkload::parse(const QString& spec)
+{
+    mBurst = mMinutely = mDeferral = mLateCancel = 0;
+    const QStringList items = spec.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    if (items.isEmpty())
+        return false;
+    for (const QString& item : items)
+    {
+        const QStringList parts = item.trimmed().split(QLatin1Char(':'));
+        if (parts.count() != 2)
+            return false;
+        bool ok;
+        const int count = parts[1].trimmed().toInt(&ok);
+        if (!ok  ||  count <= 0)
+            return false;
+        const QString type = parts[0].trimmed().toLower();
+        if (type == QLatin1StringView("burst"))
+            mBurst += count;
+        else if (type == QLatin1StringView("minutely"))
+            mMinutely += count;
+        else if (type == QLatin1StringView("deferral"))
+            mDeferral += count;
+        else if (type == QLatin1StringView("latecancel"))
+            mLateCancel += count;
+        else
+            return false;
+    }
+    return true;
+}
+
+/******************************************************************************
+* Create the alarms for the workload. Apart from burst alarms, the alarms are
+* staggered by a few seconds so that they are not all handled at once.
+*/
+QList<KAEvent> SimulationWorkload::createEvents(const KADateTime& startTime) const
+{
+    qCDebug(KALARM_LOG) << "SimulationWorkload::createEvents: burst" << mBurst << ", minutely" << mMinutely
+                        << ", deferral" << mDeferral << ", latecancel" << mLateCancel;
+    QList<KAEvent> events;
+    events.reserve(mBurst + mMinutely + mDeferral + mLateCancel);
+    const KADateTime first = startTime.addSecs(60);
+    const QFont font;
+    int n = 0;
+    auto newEvent = [&](const KADateTime& dt, int lateCancel)
+    {
+        KAEvent event(dt, QStringLiteral("Workload %1").arg(n), QStringLiteral("Workload alarm %1").arg(n),
+                      Qt::white, Qt::black, font, KAEvent::SubAction::Message, lateCancel, KAEvent::ConfirmAck);
+        event.setEventId(CalEvent::uid(KCalendarCore::CalFormat::createUniqueId(), CalEvent::ACTIVE));
+        ++n;
+        return event;
+    };
+
+    for (int i = 0;  i < mBurst;  ++i)
+        events += newEvent(first, 0);
+
+    for (int i = 0;  i < mMinutely;  ++i)
+    {
+        KAEvent event = newEvent(first.addSecs(i % 60), 0);
+        event.setRecurMinutely(MINUTELY_INTERVAL, MINUTELY_COUNT, KADateTime());
+        event.setRepetition(Repetition(KCalendarCore::Duration(MINUTELY_REPEAT_SECS, KCalendarCore::Duration::Seconds), MINUTELY_REPEATS));
+        events += event;
+    }
+
+    for (int i = 0;  i < mDeferral;  ++i)
+    {
+        // The main alarm is due after the deferral, so that each alarm
+        // triggers first for its deferral and then for its main alarm.
+        // The alarm recurs, since deferring a non-recurring alarm would
+        // expire its main alarm.
+        KAEvent event = newEvent(first.addSecs(DEFERRAL_MINUTES * 60 + i % 60), 0);
+        event.setRecurMinutely(DEFERRAL_MINUTES, DEFERRAL_COUNT, KADateTime());
+        event.defer(DateTime(first.addSecs(i % 60)), false);
+        events += event;
+    }
+
+    for (int i = 0;  i < mLateCancel;  ++i)
+    {
+        const KADateTime dt = startTime.addSecs(-LATE_CANCEL_MISSED * LATE_CANCEL_INTERVAL * 60 + i % 60);
+        KAEvent event = newEvent(dt, 1);
+        event.setRecurMinutely(LATE_CANCEL_INTERVAL, LATE_CANCEL_COUNT, KADateTime());
+        events += event;
+    }
+    return events;
+}
+
+// vim: et sw=4:
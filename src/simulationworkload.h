@@ -0,0 +1,59 @@
+/*
+ *  simulationworkload.h  -  synthetic alarm workloads for scheduling simulations
+ *  Program:  kalarm
+ *  SPDX-FileCopyrightText: 2026 David Jarvie <djarvie@kde.org>
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+/* @file simulationworkload.h - synthetic alarm workloads for scheduling simulations */
+
+#include "kalarmcalendar/kaevent.h"
+
+#include <QList>
+
+using namespace KAlarmCal;
+
+/** SimulationWorkload creates synthetic alarms to load test the scheduler,
+ *  when simulating alarm scheduling on the virtual clock (see VirtualClock).
+ *  The alarms are added to the calendars and handled by the normal scheduling
+ *  code, so that the simulation statistics measure the real scheduler.
+ *
+ *  A workload is specified as a comma separated list of TYPE:COUNT items,
+ *  where TYPE is one of:
+ *    burst       one-off alarms which are all due at the same time
+ *    minutely    minutely recurrences with sub-repetitions
+ *    deferral    recurring alarms with pending deferrals
+ *    latecancel  recurring late-cancel alarms which start before the
+ *                simulation, so that their early occurrences are missed
+ *
+ *  @author David Jarvie <djarvie@kde.org>
+ */
+class SimulationWorkload
+{
+public:
+    SimulationWorkload() = default;
+
+    /** Parse a workload specification.
+     *  @return true if valid, false if the specification has an error.
+     */
+    bool parse(const QString& spec);
+
+    /** Return whether the workload contains no alarms. */
+    bool isEmpty() const   { return !(mBurst + mMinutely + mDeferral + mLateCancel); }
+
+    /** Create the workload's alarms, each with a unique event ID.
+     *  @param startTime  The start time of the simulation.
+     */
+    QList<KAEvent> createEvents(const KADateTime& startTime) const;
+
+private:
+    int mBurst {0};        // number of burst alarms
+    int mMinutely {0};     // number of minutely recurring alarms
+    int mDeferral {0};     // number of deferred alarms
+    int mLateCancel {0};   // number of late-cancel alarms
+};
+
+// vim: et sw=4:
@@ -56,6 +56,7 @@ TemplateDlg::TemplateDlg(QWidget* parent)
     QBoxLayout* layout = new QVBoxLayout();
     layout->setContentsMargins(0, 0, 0, 0);
     hlayout->addLayout(layout);
+    Resources::loadDeferredEvents(CalEvent::TEMPLATE, this);   // keep templates loaded while the dialog exists
     mListFilterModel = DataModel::createTemplateListModel(this);
     if (!ShellProcess::authorised())
         mListFilterModel->setAlarmActionFilter(static_cast<KAEvent::Action>(KAEvent::Action::All & ~KAEvent::Action::Command));
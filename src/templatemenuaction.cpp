@@ -1,15 +1,15 @@
 /*
  *  templatemenuaction.cpp  -  menu action to select a template
  *  Program:  kalarm
- *  SPDX-FileCopyrightText: 2005-2022 David Jarvie <djarvie@kde.org>
+ *  SPDX-FileCopyrightText: 2005-2026 David Jarvie <djarvie@kde.org>
  *
  *  SPDX-License-Identifier: GPL-2.0-or-later
  */
 
 #include "templatemenuaction.h"
 
-#include "functions.h"
 #include "resourcescalendar.h"
+#include "lib/shellprocess.h"
 #include "kalarmcalendar/kaevent.h"
 
 #include <QMenu>
@@ -21,36 +21,41 @@ TemplateMenuAction::TemplateMenuAction(const QIcon& icon, const QString& label,
     setPopupMode(QToolButton::InstantPopup);
     connect(menu(), &QMenu::aboutToShow, this, &TemplateMenuAction::slotInitMenu);
     connect(menu(), &QMenu::triggered, this, &TemplateMenuAction::slotSelected);
+    connect(ResourcesCalendar::instance(), &ResourcesCalendar::templatesChanged, this, &TemplateMenuAction::slotTemplatesChanged);
 }
 
 /******************************************************************************
 * Called when the New From Template action is clicked.
 * Creates a popup menu listing all alarm templates, in sorted name order.
+* The menu is only rebuilt if the templates have changed since it was last
+* shown. If shell commands are disabled, command alarm templates are omitted.
 */
 void TemplateMenuAction::slotInitMenu()
 {
+    const bool includeCommands = ShellProcess::authorised();
+    if (mMenuValid  &&  includeCommands == mIncludeCommands)
+        return;   // the menu is already up to date
+
+    const QStringList names = ResourcesCalendar::templateNames(includeCommands);
     QMenu* m = menu();
     m->clear();
     mOriginalTexts.clear();
-
-    // Compile a sorted list of template names
-    QStringList sorted;
-    const QList<KAEvent> templates = KAlarm::templateList();
-    for (const KAEvent& templ : templates)
-    {
-        const QString name = templ.name();
-        int j = 0;
-        for (int jend = sorted.count();
-             j < jend  &&  QString::localeAwareCompare(name, sorted[j]) > 0;
-             ++j) ;
-        sorted.insert(j, name);
-    }
-
-    for (const QString& name : std::as_const(sorted))
+    for (const QString& name : names)
     {
         QAction* act = m->addAction(name);
         mOriginalTexts[act] = name;   // keep original text, since action text has shortcuts added
     }
+    mMenuValid       = true;
+    mIncludeCommands = includeCommands;
+}
+
+/******************************************************************************
+* Called when alarm templates have been added, removed or renamed.
+* Note that the menu must be rebuilt the next time it is shown.
+*/
+void TemplateMenuAction::slotTemplatesChanged()
+{
+    mMenuValid = false;
 }
 
 /******************************************************************************
@@ -1,7 +1,7 @@
 /*
  *  templatemenuaction.h  -  menu action to select a template
  *  Program:  kalarm
- *  SPDX-FileCopyrightText: 2005-2021 David Jarvie <djarvie@kde.org>
+ *  SPDX-FileCopyrightText: 2005-2026 David Jarvie <djarvie@kde.org>
  *
  *  SPDX-License-Identifier: GPL-2.0-or-later
  */
@@ -30,9 +30,12 @@ Q_SIGNALS:
 private Q_SLOTS:
     void   slotInitMenu();
     void   slotSelected(QAction*);
+    void   slotTemplatesChanged();
 
 private:
     QMap<QAction*, QString> mOriginalTexts;   // menu item texts without added ampersands
+    bool                    mMenuValid {false};     // the menu reflects the current templates
+    bool                    mIncludeCommands {false};   // the menu includes command alarm templates
 };
 
 // vim: et sw=4:
@@ -11,6 +11,7 @@
 #include "templatelistview.h"
 #include "resources/datamodel.h"
 #include "resources/eventmodel.h"
+#include "resources/resources.h"
 #include "lib/config.h"
 #include "lib/shellprocess.h"
 
@@ -49,6 +50,7 @@ TemplatePickDlg::TemplatePickDlg(KAEvent::Action type, QWidget* parent)
         type = static_cast<KAEvent::Action>(type & ~KAEvent::Action::Command);
         shown = static_cast<KAEvent::Action>(shown & ~KAEvent::Action::Command);
     }
+    Resources::loadDeferredEvents(CalEvent::TEMPLATE, this);   // keep templates loaded while the dialog exists
     mListFilterModel = DataModel::createTemplateListModel(this);
     mListFilterModel->setAlarmActionsEnabled(type);
     mListFilterModel->setAlarmActionFilter(shown);